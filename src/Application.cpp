@@ -4,11 +4,15 @@
 #ifdef _OPENMP
     #include <omp.h> // omp_get_num_threads
 #endif // _OPENMP
+#include <fstream> //To read the manifest of a batch.
 #include <string>
+#include <thread> //To slice as many jobs of a batch at the same time as there are cores.
 #include "Application.h"
 #include "FffProcessor.h"
 #include "communication/ArcusCommunication.h" //To connect via Arcus to the front-end.
+#include "communication/BatchCommandLine.h" //To slice a batch of jobs.
 #include "communication/CommandLine.h" //To use the command line to slice stuff.
+#include "communication/DaemonCommandLine.h" //To slice jobs received through a local socket.
 #include "utils/logoutput.h"
 
 namespace cura
@@ -113,23 +117,35 @@ void Application::printHelp() const
 #endif // _OPENMP
     logAlways("\n");
 #endif //ARCUS
-    logAlways("CuraEngine slice [-v] [-p] [-j <settings.json>] [-s <settingkey>=<value>] [-g] [-e<extruder_nr>] [-o <output.gcode>] [-l <model.stl>] [--next]\n");
+    logAlways("CuraEngine slice [-v] [-p] [-b<megabytes>] [-z] [-j <settings.json>] [-s <settingkey>=<value>] [-g] [-e<extruder_nr>] [-o <output.gcode>] [-l <model.stl>] [--next]\n");
     logAlways("  -v\n\tIncrease the verbose level (show log messages).\n");
 #ifdef _OPENMP
     logAlways("  -m<thread_count>\n\tSet the desired number of threads.\n");
 #endif // _OPENMP
     logAlways("  -p\n\tLog progress information.\n");
+    logAlways("  -b<megabytes>\n\tSet the size of the buffers with which the gcode is written to the output\n\tfile or to stdout. Defaults to 8.\n");
+    logAlways("  -z\n\tCompress the gcode with gzip.\n");
+    logAlways("  --binary\n\tWrite the gcode in a compact binary format with an index of the layers.\n");
     logAlways("  -j\n\tLoad settings.def.json file to register all settings and their defaults.\n");
     logAlways("  -s <setting>=<value>\n\tSet a setting to a value for the last supplied object, \n\textruder train, or general settings.\n");
     logAlways("  -l <model_file>\n\tLoad an STL model. \n");
     logAlways("  -g\n\tSwitch setting focus to the current mesh group only.\n\tUsed for one-at-a-time printing.\n");
     logAlways("  -e<extruder_nr>\n\tSwitch setting focus to the extruder train with the given number.\n");
     logAlways("  --next\n\tGenerate gcode for the previously supplied mesh group and append that to \n\tthe gcode of further models for one-at-a-time printing.\n");
-    logAlways("  -o <output_file>\n\tSpecify a file to which to write the generated gcode.\n");
+    logAlways("  -o <output_file>\n\tSpecify a file to which to write the generated gcode.\n\tIf the file name ends in .gz, the gcode is compressed with gzip.\n");
     logAlways("\n");
     logAlways("The settings are appended to the last supplied object:\n");
     logAlways("CuraEngine slice [general settings] \n\t-g [current group settings] \n\t-e0 [extruder train 0 settings] \n\t-l obj_inheriting_from_last_extruder_train.stl [object settings] \n\t--next [next group settings]\n\t... etc.\n");
     logAlways("\n");
+    logAlways("CuraEngine batch [-v] [-w<job_count>] <manifest.txt>\n");
+    logAlways("  -v\n\tIncrease the verbose level (show log messages).\n");
+    logAlways("  -w<job_count>\n\tSet how many jobs to slice at the same time. Defaults to the number of cores.\n");
+    logAlways("  <manifest.txt>\n\tA file with a job on each line, with the same arguments as after \n\tCuraEngine slice. Each job needs an output file. Arguments with spaces \n\tcan be put between double quotes. Lines starting with # are skipped.\n\tMachine definitions are loaded once for all jobs.\n");
+    logAlways("\n");
+    logAlways("CuraEngine daemon [-v] <socket_path>\n");
+    logAlways("  -v\n\tIncrease the verbose level (show log messages).\n");
+    logAlways("  <socket_path>\n\tA local socket to listen on. Each connection sends a line with the same \n\targuments as after CuraEngine slice, including an output file, and is \n\tanswered with OK or FAILED once the gcode is written. The line quit stops \n\tthe daemon. If only speed, acceleration, jerk, retraction, cooling, \n\ttemperature or flow settings changed since the last job, and none of its \n\tfiles changed on disk, its layers are reused and only the gcode is written \n\tagain.\n");
+    logAlways("\n");
     logAlways("In order to load machine definitions from custom locations, you need to create the environment variable CURA_ENGINE_SEARCH_PATH, which should contain all search paths delimited by a (semi-)colon.\n");
     logAlways("\n");
 }
@@ -165,6 +181,79 @@ void Application::slice()
     communication = new CommandLine(arguments);
 }
 
+void Application::batch()
+{
+    size_t max_parallel_jobs = std::max(1u, std::thread::hardware_concurrency());
+    std::string manifest_filename;
+    for (size_t argument_index = 2; argument_index < argc; argument_index++)
+    {
+        const std::string argument = argv[argument_index];
+        if (argument == "-v")
+        {
+            increaseVerboseLevel();
+        }
+        else if (argument.find("-w") == 0)
+        {
+            max_parallel_jobs = std::max(1, atoi(argument.c_str() + 2));
+        }
+        else if (argument[0] != '-' && manifest_filename.empty())
+        {
+            manifest_filename = argument;
+        }
+        else
+        {
+            logError("Unknown option: %s\n", argument.c_str());
+            printCall();
+            printHelp();
+            exit(1);
+        }
+    }
+
+    std::ifstream manifest(manifest_filename);
+    if (manifest_filename.empty() || !manifest)
+    {
+        logError("Failed to open the manifest: %s\n", manifest_filename.c_str());
+        exit(1);
+    }
+    const std::vector<std::vector<std::string>> jobs = BatchCommandLine::readManifest(manifest);
+    log("Slicing %d jobs, %d at a time.\n", static_cast<int>(jobs.size()), static_cast<int>(max_parallel_jobs));
+
+    communication = new BatchCommandLine(argv[0], jobs, max_parallel_jobs);
+}
+
+void Application::daemon()
+{
+    std::string socket_path;
+    for (size_t argument_index = 2; argument_index < argc; argument_index++)
+    {
+        const std::string argument = argv[argument_index];
+        if (argument == "-v")
+        {
+            increaseVerboseLevel();
+        }
+        else if (argument[0] != '-' && socket_path.empty())
+        {
+            socket_path = argument;
+        }
+        else
+        {
+            logError("Unknown option: %s\n", argument.c_str());
+            printCall();
+            printHelp();
+            exit(1);
+        }
+    }
+    if (socket_path.empty())
+    {
+        logError("Missing the socket path.\n");
+        printCall();
+        printHelp();
+        exit(1);
+    }
+
+    communication = new DaemonCommandLine(argv[0], socket_path);
+}
+
 void Application::run(const size_t argc, char** argv)
 {
     this->argc = argc;
@@ -179,17 +268,12 @@ void Application::run(const size_t argc, char** argv)
         exit(1);
     }
 
-#pragma omp parallel
-    {
-#pragma omp master
-        {
 #ifdef _OPENMP
-            log("OpenMP multithreading enabled, likely number of threads to be used: %u\n", omp_get_num_threads());
+    //Don't start the threads just to count them. The processes forked off for a batch can't use OpenMP if it was started before the fork.
+    log("OpenMP multithreading enabled, likely number of threads to be used: %u\n", omp_get_max_threads());
 #else
-            log("OpenMP multithreading disabled\n");
+    log("OpenMP multithreading disabled\n");
 #endif
-        }
-    }
 
 #ifdef ARCUS
     if (stringcasecompare(argv[1], "connect") == 0)
@@ -202,6 +286,14 @@ void Application::run(const size_t argc, char** argv)
     {
         slice();
     }
+    else if (stringcasecompare(argv[1], "batch") == 0)
+    {
+        batch();
+    }
+    else if (stringcasecompare(argv[1], "daemon") == 0)
+    {
+        daemon();
+    }
     else if (stringcasecompare(argv[1], "help") == 0)
     {
         printHelp();
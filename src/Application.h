@@ -85,6 +85,17 @@ protected:
      */
     void slice();
 
+    /*!
+     * \brief Start slicing a batch of jobs from a manifest.
+     */
+    void batch();
+
+    /*!
+     * \brief Start a daemon that slices the jobs it receives through a local
+     * socket.
+     */
+    void daemon();
+
 private:
     /*
      * \brief The number of arguments that the application was called with.
@@ -16,7 +16,7 @@
 #include "utils/math.h"
 #include "utils/orderOptimizer.h"
 
-#define OMP_MAX_ACTIVE_LAYERS_PROCESSED 30 // TODO: hardcoded-value for the max number of layers being in the pipeline while writing away and destroying layers in a multi-threaded context
+#define OMP_MAX_ACTIVE_LAYERS_PROCESSED 30 // the max number of layers being in the pipeline while writing away and destroying layers in a multi-threaded context, if no memory budget is set
 
 namespace cura
 {
@@ -24,6 +24,8 @@ namespace cura
 FffGcodeWriter::FffGcodeWriter()
 : max_object_height(0)
 , layer_plan_buffer(gcode)
+, binary_buffer(&output_buffer)
+, output_file(&output_buffer)
 {
     for (unsigned int extruder_nr = 0; extruder_nr < MAX_EXTRUDERS; extruder_nr++)
     { // initialize all as max layer_nr, so that they get updated to the lowest layer on which they are used.
@@ -44,6 +46,8 @@ void FffGcodeWriter::writeGCode(SliceDataStorage& storage, TimeKeeper& time_keep
 
     Application::getInstance().communication->beginGCode();
 
+    travel_plan_cache.clear(); // the plans of a previous mesh group don't apply to this one
+
     setConfigFanSpeedLayerTime();
 
     setConfigRetraction(storage);
@@ -110,19 +114,38 @@ void FffGcodeWriter::writeGCode(SliceDataStorage& storage, TimeKeeper& time_keep
             LayerPlan& gcode_layer = processLayer(storage, layer_nr, total_layers);
             return &gcode_layer;
         };
+    // free the data of each layer as soon as no layer which is yet to be planned looks at it, so that not all layers are in memory at once
+    const LayerIndex layer_data_look_back = getLayerDataLookBack(storage);
+    LayerIndex next_released_layer_nr = 0;
     const std::function<void (LayerPlan*)>& consume_item =
-        [this, total_layers](LayerPlan* gcode_layer)
+        [this, total_layers, &storage, layer_data_look_back, &next_released_layer_nr](LayerPlan* gcode_layer)
         {
-            Progress::messageProgress(Progress::Stage::EXPORT, std::max(0, gcode_layer->getLayerNr()) + 1, total_layers);
+            const LayerIndex layer_nr = gcode_layer->getLayerNr();
+            Progress::messageProgress(Progress::Stage::EXPORT, std::max(0, static_cast<int>(layer_nr)) + 1, total_layers);
             layer_plan_buffer.handle(*gcode_layer, gcode);
+            // all layers up to this one have been planned, and the travel move to this layer has been added to the previous one
+            for (; next_released_layer_nr <= layer_nr - layer_data_look_back; next_released_layer_nr++)
+            {
+                storage.releaseLayer(next_released_layer_nr);
+            }
+        };
+    const std::function<size_t (const LayerPlan*)> item_memory =
+        [](const LayerPlan* gcode_layer)
+        {
+            return gcode_layer->getMemoryUsage();
         };
-    const unsigned int max_task_count = OMP_MAX_ACTIVE_LAYERS_PROCESSED;
+    // with a memory budget the number of layers in the pipeline adapts to the size of the layers, instead of being fixed
+    const size_t memory_budget = scene.current_mesh_group->settings.get<size_t>("layer_plan_memory_budget", 0) * 1024 * 1024;
+    // small layers may use more of the pipeline, but not so much that the layers waiting to be written hold all of the layer data
+    const unsigned int max_task_count = (memory_budget > 0) ? OMP_MAX_ACTIVE_LAYERS_PROCESSED * 4 : OMP_MAX_ACTIVE_LAYERS_PROCESSED;
     GcodeLayerThreader<LayerPlan> threader(
         process_layer_starting_layer_nr
         , static_cast<int>(total_layers)
         , produce_item
         , consume_item
         , max_task_count
+        , item_memory
+        , memory_budget
     );
 
     // process all layers, process buffer for preheating and minimal layer time etc, write layers to gcode:
@@ -140,6 +163,36 @@ void FffGcodeWriter::writeGCode(SliceDataStorage& storage, TimeKeeper& time_keep
     gcode.writeRetraction(storage.retraction_config_per_extruder[gcode.getExtruderNr()], force); // retract after finishing each meshgroup
 }
 
+LayerIndex FffGcodeWriter::getLayerDataLookBack(const SliceDataStorage& storage) const
+{
+    // bridge skins look up to 3 layers down, walls and the spiralized wall look at the layer below and combing at the previous layer
+    LayerIndex look_back = 3;
+
+    const Settings& mesh_group_settings = Application::getInstance().current_slice->scene.current_mesh_group->settings;
+    if (mesh_group_settings.get<bool>("support_enable") || mesh_group_settings.get<bool>("support_tree_enable"))
+    {
+        // the support below a bridge is looked at support_top_distance lower, and up to 2 layers further down for the upper bridge skins
+        coord_t min_layer_thickness = mesh_group_settings.get<coord_t>("layer_height");
+        for (const SliceMeshStorage& mesh : storage.meshes)
+        {
+            for (const SliceLayer& layer : mesh.layers)
+            {
+                if (layer.thickness > 0)
+                {
+                    min_layer_thickness = std::min(min_layer_thickness, layer.thickness);
+                }
+            }
+        }
+        for (const SliceMeshStorage& mesh : storage.meshes)
+        {
+            const coord_t z_distance_top = mesh.settings.get<coord_t>("support_top_distance");
+            const LayerIndex z_distance_top_layers = round_up_divide(z_distance_top, std::max(coord_t(1), min_layer_thickness)) + 1;
+            look_back = std::max(look_back, z_distance_top_layers + 2);
+        }
+    }
+    return look_back;
+}
+
 unsigned int FffGcodeWriter::findSpiralizedLayerSeamVertexIndex(const SliceDataStorage& storage, const SliceMeshStorage& mesh, const int layer_nr, const int last_layer_nr)
 {
     const SliceLayer& layer = mesh.layers[layer_nr];
@@ -802,7 +855,7 @@ LayerPlan& FffGcodeWriter::processLayer(const SliceDataStorage& storage, LayerIn
         extruder_order_per_layer[layer_nr];
 
     const coord_t first_outer_wall_line_width = scene.extruders[extruder_order.front()].settings.get<coord_t>("wall_line_width_0");
-    LayerPlan& gcode_layer = *new LayerPlan(storage, layer_nr, z, layer_thickness, extruder_order.front(), fan_speed_layer_time_settings_per_extruder, comb_offset_from_outlines, first_outer_wall_line_width, avoid_distance);
+    LayerPlan& gcode_layer = *new LayerPlan(storage, layer_nr, z, layer_thickness, extruder_order.front(), fan_speed_layer_time_settings_per_extruder, comb_offset_from_outlines, first_outer_wall_line_width, avoid_distance, &travel_plan_cache);
 
     if (include_helper_parts && layer_nr == 0)
     { // process the skirt or the brim of the starting extruder.
@@ -1173,6 +1226,7 @@ void FffGcodeWriter::addMeshLayerToGCode(const SliceDataStorage& storage, const
     ZSeamConfig z_seam_config(mesh.settings.get<EZSeamType>("z_seam_type"), mesh.getZSeamHint(), mesh.settings.get<EZSeamCornerPrefType>("z_seam_corner"));
     const Point layer_start_position(train.settings.get<coord_t>("layer_start_x"), train.settings.get<coord_t>("layer_start_y"));
     PathOrderOptimizer part_order_optimizer(layer_start_position, z_seam_config);
+    part_order_optimizer.setTravelPlanCache(gcode_layer.getTravelPlanCache());
     for (unsigned int part_idx = 0; part_idx < layer.parts.size(); part_idx++)
     {
         const SliceLayerPart& part = layer.parts[part_idx];
@@ -1180,6 +1234,7 @@ void FffGcodeWriter::addMeshLayerToGCode(const SliceDataStorage& storage, const
         part_order_optimizer.addPolygon(part_representative);
     }
     part_order_optimizer.optimize();
+    gcode_layer.refineOrder(part_order_optimizer);
 
     for (int part_idx : part_order_optimizer.polyOrder)
     {
@@ -1499,28 +1554,10 @@ bool FffGcodeWriter::processInsets(const SliceDataStorage& storage, LayerPlan& g
         // for non-spiralized layers, determine the shape of the unsupported areas below this part
         if (!spiralize && gcode_layer.getLayerNr() > 0)
         {
-            // accumulate the outlines of all of the parts that are on the layer below
-
-            Polygons outlines_below;
-            AABB boundaryBox(part.outline);
-            for (const SliceMeshStorage& m : storage.meshes)
-            {
-                if (m.isPrinted())
-                {
-                    for (const SliceLayerPart& prevLayerPart : m.layers[gcode_layer.getLayerNr() - 1].parts)
-                    {
-                        if (boundaryBox.hit(prevLayerPart.boundaryBox))
-                        {
-                            outlines_below.add(prevLayerPart.outline);
-                        }
-                    }
-                }
-            }
-
-            const coord_t layer_height = mesh_config.inset0_config.getLayerThickness();
-
             // if support is enabled, add the support outlines also so we don't generate bridges over support
 
+            const coord_t layer_height = mesh_config.inset0_config.getLayerThickness();
+            const SupportLayer* support_layer = nullptr;
             const Settings& mesh_group_settings = Application::getInstance().current_slice->scene.current_mesh_group->settings;
             if (mesh_group_settings.get<bool>("support_enable") || mesh_group_settings.get<bool>("support_tree_enable"))
             {
@@ -1530,27 +1567,26 @@ bool FffGcodeWriter::processInsets(const SliceDataStorage& storage, LayerPlan& g
 
                 if (support_layer_nr > 0)
                 {
-                    const SupportLayer& support_layer = storage.support.supportLayers[support_layer_nr];
+                    support_layer = &storage.support.supportLayers[support_layer_nr];
+                }
+            }
+            const BridgeSupport& support_below = gcode_layer.getBridgeSupport(gcode_layer.getLayerNr() - 1, support_layer);
 
-                    if (!support_layer.support_roof.empty())
-                    {
-                        AABB support_roof_bb(support_layer.support_roof);
-                        if (boundaryBox.hit(support_roof_bb))
-                        {
-                            outlines_below.add(support_layer.support_roof);
-                        }
-                    }
-                    else
-                    {
-                        for (const SupportInfillPart& support_part : support_layer.support_infill_parts)
-                        {
-                            AABB support_part_bb(support_part.getInfillArea());
-                            if (boundaryBox.hit(support_part_bb))
-                            {
-                                outlines_below.add(support_part.getInfillArea());
-                            }
-                        }
-                    }
+            // accumulate the outlines of all of the parts that are on the layer below
+
+            Polygons outlines_below;
+            AABB boundaryBox(part.outline);
+            std::vector<size_t> part_indices_below;
+            support_below.findParts(boundaryBox, part_indices_below);
+            for (const size_t part_idx : part_indices_below)
+            {
+                outlines_below.add(*support_below.part_outlines[part_idx]);
+            }
+            for (size_t support_idx = 0; support_idx < support_below.support_areas.size(); support_idx++)
+            {
+                if (boundaryBox.hit(support_below.support_boxes[support_idx]))
+                {
+                    outlines_below.add(*support_below.support_areas[support_idx]);
                 }
             }
 
@@ -1787,12 +1823,14 @@ bool FffGcodeWriter::processSkinAndPerimeterGaps(const SliceDataStorage& storage
                             && extruder_nr == wall_0_extruder_nr;
 
     PathOrderOptimizer part_order_optimizer(gcode_layer.getLastPlannedPositionOrStartingPosition());
+    part_order_optimizer.setTravelPlanCache(gcode_layer.getTravelPlanCache());
     for (unsigned int skin_part_idx = 0; skin_part_idx < part.skin_parts.size(); skin_part_idx++)
     {
         const PolygonsPart& outline = part.skin_parts[skin_part_idx].outline;
         part_order_optimizer.addPolygon(outline.outerPolygon());
     }
     part_order_optimizer.optimize();
+    gcode_layer.refineOrder(part_order_optimizer);
 
     for (int ordered_skin_part_idx : part_order_optimizer.polyOrder)
     {
@@ -1973,7 +2011,7 @@ void FffGcodeWriter::processTopBottom(const SliceDataStorage& storage, LayerPlan
 
         Polygons supported_skin_part_regions;
 
-        const int angle = bridgeAngle(mesh.settings, skin_part.outline, storage, layer_nr - bridge_layer, support_layer, supported_skin_part_regions);
+        const int angle = bridgeAngle(mesh.settings, skin_part.outline, gcode_layer.getBridgeSupport(layer_nr - bridge_layer, support_layer), supported_skin_part_regions);
 
         if (angle > -1 || (supported_skin_part_regions.area() / (skin_part.outline.area() + 1) < support_threshold))
         {
@@ -2277,11 +2315,13 @@ bool FffGcodeWriter::processSupportInfill(const SliceDataStorage& storage, Layer
 
     // create a list of outlines and use PathOrderOptimizer to optimize the travel move
     PathOrderOptimizer island_order_optimizer(gcode_layer.getLastPlannedPositionOrStartingPosition());
+    island_order_optimizer.setTravelPlanCache(gcode_layer.getTravelPlanCache());
     for (size_t part_idx = 0; part_idx < support_layer.support_infill_parts.size(); ++part_idx)
     {
         island_order_optimizer.addPolygon(support_layer.support_infill_parts[part_idx].outline[0]);
     }
     island_order_optimizer.optimize();
+    gcode_layer.refineOrder(island_order_optimizer);
 
     //Print the thicker infill lines first. (double or more layer thickness, infill combined with previous layers)
     const std::vector<SupportInfillPart>& part_list = support_layer.support_infill_parts;
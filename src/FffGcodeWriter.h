@@ -5,7 +5,9 @@
 #define GCODE_WRITER_H
 
 
-#include <fstream>
+#include <ostream>
+#include "utils/BackgroundWriteBuffer.h"
+#include "utils/BinaryGcodeBuffer.h"
 #include "utils/gettime.h"
 #include "utils/logoutput.h"
 #include "utils/NoCopy.h"
@@ -57,10 +59,22 @@ private:
      */
     GCodeExport gcode;
 
+    /*!
+     * The buffer with which the gcode is written to a file or to stdout when
+     * using CuraEngine as command line tool.
+     */
+    BackgroundWriteBuffer output_buffer;
+
+    /*!
+     * Encodes the gcode in binary before it's passed on to the output buffer,
+     * if binary gcode is written.
+     */
+    BinaryGcodeBuffer binary_buffer;
+
     /*!
      * The gcode file to write to when using CuraEngine as command line tool.
      */
-    std::ofstream output_file;
+    std::ostream output_file;
 
     /*!
      * For each raft/filler layer, the extruders to be used in that layer in the order in which they are going to be used.
@@ -84,6 +98,14 @@ private:
 
     std::vector<FanSpeedLayerTimeSettings> fan_speed_layer_time_settings_per_extruder; //!< The settings used relating to minimal layer time and fan speeds. Configured for each extruder.
 
+    /*!
+     * The orders and combing paths planned so far, reused by layers with the
+     * same geometry as an earlier layer.
+     *
+     * Mutable since layers are planned in the const \ref FffGcodeWriter::processLayer.
+     */
+    mutable TravelPlanCache travel_plan_cache;
+
 public:
     /*
      * \brief Construct a g-code writer.
@@ -102,8 +124,7 @@ public:
      */
     bool setTargetFile(const char* filename)
     {
-        output_file.open(filename);
-        if (output_file.is_open())
+        if (output_buffer.open(filename))
         {
             gcode.setOutputStream(&output_file);
             return true;
@@ -111,6 +132,72 @@ public:
         return false;
     }
 
+    /*!
+     * Set the target to write gcode to: stdout, through a large buffer.
+     * 
+     * Used when CuraEngine is used as command line tool without output file.
+     */
+    void setTargetStdout()
+    {
+        output_buffer.open(stdout);
+        gcode.setOutputStream(&output_file);
+    }
+
+    /*!
+     * Set the size of the buffers with which gcode is written to the target
+     * file or to stdout.
+     * 
+     * \param buffer_size The size of each of the two buffers, in bytes.
+     */
+    void setTargetBufferSize(const size_t buffer_size)
+    {
+        output_buffer.setBufferSize(buffer_size);
+    }
+
+    /*!
+     * Set whether to compress the gcode written to the target file or to
+     * stdout with gzip.
+     * 
+     * \param compress Whether to compress the gcode.
+     * \return Whether the gcode will be written as requested, which is not the
+     * case if compression is requested but this build can't compress.
+     */
+    bool setTargetCompressed(const bool compress)
+    {
+        return output_buffer.setCompressed(compress);
+    }
+
+    /*!
+     * Set whether to write the gcode to the target file or to stdout in the
+     * binary format of \ref BinaryGcodeBuffer instead of as text.
+     * 
+     * Should be set before any gcode is written.
+     * 
+     * \param binary Whether to write binary gcode.
+     */
+    void setTargetBinary(const bool binary)
+    {
+        output_file.rdbuf(binary ? static_cast<std::streambuf*>(&binary_buffer) : &output_buffer);
+    }
+
+    /*!
+     * Finish writing to the target file or to stdout.
+     * 
+     * Used when CuraEngine is used as command line tool, after the gcode has
+     * been finalized.
+     * 
+     * \return Whether all gcode has been written successfully.
+     */
+    bool closeTarget()
+    {
+        bool success = true;
+        if (output_file.rdbuf() == &binary_buffer)
+        {
+            success = binary_buffer.finish();
+        }
+        return output_buffer.close() && success;
+    }
+
     /*!
      * Set the target to write gcode to: an output stream.
      * 
@@ -186,6 +273,18 @@ private:
      */
     unsigned int getStartExtruder(const SliceDataStorage& storage);
 
+    /*!
+     * Get how many layers below the layer being planned the data of the mesh
+     * layers and support layers is looked at, e.g. to detect bridges.
+     *
+     * The data of a layer which is this far below all layers which are yet to
+     * be planned can be freed.
+     *
+     * \param storage The data storage with the layers.
+     * \return The number of layers.
+     */
+    LayerIndex getLayerDataLookBack(const SliceDataStorage& storage) const;
+
     /*!
      * Set the infill angles and skin angles in the SliceDataStorage.
      * 
@@ -64,6 +64,61 @@ public:
         return gcode_writer.setTargetFile(filename);
     }
 
+    /*!
+     * Set the target to write gcode to: stdout.
+     * 
+     * Used when CuraEngine is used as command line tool without output file.
+     */
+    void setTargetStdout()
+    {
+        gcode_writer.setTargetStdout();
+    }
+
+    /*!
+     * Set the size of the buffers with which gcode is written to the target
+     * file or to stdout.
+     * 
+     * \param buffer_size The size of each of the two buffers, in bytes.
+     */
+    void setTargetBufferSize(const size_t buffer_size)
+    {
+        gcode_writer.setTargetBufferSize(buffer_size);
+    }
+
+    /*!
+     * Set whether to compress the gcode written to the target file or to
+     * stdout with gzip.
+     * 
+     * \param compress Whether to compress the gcode.
+     * \return Whether the gcode will be written as requested, which is not the
+     * case if compression is requested but this build can't compress.
+     */
+    bool setTargetCompressed(const bool compress)
+    {
+        return gcode_writer.setTargetCompressed(compress);
+    }
+
+    /*!
+     * Set whether to write the gcode to the target file or to stdout in a
+     * compact binary format instead of as text.
+     * 
+     * \param binary Whether to write binary gcode.
+     */
+    void setTargetBinary(const bool binary)
+    {
+        gcode_writer.setTargetBinary(binary);
+    }
+
+    /*!
+     * Finish writing to the target file or to stdout.
+     * 
+     * \return Whether all gcode has been written successfully.
+     */
+    bool closeTarget()
+    {
+        return gcode_writer.closeTarget();
+    }
+
     /*!
      * Set the target to write gcode to: an output stream.
      * 
@@ -2,18 +2,116 @@
 #ifndef GCODE_LAYER_THREADER_H
 #define GCODE_LAYER_THREADER_H
 
-#include <queue> // priority_queue
+#include <algorithm> // max
+#include <cassert>
+#include <condition_variable>
 #include <functional> // function
-#include <thread> // sleep
-#include <chrono> // milliseconds
+#include <mutex>
+#include <vector>
+#ifdef _OPENMP
+    #include <omp.h> // omp_get_num_threads
+#endif // _OPENMP
 
 #include "utils/logoutput.h"
-#include "utils/optional.h"
-#include "utils/Lock.h"
 
 namespace cura
 {
 
+/*!
+ * Keeps track of the memory used by the items which are produced but not yet
+ * consumed, to decide whether another item may be started.
+ *
+ * The memory an item will use is estimated from the items produced so far, so
+ * that the number of items being processed at the same time adapts to how
+ * large the items turn out to be.
+ */
+class MemoryBudgetWindow
+{
+public:
+    /*!
+     * \param memory_budget The number of bytes the active items may use, or 0
+     * to only limit the number of active items.
+     * \param max_item_count The maximum number of items (being) produced
+     * without having been consumed.
+     */
+    MemoryBudgetWindow(const size_t memory_budget, const unsigned int max_item_count)
+    : memory_budget(memory_budget)
+    , max_item_count(max_item_count)
+    {
+    }
+
+    /*!
+     * Whether another item may be started.
+     *
+     * One item may always be active, even if it's larger than the budget.
+     */
+    bool mayStart() const
+    {
+        const unsigned int active_count = producing_count + produced_count;
+        if (active_count >= max_item_count)
+        {
+            return false;
+        }
+        if (memory_budget == 0 || active_count == 0)
+        {
+            return true;
+        }
+        return produced_memory + (producing_count + 1) * estimated_item_memory <= memory_budget;
+    }
+
+    /*!
+     * Register that an item is being produced.
+     */
+    void start()
+    {
+        producing_count++;
+    }
+
+    /*!
+     * Register that an item has been produced.
+     * \param item_memory The number of bytes the item uses.
+     */
+    void produced(const size_t item_memory)
+    {
+        assert(producing_count > 0);
+        producing_count--;
+        produced_count++;
+        produced_memory += item_memory;
+        // a moving average, so that the estimate follows the size of the layers as they change with the height of the model
+        estimated_item_memory = has_estimate ? (3 * estimated_item_memory + item_memory) / 4 : item_memory;
+        has_estimate = true;
+    }
+
+    /*!
+     * Register that an item has been consumed.
+     * \param item_memory The number of bytes the item used, as given to
+     * \ref MemoryBudgetWindow::produced.
+     */
+    void consumed(const size_t item_memory)
+    {
+        assert(produced_count > 0 && produced_memory >= item_memory);
+        produced_count--;
+        produced_memory -= item_memory;
+    }
+
+    /*!
+     * The memory an item which is yet to be produced is expected to use.
+     */
+    size_t getEstimatedItemMemory() const
+    {
+        return estimated_item_memory;
+    }
+
+private:
+    const size_t memory_budget; //!< The number of bytes the active items may use, or 0 for no limit
+    const unsigned int max_item_count; //!< The maximum number of active items
+    unsigned int producing_count = 0; //!< The number of items being produced
+    unsigned int produced_count = 0; //!< The number of items produced and not yet consumed
+    size_t produced_memory = 0; //!< The number of bytes used by the items produced and not yet consumed
+    size_t estimated_item_memory = 0; //!< The number of bytes an item is expected to use
+    bool has_estimate = false; //!< Whether any item has been produced to base the estimate on
+};
+
 /*!
  * Producer Consumer construct for when:
  * - production can occur in parallel
@@ -25,6 +123,13 @@ namespace cura
  * 
  * If there is only one thread, it consumes every time it has produced one item.
  * 
+ * A thread which can do neither waits until another thread has consumed an item or
+ * has produced the item which is to be consumed next.
+ * 
+ * If a function is given to measure the memory used by an item, the number of
+ * active items is furthermore limited by a memory budget. See
+ * \ref MemoryBudgetWindow.
+ * 
  * \warning This class is only adequate when the expected production time of an item is more than (n_threads - 1) times as much as the expected consumption time of an item
  */
 template <typename T>
@@ -37,13 +142,17 @@ public:
      * \param produce_item The function with which to produce an item
      * \param consume_item The function with which to consume an item
      * \param max_task_count The maximum number of items (being) produced without having been consumed
+     * \param item_memory The function with which to measure the number of bytes a produced item uses, or nullptr
+     * \param memory_budget The number of bytes the items produced without having been consumed may use, or 0 for no limit
      */
     GcodeLayerThreader(
         int start_item_argument_index,
         int end_item_argument_index,
         const std::function<T* (int)>& produce_item,
         const std::function<void (T*)>& consume_item,
-        const unsigned int max_task_count
+        const unsigned int max_task_count,
+        const std::function<size_t (const T*)>& item_memory = nullptr,
+        const size_t memory_budget = 0
     );
 
     /*!
@@ -52,30 +161,31 @@ public:
     void run();
 private:
     /*!
-     * Produce an item and put it in \ref GcodeLayerThreader::produced
-     * 
-     * \param item_argument_index The parameter with which to call \ref GcodeLayerThreader::produce_item
+     * Consume and produce items until all items have been consumed.
+     *
+     * Run by each thread.
      */
-    void produce(int item_argument_index);
+    void work();
 
     /*!
-     * Consume an item from \ref GcodeLayerThreader::produced
-     * 
-     * \param item_idx The index into \ref GcodeLayerThreader::produced
+     * Consume the next item if it has been produced and no other thread is
+     * consuming.
+     *
+     * \param lock The lock on \ref GcodeLayerThreader::mutex, which is
+     * released while consuming.
+     * \return Whether an item has been consumed.
      */
-    void consume(int item_idx);
+    bool tryConsume(std::unique_lock<std::mutex>& lock);
 
     /*!
-     * Consume if possible, otherwise
-     * Produce if possible, otherwise
-     * wait half a second
+     * Produce the next item if there are items left to produce and not too
+     * many items are active.
+     *
+     * \param lock The lock on \ref GcodeLayerThreader::mutex, which is
+     * released while producing.
+     * \return Whether an item has been produced.
      */
-    void act();
-
-    /*!
-     * Check whether no tasks are left for a thread to pick up
-     */
-    bool finished();
+    bool tryProduce(std::unique_lock<std::mutex>& lock);
 
 private:
     // algorithm parameters
@@ -83,22 +193,19 @@ private:
     const int end_item_argument_index; //!< The end index with which \ref GcodeLayerThreader::produce_item will not be called any more
     const unsigned int item_count; //!< The number of items to produce and consume
 
-    const int max_task_count; //!< The maximum amount of items active in the system
-
     const std::function<T* (int)>& produce_item; //!< The function to produce an item
     const std::function<void (T*)>& consume_item; //!< The function to consume an item
+    const std::function<size_t (const T*)> item_memory; //!< The function to measure the memory used by an item, or nullptr
 
-    // variables which change throughout the computation of the algorithm
+    // variables which change throughout the computation of the algorithm, guarded by the mutex
+    std::mutex mutex; //!< Guards all variables below
+    std::condition_variable state_changed; //!< Notified when an item can be consumed or an item is no longer active, to wake up waiting threads
     std::vector<T*> produced; //!< ordered list for every item to be produced; contains pointers to produced items which aren't consumed yet; rest is nullptr
-    int last_produced_argument_index; //!< Counter to see which item next to produce
-
-    std::optional<int> to_be_consumed_item_idx; //!< The index into \ref GcodeLayerThreader::produced where to find the next item ready to be consumed (if any)
-    Lock consume_lock; //!< Lock to make sure no two threads consume at the same time
-    int last_consumed_idx = -1; //!< The index into \ref GcodeLayerThreader::produced for the last item consumed
-
-    // statistics
-    int active_task_count = 0; //!< Number of items active in this system.
-
+    int next_produced_argument_index; //!< The argument with which the next item will be produced
+    unsigned int next_consumed_idx = 0; //!< The index into \ref GcodeLayerThreader::produced of the next item to consume
+    bool consuming = false; //!< Whether a thread is consuming an item, to make sure no two threads consume at the same time
+    std::vector<size_t> produced_memory; //!< The memory used by each produced item, as measured when it was produced
+    MemoryBudgetWindow window; //!< Limits the number of items active in the system
 };
 
 template <typename T>
@@ -107,17 +214,22 @@ GcodeLayerThreader<T>::GcodeLayerThreader(
     int end_item_argument_index,
     const std::function<T* (int)>& produce_item,
     const std::function<void (T*)>& consume_item,
-    const unsigned int max_task_count
+    const unsigned int max_task_count,
+    const std::function<size_t (const T*)>& item_memory,
+    const size_t memory_budget
 )
 : start_item_argument_index(start_item_argument_index)
 , end_item_argument_index(end_item_argument_index)
-, item_count(end_item_argument_index - start_item_argument_index)
-, max_task_count(max_task_count)
+, item_count(std::max(0, end_item_argument_index - start_item_argument_index))
 , produce_item(produce_item)
 , consume_item(consume_item)
-, last_produced_argument_index(start_item_argument_index - 1)
+, item_memory(item_memory)
+, next_produced_argument_index(start_item_argument_index)
+, window(item_memory ? memory_budget : 0, max_task_count)
 {
+    assert(max_task_count > 0 && "Nothing can be produced if no item may be active!");
     produced.resize(item_count, nullptr);
+    produced_memory.resize(item_count, 0);
 }
 
 template <typename T>
@@ -129,105 +241,74 @@ void GcodeLayerThreader<T>::run()
         #pragma omp master
         log("Multithreading GcodeLayerThreader with %i threads.\n", omp_get_num_threads());
 #endif // _OPENMP
-        while (true)
-        {
-            if (finished())
-            {
-                break;
-            }
-            act();
-        }
+        work();
     }
 }
 
 template <typename T>
-void GcodeLayerThreader<T>::produce(int item_argument_index)
+void GcodeLayerThreader<T>::work()
 {
-    T* produced_item = produce_item(item_argument_index);
-    int item_idx = item_argument_index - start_item_argument_index;
-    #pragma omp critical
+    std::unique_lock<std::mutex> lock(mutex);
+    while (next_consumed_idx < item_count)
     {
-        produced[item_idx] = produced_item;
-        if (item_idx == last_consumed_idx + 1 && item_idx < end_item_argument_index - start_item_argument_index)
+        // consuming gets priority, so that items don't pile up
+        if (tryConsume(lock) || tryProduce(lock))
         {
-            assert(!to_be_consumed_item_idx && "the just produced item shouldn't be consumable already!");
-            to_be_consumed_item_idx = item_idx;
+            continue;
         }
+        // blocked by too many items being processed, or by another thread consuming or producing the next item
+        state_changed.wait(lock);
     }
 }
 
 template <typename T>
-void GcodeLayerThreader<T>::consume(int item_idx)
+bool GcodeLayerThreader<T>::tryConsume(std::unique_lock<std::mutex>& lock)
 {
-    consume_item(produced[item_idx]);
-    produced[item_idx] = nullptr;
-    #pragma omp critical
+    if (consuming || next_consumed_idx >= item_count || !produced[next_consumed_idx])
     {
-        assert(item_idx == last_consumed_idx + 1);
-        last_consumed_idx = item_idx;
-        if (last_consumed_idx + 1 < end_item_argument_index - start_item_argument_index && produced[last_consumed_idx + 1])
-        {
-            assert(!to_be_consumed_item_idx && "The next produced item shouldn't already be noted as being consumable because of the lock!");
-            to_be_consumed_item_idx = last_consumed_idx + 1;
-        }
-        active_task_count--;
-        assert(active_task_count >= 0);
+        return false;
     }
+    consuming = true;
+    T* item = produced[next_consumed_idx];
+    produced[next_consumed_idx] = nullptr;
+    window.consumed(produced_memory[next_consumed_idx]);
+
+    lock.unlock();
+    consume_item(item);
+    lock.lock();
+
+    consuming = false;
+    next_consumed_idx++;
+    // a task slot is free and the next item may already have been produced, or everything is done
+    state_changed.notify_all();
+    return true;
 }
 
 template <typename T>
-void GcodeLayerThreader<T>::act()
+bool GcodeLayerThreader<T>::tryProduce(std::unique_lock<std::mutex>& lock)
 {
+    if (next_produced_argument_index >= end_item_argument_index || !window.mayStart())
     {
-        int item_idx = -1;
-        #pragma omp critical
-        {
-            if (to_be_consumed_item_idx && consume_lock.test_lock())
-            {
-                item_idx = *to_be_consumed_item_idx;
-                to_be_consumed_item_idx = nullptr;
-            }
-        }
-        if (item_idx >= 0)
-        {
-            consume(item_idx);
-            consume_lock.unlock();
-            return;
-        }
+        return false;
     }
+    const int item_argument_index = next_produced_argument_index++;
+    window.start();
 
-    {
-        std::optional<int> item_argument_index;
-        #pragma omp critical
-        {
-            if (active_task_count < max_task_count)
-            {
-                item_argument_index = ++last_produced_argument_index;
-                active_task_count++;
-            }
-        }
-        if (item_argument_index && *item_argument_index < end_item_argument_index)
-        {
-            produce(*item_argument_index);
-            return;
-        }
-    }
-#ifdef _OPENMP
-    // thread is blocked by too many items being processed
-    std::this_thread::sleep_for(std::chrono::milliseconds(500));
-#endif
-}
+    lock.unlock();
+    T* item = produce_item(item_argument_index);
+    const size_t memory = item_memory ? item_memory(item) : 0;
+    lock.lock();
 
-template <typename T>
-bool GcodeLayerThreader<T>::finished()
-{
-    bool finished;
-    #pragma omp critical
+    const unsigned int item_idx = item_argument_index - start_item_argument_index;
+    produced[item_idx] = item;
+    produced_memory[item_idx] = memory;
+    window.produced(memory);
+    if (item_idx == next_consumed_idx)
     {
-        finished = last_produced_argument_index >= end_item_argument_index - 1
-            && !to_be_consumed_item_idx;
+        // threads waiting for the item which is to be consumed next can continue
+        state_changed.notify_all();
     }
-    return finished;
+    return true;
 }
 
 } // namespace cura
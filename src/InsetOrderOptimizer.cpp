@@ -1,19 +1,155 @@
 //Copyright (c) 2017 Ultimaker B.V.
 //CuraEngine is released under the terms of the AGPLv3 or higher.
 
+#include <algorithm> //For lower_bound and sort.
+
 #include "InsetOrderOptimizer.h"
 
 namespace cura
 {
 
-static int findAdjacentEnclosingPoly(const ConstPolygonRef& enclosed_inset, const std::vector<ConstPolygonPointer>& possible_enclosing_polys, const coord_t max_gap)
+AABB InsetOrderOptimizer::getBounds(const ConstPolygonRef& inset) const
+{
+    const std::unordered_map<const ClipperLib::Path*, AABB>::const_iterator it = inset_bounds.find(&*inset);
+    if (it != inset_bounds.end())
+    {
+        return it->second;
+    }
+    return AABB(inset);
+}
+
+void InsetOrderOptimizer::createInsetGrids()
+{
+    constexpr coord_t max_cells_per_inset = 64; // insets which cover more cells, e.g. the outer wall around many holes, are tested for every query instead
+    inset_indices.clear();
+    inset_grid_cell_sizes.clear();
+    inset_grids.clear();
+    large_insets.clear();
+    for (const std::vector<ConstPolygonPointer>& level_polys : inset_polys)
+    {
+        // make the cells about as large as the insets, so that most insets are only in a few cells
+        coord_t size_sum = 0;
+        for (const ConstPolygonPointer& poly : level_polys)
+        {
+            const AABB& bounds = inset_bounds.at(&**poly);
+            size_sum += std::max(coord_t(0), std::max(bounds.max.X - bounds.min.X, bounds.max.Y - bounds.min.Y));
+        }
+        const coord_t cell_size = std::max(coord_t(MM2INT(1)), size_sum / std::max(coord_t(1), static_cast<coord_t>(level_polys.size())));
+        inset_grid_cell_sizes.push_back(cell_size);
+        inset_grids.emplace_back();
+        large_insets.emplace_back();
+        for (unsigned int poly_idx = 0; poly_idx < level_polys.size(); poly_idx++)
+        {
+            const ClipperLib::Path* path = &**level_polys[poly_idx];
+            inset_indices.emplace(path, poly_idx);
+            const AABB& bounds = inset_bounds.at(path);
+            if (bounds.min.X > bounds.max.X)
+            {
+                continue; // an inset without vertices doesn't overlap anything
+            }
+            const Point min_cell(bounds.min.X / cell_size, bounds.min.Y / cell_size);
+            const Point max_cell(bounds.max.X / cell_size, bounds.max.Y / cell_size);
+            if ((max_cell.X - min_cell.X + 1) * (max_cell.Y - min_cell.Y + 1) > max_cells_per_inset)
+            {
+                large_insets.back().push_back(path);
+                continue;
+            }
+            for (coord_t x = min_cell.X; x <= max_cell.X; x++)
+            {
+                for (coord_t y = min_cell.Y; y <= max_cell.Y; y++)
+                {
+                    inset_grids.back().emplace(Point(x, y), path);
+                }
+            }
+        }
+    }
+}
+
+std::vector<unsigned int> InsetOrderOptimizer::findInsetsNear(const unsigned int level, const AABB& box) const
 {
-    // given an inset, search a collection of insets for the adjacent enclosing inset
-    for (unsigned int enclosing_poly_idx = 0; enclosing_poly_idx < possible_enclosing_polys.size(); ++enclosing_poly_idx)
+    std::vector<unsigned int> result;
+    if (box.min.X > box.max.X)
+    {
+        return result;
+    }
+    const std::vector<ConstPolygonPointer>& level_polys = inset_polys[level];
+    const coord_t cell_size = inset_grid_cell_sizes[level];
+    const Point min_cell(box.min.X / cell_size, box.min.Y / cell_size);
+    const Point max_cell(box.max.X / cell_size, box.max.Y / cell_size);
+    if ((max_cell.X - min_cell.X + 1) * (max_cell.Y - min_cell.Y + 1) > static_cast<coord_t>(level_polys.size()))
+    {
+        // the query would visit more grid cells than there are insets, so just look at all of them
+        for (unsigned int poly_idx = 0; poly_idx < level_polys.size(); poly_idx++)
+        {
+            if (getBounds(*level_polys[poly_idx]).hit(box))
+            {
+                result.push_back(poly_idx);
+            }
+        }
+        return result;
+    }
+
+    // consumed insets are erased from their level, but the remaining ones keep their order, so their current index can be found by bisection
+    auto add_if_near = [this, &level_polys, &box, &result](const ClipperLib::Path* path)
+    {
+        if (!inset_bounds.at(path).hit(box))
+        {
+            return;
+        }
+        const unsigned int original_idx = inset_indices.at(path);
+        const std::vector<ConstPolygonPointer>::const_iterator found = std::lower_bound(level_polys.begin(), level_polys.end(), original_idx,
+            [this](const ConstPolygonPointer& poly, const unsigned int idx)
+            {
+                return inset_indices.at(&**poly) < idx;
+            });
+        if (found != level_polys.end() && &***found == path)
+        {
+            result.push_back(found - level_polys.begin());
+        }
+    };
+    for (coord_t x = min_cell.X; x <= max_cell.X; x++)
     {
-        const ConstPolygonRef& enclosing = *possible_enclosing_polys[enclosing_poly_idx];
+        for (coord_t y = min_cell.Y; y <= max_cell.Y; y++)
+        {
+            const auto cell = inset_grids[level].equal_range(Point(x, y));
+            for (auto it = cell.first; it != cell.second; ++it)
+            {
+                add_if_near(it->second);
+            }
+        }
+    }
+    for (const ClipperLib::Path* path : large_insets[level])
+    {
+        add_if_near(path);
+    }
+    // an inset which overlaps several cells has been found more than once
+    std::sort(result.begin(), result.end());
+    result.erase(std::unique(result.begin(), result.end()), result.end());
+    return result;
+}
+
+bool InsetOrderOptimizer::insetsIntersect(const ConstPolygonRef& poly_a, const ConstPolygonRef& poly_b) const
+{
+    // only do the full intersection when the polys' BBs overlap
+    return getBounds(poly_a).hit(getBounds(poly_b)) && poly_a.intersection(poly_b).size() > 0;
+}
+
+bool InsetOrderOptimizer::insetOutlinesAdjacent(const ConstPolygonRef& inner_poly, const ConstPolygonRef& outer_poly, const coord_t max_gap) const
+{
+    AABB inner_aabb = getBounds(inner_poly);
+    inner_aabb.max += Point(max_gap, max_gap);
+    inner_aabb.min -= Point(max_gap, max_gap);
+    return inner_aabb.hit(getBounds(outer_poly)) && PolygonUtils::polygonOutlinesAdjacent(inner_poly, outer_poly, max_gap);
+}
+
+int InsetOrderOptimizer::findAdjacentEnclosingPoly(const ConstPolygonRef& enclosed_inset, const unsigned int level, const coord_t max_gap) const
+{
+    // given an inset, search the insets of a level for the adjacent enclosing inset, which can only be one whose bounding box overlaps that of the inset
+    for (const unsigned int enclosing_poly_idx : findInsetsNear(level, getBounds(enclosed_inset)))
+    {
+        const ConstPolygonRef& enclosing = *inset_polys[level][enclosing_poly_idx];
         // as holes don't overlap, if the insets intersect, it is safe to assume that the enclosed inset is inside the enclosing inset
-        if (PolygonUtils::polygonsIntersect(enclosing, enclosed_inset) && PolygonUtils::polygonOutlinesAdjacent(enclosed_inset, enclosing, max_gap))
+        if (insetsIntersect(enclosing, enclosed_inset) && insetOutlinesAdjacent(enclosed_inset, enclosing, max_gap))
         {
             return enclosing_poly_idx;
         }
@@ -21,15 +157,34 @@ static int findAdjacentEnclosingPoly(const ConstPolygonRef& enclosed_inset, cons
     return -1;
 }
 
+void InsetOrderOptimizer::findAdjacentPolygons(std::vector<unsigned>& adjacent_poly_indices, const ConstPolygonRef& poly, const unsigned int level, const coord_t max_gap) const
+{
+    AABB near_box = getBounds(poly);
+    near_box.expand(max_gap);
+    for (const unsigned int poly_idx : findInsetsNear(level, near_box))
+    {
+        if (insetOutlinesAdjacent(poly, *inset_polys[level][poly_idx], max_gap) ||
+            insetOutlinesAdjacent(*inset_polys[level][poly_idx], poly, max_gap))
+        {
+            adjacent_poly_indices.push_back(poly_idx);
+        }
+    }
+}
+
 void InsetOrderOptimizer::moveInside()
 {
     const coord_t outer_wall_line_width = mesh_config.inset0_config.getLineWidth();
     Point p = gcode_layer.getLastPlannedPositionOrStartingPosition();
+    if (!inside_outer_wall)
+    {
+        // the same area is needed after every hole so only compute it once per part
+        inside_outer_wall = part.insets[0].offset(-outer_wall_line_width);
+    }
     // try to move p inside the outer wall by 1.1 times the outer wall line width
     if (PolygonUtils::moveInside(part.insets[0], p, outer_wall_line_width * 1.1f) != NO_INDEX)
     {
         // move to p if it is not closer than a line width from the centre line of the outer wall
-        if (part.insets[0].offset(-outer_wall_line_width).inside(p))
+        if (inside_outer_wall->inside(p))
         {
             gcode_layer.addTravel_simple(p);
             gcode_layer.forceNewPathStart();
@@ -42,7 +197,7 @@ void InsetOrderOptimizer::moveInside()
             if (PolygonUtils::moveInside(part.insets[0], p, outer_wall_line_width * 1.1f) != NO_INDEX)
             {
                 // move to p if it is not closer than a line width from the centre line of the outer wall
-                if (part.insets[0].offset(-outer_wall_line_width).inside(p))
+                if (inside_outer_wall->inside(p))
                 {
                     gcode_layer.addTravel_simple(p);
                     gcode_layer.forceNewPathStart();
@@ -85,15 +240,16 @@ void InsetOrderOptimizer::processHoleInsets()
                 const ConstPolygonRef& inner_wall = *inset_polys[inset_level][inset_idx];
                 const ConstPolygonRef& outer_wall = *inset_polys[0][inset_idx];
                 // little subtlety here, don't test first inset against inset_polys[0][0] as it will always intersect
-                bool inset_surrounds_hole = inset_idx > 0 && PolygonUtils::polygonsIntersect(inner_wall, outer_wall);
+                bool inset_surrounds_hole = inset_idx > 0 && insetsIntersect(inner_wall, outer_wall);
                 if (!inset_surrounds_hole)
                 {
-                    // the inset didn't surround the level 0 inset with the same inset_idx but maybe it surrounds another hole
-                    // start this loop at 1 not 0 as everything is surrounded by the part outline!
-                    for (unsigned hole_idx = 1; !inset_surrounds_hole && hole_idx < inset_polys[0].size(); ++hole_idx)
+                    // the inset didn't surround the level 0 inset with the same inset_idx but maybe it surrounds another hole near it
+                    // skip index 0 as everything is surrounded by the part outline!
+                    const std::vector<unsigned int> near_hole_indices = findInsetsNear(0, getBounds(inner_wall));
+                    for (unsigned int near_idx = 0; !inset_surrounds_hole && near_idx < near_hole_indices.size(); ++near_idx)
                     {
-                        const ConstPolygonRef& outer_wall = *inset_polys[0][hole_idx];
-                        inset_surrounds_hole = PolygonUtils::polygonsIntersect(inner_wall, outer_wall);
+                        const unsigned int hole_idx = near_hole_indices[near_idx];
+                        inset_surrounds_hole = hole_idx > 0 && insetsIntersect(inner_wall, *inset_polys[0][hole_idx]);
                     }
                 }
                 if (!inset_surrounds_hole)
@@ -130,14 +286,15 @@ void InsetOrderOptimizer::processHoleInsets()
     {
         // determine the location of the z-seam and use that as the start point
         PathOrderOptimizer order_optimizer(Point(), z_seam_config);
+        order_optimizer.setTravelPlanCache(gcode_layer.getTravelPlanCache());
         order_optimizer.addPolygon(*inset_polys[0][0]);
         order_optimizer.optimize();
         const unsigned outer_poly_start_idx = gcode_layer.locateFirstSupportedVertex(*inset_polys[0][0], order_optimizer.polyStart[0]);
         start_point = (*inset_polys[0][0])[outer_poly_start_idx];
     }
-    Polygons comb_boundary(*gcode_layer.getCombBoundaryInside());
-    comb_boundary.simplify(100, 100);
-    PathOrderOptimizer order_optimizer(start_point, z_seam_config, &comb_boundary);
+    CombBoundaryCache& comb_boundaries = gcode_layer.getCombBoundaries();
+    PathOrderOptimizer order_optimizer(start_point, z_seam_config, &comb_boundaries.getBoundary(CombBoundary::PATH_ORDER), comb_boundaries.getLocToLine(CombBoundary::PATH_ORDER));
+    order_optimizer.setTravelPlanCache(gcode_layer.getTravelPlanCache(), &comb_boundaries.getBoundaryHash(CombBoundary::PATH_ORDER));
     for (unsigned int poly_idx = 1; poly_idx < inset_polys[0].size(); poly_idx++)
     {
         order_optimizer.addPolygon(*inset_polys[0][poly_idx]);
@@ -148,17 +305,24 @@ void InsetOrderOptimizer::processHoleInsets()
         // reverse the optimized order so we end up as near to the outline z-seam as possible
         std::reverse(order_optimizer.polyOrder.begin(), order_optimizer.polyOrder.end());
     }
+    // the position of each outline in the order, to tell which holes are yet to be processed
+    std::vector<int> outline_order_positions(inset_polys[0].size(), -1);
+    for (unsigned int order_idx = 0; order_idx < order_optimizer.polyOrder.size(); ++order_idx)
+    {
+        outline_order_positions[order_optimizer.polyOrder[order_idx] + 1] = order_idx; // +1 because first element (part outer wall) wasn't included
+    }
 
     // this will consume all of the insets that surround holes but not the insets next to the outermost wall of the model
     for (unsigned int outer_poly_order_idx = 0; outer_poly_order_idx < order_optimizer.polyOrder.size(); ++outer_poly_order_idx)
     {
         Polygons hole_outer_wall; // the outermost wall of a hole
-        hole_outer_wall.add(*inset_polys[0][order_optimizer.polyOrder[outer_poly_order_idx] + 1]); // +1 because first element (part outer wall) wasn't included
+        const ConstPolygonRef& hole_outer_inset = *inset_polys[0][order_optimizer.polyOrder[outer_poly_order_idx] + 1]; // +1 because first element (part outer wall) wasn't included
+        hole_outer_wall.add(hole_outer_inset);
         std::vector<unsigned int> hole_level_1_wall_indices; // the indices of the walls that touch the hole's outer wall
         if (inset_polys.size() > 1)
         {
             // find the adjacent poly in the level 1 insets that encloses the hole
-            int adjacent_enclosing_poly_idx = findAdjacentEnclosingPoly(hole_outer_wall[0], inset_polys[1], max_gap);
+            int adjacent_enclosing_poly_idx = findAdjacentEnclosingPoly(hole_outer_inset, 1, max_gap);
             if (adjacent_enclosing_poly_idx >= 0)
             {
                 // now test for the case where we are printing the outer walls first and this level 1 inset also touches other outer walls
@@ -166,24 +330,30 @@ void InsetOrderOptimizer::processHoleInsets()
                 if (outer_inset_first)
                 {
                     // does the level 1 inset touch more than one outline?
-                    Polygons inset;
-                    inset.add(*inset_polys[1][adjacent_enclosing_poly_idx]);
+                    const ConstPolygonRef& inset = *inset_polys[1][adjacent_enclosing_poly_idx];
                     int num_future_outlines_touched = 0; // number of outlines that have yet to be output that are touched by this level 1 inset
                     // does it touch the outer wall?
-                    if (PolygonUtils::polygonOutlinesAdjacent(inset[0], *inset_polys[0][0], max_gap))
+                    if (insetOutlinesAdjacent(inset, *inset_polys[0][0], max_gap))
                     {
                         // yes, the level 1 inset touches the part's outer wall
                         ++num_future_outlines_touched;
                     }
-                    // does it touch any yet to be processed hole outlines?
-                    for (unsigned int order_index = outer_poly_order_idx + 1; num_future_outlines_touched < 1 && order_index < order_optimizer.polyOrder.size(); ++order_index)
+                    // does it touch any yet to be processed hole outlines? only those near the level 1 inset can
+                    AABB near_box = getBounds(inset);
+                    near_box.expand(max_gap);
+                    const std::vector<unsigned int> near_outline_indices = (num_future_outlines_touched < 1) ? findInsetsNear(0, near_box) : std::vector<unsigned int>();
+                    for (unsigned int near_idx = 0; num_future_outlines_touched < 1 && near_idx < near_outline_indices.size(); ++near_idx)
                     {
-                        int outline_index = order_optimizer.polyOrder[order_index] + 1; // +1 because first element (part outer wall) wasn't included
+                        const unsigned int outline_index = near_outline_indices[near_idx];
+                        if (outline_order_positions[outline_index] <= static_cast<int>(outer_poly_order_idx))
+                        {
+                            continue; // the part's outer wall or an outline that has already been processed
+                        }
                         // as we don't know the shape of the outlines (straight, concave, convex, etc.) and the
                         // adjacency test assumes that the poly's are arranged so that the first has smaller
                         // radius curves than the second (it's "inside" the second) we need to test both combinations
-                        if (PolygonUtils::polygonOutlinesAdjacent(inset[0], *inset_polys[0][outline_index], max_gap) ||
-                            PolygonUtils::polygonOutlinesAdjacent(*inset_polys[0][outline_index], inset[0], max_gap))
+                        if (insetOutlinesAdjacent(inset, *inset_polys[0][outline_index], max_gap) ||
+                            insetOutlinesAdjacent(*inset_polys[0][outline_index], inset, max_gap))
                         {
                             // yes, it touches this yet to be processed hole outline
                             ++num_future_outlines_touched;
@@ -206,7 +376,7 @@ void InsetOrderOptimizer::processHoleInsets()
                 // we didn't find a level 1 inset that encloses this hole so now look to see if there is one or more level 1 insets that simply touch
                 // this hole and use those instead - however, as the level 1 insets will also touch other holes and/or the outer wall we don't want
                 // to do this when printing the outer walls first
-                PolygonUtils::findAdjacentPolygons(hole_level_1_wall_indices, hole_outer_wall[0], inset_polys[1], max_gap);
+                findAdjacentPolygons(hole_level_1_wall_indices, hole_outer_inset, 1, max_gap);
             }
         }
 
@@ -233,7 +403,7 @@ void InsetOrderOptimizer::processHoleInsets()
             // now find all the insets that immediately surround the level 1 wall and consume them
             for (unsigned int inset_level = 2; inset_level < num_insets && inset_polys[inset_level].size(); ++inset_level)
             {
-                int i = findAdjacentEnclosingPoly(ConstPolygonRef(*last_inset), inset_polys[inset_level], wall_line_width_x * 1.1f);
+                int i = findAdjacentEnclosingPoly(ConstPolygonRef(*last_inset), inset_level, wall_line_width_x * 1.1f);
                 if (i >= 0)
                 {
                     // we have found an enclosing inset
@@ -244,10 +414,14 @@ void InsetOrderOptimizer::processHoleInsets()
                         // that haven't yet been processed to see if they are also enclosed by this enclosing inset
                         const ConstPolygonRef& enclosing_inset = *inset_polys[inset_level][i];
                         bool encloses_future_hole = false; // set true if this inset also encloses another hole that hasn't yet been processed
-                        for (unsigned int hole_order_index = outer_poly_order_idx + 1; !encloses_future_hole && hole_order_index < order_optimizer.polyOrder.size(); ++hole_order_index)
+                        const std::vector<unsigned int> near_outline_indices = findInsetsNear(0, getBounds(enclosing_inset)); // only holes near the inset can be enclosed by it
+                        for (unsigned int near_idx = 0; !encloses_future_hole && near_idx < near_outline_indices.size(); ++near_idx)
                         {
-                            const ConstPolygonRef& enclosed_inset = *inset_polys[0][order_optimizer.polyOrder[hole_order_index] + 1]; // +1 because first element (part outer wall) wasn't included
-                            encloses_future_hole = PolygonUtils::polygonsIntersect(enclosing_inset, enclosed_inset);
+                            const unsigned int outline_index = near_outline_indices[near_idx];
+                            if (outline_order_positions[outline_index] > static_cast<int>(outer_poly_order_idx))
+                            {
+                                encloses_future_hole = insetsIntersect(enclosing_inset, *inset_polys[0][outline_index]);
+                            }
                         }
                         if (encloses_future_hole)
                         {
@@ -288,7 +462,7 @@ void InsetOrderOptimizer::processHoleInsets()
 
                 // detect special case where where the z-seam is located on the sharpest corner and there is only 1 hole and
                 // the gap between the walls is just a few line widths
-                if (z_seam_config.type == EZSeamType::SHARPEST_CORNER && inset_polys[0].size() == 2 && PolygonUtils::polygonOutlinesAdjacent(*inset_polys[0][1], *inset_polys[0][0], max_gap * 4))
+                if (z_seam_config.type == EZSeamType::SHARPEST_CORNER && inset_polys[0].size() == 2 && insetOutlinesAdjacent(*inset_polys[0][1], *inset_polys[0][0], max_gap * 4))
                 {
                     // align z-seam of hole with z-seam of outer wall - makes a nicer job when printing tubes
                     outer_poly_start_idx = PolygonUtils::findNearestVert(start_point, hole_outer_wall.back());
@@ -316,7 +490,7 @@ void InsetOrderOptimizer::processHoleInsets()
 
             // detect special case where where the z-seam is located on the sharpest corner and there is only 1 hole and
             // the gap between the walls is just a few line widths
-            if (z_seam_config.type == EZSeamType::SHARPEST_CORNER && inset_polys[0].size() == 2 && PolygonUtils::polygonOutlinesAdjacent(*inset_polys[0][1], *inset_polys[0][0], max_gap * 2))
+            if (z_seam_config.type == EZSeamType::SHARPEST_CORNER && inset_polys[0].size() == 2 && insetOutlinesAdjacent(*inset_polys[0][1], *inset_polys[0][0], max_gap * 2))
             {
                 // align z-seam of hole with z-seam of outer wall - makes a nicer job when printing tubes
                 const unsigned point_idx = PolygonUtils::findNearestVert(start_point, hole_outer_wall.back());
@@ -355,7 +529,7 @@ void InsetOrderOptimizer::processOuterWallInsets(const bool include_outer, const
         for (unsigned int level_1_wall_idx = 0; inset_polys.size() > 1 && level_1_wall_idx < inset_polys[1].size(); ++level_1_wall_idx)
         {
             ConstPolygonRef inner = *inset_polys[1][level_1_wall_idx];
-            if (PolygonUtils::polygonsIntersect(inner, outer_wall))
+            if (insetsIntersect(inner, outer_wall))
             {
                 ++num_level_1_insets;
                 part_inner_walls.add(inner);
@@ -364,27 +538,42 @@ void InsetOrderOptimizer::processOuterWallInsets(const bool include_outer, const
                 --level_1_wall_idx; // we've shortened the vector so decrement the index otherwise, we'll skip an element
 
                 // now find all the insets that immediately fill the level 1 inset and consume them also
-                Polygons enclosing_insets; // the set of insets that we are trying to "fill in"
-                enclosing_insets.add(inner);
-                Polygons next_level_enclosing_insets;
+                std::vector<ConstPolygonPointer> enclosing_insets; // the set of insets that we are trying to "fill in"
+                enclosing_insets.push_back(inner);
+                std::vector<ConstPolygonPointer> next_level_enclosing_insets;
                 for (unsigned int inset_level = 2; inset_level < num_insets && inset_polys[inset_level].size(); ++inset_level)
                 {
-                    // test the level N insets to see if they are adjacent to any of the level N-1 insets
-                    for (unsigned int level_n_wall_idx = 0; level_n_wall_idx < inset_polys[inset_level].size(); ++level_n_wall_idx)
+                    // test the level N insets to see if they are adjacent to any of the level N-1 insets, which only those near a level N-1 inset can be
+                    std::vector<unsigned int> near_level_n_wall_indices;
+                    for (ConstPolygonPointer enclosing_inset : enclosing_insets)
                     {
-                        for (ConstPolygonRef enclosing_inset : enclosing_insets)
+                        AABB near_box = getBounds(*enclosing_inset);
+                        near_box.expand(wall_line_width_x * 1.1f);
+                        const std::vector<unsigned int> near_indices = findInsetsNear(inset_level, near_box);
+                        near_level_n_wall_indices.insert(near_level_n_wall_indices.end(), near_indices.begin(), near_indices.end());
+                    }
+                    std::sort(near_level_n_wall_indices.begin(), near_level_n_wall_indices.end());
+                    near_level_n_wall_indices.erase(std::unique(near_level_n_wall_indices.begin(), near_level_n_wall_indices.end()), near_level_n_wall_indices.end());
+                    std::vector<unsigned int> consumed_level_n_wall_indices;
+                    for (const unsigned int level_n_wall_idx : near_level_n_wall_indices)
+                    {
+                        for (ConstPolygonPointer enclosing_inset : enclosing_insets)
                         {
                             ConstPolygonRef level_n_inset = *inset_polys[inset_level][level_n_wall_idx];
-                            if (PolygonUtils::polygonOutlinesAdjacent(level_n_inset, enclosing_inset, wall_line_width_x * 1.1f))
+                            if (insetOutlinesAdjacent(level_n_inset, *enclosing_inset, wall_line_width_x * 1.1f))
                             {
-                                next_level_enclosing_insets.add(level_n_inset);
+                                next_level_enclosing_insets.push_back(level_n_inset);
                                 part_inner_walls.add(level_n_inset);
-                                inset_polys[inset_level].erase(inset_polys[inset_level].begin() + level_n_wall_idx);
-                                --level_n_wall_idx; // we've shortened the vector so decrement the index otherwise, we'll skip an element
+                                consumed_level_n_wall_indices.push_back(level_n_wall_idx);
                                 break;
                             }
                         }
                     }
+                    // consume the level N insets from the back, so that the indices of the others stay valid
+                    for (std::vector<unsigned int>::const_reverse_iterator consumed = consumed_level_n_wall_indices.rbegin(); consumed != consumed_level_n_wall_indices.rend(); ++consumed)
+                    {
+                        inset_polys[inset_level].erase(inset_polys[inset_level].begin() + *consumed);
+                    }
                     enclosing_insets = next_level_enclosing_insets;
                     next_level_enclosing_insets.clear();
                 }
@@ -398,6 +587,7 @@ void InsetOrderOptimizer::processOuterWallInsets(const bool include_outer, const
         gcode_layer.setIsInside(true); // going to print stuff inside print object
         // determine the location of the z seam
         PathOrderOptimizer order_optimizer(gcode_layer.getLastPlannedPositionOrStartingPosition(), z_seam_config);
+        order_optimizer.setTravelPlanCache(gcode_layer.getTravelPlanCache());
         order_optimizer.addPolygon(*inset_polys[0][0]);
         order_optimizer.optimize();
         const unsigned outer_poly_start_idx = gcode_layer.locateFirstSupportedVertex(*inset_polys[0][0], order_optimizer.polyStart[0]);
@@ -518,6 +708,17 @@ bool InsetOrderOptimizer::processInsetsWithOptimizedOrdering()
         }
     }
 
+    // compute the bounding boxes of all the insets up front, the ordering below repeatedly tests each hole against the other insets
+    inset_bounds.clear();
+    for (const std::vector<ConstPolygonPointer>& level_polys : inset_polys)
+    {
+        for (const ConstPolygonPointer& poly : level_polys)
+        {
+            inset_bounds.emplace(&**poly, AABB(*poly));
+        }
+    }
+    createInsetGrids();
+
     // if the print has thin walls due to the distance from a hole to the outer wall being smaller than a line width, it will produce a nicer finish on
     // the outer wall if it is printed before the holes because the outer wall does not get flow reduced but the hole walls will get flow reduced where
     // they are close to the outer wall. However, we only want to do this if the level 0 insets are being printed before the higher level insets.
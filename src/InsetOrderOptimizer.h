@@ -1,7 +1,11 @@
 #ifndef INSET_ORDER_OPTIMIZER_H
 #define INSET_ORDER_OPTIMIZER_H
 
+#include <unordered_map>
+
 #include "FffGcodeWriter.h"
+#include "utils/AABB.h"
+#include "utils/optional.h"
 
 namespace cura 
 {
@@ -50,6 +54,79 @@ private:
     WallOverlapComputation* wall_overlapper_0;
     WallOverlapComputation* wall_overlapper_x;
     std::vector<std::vector<ConstPolygonPointer>> inset_polys; // vector of vectors holding the inset polygons
+    std::unordered_map<const ClipperLib::Path*, AABB> inset_bounds; //!< The bounding box of each of the \ref inset_polys, computed once so that insets which are far apart can be skipped cheaply
+    std::unordered_map<const ClipperLib::Path*, unsigned int> inset_indices; //!< The index of each of the \ref inset_polys within its level before any were consumed, the insets that remain keep this order
+    std::vector<coord_t> inset_grid_cell_sizes; //!< For each level of the \ref inset_polys, the size of the cells of its grid in \ref inset_grids
+    std::vector<std::unordered_multimap<Point, const ClipperLib::Path*>> inset_grids; //!< For each level of the \ref inset_polys, the insets whose bounding box overlaps each grid cell, so that only the insets near an inset need to be tested
+    std::vector<std::vector<const ClipperLib::Path*>> large_insets; //!< For each level of the \ref inset_polys, the insets which would cover too many cells of its grid, which are always tested
+    std::optional<Polygons> inside_outer_wall; //!< The area further than a line width inside the part's outer walls, used by \ref moveInside (computed on first use)
+
+    /*!
+     * Get the bounding box of an inset, using the precomputed bounding boxes
+     * of the \ref inset_polys where possible.
+     * \param inset The inset polygon.
+     * \return The bounding box of the inset.
+     */
+    AABB getBounds(const ConstPolygonRef& inset) const;
+
+    /*!
+     * Put the \ref inset_polys of each level in a grid by their bounding
+     * boxes, to be looked up with \ref findInsetsNear.
+     */
+    void createInsetGrids();
+
+    /*!
+     * Find the insets of a level whose bounding boxes overlap a box.
+     *
+     * Only the insets which haven't been consumed yet are found.
+     * \param level The level of the insets, i.e. the index in \ref inset_polys.
+     * \param box The box to look in.
+     * \return The indices of the insets in the level, in increasing order.
+     */
+    std::vector<unsigned int> findInsetsNear(const unsigned int level, const AABB& box) const;
+
+    /*!
+     * Test whether two insets intersect.
+     *
+     * This gives the same result as PolygonUtils::polygonsIntersect but
+     * doesn't need to recompute the bounding boxes of the insets.
+     * \param poly_a The first inset.
+     * \param poly_b The second inset.
+     * \return true if the insets intersect.
+     */
+    bool insetsIntersect(const ConstPolygonRef& poly_a, const ConstPolygonRef& poly_b) const;
+
+    /*!
+     * Test whether the outlines of two insets are adjacent.
+     *
+     * This gives the same result as PolygonUtils::polygonOutlinesAdjacent but
+     * only looks at the vertices of insets whose bounding boxes are near.
+     * \param inner_poly The inset with the smaller radius curves.
+     * \param outer_poly The other inset.
+     * \param max_gap Insets which are closer than this are considered to be adjacent.
+     * \return true if the outlines of the insets are adjacent.
+     */
+    bool insetOutlinesAdjacent(const ConstPolygonRef& inner_poly, const ConstPolygonRef& outer_poly, const coord_t max_gap) const;
+
+    /*!
+     * Given an inset, search the insets of a level for the adjacent inset
+     * enclosing it.
+     * \param enclosed_inset The inset to find the enclosing inset for.
+     * \param level The level of the insets to search, i.e. the index in \ref inset_polys.
+     * \param max_gap Insets which are closer than this are considered to be adjacent.
+     * \return The index of the enclosing inset in the level or -1 if there is none.
+     */
+    int findAdjacentEnclosingPoly(const ConstPolygonRef& enclosed_inset, const unsigned int level, const coord_t max_gap) const;
+
+    /*!
+     * Find the indices of the insets of a level which are adjacent to a given
+     * inset.
+     * \param[out] adjacent_poly_indices The indices of the adjacent insets in the level are appended to this.
+     * \param poly The inset to find the adjacent insets of.
+     * \param level The level of the insets to search, i.e. the index in \ref inset_polys.
+     * \param max_gap Insets which are closer than this are considered to be adjacent.
+     */
+    void findAdjacentPolygons(std::vector<unsigned>& adjacent_poly_indices, const ConstPolygonRef& poly, const unsigned int level, const coord_t max_gap) const;
 
     /*!
      * Generate the insets for the holes of a given layer part after optimizing the ordering.
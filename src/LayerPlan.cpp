@@ -10,6 +10,7 @@
 #include "raft.h" // getTotalExtraLayers
 #include "sliceDataStorage.h"
 #include "communication/Communication.h"
+#include "settings/types/Duration.h"
 #include "settings/types/Ratio.h"
 #include "utils/polygonUtils.h"
 
@@ -72,7 +73,7 @@ void LayerPlan::forceNewPathStart()
         paths[paths.size()-1].done = true;
 }
 
-LayerPlan::LayerPlan(const SliceDataStorage& storage, LayerIndex layer_nr, coord_t z, coord_t layer_thickness, size_t start_extruder, const std::vector<FanSpeedLayerTimeSettings>& fan_speed_layer_time_settings_per_extruder, coord_t comb_boundary_offset, coord_t comb_move_inside_distance, coord_t travel_avoid_distance)
+LayerPlan::LayerPlan(const SliceDataStorage& storage, LayerIndex layer_nr, coord_t z, coord_t layer_thickness, size_t start_extruder, const std::vector<FanSpeedLayerTimeSettings>& fan_speed_layer_time_settings_per_extruder, coord_t comb_boundary_offset, coord_t comb_move_inside_distance, coord_t travel_avoid_distance, TravelPlanCache* travel_plan_cache)
 : storage(storage)
 , configs_storage(storage, layer_nr, layer_thickness)
 , z(z)
@@ -86,8 +87,8 @@ LayerPlan::LayerPlan(const SliceDataStorage& storage, LayerIndex layer_nr, coord
 , last_extruder_previous_layer(start_extruder)
 , last_planned_extruder(&Application::getInstance().current_slice->scene.extruders[start_extruder])
 , first_travel_destination_is_inside(false) // set properly when addTravel is called for the first time (otherwise not set properly)
-, comb_boundary_inside1(computeCombBoundaryInside(1))
-, comb_boundary_inside2(computeCombBoundaryInside(2))
+, comb_boundaries(storage, layer_nr, comb_boundary_offset, travel_avoid_distance)
+, travel_plan_cache(travel_plan_cache)
 , comb_move_inside_distance(comb_move_inside_distance)
 , fan_speed_layer_time_settings_per_extruder(fan_speed_layer_time_settings_per_extruder)
 {
@@ -96,7 +97,7 @@ LayerPlan::LayerPlan(const SliceDataStorage& storage, LayerIndex layer_nr, coord
     is_inside = false; // assumes the next move will not be to inside a layer part (overwritten just before going into a layer part)
     if (Application::getInstance().current_slice->scene.current_mesh_group->settings.get<CombingMode>("retraction_combing") != CombingMode::OFF)
     {
-        comb = new Comb(storage, layer_nr, comb_boundary_inside1, comb_boundary_inside2, comb_boundary_offset, travel_avoid_distance, comb_move_inside_distance);
+        comb = new Comb(storage, layer_nr, comb_boundaries, comb_boundary_offset, travel_avoid_distance, comb_move_inside_distance, travel_plan_cache);
     }
     else
     {
@@ -113,6 +114,13 @@ LayerPlan::LayerPlan(const SliceDataStorage& storage, LayerIndex layer_nr, coord
     { //Skirt and brim.
         skirt_brim_is_processed[extruder_nr] = false;
     }
+
+    const Settings& mesh_group_settings = Application::getInstance().current_slice->scene.current_mesh_group->settings;
+    order_refinement_time_left = 0.0;
+    if (mesh_group_settings.get<bool>("travel_order_refinement_enabled", false))
+    {
+        order_refinement_time_left = mesh_group_settings.get<Duration>("travel_order_refinement_max_time", Duration(0.05));
+    }
 }
 
 LayerPlan::~LayerPlan()
@@ -126,117 +134,33 @@ ExtruderTrain* LayerPlan::getLastPlannedExtruderTrain()
     return last_planned_extruder;
 }
 
-
-Polygons LayerPlan::computeCombBoundaryInside(const size_t max_inset)
+const BridgeSupport& LayerPlan::getBridgeSupport(const unsigned layer_nr, const SupportLayer* support_layer)
 {
-    const CombingMode combing_mode = Application::getInstance().current_slice->scene.current_mesh_group->settings.get<CombingMode>("retraction_combing");
-    if (combing_mode == CombingMode::OFF)
+    for (const BridgeSupport& bridge_support : bridge_supports)
     {
-        return Polygons();
-    }
-    if (layer_nr < 0)
-    { // when a raft is present
-        if (combing_mode == CombingMode::NO_SKIN)
+        if (bridge_support.layer_nr == layer_nr && bridge_support.support_layer == support_layer)
         {
-            return Polygons();
-        }
-        else
-        {
-            return storage.raftOutline.offset(MM2INT(0.1));
+            return bridge_support;
         }
     }
-    else 
-    {
-        Polygons comb_boundary;
-        for (const SliceMeshStorage& mesh : storage.meshes)
-        {
-            const SliceLayer& layer = mesh.layers[layer_nr];
-            if (mesh.settings.get<bool>("infill_mesh")) {
-                continue;
-            }
-            const CombingMode combing_mode = mesh.settings.get<CombingMode>("retraction_combing");
-            if (combing_mode == CombingMode::NO_SKIN)
-            {
-                // we need to include the walls in the comb boundary otherwise it's not possible to tell if a travel move crosses a skin region
-
-                const coord_t line_width_0 = mesh.settings.get<coord_t>("wall_line_width_0");
-
-                for (const SliceLayerPart& part : layer.parts)
-                {
-                    const size_t num_insets = part.insets.size();
-                    Polygons outer = part.outline; // outer boundary of wall combing region
-                    coord_t outer_to_outline_dist = 0; // distance from outer to the part's outline
-
-                    if (num_insets > 1 && part.insets[1].size() == part.outline.size())
-                    {
-                        // part's wall has multiple lines and the 2nd wall line is complete
-                        // set the outer boundary to the inside edge of the outer wall
-
-                        outer = part.insets[0].offset(-line_width_0/2);
-                        outer_to_outline_dist = line_width_0;
-                    }
-                    else if (num_insets > 0)
-                    {
-                        // set the outer boundary to be 1/4 line width inside the centre line of the outer wall
-
-                        outer = part.insets[0].offset(-line_width_0/4);
-                        outer_to_outline_dist = line_width_0*3/4;
-                    }
-
-                    // finally, check that outer actually has the same number of polygons as the part's outline
-                    // if it doesn't it means that the outer wall is missing where the part narrows so in those
-                    // regions we need to use the part outline for the outer boundary of the combing region
-                    // (expect poor results due to the nozzle being allowed to go right to the part's edge)
-
-                    if (outer.size() != part.outline.size())
-                    {
-                        // first we calculate the part outline for those portions of the part where outer is missing
-                        // this is done by shrinking the part outline so that it is very slightly smaller than outer, then expanding it again so it is very
-                        // slightly larger than its original size and subtracting that from the original part outline
-                        // NOTE - the additional small shrink/expands are required to ensure that the polygons overlap a little so we do not rely on exact results
-
-                        Polygons outline_where_outer_is_missing(part.outline.difference(part.outline.offset(-(outer_to_outline_dist+5)).offset(outer_to_outline_dist+10)));
-
-                        // merge outer with the portions of the part outline we just calculated
-                        // the trick here is to expand the outlines sufficiently so that they overlap when unioned and then the result is shrunk back to the correct size
-
-                        outer = outer.offset(outer_to_outline_dist/2+10).unionPolygons(outline_where_outer_is_missing.offset(outer_to_outline_dist/2+10)).offset(-(outer_to_outline_dist/2+10));
-                    }
-
-                    Polygons inner; // inner boundary of wall combing region
+    bridge_supports.emplace_back(storage, layer_nr, support_layer);
+    return bridge_supports.back();
+}
 
-                    // the inside of the wall combing region is just inside the wall's inner edge so it can meet up with the infill (if any)
 
-                    if (num_insets == 0)
-                    {
-                        inner = part.outline.offset(-10);
-                    }
-                    else if (num_insets == 1)
-                    {
-                        inner = part.insets[0].offset(-10-line_width_0/2);
-                    }
-                    else if(num_insets > 1)
-                    {
-                        inner = part.insets[num_insets - 1].offset(-10 - mesh.settings.get<coord_t>("wall_line_width_x") / 2);
-                    }
+void LayerPlan::refineOrder(PathOrderOptimizer& order_optimizer)
+{
+    if (order_refinement_time_left > 0)
+    {
+        order_optimizer.refine(order_refinement_time_left);
+    }
+}
 
-                    // combine the wall combing region (outer - inner) with the infill (if any)
-                    comb_boundary.add(part.infill_area.unionPolygons(outer.difference(inner)));
-                }
-            }
-            else if (combing_mode == CombingMode::INFILL)
-            {
-                for (const SliceLayerPart& part : layer.parts)
-                {
-                    comb_boundary.add(part.infill_area);
-                }
-            }
-            else
-            {
-                comb_boundary.add(layer.getInnermostWalls(max_inset, mesh));
-            }
-        }
-        return comb_boundary;
+void LayerPlan::refineOrder(LineOrderOptimizer& order_optimizer, const Polygons& travel_boundary)
+{
+    if (order_refinement_time_left > 0)
+    {
+        order_optimizer.refine(order_refinement_time_left, &travel_boundary);
     }
 }
 
@@ -311,11 +235,12 @@ void LayerPlan::moveInsideCombBoundary(const coord_t distance)
     constexpr coord_t max_dist2 = MM2INT(2.0) * MM2INT(2.0); // if we are further than this distance, we conclude we are not inside even though we thought we were.
     // this function is to be used to move from the boudary of a part to inside the part
     Point p = getLastPlannedPositionOrStartingPosition(); // copy, since we are going to move p
-    if (PolygonUtils::moveInside(comb_boundary_inside2, p, distance, max_dist2) != NO_INDEX)
+    const Polygons& comb_boundary_inside = comb_boundaries.getBoundary(CombBoundary::OPTIMAL);
+    if (PolygonUtils::moveInside(comb_boundary_inside, p, distance, max_dist2) != NO_INDEX)
     {
         //Move inside again, so we move out of tight 90deg corners
-        PolygonUtils::moveInside(comb_boundary_inside2, p, distance, max_dist2);
-        if (comb_boundary_inside2.inside(p))
+        PolygonUtils::moveInside(comb_boundary_inside, p, distance, max_dist2);
+        if (comb_boundary_inside.inside(p))
         {
             addTravel_simple(p);
             //Make sure the that any retraction happens after this move, not before it by starting a new move path.
@@ -552,11 +477,13 @@ void LayerPlan::addPolygonsByOptimizer(const Polygons& polygons, const GCodePath
         return;
     }
     PathOrderOptimizer orderOptimizer(getLastPlannedPositionOrStartingPosition(), z_seam_config);
+    orderOptimizer.setTravelPlanCache(travel_plan_cache);
     for (unsigned int poly_idx = 0; poly_idx < polygons.size(); poly_idx++)
     {
         orderOptimizer.addPolygon(polygons[poly_idx]);
     }
     orderOptimizer.optimize();
+    refineOrder(orderOptimizer);
     
     if(reverse_order == false)
     {
@@ -940,11 +867,13 @@ void LayerPlan::addWall(ConstPolygonRef wall, int start_idx, const SliceMeshStor
 void LayerPlan::addWalls(const Polygons& walls, const SliceMeshStorage& mesh, const GCodePathConfig& non_bridge_config, const GCodePathConfig& bridge_config, WallOverlapComputation* wall_overlap_computation, const ZSeamConfig& z_seam_config, coord_t wall_0_wipe_dist, float flow_ratio, bool always_retract)
 {
     PathOrderOptimizer orderOptimizer(getLastPlannedPositionOrStartingPosition(), z_seam_config);
+    orderOptimizer.setTravelPlanCache(travel_plan_cache);
     for (unsigned int poly_idx = 0; poly_idx < walls.size(); poly_idx++)
     {
         orderOptimizer.addPolygon(walls[poly_idx]);
     }
     orderOptimizer.optimize();
+    refineOrder(orderOptimizer);
     for (unsigned int poly_idx : orderOptimizer.polyOrder)
     {
         addWall(walls[poly_idx], orderOptimizer.polyStart[poly_idx], mesh, non_bridge_config, bridge_config, wall_overlap_computation, wall_0_wipe_dist, flow_ratio, always_retract);
@@ -986,34 +915,17 @@ unsigned LayerPlan::locateFirstSupportedVertex(ConstPolygonRef wall, const unsig
 
 void LayerPlan::addLinesByOptimizer(const Polygons& polygons, const GCodePathConfig& config, SpaceFillType space_fill_type, bool enable_travel_optimization, int wipe_dist, float flow_ratio, std::optional<Point> near_start_location, double fan_speed)
 {
-    Polygons boundary;
-    if (enable_travel_optimization && comb_boundary_inside2.size() > 0)
-    {
-        // use the combing boundary inflated so that all infill lines are inside the boundary
-        int dist = 0;
-        if (layer_nr >= 0)
-        {
-            // determine how much the skin/infill lines overlap the combing boundary
-            for (const SliceMeshStorage& mesh : storage.meshes)
-            {
-                const coord_t overlap = std::max(mesh.settings.get<coord_t>("skin_overlap_mm"), mesh.settings.get<coord_t>("infill_overlap_mm"));
-                if (overlap > dist)
-                {
-                    dist = overlap;
-                }
-            }
-            dist += 100; // ensure boundary is slightly outside all skin/infill lines
-        }
-        boundary.add(comb_boundary_inside2.offset(dist));
-        // simplify boundary to cut down processing time
-        boundary.simplify(100, 100);
-    }
-    LineOrderOptimizer orderOptimizer(near_start_location.value_or(getLastPlannedPositionOrStartingPosition()), &boundary);
+    const Polygons no_boundary;
+    const Polygons& boundary = (enable_travel_optimization || order_refinement_time_left > 0) ? comb_boundaries.getBoundary(CombBoundary::LINE_ORDER) : no_boundary;
+    LocToLineGrid* loc_to_line = (enable_travel_optimization && boundary.size() > 0) ? comb_boundaries.getLocToLine(CombBoundary::LINE_ORDER) : nullptr;
+    LineOrderOptimizer orderOptimizer(near_start_location.value_or(getLastPlannedPositionOrStartingPosition()), enable_travel_optimization ? &boundary : nullptr, loc_to_line, &line_order_combing_distances);
+    orderOptimizer.setTravelPlanCache(travel_plan_cache, enable_travel_optimization ? &comb_boundaries.getBoundaryHash(CombBoundary::LINE_ORDER) : nullptr);
     for (unsigned int line_idx = 0; line_idx < polygons.size(); line_idx++)
     {
         orderOptimizer.addPolygon(polygons[line_idx]);
     }
     orderOptimizer.optimize();
+    refineOrder(orderOptimizer, boundary);
 
     for (unsigned int order_idx = 0; order_idx < orderOptimizer.polyOrder.size(); order_idx++)
     {
@@ -1494,9 +1406,19 @@ void LayerPlan::writeGCode(GCodeExport& gcode)
                 }
                 if (!coasting) // not same as 'else', cause we might have changed [coasting] in the line above...
                 { // normal path to gcode algorithm
+                    std::vector<PathArc>::const_iterator arc = path.arcs.begin();
                     for(unsigned int point_idx = 0; point_idx < path.points.size(); point_idx++)
                     {
                         communication->sendLineTo(path.config->type, path.points[point_idx], path.getLineWidthForLayerView(), path.config->getLayerThickness(), speed);
+                        if (arc != path.arcs.end() && point_idx > arc->start_idx)
+                        { // the points within an arc are written as a single arc move at its end
+                            if (point_idx == arc->end_idx)
+                            {
+                                gcode.writeArc(path.points[point_idx], arc->center, arc->clockwise, speed, path.getExtrusionMM3perMM(), path.config->type, update_extrusion_offset);
+                                ++arc;
+                            }
+                            continue;
+                        }
                         gcode.writeExtrusion(path.points[point_idx], speed, path.getExtrusionMM3perMM(), path.config->type, update_extrusion_offset);
                     }
                 }
@@ -1730,6 +1652,38 @@ void LayerPlan::optimizePaths(const Point& starting_position)
         MergeInfillLines merger(extr_plan);
         merger.mergeInfillLines(extr_plan.paths, starting_position);
     }
+
+    const Settings& mesh_group_settings = Application::getInstance().current_slice->scene.current_mesh_group->settings;
+    if (mesh_group_settings.get<bool>("arc_fitting_enabled", false) && mesh_group_settings.get<EGCodeFlavor>("machine_gcode_flavor") != EGCodeFlavor::BFB)
+    {
+        //Write runs of points on a curve as arcs.
+        const ArcFitter arc_fitter(mesh_group_settings.get<coord_t>("arc_fitting_max_deviation", MM2INT(0.025)));
+        for (ExtruderPlan& extr_plan : extruder_plans)
+        {
+            for (GCodePath& path : extr_plan.paths)
+            {
+                if (!path.isTravelPath() && !path.spiralize)
+                {
+                    path.arcs = arc_fitter.fit(path.points);
+                }
+            }
+        }
+    }
+}
+
+size_t LayerPlan::getMemoryUsage() const
+{
+    size_t result = sizeof(LayerPlan) + comb_boundaries.getMemoryUsage();
+    result += (bridge_wall_mask.pointCount() + overhang_mask.pointCount()) * sizeof(Point);
+    for (const ExtruderPlan& extruder_plan : extruder_plans)
+    {
+        result += sizeof(ExtruderPlan) + extruder_plan.paths.capacity() * sizeof(GCodePath);
+        for (const GCodePath& path : extruder_plan.paths)
+        {
+            result += path.points.capacity() * sizeof(Point) + path.arcs.capacity() * sizeof(PathArc);
+        }
+    }
+    return result;
 }
 
 }//namespace cura
@@ -4,8 +4,10 @@
 #ifndef LAYER_PLAN_H
 #define LAYER_PLAN_H
 
+#include <deque>
 #include <vector>
 
+#include "bridge.h"
 #include "FanSpeedLayerTime.h"
 #include "gcodeExport.h"
 #include "GCodePathConfig.h"
@@ -13,9 +15,11 @@
 #include "SpaceFillType.h"
 #include "wallOverlap.h"
 #include "pathPlanning/Comb.h"
+#include "pathPlanning/CombBoundaryCache.h"
 #include "pathPlanning/GCodePath.h"
 #include "pathPlanning/NozzleTempInsert.h"
 #include "pathPlanning/TimeMaterialEstimates.h"
+#include "pathPlanning/TravelPlanCache.h"
 #include "settings/PathConfigStorage.h"
 #include "settings/types/LayerIndex.h"
 #include "utils/logoutput.h"
@@ -269,15 +273,20 @@ private:
     bool first_travel_destination_is_inside; //!< Whether the destination of the first planned travel move is inside a layer part
     bool was_inside; //!< Whether the last planned (extrusion) move was inside a layer part
     bool is_inside; //!< Whether the destination of the next planned travel move is inside a layer part
-    Polygons comb_boundary_inside1; //!< The minimum boundary within which to comb, or to move into when performing a retraction.
-    Polygons comb_boundary_inside2; //!< The boundary preferably within which to comb, or to move into when performing a retraction.
+    CombBoundaryCache comb_boundaries; //!< The boundaries within which to comb, or to move into when performing a retraction, shared by the combing and the order optimizers of this layer.
+    TravelPlanCache* travel_plan_cache; //!< Orders and combing paths found for earlier layers, reused when this layer has the same geometry (or nullptr)
     Comb* comb;
     coord_t comb_move_inside_distance;  //!< Whenever using the minimum boundary for combing it tries to move the coordinates inside by this distance after calculating the combing.
     Polygons bridge_wall_mask; //!< The regions of a layer part that are not supported, used for bridging
     Polygons overhang_mask; //!< The regions of a layer part where the walls overhang
+    std::deque<BridgeSupport> bridge_supports; //!< The areas of the layers below which bridges in this layer could rest on, computed when first needed
 
     const std::vector<FanSpeedLayerTimeSettings> fan_speed_layer_time_settings_per_extruder;
 
+    double order_refinement_time_left; //!< The time in seconds which may still be spent on refining the order of parts and lines in this layer, see LayerPlan::refineOrder
+
+    CombingDistanceCache line_order_combing_distances; //!< The combed distances within the CombBoundary::LINE_ORDER boundary computed by all line orders of this layer
+
 private:
     /*!
      * Either create a new path with the given config or return the last path if it already had that config.
@@ -319,8 +328,11 @@ public:
      * while combing.
      * \param travel_avoid_distance The distance by which to avoid other layer
      * parts when travelling through air.
+     * \param travel_plan_cache Orders and combing paths found for earlier
+     * layers, to be reused when this layer has the same geometry, or nullptr
+     * to compute everything for this layer.
      */
-    LayerPlan(const SliceDataStorage& storage, LayerIndex layer_nr, coord_t z, coord_t layer_height, size_t start_extruder, const std::vector<FanSpeedLayerTimeSettings>& fan_speed_layer_time_settings_per_extruder, coord_t comb_boundary_offset, coord_t comb_move_inside_distance, coord_t travel_avoid_distance);
+    LayerPlan(const SliceDataStorage& storage, LayerIndex layer_nr, coord_t z, coord_t layer_height, size_t start_extruder, const std::vector<FanSpeedLayerTimeSettings>& fan_speed_layer_time_settings_per_extruder, coord_t comb_boundary_offset, coord_t comb_move_inside_distance, coord_t travel_avoid_distance, TravelPlanCache* travel_plan_cache = nullptr);
 
     ~LayerPlan();
 
@@ -332,21 +344,60 @@ public:
      */
     ExtruderTrain* getLastPlannedExtruderTrain();
 
-    const Polygons* getCombBoundaryInside() const
+    /*!
+     * Get the comb boundaries of this layer, to share them with the order
+     * optimizers of this layer.
+     */
+    CombBoundaryCache& getCombBoundaries()
     {
-        return &comb_boundary_inside2;
+        return comb_boundaries;
     }
 
-private:
     /*!
-     * \brief Compute the boundary within which to comb, or to move into when
-     * performing a retraction.
-     * \param max_inset The greatest inset index.
-     * \return the comb_boundary_inside
+     * Get the areas of a layer below this one which a bridge in this layer
+     * could rest on, shared by all parts of this layer which are checked for
+     * bridging over that layer.
+     * \param layer_nr The layer below this one.
+     * \param support_layer The support that the bridge could rest on, if any.
      */
-    Polygons computeCombBoundaryInside(const size_t max_inset);
+    const BridgeSupport& getBridgeSupport(const unsigned layer_nr, const SupportLayer* support_layer);
+
+    /*!
+     * Get the orders and combing paths found for earlier layers, to let the
+     * order optimizers of this layer reuse them.
+     * \return The cache, or nullptr if nothing is reused.
+     */
+    TravelPlanCache* getTravelPlanCache()
+    {
+        return travel_plan_cache;
+    }
+
+    /*!
+     * Shorten the travel moves between the parts ordered by \p order_optimizer
+     * if travel order refinement is enabled.
+     *
+     * All refinements in this layer share one time budget, so that the
+     * refinement can't slow down the slicing of a layer by more than that.
+     *
+     * \param order_optimizer The optimizer which has already determined an
+     * order.
+     */
+    void refineOrder(PathOrderOptimizer& order_optimizer);
+
+    /*!
+     * Shorten the travel moves between the lines ordered by \p order_optimizer
+     * if travel order refinement is enabled.
+     *
+     * All refinements in this layer share one time budget, so that the
+     * refinement can't slow down the slicing of a layer by more than that.
+     *
+     * \param order_optimizer The optimizer which has already determined an
+     * order.
+     * \param travel_boundary The boundary which the travel moves introduced by
+     * the refinement may not cross, since they would have to comb around it.
+     */
+    void refineOrder(LineOrderOptimizer& order_optimizer, const Polygons& travel_boundary);
 
-public:
     int getLayerNr() const
     {
         return layer_nr;
@@ -657,6 +708,14 @@ public:
      * \param starting_position Start from this coordinate.
      * */
     void optimizePaths(const Point& starting_position);
+
+    /*!
+     * Estimate the memory used by this layer plan: its paths and the combing
+     * boundaries and masks computed for it.
+     *
+     * \return The estimated number of bytes.
+     */
+    size_t getMemoryUsage() const;
 };
 
 }//namespace cura
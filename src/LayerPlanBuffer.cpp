@@ -1,6 +1,8 @@
 //Copyright (c) 2018 Ultimaker B.V.
 //CuraEngine is released under the terms of the AGPLv3 or higher.
 
+#include <memory> // shared_ptr
+
 #include "Application.h" //To flush g-code through the communication channel.
 #include "communication/Communication.h" //To flush g-code through the communication channel.
 #include "FffProcessor.h"
@@ -8,6 +10,7 @@
 #include "LayerPlanBuffer.h"
 #include "utils/logoutput.h"
 #include "MergeInfillLines.h"
+#include "utils/DeferredFormatBuffer.h"
 
 namespace cura {
 
@@ -26,11 +29,40 @@ void LayerPlanBuffer::handle(LayerPlan& layer_plan, GCodeExport& gcode)
     LayerPlan* to_be_written = processBuffer();
     if (to_be_written)
     {
-        to_be_written->writeGCode(gcode);
-        delete to_be_written;
+        writeLayer(to_be_written, gcode);
+    }
+}
+
+void LayerPlanBuffer::writeLayer(LayerPlan* layer_plan, GCodeExport& gcode)
+{
+    std::shared_ptr<DeferredFormatBuffer> layer_gcode = std::make_shared<DeferredFormatBuffer>();
+    {
+        std::ostream* output_stream = gcode.getOutputStream();
+        std::ostream layer_stream(layer_gcode.get());
+        layer_stream.copyfmt(*output_stream); // so that numbers which aren't deferred are written the same
+        gcode.setOutputStream(&layer_stream);
+        layer_plan->writeGCode(gcode);
+        gcode.setOutputStream(output_stream);
+    }
+    delete layer_plan;
+
+    // with a single core there's nothing to gain from formatting on another thread
+    const std::launch policy = (max_formatting_layers > 1) ? std::launch::async : std::launch::deferred;
+    formatting_layers.push_back(std::async(policy, [layer_gcode]() { return layer_gcode->format(); }));
+    if (formatting_layers.size() >= max_formatting_layers)
+    {
+        appendFormattedLayer(gcode);
     }
 }
 
+void LayerPlanBuffer::appendFormattedLayer(GCodeExport& gcode)
+{
+    const std::string layer_gcode = formatting_layers.front().get();
+    formatting_layers.pop_front();
+    gcode.getOutputStream()->write(layer_gcode.data(), layer_gcode.size());
+    Application::getInstance().communication->flushGCode();
+}
+
 LayerPlan* LayerPlanBuffer::processBuffer()
 {
     if (buffer.empty())
@@ -64,11 +96,13 @@ void LayerPlanBuffer::flush()
     }
     while (!buffer.empty())
     {
-        buffer.front()->writeGCode(gcode);
-        Application::getInstance().communication->flushGCode();
-        delete buffer.front();
+        writeLayer(buffer.front(), gcode);
         buffer.pop_front();
     }
+    while (!formatting_layers.empty())
+    {
+        appendFormattedLayer(gcode);
+    }
 }
 
 void LayerPlanBuffer::addConnectingTravelMove(LayerPlan* prev_layer, const LayerPlan* newest_layer)
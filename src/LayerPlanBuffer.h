@@ -4,7 +4,11 @@
 #ifndef LAYER_PLAN_BUFFER_H
 #define LAYER_PLAN_BUFFER_H
 
+#include <algorithm> // max
+#include <deque>
+#include <future>
 #include <list>
+#include <thread> // hardware_concurrency
 
 #include "gcodeExport.h"
 #include "LayerPlan.h"
@@ -49,10 +53,26 @@ class LayerPlanBuffer
      * The back is the highest/newest layer.
      */
     std::list<LayerPlan*> buffer;
+
+    /*!
+     * The g-code of the layers which have been written but of which the
+     * numbers are still being formatted, in parallel.
+     *
+     * The front is the lowest/oldest layer, which is the next to be appended
+     * to the output stream.
+     */
+    std::deque<std::future<std::string>> formatting_layers;
+
+    /*!
+     * The number of layers of which the numbers may be formatted at the same
+     * time, before waiting for the lowest one to be done.
+     */
+    const size_t max_formatting_layers;
 public:
     LayerPlanBuffer(GCodeExport& gcode)
     : gcode(gcode)
     , extruder_used_in_meshgroup(MAX_EXTRUDERS, false)
+    , max_formatting_layers(std::max(1u, std::thread::hardware_concurrency()))
     { }
 
     void setPreheatConfig();
@@ -88,6 +108,27 @@ private:
      */
     LayerPlan* processBuffer();
 
+    /*!
+     * Write a layer plan to g-code and delete it.
+     *
+     * The state of the g-code (positions, extrusion amounts, temperatures) is
+     * computed here, in order, but the numbers are formatted on another
+     * thread. The formatted layers are appended to the output stream in order
+     * once they are done.
+     *
+     * \param layer_plan The layer plan to write.
+     * \param gcode The exporter with which to write the layer.
+     */
+    void writeLayer(LayerPlan* layer_plan, GCodeExport& gcode);
+
+    /*!
+     * Append the lowest layer of which the numbers are being formatted to the
+     * output stream, once it is done.
+     *
+     * \param gcode The exporter to which the layer is written.
+     */
+    void appendFormattedLayer(GCodeExport& gcode);
+
     /*!
      * Add the travel move to properly travel from the end location of the previous layer to the starting location of the next
      * 
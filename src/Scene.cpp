@@ -57,23 +57,14 @@ const std::string Scene::getAllSettingsString() const
     return output.str();
 }
 
-void Scene::processMeshGroup(MeshGroup& mesh_group)
+void Scene::processMeshGroup(MeshGroup& mesh_group, SliceDataStorage* sliced_storage)
 {
     FffProcessor* fff_processor = FffProcessor::getInstance();
     fff_processor->time_keeper.restart();
 
     TimeKeeper time_keeper_total;
 
-    bool empty = true;
-    for (Mesh& mesh : mesh_group.meshes)
-    {
-        if (!mesh.settings.get<bool>("infill_mesh") && !mesh.settings.get<bool>("anti_overhang_mesh"))
-        {
-            empty = false;
-            break;
-        }
-    }
-    if (empty)
+    if (!hasPrintedMeshes(mesh_group))
     {
         Progress::messageProgress(Progress::Stage::FINISH, 1, 1); // 100% on this meshgroup
         log("Total time elapsed %5.2fs.\n", time_keeper_total.restart());
@@ -94,15 +85,19 @@ void Scene::processMeshGroup(MeshGroup& mesh_group)
     }
     else //Normal operation (not wireframe).
     {
-        SliceDataStorage storage;
-
-        if (!fff_processor->polygon_generator.generateAreas(storage, &mesh_group, fff_processor->time_keeper))
+        std::unique_ptr<SliceDataStorage> storage;
+        if (!sliced_storage)
         {
-            return;
+            storage.reset(new SliceDataStorage());
+            if (!fff_processor->polygon_generator.generateAreas(*storage, &mesh_group, fff_processor->time_keeper))
+            {
+                return;
+            }
+            sliced_storage = storage.get();
         }
         
         Progress::messageProgressStage(Progress::Stage::EXPORT, &fff_processor->time_keeper);
-        fff_processor->gcode_writer.writeGCode(storage, fff_processor->time_keeper);
+        fff_processor->gcode_writer.writeGCode(*sliced_storage, fff_processor->time_keeper);
     }
 
     Progress::messageProgress(Progress::Stage::FINISH, 1, 1); // 100% on this meshgroup
@@ -111,4 +106,27 @@ void Scene::processMeshGroup(MeshGroup& mesh_group)
     log("Total time elapsed %5.2fs.\n", time_keeper_total.restart());
 }
 
+bool Scene::sliceMeshGroup(MeshGroup& mesh_group, SliceDataStorage& storage)
+{
+    if (!hasPrintedMeshes(mesh_group) || mesh_group.settings.get<bool>("wireframe_enabled"))
+    {
+        return false;
+    }
+    FffProcessor* fff_processor = FffProcessor::getInstance();
+    fff_processor->time_keeper.restart();
+    return fff_processor->polygon_generator.generateAreas(storage, &mesh_group, fff_processor->time_keeper);
+}
+
+bool Scene::hasPrintedMeshes(const MeshGroup& mesh_group)
+{
+    for (const Mesh& mesh : mesh_group.meshes)
+    {
+        if (!mesh.settings.get<bool>("infill_mesh") && !mesh.settings.get<bool>("anti_overhang_mesh"))
+        {
+            return true;
+        }
+    }
+    return false;
+}
+
 } //namespace cura
\ No newline at end of file
@@ -70,10 +70,32 @@ public:
     /*
      * \brief Generate the 3D printing instructions to print a given mesh group.
      * \param mesh_group The mesh group to slice.
+     * \param sliced_storage If given, the layer data of the mesh group from
+     * \ref Scene::sliceMeshGroup, so that only the g-code is written.
      */
-    void processMeshGroup(MeshGroup& mesh_group);
+    void processMeshGroup(MeshGroup& mesh_group, SliceDataStorage* sliced_storage = nullptr);
+
+    /*
+     * \brief Slice a mesh group into layer data, without writing g-code yet.
+     *
+     * The g-code can then be written with \ref Scene::processMeshGroup, also
+     * several times with different settings as long as they don't affect the
+     * layer data.
+     * \param mesh_group The mesh group to slice.
+     * \param storage The storage to slice the mesh group into.
+     * \return Whether the g-code of the mesh group is written from the layer
+     * data. This isn't the case when printing wireframes or when the mesh group
+     * has nothing to print.
+     */
+    bool sliceMeshGroup(MeshGroup& mesh_group, SliceDataStorage& storage);
 
 private:
+    /*
+     * \brief Whether any of the meshes of a mesh group is printed, rather than
+     * only modifying the other meshes.
+     */
+    static bool hasPrintedMeshes(const MeshGroup& mesh_group);
+
     /*
      * \brief You are not allowed to copy the scene.
      */
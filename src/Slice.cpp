@@ -10,17 +10,40 @@ Slice::Slice(const size_t num_mesh_groups)
 : scene(num_mesh_groups)
 {}
 
-void Slice::compute()
+void Slice::compute(const std::vector<std::unique_ptr<SliceDataStorage>>& sliced_storages)
 {
     logWarning("%s", scene.getAllSettingsString().c_str());
     for (std::vector<MeshGroup>::iterator mesh_group = scene.mesh_groups.begin(); mesh_group != scene.mesh_groups.end(); mesh_group++)
     {
-        scene.current_mesh_group = mesh_group;
-        for (ExtruderTrain& extruder : scene.extruders)
+        setCurrentMeshGroup(mesh_group);
+        const size_t mesh_group_idx = mesh_group - scene.mesh_groups.begin();
+        SliceDataStorage* sliced_storage = (mesh_group_idx < sliced_storages.size()) ? sliced_storages[mesh_group_idx].get() : nullptr;
+        scene.processMeshGroup(*mesh_group, sliced_storage);
+    }
+}
+
+std::vector<std::unique_ptr<SliceDataStorage>> Slice::sliceMeshGroups()
+{
+    std::vector<std::unique_ptr<SliceDataStorage>> result;
+    for (std::vector<MeshGroup>::iterator mesh_group = scene.mesh_groups.begin(); mesh_group != scene.mesh_groups.end(); mesh_group++)
+    {
+        setCurrentMeshGroup(mesh_group);
+        std::unique_ptr<SliceDataStorage> storage(new SliceDataStorage());
+        if (!scene.sliceMeshGroup(*mesh_group, *storage))
         {
-            extruder.settings.setParent(&scene.current_mesh_group->settings);
+            storage.reset();
         }
-        scene.processMeshGroup(*mesh_group);
+        result.push_back(std::move(storage));
+    }
+    return result;
+}
+
+void Slice::setCurrentMeshGroup(const std::vector<MeshGroup>::iterator mesh_group)
+{
+    scene.current_mesh_group = mesh_group;
+    for (ExtruderTrain& extruder : scene.extruders)
+    {
+        extruder.settings.setParent(&scene.current_mesh_group->settings);
     }
 }
 
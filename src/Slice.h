@@ -4,6 +4,8 @@
 #ifndef SLICE_H
 #define SLICE_H
 
+#include <memory> //To store the layer data of each mesh group.
+
 #include "Scene.h" //To store the scene to slice.
 
 namespace cura
@@ -33,8 +35,22 @@ public:
      *
      * The g-code output is sent through the currently active communication
      * channel.
+     * \param sliced_storages If given, the layer data of each mesh group from
+     * \ref Slice::sliceMeshGroups, so that only the g-code is written.
+     */
+    void compute(const std::vector<std::unique_ptr<SliceDataStorage>>& sliced_storages = std::vector<std::unique_ptr<SliceDataStorage>>());
+
+    /*
+     * \brief Slice the mesh groups of the scene into layer data, without
+     * producing g-code yet.
+     *
+     * The g-code can then be written with \ref Slice::compute, also several
+     * times with different settings as long as they don't affect the layer
+     * data.
+     * \return The layer data of each mesh group, or nullptr for mesh groups
+     * whose g-code isn't written from layer data.
      */
-    void compute();
+    std::vector<std::unique_ptr<SliceDataStorage>> sliceMeshGroups();
 
     /*
      * \brief Empty out the slice instance, restoring it as if it were a new
@@ -46,6 +62,11 @@ public:
     void reset();
 
 private:
+    /*
+     * \brief Make a mesh group the one being processed.
+     */
+    void setCurrentMeshGroup(const std::vector<MeshGroup>::iterator mesh_group);
+
     /*
      * \brief Disallow copying slice objects since they are heavyweight.
      *
@@ -1,75 +1,137 @@
 //Copyright (c) 2018 Ultimaker B.V.
 //CuraEngine is released under the terms of the AGPLv3 or higher.
 
+#include <algorithm>
+
 #include "bridge.h"
 
 namespace cura {
 
-int bridgeAngle(const Settings& settings, const Polygons& skin_outline, const SliceDataStorage& storage, const unsigned layer_nr, const SupportLayer* support_layer, Polygons& supported_regions)
+/*!
+ * Choose the size of the cells of the grid over the parts of a layer.
+ *
+ * The cells are made about as large as an average part, so that most parts
+ * overlap only a few cells.
+ */
+static coord_t partGridCellSize(const std::vector<AABB>& part_boxes)
 {
-    AABB boundary_box(skin_outline);
-
-    //To detect if we have a bridge, first calculate the intersection of the current layer with the previous layer.
-    // This gives us the islands that the layer rests on.
-    Polygons islands;
-
-    Polygons prev_layer_outline; // we also want the complete outline of the previous layer
+    constexpr coord_t min_cell_size = 1000;
+    if (part_boxes.empty())
+    {
+        return min_cell_size;
+    }
+    coord_t total_size = 0;
+    for (const AABB& box : part_boxes)
+    {
+        total_size += std::max(box.max.X - box.min.X, box.max.Y - box.min.Y);
+    }
+    return std::max(min_cell_size, total_size / static_cast<coord_t>(part_boxes.size()));
+}
 
+BridgeSupport::BridgeSupport(const SliceDataStorage& storage, const unsigned layer_nr, const SupportLayer* support_layer)
+: layer_nr(layer_nr)
+, support_layer(support_layer)
+, part_grid(1000) // replaced below, once the sizes of the parts are known
+{
     // include parts from all meshes
     for (const SliceMeshStorage& mesh : storage.meshes)
     {
         if (mesh.isPrinted())
         {
-            for (const SliceLayerPart& prev_layer_part : mesh.layers[layer_nr].parts)
+            for (const SliceLayerPart& part : mesh.layers[layer_nr].parts)
             {
-                prev_layer_outline.add(prev_layer_part.outline); // not intersected with skin
-
-                if (!boundary_box.hit(prev_layer_part.boundaryBox))
-                    continue;
+                part_outlines.push_back(&part.outline);
+                part_boxes.push_back(part.boundaryBox);
+            }
+        }
+    }
 
-                islands.add(skin_outline.intersection(prev_layer_part.outline));
+    const coord_t cell_size = partGridCellSize(part_boxes);
+    part_grid = SparsePointGridInclusive<size_t>(cell_size, part_boxes.size() * 4);
+    constexpr coord_t max_cells_per_part = 64; // a part which is much larger than the others is checked for every query instead
+    for (size_t part_idx = 0; part_idx < part_boxes.size(); part_idx++)
+    {
+        const AABB& box = part_boxes[part_idx];
+        const coord_t min_x = box.min.X / cell_size;
+        const coord_t max_x = box.max.X / cell_size;
+        const coord_t min_y = box.min.Y / cell_size;
+        const coord_t max_y = box.max.Y / cell_size;
+        if ((max_x - min_x + 1) * (max_y - min_y + 1) > max_cells_per_part)
+        {
+            large_parts.push_back(part_idx);
+            continue;
+        }
+        for (coord_t y = min_y; y <= max_y; y++)
+        {
+            for (coord_t x = min_x; x <= max_x; x++)
+            {
+                part_grid.insert(Point(x * cell_size, y * cell_size), part_idx);
             }
         }
     }
-    supported_regions = islands;
 
     if (support_layer)
     {
-        // add the regions of the skin that have support below them to supportedRegions
-        // but don't add these regions to islands because that can actually cause the code
-        // below to consider the skin a bridge when it isn't (e.g. a skin that is supported by
-        // the model on one side but the remainder of the skin is above support would look like
-        // a bridge because it would have two islands) - FIXME more work required here?
-
         if (!support_layer->support_roof.empty())
         {
-            AABB support_roof_bb(support_layer->support_roof);
-            if (boundary_box.hit(support_roof_bb))
-            {
-                prev_layer_outline.add(support_layer->support_roof); // not intersected with skin
-
-                Polygons supported_skin(skin_outline.intersection(support_layer->support_roof));
-                if (!supported_skin.empty())
-                {
-                    supported_regions.add(supported_skin);
-                }
-            }
+            support_areas.push_back(&support_layer->support_roof);
+            support_boxes.emplace_back(support_layer->support_roof);
         }
         else
         {
             for (const SupportInfillPart& support_part : support_layer->support_infill_parts)
             {
-                AABB support_part_bb(support_part.getInfillArea());
-                if (boundary_box.hit(support_part_bb))
-                {
-                    prev_layer_outline.add(support_part.getInfillArea()); // not intersected with skin
+                support_areas.push_back(&support_part.getInfillArea());
+                support_boxes.emplace_back(support_part.getInfillArea());
+            }
+        }
+    }
+}
 
-                    Polygons supported_skin(skin_outline.intersection(support_part.getInfillArea()));
-                    if (!supported_skin.empty())
-                    {
-                        supported_regions.add(supported_skin);
-                    }
-                }
+void BridgeSupport::findParts(const AABB& box, std::vector<size_t>& part_indices) const
+{
+    part_indices = large_parts;
+    const Point middle = box.getMiddle();
+    const coord_t radius = std::max(box.max.X - middle.X, box.max.Y - middle.Y) + 1;
+    for (const size_t part_idx : part_grid.getNearbyVals(middle, radius))
+    {
+        part_indices.push_back(part_idx);
+    }
+    // a part is in every cell it overlaps, and the parts should be visited in the same order for each query
+    std::sort(part_indices.begin(), part_indices.end());
+    part_indices.erase(std::unique(part_indices.begin(), part_indices.end()), part_indices.end());
+    part_indices.erase(std::remove_if(part_indices.begin(), part_indices.end(), [this, &box](const size_t part_idx) { return !box.hit(part_boxes[part_idx]); }), part_indices.end());
+}
+
+int bridgeAngle(const Settings& settings, const Polygons& skin_outline, const BridgeSupport& support_below, Polygons& supported_regions)
+{
+    AABB boundary_box(skin_outline);
+
+    //To detect if we have a bridge, first calculate the intersection of the current layer with the previous layer.
+    // This gives us the islands that the layer rests on.
+    Polygons islands;
+
+    std::vector<size_t> part_indices;
+    support_below.findParts(boundary_box, part_indices);
+    for (const size_t part_idx : part_indices)
+    {
+        islands.add(skin_outline.intersection(*support_below.part_outlines[part_idx]));
+    }
+    supported_regions = islands;
+
+    // add the regions of the skin that have support below them to supportedRegions
+    // but don't add these regions to islands because that can actually cause the code
+    // below to consider the skin a bridge when it isn't (e.g. a skin that is supported by
+    // the model on one side but the remainder of the skin is above support would look like
+    // a bridge because it would have two islands) - FIXME more work required here?
+    for (size_t support_idx = 0; support_idx < support_below.support_areas.size(); support_idx++)
+    {
+        if (boundary_box.hit(support_below.support_boxes[support_idx]))
+        {
+            Polygons supported_skin(skin_outline.intersection(*support_below.support_areas[support_idx]));
+            if (!supported_skin.empty())
+            {
+                supported_regions.add(supported_skin);
             }
         }
     }
@@ -93,6 +155,24 @@ int bridgeAngle(const Settings& settings, const Polygons& skin_outline, const Sl
             // the air boundary do appear to be supported
 
             const int bb_max_dim = std::max(boundary_box.max.X - boundary_box.min.X, boundary_box.max.Y - boundary_box.min.Y);
+
+            // the outline of the previous layer, as far as it is within the region of air that is considered
+            Polygons prev_layer_outline;
+            AABB air_box(boundary_box);
+            air_box.expand(bb_max_dim + 10);
+            support_below.findParts(air_box, part_indices);
+            for (const size_t part_idx : part_indices)
+            {
+                prev_layer_outline.add(*support_below.part_outlines[part_idx]);
+            }
+            for (size_t support_idx = 0; support_idx < support_below.support_areas.size(); support_idx++)
+            {
+                if (boundary_box.hit(support_below.support_boxes[support_idx]))
+                {
+                    prev_layer_outline.add(*support_below.support_areas[support_idx]);
+                }
+            }
+
             const Polygons air_below(bb_poly.offset(bb_max_dim).difference(prev_layer_outline).offset(-10));
 
             Polygons skin_perimeter_lines;
@@ -5,11 +5,53 @@
 #define BRIDGE_H
 
 #include "sliceDataStorage.h"
+#include "utils/AABB.h"
+#include "utils/SparsePointGridInclusive.h"
 
 namespace cura {
     class Polygons;
     class SliceLayer;
 
+/*!
+ * \brief The areas of a layer which a bridge in a layer above could rest on.
+ *
+ * These are the parts of all printed meshes and the support of a layer. Their
+ * bounding boxes are computed once and the parts are bucketed in a grid, so
+ * that for each skin part only the areas below it need to be visited.
+ */
+class BridgeSupport
+{
+public:
+    /*!
+     * \param storage The slice data storage where to find the parts.
+     * \param layer_nr The layer that the bridge would rest on.
+     * \param support_layer Support that the bridge could rest on, if any.
+     */
+    BridgeSupport(const SliceDataStorage& storage, const unsigned layer_nr, const SupportLayer* support_layer);
+
+    const unsigned layer_nr; //!< The layer that the bridge would rest on
+    const SupportLayer* const support_layer; //!< Support that the bridge could rest on (or nullptr)
+
+    std::vector<const Polygons*> part_outlines; //!< The outlines of the parts of all printed meshes, in the order of the meshes and parts
+    std::vector<AABB> part_boxes; //!< The bounding box of each of #part_outlines
+
+    std::vector<const Polygons*> support_areas; //!< The support roof, or the support infill parts if there is no roof
+    std::vector<AABB> support_boxes; //!< The bounding box of each of #support_areas
+
+    /*!
+     * Find the parts of which the bounding box overlaps with \p box.
+     *
+     * \param box The box to find the parts under.
+     * \param[out] part_indices The indices into #part_outlines, in increasing
+     * order.
+     */
+    void findParts(const AABB& box, std::vector<size_t>& part_indices) const;
+
+private:
+    SparsePointGridInclusive<size_t> part_grid; //!< The indices of the parts, inserted in each grid cell their bounding box overlaps
+    std::vector<size_t> large_parts; //!< The parts which overlap too many cells to insert them in #part_grid
+};
+
 /*!
  * \brief Computes the angle that lines have to take to bridge a certain shape
  * best.
@@ -17,14 +59,12 @@ namespace cura {
  * If the area should not be bridged, an angle of -1 is returned.
  * \param settings The settings container to get settings from.
  * \param skin_outline The shape to fill with lines.
- * \param storage The slice data storage where to find objects that the bridge
- * could rest on in previous layers.
- * \param layer_nr The layer that the bridge has to be created on.
- * \param support_layer Support that the bridge could rest on.
+ * \param support_below The areas of the layer below that the bridge could
+ * rest on.
  * \param supported_regions Pre-computed regions that the support layer would
  * support.
  */
-int bridgeAngle(const Settings& settings, const Polygons& skin_outline, const SliceDataStorage& storage, const unsigned layer_nr, const SupportLayer* support_layer, Polygons& supported_regions);
+int bridgeAngle(const Settings& settings, const Polygons& skin_outline, const BridgeSupport& support_below, Polygons& supported_regions);
 
 }//namespace cura
 
@@ -17,6 +17,7 @@
 #include "../Slice.h" //To process slices.
 #include "../settings/types/LayerIndex.h" //To point to layers.
 #include "../settings/types/Velocity.h" //To send to layer view how fast stuff is printing.
+#include "../utils/CompactPathEncoding.h" //To send the layer view data compactly if the front-end can read that.
 #include "../utils/logoutput.h"
 
 namespace cura
@@ -84,6 +85,10 @@ public:
     /*!
      * \brief Used to select which layer the following layer data is intended
      * for.
+     *
+     * Layers are written in order, so when moving on to a higher layer the
+     * current layer is complete and gets sent to the front-end right away,
+     * rather than keeping the layer data of the whole print in memory.
      * \param new_layer_nr The new layer to switch to.
      */
     void setLayer(const LayerIndex& new_layer_nr)
@@ -91,6 +96,10 @@ public:
         if (_layer_nr != new_layer_nr)
         {
             flushPathSegments();
+            if (new_layer_nr > _layer_nr)
+            {
+                _cs_private_data.sendOptimizedLayer(_layer_nr);
+            }
             _layer_nr = new_layer_nr;
         }
     }
@@ -152,6 +161,12 @@ public:
         path_segment->set_extruder(extruder);
         path_segment->set_point_type(data_point_type);
 
+        if (_cs_private_data.compact_layer_data)
+        {
+            flushCompactPathSegment(*path_segment);
+            return;
+        }
+
         std::string line_type_data;
         line_type_data.append(reinterpret_cast<const char*>(line_types.data()), line_types.size() * sizeof(PrintFeatureType));
         line_types.clear();
@@ -178,6 +193,28 @@ public:
         path_segment->set_line_feedrate(line_velocity_data);
     }
 
+    /*!
+     * \brief Transfers the currently buffered line segments to a path segment
+     * message in the compact encoding.
+     * \param path_segment The message to fill.
+     */
+    void flushCompactPathSegment(proto::PathSegment& path_segment)
+    {
+        path_segment.set_encoding(proto::PathSegment::Compact);
+        const size_t dimensions = (data_point_type == cura::proto::PathSegment::Point3D) ? 3 : 2;
+
+        path_segment.set_line_type(CompactPathEncoding::encodeTypes(line_types));
+        line_types.clear();
+        path_segment.set_points(CompactPathEncoding::encodePoints(points, dimensions));
+        points.clear();
+        path_segment.set_line_width(CompactPathEncoding::encodeRuns(line_widths, CompactPathEncoding::coordinate_scale));
+        line_widths.clear();
+        path_segment.set_line_thickness(CompactPathEncoding::encodeRuns(line_thicknesses, CompactPathEncoding::coordinate_scale));
+        line_thicknesses.clear();
+        path_segment.set_line_feedrate(CompactPathEncoding::encodeRuns(line_velocities, CompactPathEncoding::feedrate_scale));
+        line_velocities.clear();
+    }
+
     /*!
      * \brief Move the current point of this path to \p position.
      */
@@ -390,6 +427,7 @@ void ArcusCommunication::sendOptimizedLayerData()
 {
     path_compiler->flushPathSegments(); //Make sure the last path segment has been flushed from the compiler.
 
+    std::lock_guard<std::mutex> lock(private_data->optimized_layers_mutex);
     SliceDataStruct<proto::LayerOptimized>& data = private_data->optimized_layers;
     data.sliced_objects++;
     data.current_layer_offset = data.current_layer_count;
@@ -397,7 +435,7 @@ void ArcusCommunication::sendOptimizedLayerData()
     {
         return;
     }
-    log("Sending %d layers.", data.current_layer_count);
+    log("Sending %d remaining layers.\n", static_cast<int>(data.slice_data.size())); //Most layers were already sent while writing them.
 
     for (std::pair<const int, std::shared_ptr<proto::LayerOptimized>> entry : data.slice_data) //Note: This is in no particular order!
     {
@@ -494,6 +532,7 @@ void ArcusCommunication::sliceNext()
     Slice slice(slice_message->object_lists().size());
     Application::getInstance().current_slice = &slice;
 
+    private_data->compact_layer_data = slice_message->compact_layer_data();
     private_data->readGlobalSettingsMessage(slice_message->global_settings());
     private_data->readExtruderSettingsMessage(slice_message->extruders());
     const size_t extruder_count = slice.scene.extruders.size();
@@ -3,6 +3,8 @@
 
 #ifdef ARCUS
 
+#include <Arcus/Socket.h> //To send the layers that are done.
+
 #include "ArcusCommunicationPrivate.h"
 #include "../Application.h"
 
@@ -12,6 +14,7 @@ namespace cura
 ArcusCommunication::Private::Private()
     : socket(nullptr)
     , object_count(0)
+    , compact_layer_data(false)
     , last_sent_progress(-1)
     , slice_count(0)
     , millisecUntilNextTry(100)
@@ -19,6 +22,7 @@ ArcusCommunication::Private::Private()
 
 std::shared_ptr<proto::LayerOptimized> ArcusCommunication::Private::getOptimizedLayerById(LayerIndex layer_nr)
 {
+    std::lock_guard<std::mutex> lock(optimized_layers_mutex);
     layer_nr += optimized_layers.current_layer_offset;
     std::unordered_map<int, std::shared_ptr<proto::LayerOptimized>>::iterator find_result = optimized_layers.slice_data.find(layer_nr);
 
@@ -36,6 +40,24 @@ std::shared_ptr<proto::LayerOptimized> ArcusCommunication::Private::getOptimized
     }
 }
 
+void ArcusCommunication::Private::sendOptimizedLayer(LayerIndex layer_nr)
+{
+    std::shared_ptr<proto::LayerOptimized> layer;
+    {
+        std::lock_guard<std::mutex> lock(optimized_layers_mutex);
+        layer_nr += optimized_layers.current_layer_offset;
+        std::unordered_map<int, std::shared_ptr<proto::LayerOptimized>>::iterator find_result = optimized_layers.slice_data.find(layer_nr);
+        if (find_result == optimized_layers.slice_data.end()) //Nothing to send.
+        {
+            return;
+        }
+        layer = find_result->second;
+        optimized_layers.slice_data.erase(find_result);
+    }
+    logDebug("Sending layer data for layer %i.\n", static_cast<int>(layer_nr));
+    socket->sendMessage(layer);
+}
+
 void ArcusCommunication::Private::readGlobalSettingsMessage(const proto::SettingList& global_settings_message)
 {
     Slice* slice = Application::getInstance().current_slice;
@@ -111,17 +133,9 @@ void ArcusCommunication::Private::readMeshGroupMessage(const proto::ObjectList&
         ExtruderTrain& extruder = mesh.settings.get<ExtruderTrain&>("extruder_nr"); //Set the parent setting to the correct extruder.
         mesh.settings.setParent(&extruder.settings);
 
-        for (size_t face = 0; face < face_count; face++)
-        {
-            const std::string data = object.vertices().substr(face * bytes_per_face, bytes_per_face);
-            const FPoint3* float_vertices = reinterpret_cast<const FPoint3*>(data.data());
-
-            Point3 verts[3];
-            verts[0] = matrix.apply(float_vertices[0]);
-            verts[1] = matrix.apply(float_vertices[1]);
-            verts[2] = matrix.apply(float_vertices[2]);
-            mesh.addFace(verts[0], verts[1], verts[2]);
-        }
+        //Read the vertices in place, rather than copying each face out of the message.
+        const float* vertex_data = reinterpret_cast<const float*>(object.vertices().data());
+        mesh.addFaces(vertex_data, face_count, matrix);
 
         mesh.mesh_name = object.name();
         mesh.finish();
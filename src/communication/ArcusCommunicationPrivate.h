@@ -5,6 +5,7 @@
 #define ARCUSCOMMUNICATIONPRIVATE_H
 #ifdef ARCUS
 
+#include <mutex> //To guard the optimised layer data, which is added to while planning other layers.
 #include <sstream> //For ostringstream.
 
 #include "ArcusCommunication.h" //We're adding a subclass to this.
@@ -27,6 +28,16 @@ public:
      */
     std::shared_ptr<proto::LayerOptimized> getOptimizedLayerById(LayerIndex layer_nr);
 
+    /*
+     * Send the optimised layer data of a layer to the front-end and forget
+     * about it.
+     *
+     * This should only be called when no more data will be added to the layer.
+     * If there is no data for the layer, nothing is sent.
+     * \param layer_nr The layer number to send the optimised layer data of.
+     */
+    void sendOptimizedLayer(LayerIndex layer_nr);
+
     /*
      * Reads the global settings from a Protobuf message.
      *
@@ -51,6 +62,9 @@ public:
 
     SliceDataStruct<cura::proto::Layer> sliced_layers;
     SliceDataStruct<cura::proto::LayerOptimized> optimized_layers;
+    std::mutex optimized_layers_mutex; //!< Guards optimized_layers, since layers are completed while others are still being planned.
+
+    bool compact_layer_data; //!< Whether the front-end can read the layer view data in the compact encoding.
 
     int last_sent_progress; //!< Last sent progress promille (1/1000th). Used to not send duplicate messages with the same promille.
 
@@ -0,0 +1,205 @@
+//Copyright (c) 2018 Ultimaker B.V.
+//CuraEngine is released under the terms of the AGPLv3 or higher.
+
+#include <algorithm> //For std::find and std::max.
+#include <cstdio> //To flush the output before forking.
+#include <cstdlib> //For exit.
+#ifdef _OPENMP
+    #include <omp.h> //To share the cores among the jobs that are sliced at the same time.
+#endif // _OPENMP
+#if defined(__linux__) || (defined(__APPLE__) && defined(__MACH__))
+    #include <sys/wait.h> //To wait for the processes of the jobs.
+    #include <unistd.h> //To fork the processes of the jobs.
+#endif
+
+#include "BatchCommandLine.h"
+#include "../Application.h" //To set a scene to load the definitions into.
+#include "../Slice.h"
+#include "../utils/logoutput.h"
+
+namespace cura
+{
+
+BatchCommandLine::BatchCommandLine(const std::string& executable, const std::vector<std::vector<std::string>>& jobs, const size_t max_parallel_jobs)
+: CommandLine({})
+, next_job_idx(0)
+, max_parallel_jobs(std::max(size_t(1), max_parallel_jobs))
+, failed_job_count(0)
+{
+    for (const std::vector<std::string>& job : jobs)
+    {
+        std::vector<std::string> job_arguments = {executable, "slice"};
+        job_arguments.insert(job_arguments.end(), job.begin(), job.end());
+        this->jobs.push_back(job_arguments);
+    }
+    cache_json_documents = true;
+    loadDefinitions();
+}
+
+std::vector<std::vector<std::string>> BatchCommandLine::readManifest(std::istream& manifest)
+{
+    std::vector<std::vector<std::string>> result;
+    std::string line;
+    while (std::getline(manifest, line))
+    {
+        std::vector<std::string> job;
+        std::string argument;
+        bool in_argument = false;
+        bool in_quotes = false;
+        for (const char character : line)
+        {
+            if (character == '"')
+            {
+                in_quotes = !in_quotes;
+                in_argument = true; //Even "" is an argument.
+            }
+            else if (!in_quotes && (character == ' ' || character == '\t' || character == '\r'))
+            {
+                if (in_argument)
+                {
+                    job.push_back(argument);
+                    argument.clear();
+                    in_argument = false;
+                }
+            }
+            else
+            {
+                argument.push_back(character);
+                in_argument = true;
+            }
+        }
+        if (in_argument)
+        {
+            job.push_back(argument);
+        }
+
+        if (!job.empty() && job[0][0] != '#') //Skip empty lines and comments.
+        {
+            result.push_back(job);
+        }
+    }
+    return result;
+}
+
+bool BatchCommandLine::hasSlice() const
+{
+    return next_job_idx < jobs.size() || !running_jobs.empty();
+}
+
+void BatchCommandLine::sliceNext()
+{
+    if (next_job_idx < jobs.size() && running_jobs.size() < max_parallel_jobs)
+    {
+        next_job_idx++;
+        startJob(next_job_idx - 1);
+    }
+    else
+    {
+        waitForJob();
+    }
+}
+
+void BatchCommandLine::loadDefinitions()
+{
+    Slice slice(1); //Loading a machine definition creates its extruders in the scene.
+    Application::getInstance().current_slice = &slice;
+    for (const std::vector<std::string>& job : jobs)
+    {
+        for (size_t argument_index = 2; argument_index + 1 < job.size(); argument_index++)
+        {
+            if (job[argument_index] == "-j")
+            {
+                loadJSON(job[argument_index + 1], slice.scene.settings); //If this fails, the job itself fails too when it loads the file.
+            }
+        }
+    }
+    Application::getInstance().current_slice = nullptr;
+}
+
+void BatchCommandLine::startJob(const size_t job_idx)
+{
+    const std::vector<std::string>& job = jobs[job_idx];
+    if (std::find(job.begin() + 2, job.end(), "-o") == job.end())
+    {
+        logError("Job %d has no output file.\n", static_cast<int>(job_idx + 1));
+        finishJob(job_idx, false);
+        return;
+    }
+
+#if defined(__linux__) || (defined(__APPLE__) && defined(__MACH__))
+    //Otherwise the process of the job writes what's still in the buffers again.
+    fflush(stdout);
+    fflush(stderr);
+    const pid_t process_id = fork();
+    if (process_id < 0)
+    {
+        logError("Failed to start a process for job %d.\n", static_cast<int>(job_idx + 1));
+        finishJob(job_idx, false);
+        return;
+    }
+    if (process_id == 0) //This is the process of the job.
+    {
+#ifdef _OPENMP
+        //Otherwise each job uses all cores, while the other jobs are running too. A -m argument of the job still overrides this.
+        omp_set_num_threads(std::max(1, omp_get_num_procs() / static_cast<int>(max_parallel_jobs)));
+#endif // _OPENMP
+        arguments = job;
+        CommandLine::sliceNext(); //Exits with an error code if the job fails.
+        exit(0);
+    }
+    running_jobs.emplace(process_id, job_idx);
+#else
+    logError("Batch slicing is not supported on this platform.\n");
+    finishJob(job_idx, false);
+#endif
+}
+
+void BatchCommandLine::waitForJob()
+{
+#if defined(__linux__) || (defined(__APPLE__) && defined(__MACH__))
+    int status;
+    const pid_t process_id = waitpid(-1, &status, 0);
+    const std::unordered_map<int, size_t>::const_iterator job = running_jobs.find(process_id);
+    if (job == running_jobs.end())
+    {
+        if (process_id < 0) //There are no processes left to wait for, so the remaining jobs will never finish.
+        {
+            logError("Lost track of the jobs being sliced.\n");
+            const std::unordered_map<int, size_t> lost_jobs = running_jobs;
+            running_jobs.clear();
+            for (const std::pair<const int, size_t>& lost_job : lost_jobs)
+            {
+                finishJob(lost_job.second, false);
+            }
+        }
+        return;
+    }
+    const size_t job_idx = job->second;
+    running_jobs.erase(job);
+    finishJob(job_idx, WIFEXITED(status) && WEXITSTATUS(status) == 0);
+#endif
+}
+
+void BatchCommandLine::finishJob(const size_t job_idx, const bool success)
+{
+    if (success)
+    {
+        log("Finished job %d of %d.\n", static_cast<int>(job_idx + 1), static_cast<int>(jobs.size()));
+    }
+    else
+    {
+        failed_job_count++;
+        logError("Job %d of %d failed.\n", static_cast<int>(job_idx + 1), static_cast<int>(jobs.size()));
+    }
+
+    if (!hasSlice())
+    {
+        logAlways("Sliced %d jobs, of which %d failed.\n", static_cast<int>(jobs.size()), static_cast<int>(failed_job_count));
+        if (failed_job_count > 0)
+        {
+            exit(1);
+        }
+    }
+}
+
+} //namespace cura
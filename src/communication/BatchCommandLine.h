@@ -0,0 +1,119 @@
+//Copyright (c) 2018 Ultimaker B.V.
+//CuraEngine is released under the terms of the AGPLv3 or higher.
+
+#ifndef BATCHCOMMANDLINE_H
+#define BATCHCOMMANDLINE_H
+
+#include <istream> //To read the manifest.
+#include <unordered_map> //To track the jobs that are being sliced.
+
+#include "CommandLine.h" //The class we're extending.
+
+namespace cura
+{
+
+/*
+ * \brief Slices a batch of jobs from a manifest in one process, as if
+ * CuraEngine were called with "slice" for each of them.
+ *
+ * Starting CuraEngine and parsing the machine definitions takes a good part of
+ * the time to slice a small model. The definitions are parsed once here, and
+ * then each job is sliced in a process forked off from this one, which starts
+ * with the parsed definitions in memory. Since slicing leaves state behind in
+ * the engine, each job gets a fresh process this way, so its g-code is the
+ * same as when it's sliced on its own.
+ *
+ * Several jobs are sliced at the same time, up to a maximum.
+ */
+class BatchCommandLine : public CommandLine
+{
+public:
+    /*
+     * \brief Construct a new communicator that slices a batch of jobs.
+     *
+     * This parses the JSON files of all jobs already.
+     * \param executable The name with which the application was called.
+     * \param jobs The command line arguments of each job, as they would follow
+     * "CuraEngine slice". Each job needs an output file.
+     * \param max_parallel_jobs How many jobs to slice at the same time at most.
+     */
+    BatchCommandLine(const std::string& executable, const std::vector<std::vector<std::string>>& jobs, const size_t max_parallel_jobs);
+
+    /*
+     * \brief Read the jobs from a manifest.
+     *
+     * Each line of the manifest is a job, with the same arguments as after
+     * "CuraEngine slice", separated by spaces. Arguments with spaces in them
+     * can be put between double quotes. Empty lines and lines starting with #
+     * are skipped.
+     * \param manifest The manifest to read.
+     * \return The arguments of each job.
+     */
+    static std::vector<std::vector<std::string>> readManifest(std::istream& manifest);
+
+    /*
+     * \brief Test if there are any jobs left to start or to wait for.
+     */
+    bool hasSlice() const override;
+
+    /*
+     * \brief Start slicing the next job, or wait for a job to finish if the
+     * maximum number of jobs are being sliced already.
+     */
+    void sliceNext() override;
+
+private:
+    /*
+     * \brief The command line arguments of each job, including the executable
+     * and "slice".
+     */
+    std::vector<std::vector<std::string>> jobs;
+
+    /*
+     * \brief The index of the next job to start.
+     */
+    size_t next_job_idx;
+
+    /*
+     * \brief How many jobs to slice at the same time at most.
+     */
+    size_t max_parallel_jobs;
+
+    /*
+     * \brief The jobs being sliced, by the process ID of their process.
+     */
+    std::unordered_map<int, size_t> running_jobs;
+
+    /*
+     * \brief The number of jobs that failed so far.
+     */
+    size_t failed_job_count;
+
+    /*
+     * \brief Parse the JSON files of all jobs, including the ones they inherit
+     * from, so that the processes of the jobs don't need to.
+     */
+    void loadDefinitions();
+
+    /*
+     * \brief Start slicing a job in a new process.
+     * \param job_idx The index of the job.
+     */
+    void startJob(const size_t job_idx);
+
+    /*
+     * \brief Wait until one of the jobs being sliced has finished.
+     */
+    void waitForJob();
+
+    /*
+     * \brief Register that a job has finished.
+     * \param job_idx The index of the job.
+     * \param success Whether the g-code of the job was written successfully.
+     */
+    void finishJob(const size_t job_idx, const bool success);
+};
+
+} //namespace cura
+
+#endif //BATCHCOMMANDLINE_H
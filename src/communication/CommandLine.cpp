@@ -12,6 +12,7 @@
 #include <rapidjson/rapidjson.h>
 #include <rapidjson/error/en.h> //Loading JSON documents to get settings from them.
 #include <rapidjson/filereadstream.h>
+#include <sys/stat.h> //To find out whether a cached JSON document changed.
 #include <unordered_set>
 
 #include "CommandLine.h"
@@ -23,6 +24,7 @@ namespace cura
 
 CommandLine::CommandLine(const std::vector<std::string>& arguments)
 : arguments(arguments)
+, cache_json_documents(false)
 , last_shown_progress(0)
 {
 }
@@ -82,7 +84,51 @@ void CommandLine::sliceNext()
 {
     FffProcessor::getInstance()->time_keeper.restart();
 
-    //Count the number of mesh groups to slice for.
+    Slice slice(getMeshGroupCount());
+
+    Application::getInstance().current_slice = &slice;
+
+    FffProcessor::getInstance()->setTargetStdout(); //Unless an output file is given.
+    if (!applyTargetArguments() || !loadArguments(slice))
+    {
+        exit(1);
+    }
+
+    arguments.clear(); //We've processed all arguments now.
+
+#ifndef DEBUG
+    try
+    {
+#endif //DEBUG
+        slice.scene.mesh_groups.back().finalize();
+        log("Loaded from disk in %5.3fs\n", FffProcessor::getInstance()->time_keeper.restart());
+
+        //Start slicing.
+        slice.compute();
+#ifndef DEBUG
+    }
+    catch(...)
+    {
+        //Catch all exceptions.
+        //This prevents the "something went wrong" dialogue on Windows to pop up on a thrown exception.
+        //Only ClipperLib currently throws exceptions. And only in the case that it makes an internal error.
+        logError("Unknown exception.\n");
+        exit(1);
+    }
+#endif //DEBUG
+
+    //Finalize the processor. This adds the end g-code and reports statistics.
+    FffProcessor::getInstance()->finalize();
+
+    if (!FffProcessor::getInstance()->closeTarget()) //Completes the output, e.g. the end of compressed g-code.
+    {
+        logError("Failed to write the g-code.\n");
+        exit(1);
+    }
+}
+
+size_t CommandLine::getMeshGroupCount() const
+{
     size_t num_mesh_groups = 1;
     for (size_t argument_index = 2; argument_index < arguments.size(); argument_index++)
     {
@@ -91,10 +137,66 @@ void CommandLine::sliceNext()
             num_mesh_groups++;
         }
     }
-    Slice slice(num_mesh_groups);
+    return num_mesh_groups;
+}
 
-    Application::getInstance().current_slice = &slice;
+bool CommandLine::applyTargetArguments()
+{
+    for (size_t argument_index = 2; argument_index < arguments.size(); argument_index++)
+    {
+        const std::string& argument = arguments[argument_index];
+        if (argument == "--binary")
+        {
+            FffProcessor::getInstance()->setTargetBinary(true);
+        }
+        else if (argument.size() < 2 || argument[0] != '-' || argument[1] == '-')
+        {
+            continue;
+        }
+        else if (argument[1] == 'z')
+        {
+            if (!FffProcessor::getInstance()->setTargetCompressed(true))
+            {
+                logError("Compressed output is not supported by this build.\n");
+                return false;
+            }
+        }
+        else if (argument[1] == 'b')
+        {
+            const int megabytes = stoi(argument.substr(2));
+            FffProcessor::getInstance()->setTargetBufferSize(std::max(1, megabytes) * size_t(1024 * 1024));
+        }
+        else if (argument[1] == 'o')
+        {
+            argument_index++;
+            if (argument_index >= arguments.size())
+            {
+                logError("Missing output file with -o argument.");
+                return false;
+            }
+            const std::string& filename = arguments[argument_index];
+            if (!FffProcessor::getInstance()->setTargetFile(filename.c_str()))
+            {
+                logError("Failed to open %s for output.\n", filename.c_str());
+                return false;
+            }
+            const std::string gzip_extension = ".gz";
+            if (filename.size() > gzip_extension.size() && filename.compare(filename.size() - gzip_extension.size(), gzip_extension.size(), gzip_extension) == 0
+                && !FffProcessor::getInstance()->setTargetCompressed(true))
+            {
+                logWarning("Compressed output is not supported by this build. Writing %s uncompressed.\n", filename.c_str());
+            }
+        }
+        else if (argument[1] == 'j' || argument[1] == 'l' || argument[1] == 's')
+        {
+            argument_index++; //Skip the value of the argument, which may start with a "-" too.
+        }
+    }
+    return true;
+}
 
+bool CommandLine::loadArguments(Slice& slice, std::unordered_map<size_t, Settings*>* setting_targets)
+{
     size_t mesh_group_index = 0;
     Settings* last_settings = &slice.scene.settings;
 
@@ -125,9 +227,13 @@ void CommandLine::sliceNext()
                         //This prevents the "something went wrong" dialogue on Windows to pop up on a thrown exception.
                         //Only ClipperLib currently throws exceptions. And only in the case that it makes an internal error.
                         logError("Unknown exception!\n");
-                        exit(1);
+                        return false;
                     }
                 }
+                else if (argument == "--binary")
+                {
+                    //Applied by applyTargetArguments.
+                }
                 else
                 {
                     logError("Unknown option: %s\n", argument.c_str());
@@ -157,19 +263,25 @@ void CommandLine::sliceNext()
                         enableProgressLogging();
                         break;
                     }
+                    case 'z':
+                    case 'b':
+                    {
+                        //Applied by applyTargetArguments.
+                        break;
+                    }
                     case 'j':
                     {
                         argument_index++;
                         if (argument_index >= arguments.size())
                         {
                             logError("Missing JSON file with -j argument.");
-                            exit(1);
+                            return false;
                         }
                         argument = arguments[argument_index];
                         if (loadJSON(argument, *last_settings))
                         {
                             logError("Failed to load JSON file: %s\n", argument.c_str());
-                            exit(1);
+                            return false;
                         }
 
                         //If this was the global stack, create extruders for the machine_extruder_count setting.
@@ -199,7 +311,7 @@ void CommandLine::sliceNext()
                         if (argument_index >= arguments.size())
                         {
                             logError("Missing model file with -l argument.");
-                            exit(1);
+                            return false;
                         }
                         argument = arguments[argument_index];
 
@@ -208,7 +320,7 @@ void CommandLine::sliceNext()
                         if (!loadMeshIntoMeshGroup(&slice.scene.mesh_groups[mesh_group_index], argument.c_str(), transformation, last_extruder.settings))
                         {
                             logError("Failed to load model: %s. (error number %d)\n", argument.c_str(), errno);
-                            exit(1);
+                            return false;
                         }
                         else
                         {
@@ -218,18 +330,7 @@ void CommandLine::sliceNext()
                     }
                     case 'o':
                     {
-                        argument_index++;
-                        if (argument_index >= arguments.size())
-                        {
-                            logError("Missing output file with -o argument.");
-                            exit(1);
-                        }
-                        argument = arguments[argument_index];
-                        if (!FffProcessor::getInstance()->setTargetFile(argument.c_str()))
-                        {
-                            logError("Failed to open %s for output.\n", argument.c_str());
-                            exit(1);
-                        }
+                        argument_index++; //Applied by applyTargetArguments.
                         break;
                     }
                     case 'g':
@@ -245,7 +346,7 @@ void CommandLine::sliceNext()
                         if (argument_index >= arguments.size())
                         {
                             logError("Missing setting name and value with -s argument.");
-                            exit(1);
+                            return false;
                         }
                         argument = arguments[argument_index];
                         const size_t value_position = argument.find("=");
@@ -253,10 +354,14 @@ void CommandLine::sliceNext()
                         if (value_position == std::string::npos)
                         {
                             logError("Missing value in setting argument: -s %s", argument.c_str());
-                            exit(1);
+                            return false;
                         }
                         std::string value = argument.substr(value_position + 1);
                         last_settings->add(key, value);
+                        if (setting_targets)
+                        {
+                            (*setting_targets)[argument_index] = last_settings;
+                        }
                         break;
                     }
                     default:
@@ -264,8 +369,7 @@ void CommandLine::sliceNext()
                         logError("Unknown option: -%c\n", argument[1]);
                         Application::getInstance().printCall();
                         Application::getInstance().printHelp();
-                        exit(1);
-                        break;
+                        return false;
                     }
                 }
             }
@@ -275,55 +379,57 @@ void CommandLine::sliceNext()
             logError("Unknown option: %s\n", argument.c_str());
             Application::getInstance().printCall();
             Application::getInstance().printHelp();
-            exit(1);
+            return false;
         }
     }
-
-    arguments.clear(); //We've processed all arguments now.
-
-#ifndef DEBUG
-    try
-    {
-#endif //DEBUG
-        slice.scene.mesh_groups[mesh_group_index].finalize();
-        log("Loaded from disk in %5.3fs\n", FffProcessor::getInstance()->time_keeper.restart());
-
-        //Start slicing.
-        slice.compute();
-#ifndef DEBUG
-    }
-    catch(...)
-    {
-        //Catch all exceptions.
-        //This prevents the "something went wrong" dialogue on Windows to pop up on a thrown exception.
-        //Only ClipperLib currently throws exceptions. And only in the case that it makes an internal error.
-        logError("Unknown exception.\n");
-        exit(1);
-    }
-#endif //DEBUG
-
-    //Finalize the processor. This adds the end g-code and reports statistics.
-    FffProcessor::getInstance()->finalize();
+    return true;
 }
 
 int CommandLine::loadJSON(const std::string& json_filename, Settings& settings)
 {
-    FILE* file = fopen(json_filename.c_str(), "rb");
-    if (!file)
+    const rapidjson::Document* json_document = nullptr;
+    std::unique_ptr<rapidjson::Document> parsed_document;
+    FileStatus file_status{-1, -1};
+    if (cache_json_documents)
     {
-        logError("Couldn't open JSON file: %s\n", json_filename.c_str());
-        return 1;
+        file_status = getFileStatus(json_filename); //Before parsing, so that a change while parsing is noticed next time.
+        const std::unordered_map<std::string, std::pair<FileStatus, std::unique_ptr<rapidjson::Document>>>::iterator cached_document = json_documents.find(json_filename);
+        if (cached_document != json_documents.end())
+        {
+            if (cached_document->second.first == file_status)
+            {
+                json_document = cached_document->second.second.get();
+            }
+            else //The file changed since it was parsed.
+            {
+                json_documents.erase(cached_document);
+            }
+        }
     }
-
-    rapidjson::Document json_document;
-    char read_buffer[4096];
-    rapidjson::FileReadStream reader_stream(file, read_buffer, sizeof(read_buffer));
-    json_document.ParseStream(reader_stream);
-    fclose(file);
-    if (json_document.HasParseError())
+    if (!json_document)
     {
-        logError("Error parsing JSON (offset %u): %s\n", static_cast<unsigned int>(json_document.GetErrorOffset()), GetParseError_En(json_document.GetParseError()));
-        return 2;
+        FILE* file = fopen(json_filename.c_str(), "rb");
+        if (!file)
+        {
+            logError("Couldn't open JSON file: %s\n", json_filename.c_str());
+            return 1;
+        }
+
+        parsed_document.reset(new rapidjson::Document);
+        char read_buffer[4096];
+        rapidjson::FileReadStream reader_stream(file, read_buffer, sizeof(read_buffer));
+        parsed_document->ParseStream(reader_stream);
+        fclose(file);
+        if (parsed_document->HasParseError())
+        {
+            logError("Error parsing JSON (offset %u): %s\n", static_cast<unsigned int>(parsed_document->GetErrorOffset()), GetParseError_En(parsed_document->GetParseError()));
+            return 2;
+        }
+        json_document = parsed_document.get();
+        if (cache_json_documents)
+        {
+            json_documents.emplace(json_filename, std::make_pair(file_status, std::move(parsed_document)));
+        }
     }
 
     std::unordered_set<std::string> search_directories = defaultSearchDirectories(); //For finding the inheriting JSON files.
@@ -332,7 +438,17 @@ int CommandLine::loadJSON(const std::string& json_filename, Settings& settings)
     std::string directory = std::string(dirname(filename_copy));
     search_directories.emplace(directory);
 
-    return loadJSON(json_document, search_directories, settings);
+    return loadJSON(*json_document, search_directories, settings);
+}
+
+CommandLine::FileStatus CommandLine::getFileStatus(const std::string& filename)
+{
+    struct stat file_status;
+    if (stat(filename.c_str(), &file_status) != 0)
+    {
+        return FileStatus{-1, -1};
+    }
+    return FileStatus{static_cast<int64_t>(file_status.st_mtime), static_cast<int64_t>(file_status.st_size)};
 }
 
 std::unordered_set<std::string> CommandLine::defaultSearchDirectories()
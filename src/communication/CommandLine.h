@@ -4,8 +4,13 @@
 #ifndef COMMANDLINE_H
 #define COMMANDLINE_H
 
+#include <cstdint> //For the status of files.
+#include <memory> //To store the parsed JSON documents.
 #include <rapidjson/document.h> //Loading JSON documents to get settings from them.
 #include <string> //To store the command line arguments.
+#include <unordered_map> //To look up the parsed JSON documents by file name.
+#include <unordered_set> //To store the directories to search for definition files.
+#include <utility> //For pair.
 #include <vector> //To store the command line arguments.
 
 #include "Communication.h" //The class we're implementing.
@@ -13,6 +18,7 @@
 namespace cura
 {
 class Settings;
+class Slice;
 
 /*
  * \brief When slicing via the command line, interprets the command line
@@ -21,6 +27,27 @@ class Settings;
 class CommandLine : public Communication
 {
 public:
+    /*
+     * \brief When a file was last modified and how large it is, to find out
+     * whether it changed since it was loaded.
+     */
+    struct FileStatus
+    {
+        int64_t modified_time; //!< When the file was last modified, in seconds since the epoch, or -1 if it doesn't exist.
+        int64_t size; //!< The size of the file in bytes, or -1 if it doesn't exist.
+
+        bool operator==(const FileStatus& other) const
+        {
+            return modified_time == other.modified_time && size == other.size;
+        }
+    };
+
+    /*
+     * \brief Get when a file was last modified and how large it is.
+     * \param filename The file to get the status of.
+     */
+    static FileStatus getFileStatus(const std::string& filename);
+
     /*
      * \brief Construct a new communicator that interprets the command line to
      * start a slice.
@@ -143,22 +170,18 @@ public:
      */
     void sliceNext() override;
 
-private:
+protected:
     /*
      * \brief The command line arguments that the application was called with.
      */
     std::vector<std::string> arguments;
 
     /*
-     * The last progress update that we output to stdcerr.
-     */
-    unsigned int last_shown_progress;
-
-    /*
-     * \brief Get the default search directories to search for definition files.
-     * \return The default search directories to search for definition files.
+     * \brief Whether to keep the JSON documents in memory once they are parsed,
+     * so that loading the same file again doesn't parse it again, unless the
+     * file changed since.
      */
-    std::unordered_set<std::string> defaultSearchDirectories();
+    bool cache_json_documents;
 
     /*
      * \brief Load a JSON file and store the settings inside it.
@@ -170,6 +193,52 @@ private:
      */
     int loadJSON(const std::string& json_filename, Settings& settings);
 
+    /*
+     * \brief Get the number of mesh groups that the command line arguments
+     * describe.
+     */
+    size_t getMeshGroupCount() const;
+
+    /*
+     * \brief Set where to write the g-code to and how, from the command line
+     * arguments that are about the output: -o, -z, -b and --binary.
+     * \return Whether the output could be set up. If not, an error has been
+     * logged.
+     */
+    bool applyTargetArguments();
+
+    /*
+     * \brief Load the settings and models of the command line arguments into
+     * a slice, except the arguments about the output.
+     * \param slice The slice to load into. It should have as many mesh groups
+     * as \ref CommandLine::getMeshGroupCount.
+     * \param[out] setting_targets If given, stores for each setting argument,
+     * by the index of its value in the arguments, the settings it was stored
+     * in.
+     * \return Whether all arguments could be loaded. If not, an error has been
+     * logged.
+     */
+    bool loadArguments(Slice& slice, std::unordered_map<size_t, Settings*>* setting_targets = nullptr);
+
+private:
+    /*
+     * The last progress update that we output to stdcerr.
+     */
+    unsigned int last_shown_progress;
+
+    /*
+     * \brief The JSON documents parsed so far, by file name, with the status
+     * of their file when they were parsed, if
+     * \ref CommandLine::cache_json_documents is set.
+     */
+    std::unordered_map<std::string, std::pair<FileStatus, std::unique_ptr<rapidjson::Document>>> json_documents;
+
+    /*
+     * \brief Get the default search directories to search for definition files.
+     * \return The default search directories to search for definition files.
+     */
+    std::unordered_set<std::string> defaultSearchDirectories();
+
     /*
      * \brief Load a JSON document and store the settings inside it.
      * \param document The JSON document to load the settings from.
@@ -0,0 +1,401 @@
+//Copyright (c) 2018 Ultimaker B.V.
+//CuraEngine is released under the terms of the AGPLv3 or higher.
+
+#include <algorithm> //For std::find.
+#include <cstdio> //To flush the output before forking.
+#include <cstdlib> //For exit.
+#include <cstring> //To fill in the address of the socket.
+#include <sstream> //To split the request into arguments.
+#ifdef _OPENMP
+    #include <omp.h> //To limit the process that writes the g-code to a single thread.
+#endif // _OPENMP
+#if defined(__linux__) || (defined(__APPLE__) && defined(__MACH__))
+    #include <csignal> //To keep running when a client disconnects before it gets its answer.
+    #include <sys/socket.h> //To listen for jobs.
+    #include <sys/stat.h> //To find a socket left behind by an earlier daemon.
+    #include <sys/un.h> //For the address of the socket.
+    #include <sys/wait.h> //To wait for the process that writes the g-code.
+    #include <unistd.h> //To fork the process that writes the g-code.
+#endif
+
+#include "BatchCommandLine.h" //To split the request into arguments like the lines of a manifest.
+#include "DaemonCommandLine.h"
+#include "../Application.h" //To set the slice that is being processed.
+#include "../FffProcessor.h" //To set where to write the g-code.
+#include "../Slice.h"
+#include "../utils/gettime.h" //To report how long writing the g-code took.
+#include "../utils/logoutput.h"
+
+namespace cura
+{
+
+DaemonCommandLine::DaemonCommandLine(const std::string& executable, const std::string& socket_path)
+: CommandLine({})
+, executable(executable)
+, socket_path(socket_path)
+, socket_fd(-1)
+, daemon_process_id(-1)
+, running(false)
+{
+    cache_json_documents = true; //Most jobs use the same machine definitions.
+
+#if defined(__linux__) || (defined(__APPLE__) && defined(__MACH__))
+    sockaddr_un address;
+    memset(&address, 0, sizeof(address));
+    address.sun_family = AF_UNIX;
+    if (socket_path.empty() || socket_path.size() >= sizeof(address.sun_path))
+    {
+        logError("Invalid socket path: %s\n", socket_path.c_str());
+        exit(1);
+    }
+    strncpy(address.sun_path, socket_path.c_str(), sizeof(address.sun_path) - 1);
+
+    struct stat file_status;
+    if (stat(socket_path.c_str(), &file_status) == 0 && S_ISSOCK(file_status.st_mode)) //Left behind by a daemon that didn't stop cleanly.
+    {
+        unlink(socket_path.c_str());
+    }
+
+    socket_fd = socket(AF_UNIX, SOCK_STREAM, 0);
+    if (socket_fd < 0 || bind(socket_fd, reinterpret_cast<sockaddr*>(&address), sizeof(address)) != 0 || listen(socket_fd, 8) != 0)
+    {
+        logError("Failed to listen on socket %s.\n", socket_path.c_str());
+        exit(1);
+    }
+    signal(SIGPIPE, SIG_IGN);
+    daemon_process_id = getpid();
+    running = true;
+    log("Listening for jobs on %s.\n", socket_path.c_str());
+#else
+    logError("The daemon is not supported on this platform.\n");
+    exit(1);
+#endif
+}
+
+DaemonCommandLine::~DaemonCommandLine()
+{
+#if defined(__linux__) || (defined(__APPLE__) && defined(__MACH__))
+    if (socket_fd >= 0)
+    {
+        close(socket_fd);
+        if (getpid() == daemon_process_id)
+        {
+            unlink(socket_path.c_str());
+        }
+    }
+#endif
+}
+
+bool DaemonCommandLine::findDownstreamChanges(const std::vector<std::string>& last_arguments, const std::vector<std::string>& arguments, std::unordered_map<size_t, std::string>& changed_settings)
+{
+    //Find the arguments that are loaded into the slice, by their index, leaving out the arguments about the output.
+    auto get_loaded_indices = [](const std::vector<std::string>& arguments)
+    {
+        std::vector<size_t> result;
+        for (size_t argument_index = 2; argument_index < arguments.size(); argument_index++)
+        {
+            const std::string& argument = arguments[argument_index];
+            if (argument == "--binary" || argument.find("-z") == 0 || argument.find("-b") == 0)
+            {
+                continue;
+            }
+            if (argument == "-o")
+            {
+                argument_index++;
+                continue;
+            }
+            result.push_back(argument_index);
+            if ((argument == "-j" || argument == "-l" || argument == "-s") && argument_index + 1 < arguments.size())
+            {
+                argument_index++; //The value may start with a "-" too.
+                result.push_back(argument_index);
+            }
+        }
+        return result;
+    };
+    const std::vector<size_t> last_indices = get_loaded_indices(last_arguments);
+    const std::vector<size_t> indices = get_loaded_indices(arguments);
+    if (last_indices.size() != indices.size())
+    {
+        return false;
+    }
+
+    changed_settings.clear();
+    for (size_t i = 0; i < indices.size(); i++)
+    {
+        const std::string& last_argument = last_arguments[last_indices[i]];
+        const std::string& argument = arguments[indices[i]];
+        if (argument == last_argument)
+        {
+            continue;
+        }
+        //Only the value of a setting argument may differ, of the same setting, which is only used when writing the g-code.
+        if (i == 0 || last_arguments[last_indices[i - 1]] != "-s" || arguments[indices[i - 1]] != "-s")
+        {
+            return false;
+        }
+        const size_t last_value_position = last_argument.find("=");
+        const size_t value_position = argument.find("=");
+        if (value_position == std::string::npos || last_argument.compare(0, last_value_position, argument, 0, value_position) != 0 || !isDownstreamSetting(argument.substr(0, value_position)))
+        {
+            return false;
+        }
+        changed_settings[last_indices[i]] = argument;
+    }
+    return true;
+}
+
+bool DaemonCommandLine::isDownstreamSetting(const std::string& key)
+{
+    //Prefixes of the settings that are only used by FffGcodeWriter, LayerPlan and GCodeExport.
+    static const std::vector<std::string> downstream_prefixes = {
+        "speed_",
+        "acceleration_",
+        "jerk_",
+        "retraction_",
+        "retract_",
+        "cool_",
+        "material_print_temperature",
+        "material_initial_print_temperature",
+        "material_final_print_temperature",
+        "material_bed_temperature",
+        "material_standby_temperature",
+        "material_flow",
+        "machine_start_gcode",
+        "machine_end_gcode"
+    };
+    for (const std::string& prefix : downstream_prefixes)
+    {
+        if (key.compare(0, prefix.size(), prefix) == 0)
+        {
+            return true;
+        }
+    }
+    return false;
+}
+
+std::unordered_map<std::string, CommandLine::FileStatus> DaemonCommandLine::getInputFileStatuses(const std::vector<std::string>& arguments)
+{
+    std::unordered_map<std::string, FileStatus> result;
+    for (size_t argument_index = 2; argument_index + 1 < arguments.size(); argument_index++)
+    {
+        if (arguments[argument_index] == "-j" || arguments[argument_index] == "-l")
+        {
+            argument_index++;
+            result.emplace(arguments[argument_index], getFileStatus(arguments[argument_index]));
+        }
+    }
+    return result;
+}
+
+bool DaemonCommandLine::hasSlice() const
+{
+    return running;
+}
+
+void DaemonCommandLine::sliceNext()
+{
+#if defined(__linux__) || (defined(__APPLE__) && defined(__MACH__))
+    const int connection_fd = accept(socket_fd, nullptr, nullptr);
+    if (connection_fd < 0)
+    {
+        logError("Failed to accept a connection on socket %s.\n", socket_path.c_str());
+        return;
+    }
+    const std::string request = readLine(connection_fd);
+    if (request == "quit")
+    {
+        log("Stopping the daemon.\n");
+        writeLine(connection_fd, "OK quit");
+        close(connection_fd);
+        running = false;
+        return;
+    }
+
+    arguments = parseRequest(request);
+    std::unordered_map<size_t, std::string> changed_settings;
+    std::string answer;
+    if (last_slice && findDownstreamChanges(last_arguments, arguments, changed_settings) && getInputFileStatuses(last_arguments) == last_input_files)
+    {
+        log("Writing the g-code of the last job again with %d changed settings.\n", static_cast<int>(changed_settings.size()));
+        for (const std::pair<const size_t, std::string>& changed_setting : changed_settings)
+        {
+            const std::string& argument = changed_setting.second;
+            const size_t value_position = argument.find("=");
+            setting_targets[changed_setting.first]->add(argument.substr(0, value_position), argument.substr(value_position + 1));
+            last_arguments[changed_setting.first] = argument;
+        }
+        answer = writeGCode() ? "OK rewritten" : "FAILED";
+    }
+    else
+    {
+        answer = (loadSlice() && writeGCode()) ? "OK sliced" : "FAILED";
+    }
+    arguments.clear();
+
+    writeLine(connection_fd, answer);
+    close(connection_fd);
+#endif
+}
+
+std::vector<std::string> DaemonCommandLine::parseRequest(const std::string& request) const
+{
+    std::vector<std::string> result = {executable, "slice"};
+    std::istringstream request_stream(request);
+    const std::vector<std::vector<std::string>> lines = BatchCommandLine::readManifest(request_stream);
+    if (!lines.empty())
+    {
+        result.insert(result.end(), lines[0].begin(), lines[0].end());
+    }
+    return result;
+}
+
+bool DaemonCommandLine::loadSlice()
+{
+    //Release the last job before loading the next one.
+    last_storages.clear();
+    last_slice.reset();
+    setting_targets.clear();
+    last_arguments.clear();
+    last_input_files.clear();
+    Application::getInstance().current_slice = nullptr;
+
+    const std::unordered_map<std::string, FileStatus> input_files = getInputFileStatuses(arguments); //Before loading, so that a change while loading is noticed next time.
+    FffProcessor::getInstance()->time_keeper.restart();
+    last_slice.reset(new Slice(getMeshGroupCount()));
+    Application::getInstance().current_slice = last_slice.get();
+    if (!loadArguments(*last_slice, &setting_targets))
+    {
+        last_slice.reset();
+        setting_targets.clear();
+        Application::getInstance().current_slice = nullptr;
+        return false;
+    }
+
+#ifndef DEBUG
+    try
+    {
+#endif //DEBUG
+        last_slice->scene.mesh_groups.back().finalize();
+        log("Loaded from disk in %5.3fs\n", FffProcessor::getInstance()->time_keeper.restart());
+
+        last_storages = last_slice->sliceMeshGroups();
+#ifndef DEBUG
+    }
+    catch(...)
+    {
+        logError("Unknown exception.\n");
+        last_storages.clear();
+        last_slice.reset();
+        setting_targets.clear();
+        Application::getInstance().current_slice = nullptr;
+        return false;
+    }
+#endif //DEBUG
+
+    last_arguments = arguments;
+    last_input_files = input_files;
+    return true;
+}
+
+bool DaemonCommandLine::writeGCode()
+{
+    if (std::find(arguments.begin() + 2, arguments.end(), "-o") == arguments.end())
+    {
+        logError("The job has no output file.\n");
+        return false;
+    }
+
+#if defined(__linux__) || (defined(__APPLE__) && defined(__MACH__))
+    TimeKeeper time_keeper;
+
+    //Otherwise the process that writes the g-code writes what's still in the buffers again.
+    fflush(stdout);
+    fflush(stderr);
+    const pid_t process_id = fork();
+    if (process_id < 0)
+    {
+        logError("Failed to start a process to write the g-code.\n");
+        return false;
+    }
+    if (process_id == 0) //This is the process that writes the g-code.
+    {
+#ifdef _OPENMP
+        omp_set_num_threads(1); //The threads that OpenMP started in the daemon don't exist in this process.
+#endif // _OPENMP
+        FffProcessor::getInstance()->setTargetStdout(); //Unless an output file is given.
+        if (!applyTargetArguments())
+        {
+            exit(1);
+        }
+#ifndef DEBUG
+        try
+        {
+#endif //DEBUG
+            last_slice->compute(last_storages);
+#ifndef DEBUG
+        }
+        catch(...)
+        {
+            logError("Unknown exception.\n");
+            exit(1);
+        }
+#endif //DEBUG
+        FffProcessor::getInstance()->finalize();
+        if (!FffProcessor::getInstance()->closeTarget())
+        {
+            logError("Failed to write the g-code.\n");
+            exit(1);
+        }
+        exit(0);
+    }
+
+    int status;
+    if (waitpid(process_id, &status, 0) != process_id || !WIFEXITED(status) || WEXITSTATUS(status) != 0)
+    {
+        logError("Failed to write the g-code.\n");
+        return false;
+    }
+    log("Wrote the g-code in %5.3fs\n", time_keeper.restart());
+    return true;
+#else
+    return false;
+#endif
+}
+
+std::string DaemonCommandLine::readLine(const int connection_fd) const
+{
+    std::string result;
+#if defined(__linux__) || (defined(__APPLE__) && defined(__MACH__))
+    char character;
+    while (read(connection_fd, &character, 1) == 1 && character != '\n')
+    {
+        result.push_back(character);
+    }
+    if (!result.empty() && result.back() == '\r')
+    {
+        result.pop_back();
+    }
+#endif
+    return result;
+}
+
+void DaemonCommandLine::writeLine(const int connection_fd, const std::string& line) const
+{
+#if defined(__linux__) || (defined(__APPLE__) && defined(__MACH__))
+    const std::string message = line + "\n";
+    size_t written = 0;
+    while (written < message.size())
+    {
+        const ssize_t result = write(connection_fd, message.data() + written, message.size() - written);
+        if (result <= 0)
+        {
+            logWarning("Failed to answer the client.\n");
+            return;
+        }
+        written += result;
+    }
+#endif
+}
+
+} //namespace cura
@@ -0,0 +1,184 @@
+//Copyright (c) 2018 Ultimaker B.V.
+//CuraEngine is released under the terms of the AGPLv3 or higher.
+
+#ifndef DAEMONCOMMANDLINE_H
+#define DAEMONCOMMANDLINE_H
+
+#include <memory> //To keep the slice and its layer data between requests.
+#include <unordered_map> //To find the settings of each setting argument.
+
+#include "CommandLine.h" //The class we're extending.
+
+namespace cura
+{
+class SliceDataStorage;
+
+/*
+ * \brief Keeps running in the background and slices the jobs that it receives
+ * through a local socket, as if CuraEngine were called with "slice" for each
+ * of them.
+ *
+ * Each connection to the socket sends a single line with the same arguments as
+ * after "CuraEngine slice", which need to include an output file. The daemon
+ * answers with a line starting with "OK" or "FAILED" once the g-code is
+ * written. The line "quit" stops the daemon.
+ *
+ * The models and layer data of the last job are kept. If the next job only
+ * changes settings that are used when writing the g-code, such as speeds,
+ * temperatures, retraction and cooling, only the g-code is written again
+ * from the kept layer data, which is a lot faster than slicing again. If a
+ * model or JSON file of the job changed on disk since, it's sliced again.
+ *
+ * Writing g-code leaves state behind in the engine and releases the layer data
+ * as it goes, so the g-code is written in a process forked off from the
+ * daemon. That way the kept layer data stays intact and each job gives the
+ * same g-code as when it's sliced on its own.
+ */
+class DaemonCommandLine : public CommandLine
+{
+public:
+    /*
+     * \brief Construct a new communicator that listens to a local socket for
+     * jobs to slice.
+     * \param executable The name with which the application was called.
+     * \param socket_path Where to create the socket.
+     */
+    DaemonCommandLine(const std::string& executable, const std::string& socket_path);
+
+    /*
+     * \brief Close and remove the socket.
+     */
+    ~DaemonCommandLine();
+
+    /*
+     * \brief Find the settings that changed between two jobs, if those are the
+     * only changes and they are only used when writing the g-code.
+     *
+     * Arguments about the output, like the output file, are allowed to differ
+     * too.
+     * \param last_arguments The arguments of the previous job.
+     * \param arguments The arguments of the next job.
+     * \param[out] changed_settings The changed setting arguments, by the index
+     * of their value in the arguments of the previous job, with their new
+     * value.
+     * \return Whether the g-code of the next job can be written from the layer
+     * data of the previous job.
+     */
+    static bool findDownstreamChanges(const std::vector<std::string>& last_arguments, const std::vector<std::string>& arguments, std::unordered_map<size_t, std::string>& changed_settings);
+
+    /*
+     * \brief Whether a setting is only used when writing the g-code, so that
+     * it doesn't affect the layer data.
+     * \param key The key of the setting.
+     */
+    static bool isDownstreamSetting(const std::string& key);
+
+    /*
+     * \brief Get the status of the model and JSON files of a job, to find out
+     * whether they changed since the job was loaded.
+     * \param arguments The arguments of the job.
+     * \return The status of each file given with "-l" or "-j", by file name.
+     */
+    static std::unordered_map<std::string, FileStatus> getInputFileStatuses(const std::vector<std::string>& arguments);
+
+    /*
+     * \brief Test if the daemon is still running.
+     */
+    bool hasSlice() const override;
+
+    /*
+     * \brief Wait for the next job and slice it.
+     */
+    void sliceNext() override;
+
+private:
+    /*
+     * \brief The name with which the application was called.
+     */
+    std::string executable;
+
+    /*
+     * \brief Where the socket was created.
+     */
+    std::string socket_path;
+
+    /*
+     * \brief The file descriptor of the socket, or -1 if it isn't open.
+     */
+    int socket_fd;
+
+    /*
+     * \brief The process that created the socket.
+     *
+     * Only that process may remove it, not the processes that write g-code.
+     */
+    int daemon_process_id;
+
+    /*
+     * \brief Whether the daemon should keep waiting for jobs.
+     */
+    bool running;
+
+    /*
+     * \brief The arguments that the kept slice was loaded from, with the
+     * settings changed since.
+     */
+    std::vector<std::string> last_arguments;
+
+    /*
+     * \brief The status of the model and JSON files of the last job, from
+     * before they were loaded.
+     */
+    std::unordered_map<std::string, FileStatus> last_input_files;
+
+    /*
+     * \brief The slice of the last job, with its models and settings.
+     */
+    std::unique_ptr<Slice> last_slice;
+
+    /*
+     * \brief The layer data of each mesh group of the last job.
+     */
+    std::vector<std::unique_ptr<SliceDataStorage>> last_storages;
+
+    /*
+     * \brief The settings that each setting argument of the last job was
+     * stored in, by the index of its value in the arguments.
+     */
+    std::unordered_map<size_t, Settings*> setting_targets;
+
+    /*
+     * \brief Get the arguments of a job, including the executable and "slice".
+     * \param request The line that was sent through the socket.
+     */
+    std::vector<std::string> parseRequest(const std::string& request) const;
+
+    /*
+     * \brief Load and slice the models of a job, replacing the kept slice.
+     * \return Whether the job could be loaded and sliced.
+     */
+    bool loadSlice();
+
+    /*
+     * \brief Write the g-code of the kept slice, in a new process.
+     * \return Whether the g-code was written successfully.
+     */
+    bool writeGCode();
+
+    /*
+     * \brief Read a line from a connection to the socket.
+     * \param connection_fd The file descriptor of the connection.
+     */
+    std::string readLine(const int connection_fd) const;
+
+    /*
+     * \brief Send a line through a connection to the socket.
+     * \param connection_fd The file descriptor of the connection.
+     * \param line The line to send, without line ending.
+     */
+    void writeLine(const int connection_fd, const std::string& line) const;
+};
+
+} //namespace cura
+
+#endif //DAEMONCOMMANDLINE_H
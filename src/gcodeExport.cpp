@@ -4,6 +4,8 @@
 #include <stdarg.h>
 #include <iomanip>
 #include <cmath>
+#include <memory> // shared_ptr
+#include <thread> // hardware_concurrency
 
 #include "Application.h" //To send layer view data.
 #include "communication/Communication.h" //To send layer view data.
@@ -11,6 +13,7 @@
 #include "utils/logoutput.h"
 #include "PrintFeature.h"
 #include "utils/Date.h"
+#include "utils/DeferredFormatBuffer.h" // To calculate time estimates while the layer waits to be formatted.
 #include "utils/string.h" // MMtoStream, PrecisionedDouble
 
 namespace cura {
@@ -252,6 +255,11 @@ void GCodeExport::setOutputStream(std::ostream* stream)
     *output_stream << std::fixed;
 }
 
+std::ostream* GCodeExport::getOutputStream()
+{
+    return output_stream;
+}
+
 bool GCodeExport::getExtruderIsUsed(const int extruder_nr) const
 {
     assert(extruder_nr >= 0);
@@ -407,6 +415,11 @@ double GCodeExport::getTotalFilamentUsed(size_t extruder_nr)
 
 std::vector<Duration> GCodeExport::getTotalPrintTimePerFeature()
 {
+    if (pending_print_times.valid())
+    {
+        total_print_times = pending_print_times.get();
+        pending_print_times = std::shared_future<std::vector<Duration>>();
+    }
     return total_print_times;
 }
 
@@ -433,11 +446,59 @@ void GCodeExport::resetTotalPrintTimeAndFilament()
         extruder_attr[e].waited_for_temperature = false;
     }
     current_e_value = 0.0;
+    pending_print_times = std::shared_future<std::vector<Duration>>();
     estimateCalculator.reset();
 }
 
 void GCodeExport::updateTotalPrintTime()
 {
+    DeferredFormatBuffer* deferred_buffer = DeferredFormatBuffer::of(*output_stream);
+    if (deferred_buffer)
+    {
+        // Each layer starts and ends at standstill in the estimate, so the estimate of the layer can be calculated on its own,
+        // while the next layers are planned. Only adding it to the totals waits for the estimates of the previous layers.
+        static const std::launch policy = (std::thread::hardware_concurrency() > 1) ? std::launch::async : std::launch::deferred;
+        // moving leaves the firmware settings and the position in place, and only takes the planned moves
+        std::shared_ptr<TimeEstimateCalculator> layer_estimate = std::make_shared<TimeEstimateCalculator>(std::move(estimateCalculator));
+        estimateCalculator.reset();
+        std::shared_future<std::vector<Duration>> previous_totals = pending_print_times; // not const, so that the copy in the function can be released
+        std::vector<Duration> totals = total_print_times;
+        pending_print_times = std::async(policy, [layer_estimate, previous_totals, totals]() mutable
+            {
+                // the shared state of the future keeps this function alive, so release the estimate and the previous layers as soon as they're used
+                std::shared_ptr<TimeEstimateCalculator> estimate = std::move(layer_estimate);
+                std::shared_future<std::vector<Duration>> previous = std::move(previous_totals);
+                const std::vector<Duration> estimates = estimate->calculate();
+                estimate.reset();
+                std::vector<Duration> result = std::move(totals);
+                if (previous.valid())
+                {
+                    result = previous.get();
+                    previous = std::shared_future<std::vector<Duration>>();
+                }
+                for (size_t i = 0; i < estimates.size(); i++)
+                {
+                    result[i] += estimates[i];
+                }
+                return result;
+            }).share();
+        const std::shared_future<std::vector<Duration>> layer_totals = pending_print_times;
+        const std::shared_future<double> time_elapsed = std::async(std::launch::deferred, [layer_totals]()
+            {
+                double sum = 0.0;
+                for (const Duration& item : layer_totals.get())
+                {
+                    sum += item;
+                }
+                return sum;
+            }).share();
+        *output_stream << ";TIME_ELAPSED:";
+        deferred_buffer->deferPending(time_elapsed, *output_stream);
+        *output_stream << new_line;
+        return;
+    }
+
+    getTotalPrintTimePerFeature(); // wait for the estimates of layers which are still being calculated
     std::vector<Duration> estimates = estimateCalculator.calculate();
     for(size_t i = 0; i < estimates.size(); i++)
     {
@@ -581,6 +642,53 @@ void GCodeExport::writeExtrusion(const Point3& p, const Velocity& speed, double
     writeExtrusion(p.x, p.y, p.z, speed, extrusion_mm3_per_mm, feature, update_extrusion_offset);
 }
 
+void GCodeExport::writeArc(const Point& end, const Point& center, const bool clockwise, const Velocity& speed, const double extrusion_mm3_per_mm, const PrintFeatureType& feature, const bool update_extrusion_offset)
+{
+    const coord_t z = current_layer_z;
+    if (currentPosition.x == end.X && currentPosition.y == end.Y && currentPosition.z == z)
+    {
+        return;
+    }
+
+    const double extrusion_per_mm = prepareExtrusion(speed, extrusion_mm3_per_mm, update_extrusion_offset, Point3(end.X, end.Y, z));
+
+    //The angles around the center from the start, in the direction of the arc.
+    const Point start(currentPosition.x, currentPosition.y);
+    const Point from = start - center;
+    auto angle_from_start = [&from, clockwise](const Point& to)
+    {
+        double angle = std::atan2(static_cast<double>(from.X) * to.Y - static_cast<double>(from.Y) * to.X, static_cast<double>(from.X) * to.X + static_cast<double>(from.Y) * to.Y);
+        if (clockwise)
+        {
+            angle = -angle;
+        }
+        if (angle <= 0)
+        {
+            angle += 2 * M_PI;
+        }
+        return angle;
+    };
+    const double angle = angle_from_start(end - center);
+    const double arc_length = std::hypot(angle * vSizeMM(from), INT2MM(z - currentPosition.z));
+    const double new_e_value = current_e_value + extrusion_per_mm * arc_length;
+
+    //The arc can bulge out beyond its start and end, at the points of the circle furthest along X or Y that it passes.
+    const coord_t radius = vSize(from);
+    for (const Point direction : {Point(1, 0), Point(0, 1), Point(-1, 0), Point(0, -1)})
+    {
+        if (angle_from_start(direction) < angle)
+        {
+            const Point extreme = center + direction * radius;
+            const Point gcode_extreme = getGcodePos(extreme.X, extreme.Y, current_extruder);
+            total_bounding_box.include(Point3(gcode_extreme.X, gcode_extreme.Y, z));
+        }
+    }
+
+    *output_stream << (clockwise ? "G2" : "G3");
+    const Point center_offset = center - start;
+    writeFXYZE(speed, end.X, end.Y, z, new_e_value, feature, &center_offset, clockwise);
+}
+
 void GCodeExport::writeMoveBFB(const int x, const int y, const int z, const Velocity& speed, double extrusion_mm3_per_mm, PrintFeatureType feature)
 {
     if (std::isinf(extrusion_mm3_per_mm))
@@ -683,6 +791,18 @@ void GCodeExport::writeExtrusion(const int x, const int y, const int z, const Ve
     assert(extrusion_mm3_per_mm >= 0.0);
 #endif //ASSERT_INSANE_OUTPUT
 
+    const double extrusion_per_mm = prepareExtrusion(speed, extrusion_mm3_per_mm, update_extrusion_offset, Point3(x, y, z));
+
+    const Point3 diff = Point3(x,y,z) - currentPosition;
+
+    double new_e_value = current_e_value + extrusion_per_mm * diff.vSizeMM();
+
+    *output_stream << "G1";
+    writeFXYZE(speed, x, y, z, new_e_value, feature);
+}
+
+double GCodeExport::prepareExtrusion(const Velocity& speed, const double extrusion_mm3_per_mm, const bool update_extrusion_offset, const Point3& end)
+{
     if (std::isinf(extrusion_mm3_per_mm))
     {
         logError("Extrusion rate is infinite!");
@@ -702,14 +822,14 @@ void GCodeExport::writeExtrusion(const int x, const int y, const int z, const Ve
         logWarning("Warning! Negative extrusion move!\n");
     }
 
-    double extrusion_per_mm = mm3ToE(extrusion_mm3_per_mm);
+    const double extrusion_per_mm = mm3ToE(extrusion_mm3_per_mm);
 
     if (is_z_hopped > 0)
     {
         writeZhopEnd();
     }
 
-    Point3 diff = Point3(x,y,z) - currentPosition;
+    const Point3 diff = end - currentPosition;
 
     writeUnretractionAndPrime();
 
@@ -730,13 +850,10 @@ void GCodeExport::writeExtrusion(const int x, const int y, const int z, const Ve
         *output_stream << ";FLOW_RATE_COMPENSATED_OFFSET = " << current_e_offset << new_line;
     }
 
-    double new_e_value = current_e_value + extrusion_per_mm * diff.vSizeMM();
-
-    *output_stream << "G1";
-    writeFXYZE(speed, x, y, z, new_e_value, feature);
+    return extrusion_per_mm;
 }
 
-void GCodeExport::writeFXYZE(const Velocity& speed, const int x, const int y, const int z, const double e, const PrintFeatureType& feature)
+void GCodeExport::writeFXYZE(const Velocity& speed, const int x, const int y, const int z, const double e, const PrintFeatureType& feature, const Point* arc_center_offset, const bool clockwise)
 {
     if (currentSpeed != speed)
     {
@@ -752,6 +869,10 @@ void GCodeExport::writeFXYZE(const Velocity& speed, const int x, const int y, co
     {
         *output_stream << " Z" << MMtoStream{z};
     }
+    if (arc_center_offset)
+    {
+        *output_stream << " I" << MMtoStream{arc_center_offset->X} << " J" << MMtoStream{arc_center_offset->Y};
+    }
     if (e + current_e_offset != current_e_value)
     {
         const double output_e = (relative_extrusion)? e + current_e_offset - current_e_value : e + current_e_offset;
@@ -761,7 +882,15 @@ void GCodeExport::writeFXYZE(const Velocity& speed, const int x, const int y, co
     
     currentPosition = Point3(x, y, z);
     current_e_value = e;
-    estimateCalculator.plan(TimeEstimateCalculator::Position(INT2MM(x), INT2MM(y), INT2MM(z), eToMm(e)), speed, feature);
+    const TimeEstimateCalculator::Position position(INT2MM(x), INT2MM(y), INT2MM(z), eToMm(e));
+    if (arc_center_offset)
+    {
+        estimateCalculator.planArc(position, INT2MM(arc_center_offset->X), INT2MM(arc_center_offset->Y), clockwise, speed, feature);
+    }
+    else
+    {
+        estimateCalculator.plan(position, speed, feature);
+    }
 }
 
 void GCodeExport::writeUnretractionAndPrime()
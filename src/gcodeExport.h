@@ -6,6 +6,7 @@
 
 #include <stdio.h>
 #include <deque> // for extrusionAmountAtPreviousRetractions
+#include <future> // for pending_print_times
 #include <sstream> // for stream.str()
 
 #include "timeEstimate.h"
@@ -106,6 +107,7 @@ private:
     EGCodeFlavor flavor;
 
     std::vector<Duration> total_print_times; //!< The total estimated print time in seconds for each feature
+    std::shared_future<std::vector<Duration>> pending_print_times; //!< The total print times including the layers of which the estimate is still being calculated, if any
     TimeEstimateCalculator estimateCalculator;
     
     bool is_volumatric;
@@ -176,6 +178,11 @@ public:
 
     void setOutputStream(std::ostream* stream);
 
+    /*!
+     * Get the stream to which the g-code is currently written.
+     */
+    std::ostream* getOutputStream();
+
     bool getExtruderIsUsed(const int extruder_nr) const; //!< return whether the extruder has been used throughout printing all meshgroup up till now
 
     Point getGcodePos(const coord_t x, const coord_t y, const int extruder_train) const;
@@ -226,6 +233,17 @@ public:
      * \return total print time in seconds for the complete print
      */
     double getSumTotalPrintTimes();
+
+    /*!
+     * Add the estimated time of the moves written since the last update to
+     * the total print times, and write the total print time so far as a
+     * comment.
+     *
+     * If the output stream formats its numbers later, see
+     * \ref DeferredFormatBuffer, the estimate is calculated on another thread
+     * while the next layers are written, and the comment is formatted once it
+     * is done.
+     */
     void updateTotalPrintTime();
     void resetTotalPrintTimeAndFilament();
     
@@ -299,6 +317,24 @@ public:
      * \param update_extrusion_offset whether to update the extrusion offset to match the current flow rate
      */
     void writeExtrusion(const Point3& p, const Velocity& speed, double extrusion_mm3_per_mm, PrintFeatureType feature, bool update_extrusion_offset = false);
+
+    /*!
+     * Extrude along a circular arc from the current position with G2 or G3,
+     * at the extrusion Z.
+     * Perform un-z-hop
+     * Perform unretraction
+     *
+     * Coordinates are build plate coordinates, which might be offsetted when extruder offsets are encoded in the gcode.
+     *
+     * \param end location to go to
+     * \param center the center of the circle the arc lies on
+     * \param clockwise whether to go clockwise (G2) or counter-clockwise (G3) around the center
+     * \param speed movement speed
+     * \param extrusion_mm3_per_mm flow
+     * \param feature the feature that's currently printing
+     * \param update_extrusion_offset whether to update the extrusion offset to match the current flow rate
+     */
+    void writeArc(const Point& end, const Point& center, const bool clockwise, const Velocity& speed, const double extrusion_mm3_per_mm, const PrintFeatureType& feature, const bool update_extrusion_offset = false);
 private:
     /*!
      * Coordinates are build plate coordinates, which might be offsetted when extruder offsets are encoded in the gcode.
@@ -326,17 +362,35 @@ private:
      */
     void writeExtrusion(const int x, const int y, const int z, const Velocity& speed, const double extrusion_mm3_per_mm, const PrintFeatureType& feature, const bool update_extrusion_offset = false);
 
+    /*!
+     * Get ready to extrude towards \p end: check the flow, perform un-z-hop
+     * and unretraction and update the flow rate compensation.
+     *
+     * convenience function called from writeExtrusion and writeArc
+     *
+     * \param speed movement speed
+     * \param extrusion_mm3_per_mm flow
+     * \param update_extrusion_offset whether to update the extrusion offset to match the current flow rate
+     * \param end build plate location the extrusion move goes to
+     * \return the E value to extrude per mm moved
+     */
+    double prepareExtrusion(const Velocity& speed, const double extrusion_mm3_per_mm, const bool update_extrusion_offset, const Point3& end);
+
     /*!
      * Write the F, X, Y, Z and E value (if they are not different from the last)
+     * and for arcs the I and J value
      * 
-     * convenience function called from writeExtrusion and writeTravel
+     * convenience function called from writeExtrusion, writeTravel and writeArc
      * 
      * This function also applies the gcode offset by calling \ref GCodeExport::getGcodePos
-     * This function updates the \ref GCodeExport::total_bounding_box
+     * This function updates the \ref GCodeExport::total_bounding_box with the end point only
      * It estimates the time in \ref GCodeExport::estimateCalculator for the correct feature
      * It updates \ref GCodeExport::currentPosition, \ref GCodeExport::current_e_value and \ref GCodeExport::currentSpeed
+     *
+     * \param arc_center_offset for an arc, the center of its circle relative to the current position, otherwise nullptr
+     * \param clockwise for an arc, whether it goes clockwise around the center
      */
-    void writeFXYZE(const Velocity& speed, const int x, const int y, const int z, const double e, const PrintFeatureType& feature);
+    void writeFXYZE(const Velocity& speed, const int x, const int y, const int z, const double e, const PrintFeatureType& feature, const Point* arc_center_offset = nullptr, const bool clockwise = false);
 
     /*!
      * The writeTravel and/or writeExtrusion when flavor == BFB
@@ -1,6 +1,8 @@
 //Copyright (c) 2018 Ultimaker B.V.
 //CuraEngine is released under the terms of the AGPLv3 or higher.
 
+#include <algorithm> //For std::min.
+
 #include "mesh.h"
 #include "utils/logoutput.h"
 
@@ -49,6 +51,26 @@ void Mesh::addFace(Point3& v0, Point3& v1, Point3& v2)
     vertices[face.vertex_index[2]].connected_faces.push_back(idx);
 }
 
+void Mesh::addFaces(const float* vertex_data, const size_t face_count, const FMatrix3x3& matrix)
+{
+    faces.reserve(faces.size() + face_count);
+    vertices.reserve(vertices.size() + face_count / 2); // a closed mesh has about half as many vertices as faces
+    vertex_hash_map.reserve(vertex_hash_map.size() + face_count / 2);
+
+    // transform the vertices in batches, so that a large mesh isn't copied in full
+    constexpr size_t batch_face_count = 4096;
+    std::vector<Point3> batch(std::min(face_count, batch_face_count) * 3);
+    for (size_t batch_start = 0; batch_start < face_count; batch_start += batch_face_count)
+    {
+        const size_t batch_end = std::min(face_count, batch_start + batch_face_count);
+        matrix.apply(vertex_data + batch_start * 9, (batch_end - batch_start) * 3, batch.data());
+        for (size_t face_idx = 0; face_idx < batch_end - batch_start; face_idx++)
+        {
+            addFace(batch[face_idx * 3], batch[face_idx * 3 + 1], batch[face_idx * 3 + 2]);
+        }
+    }
+}
+
 void Mesh::clear()
 {
     faces.clear();
@@ -96,15 +118,16 @@ void Mesh::expandXY(int64_t offset)
 int Mesh::findIndexOfVertex(const Point3& v)
 {
     uint32_t hash = pointHash(v);
+    std::vector<uint32_t>& vertices_with_hash = vertex_hash_map[hash];
 
-    for(unsigned int idx = 0; idx < vertex_hash_map[hash].size(); idx++)
+    for(unsigned int idx = 0; idx < vertices_with_hash.size(); idx++)
     {
-        if ((vertices[vertex_hash_map[hash][idx]].p - v).testLength(vertex_meld_distance))
+        if ((vertices[vertices_with_hash[idx]].p - v).testLength(vertex_meld_distance))
         {
-            return vertex_hash_map[hash][idx];
+            return vertices_with_hash[idx];
         }
     }
-    vertex_hash_map[hash].push_back(vertices.size());
+    vertices_with_hash.push_back(vertices.size());
     vertices.emplace_back(v);
     
     aabb.include(v);
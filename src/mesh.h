@@ -6,6 +6,7 @@
 
 #include "settings/Settings.h"
 #include "utils/AABB3D.h"
+#include "utils/floatpoint.h"
 
 namespace cura
 {
@@ -72,6 +73,21 @@ public:
     Mesh();
 
     void addFace(Point3& v0, Point3& v1, Point3& v2); //!< add a face to the mesh without settings it's connected_faces.
+
+    /*!
+     * Add many faces to the mesh at once, without setting their
+     * connected_faces.
+     *
+     * The same as adding each face with \ref Mesh::addFace, but the vertices
+     * are read in place and transformed in bulk, and the memory for the faces
+     * is allocated once.
+     * \param vertex_data The coordinates of the vertices in millimetres: the x,
+     * y and z of the three vertices of each face after each other, as sent by
+     * the front-end.
+     * \param face_count The number of faces.
+     * \param matrix The transformation to apply to the vertices.
+     */
+    void addFaces(const float* vertex_data, const size_t face_count, const FMatrix3x3& matrix);
     void clear(); //!< clears all data
     void finish(); //!< complete the model : set the connected_face_index fields of the faces.
 
@@ -1,23 +1,101 @@
 /** Copyright (C) 2013 Ultimaker - Released under terms of the AGPLv3 License */
+#include <algorithm>
+#include <cmath>
+
 #include "pathOrderOptimizer.h"
+#include "utils/AABB.h"
+#include "utils/gettime.h"
 #include "utils/logoutput.h"
 #include "utils/SparsePointGridInclusive.h"
 #include "utils/linearAlg2D.h"
 #include "pathPlanning/LinePolygonsCrossings.h"
 #include "pathPlanning/CombPath.h"
+#include "pathPlanning/TravelPlanCache.h"
 
 #define INLINE static inline
 
 namespace cura {
 
+/*!
+ * Hash everything the order found by an order optimizer depends on, to look it
+ * up in a TravelPlanCache.
+ *
+ * \param optimizer_type Distinguishes the orders of the different optimizers.
+ * \param start_point Where the travel to the first polygon starts.
+ * \param polygons The polygons to order.
+ * \param combing_boundary The boundary to comb within, if any.
+ * \param combing_boundary_hash The hash of \p combing_boundary, if already known.
+ */
+static GeometryHash hashOrderInput(const int optimizer_type, const Point& start_point, const std::vector<ConstPolygonPointer>& polygons, const Polygons* combing_boundary, const GeometryHash* combing_boundary_hash)
+{
+    GeometryHash hash;
+    hash.add(optimizer_type).add(start_point).add(static_cast<uint64_t>(polygons.size()));
+    for (const ConstPolygonPointer& polygon : polygons)
+    {
+        hash.add(*polygon);
+    }
+    hash.add(combing_boundary != nullptr);
+    if (combing_boundary != nullptr)
+    {
+        hash.add(combing_boundary_hash ? *combing_boundary_hash : GeometryHash().add(*combing_boundary));
+    }
+    return hash;
+}
+
+/*!
+ * Look up the order found before for the same input in a TravelPlanCache.
+ *
+ * The key is only a hash of the input, so a stored order which doesn't fit the
+ * polygons being ordered is treated as if nothing had been stored.
+ *
+ * \param cache The cache to look in.
+ * \param key The hash of the input.
+ * \param polygon_count The number of polygons being ordered.
+ * \param[out] poly_start The start vertex of each polygon, left empty if no
+ * order is found.
+ * \param[out] poly_order The order of the polygons, left empty if no order is
+ * found.
+ * \return Whether a fitting order has been found.
+ */
+static bool getCachedOrder(TravelPlanCache& cache, const GeometryHash& key, const size_t polygon_count, std::vector<int>& poly_start, std::vector<int>& poly_order)
+{
+    if (!cache.getOrder(key, poly_start, poly_order))
+    {
+        return false;
+    }
+    // polygons without vertices aren't ordered, so the order may be shorter
+    bool fits = poly_start.size() == polygon_count && poly_order.size() <= polygon_count;
+    for (unsigned int order_idx = 0; fits && order_idx < poly_order.size(); order_idx++)
+    {
+        fits = poly_order[order_idx] >= 0 && static_cast<size_t>(poly_order[order_idx]) < polygon_count;
+    }
+    if (!fits)
+    {
+        poly_start.clear();
+        poly_order.clear();
+    }
+    return fits;
+}
+
 /**
 *
 */
 void PathOrderOptimizer::optimize()
 {
-    bool picked[polygons.size()];
-    memset(picked, false, sizeof(bool) * polygons.size());/// initialized as falses
-    loc_to_line = nullptr;
+    // the order only depends on the input, so when the same input has been optimized before (e.g. on an earlier layer with the same walls) reuse that order
+    const bool use_cache = travel_plan_cache != nullptr && config.type != EZSeamType::RANDOM;
+    GeometryHash input_hash;
+    if (use_cache)
+    {
+        input_hash = hashOrderInput(0, startPoint, polygons, combing_boundary, combing_boundary_hash);
+        input_hash.add(static_cast<int>(config.type)).add(config.pos).add(static_cast<int>(config.corner_pref));
+        if (getCachedOrder(*travel_plan_cache, input_hash, polygons.size(), polyStart, polyOrder))
+        {
+            return;
+        }
+    }
+
+    const bool own_loc_to_line = loc_to_line == nullptr;
 
     for (unsigned poly_idx = 0; poly_idx < polygons.size(); ++poly_idx) /// find closest point to initial starting point within each polygon +initialize picked
     {
@@ -39,6 +117,34 @@ void PathOrderOptimizer::optimize()
         assert(poly.size() != 2);
     }
 
+    // index the start points of the polygons, so that finding the next polygon only needs to look at the polygons near the previous one
+    AABB start_points_box;
+    size_t start_point_count = 0;
+    for (unsigned int poly_idx = 0; poly_idx < polygons.size(); poly_idx++)
+    {
+        if (polygons[poly_idx]->size() < 1) /// skip single-point-polygons
+        {
+            continue;
+        }
+        start_points_box.include((*polygons[poly_idx])[polyStart[poly_idx]]);
+        start_point_count++;
+    }
+    if (start_point_count == 0)
+    {
+        start_points_box = AABB(Point(0, 0), Point(0, 0));
+    }
+    // aim for roughly one start point per grid cell
+    const coord_t min_cell_size = 100;
+    const coord_t cell_size = std::max(min_cell_size, static_cast<coord_t>(vSize(start_points_box.max - start_points_box.min) / std::sqrt(std::max(start_point_count, size_t(1)))));
+    const coord_t box_cell_count = ((start_points_box.max.X - start_points_box.min.X) / cell_size + 2) * ((start_points_box.max.Y - start_points_box.min.Y) / cell_size + 2);
+    SparsePointGridInclusive<unsigned int> start_point_grid(cell_size, start_point_count);
+    for (unsigned int poly_idx = 0; poly_idx < polygons.size(); poly_idx++)
+    {
+        if (polygons[poly_idx]->size() >= 1)
+        {
+            start_point_grid.insert((*polygons[poly_idx])[polyStart[poly_idx]], poly_idx);
+        }
+    }
 
     Point prev_point;
     switch (config.type)
@@ -52,65 +158,92 @@ void PathOrderOptimizer::optimize()
         default:
             prev_point = startPoint;
     }
+
+    std::vector<bool> picked(polygons.size(), false);
+    std::vector<unsigned int> evaluated_in_round(polygons.size(), 0); // the last round in which the travel distance to each polygon has been computed
+    std::vector<std::pair<float, unsigned int>> candidates; // straight squared distance and index of polygons near prev_point
     for (unsigned int poly_order_idx = 0; poly_order_idx < polygons.size(); poly_order_idx++) /// actual path order optimizer
     {
+        const unsigned int round = poly_order_idx + 1;
         int best_poly_idx = -1;
         float bestDist2 = std::numeric_limits<float>::infinity();
+        size_t combed_count = 0;
 
-
-        for (unsigned int poly_idx = 0; poly_idx < polygons.size(); poly_idx++)
+        // the remaining polygons are looked up in a growing radius around prev_point
+        // once the best distance found is within the radius, no polygon outside of it can be any closer, since combing never makes the travel shorter
+        coord_t max_radius = 0;
+        for (const Point corner : { start_points_box.min, start_points_box.max, Point(start_points_box.min.X, start_points_box.max.Y), Point(start_points_box.max.X, start_points_box.min.Y) })
         {
-            if (picked[poly_idx] || polygons[poly_idx]->size() < 1) /// skip single-point-polygons
-            {
-                continue;
-            }
-
-            assert (polygons[poly_idx]->size() != 2);
-
-            const Point& p = (*polygons[poly_idx])[polyStart[poly_idx]];
-            float dist2 = vSize2f(p - prev_point);
-            if (dist2 < bestDist2 && combing_boundary)
+            max_radius = std::max(max_radius, vSize(corner - prev_point));
+        }
+        for (coord_t radius = cell_size; ; radius *= 2)
+        {
+            candidates.clear();
+            const coord_t query_cell_width = 2 * radius / cell_size + 2;
+            const bool query_all = radius >= max_radius || query_cell_width * query_cell_width >= box_cell_count;
+            if (query_all)
             {
-                // using direct routing, this poly is the closest so far but as the combing boundary
-                // is available, get the combed distance and use that instead
-                if (PolygonUtils::polygonCollidesWithLineSegment(*combing_boundary, p, prev_point))
+                // the query would visit more grid cells than there are in the area of the start points, so just look at all of them
+                for (unsigned int poly_idx = 0; poly_idx < polygons.size(); poly_idx++)
                 {
-                    if (!loc_to_line)
+                    if (!picked[poly_idx] && evaluated_in_round[poly_idx] != round && polygons[poly_idx]->size() >= 1)
                     {
-                        // the combing boundary has been provided so do the initialisation
-                        // required to be able to calculate realistic travel distances to the start of new paths
-                        const int travel_avoid_distance = 2000; // assume 2mm - not really critical for our purposes
-                        loc_to_line = PolygonUtils::createLocToLineGrid(*combing_boundary, travel_avoid_distance);
+                        candidates.emplace_back(vSize2f((*polygons[poly_idx])[polyStart[poly_idx]] - prev_point), poly_idx);
                     }
-                    CombPath comb_path;
-                    if (LinePolygonsCrossings::comb(*combing_boundary, *loc_to_line, p, prev_point, comb_path, -40, 0, false))
+                }
+            }
+            else
+            {
+                const std::function<bool (const SparsePointGridInclusiveImpl::SparsePointGridInclusiveElem<unsigned int>&)> add_candidate =
+                    [&](const SparsePointGridInclusiveImpl::SparsePointGridInclusiveElem<unsigned int>& elem)
                     {
-                        float dist = 0;
-                        Point last_point = p;
-                        for (const Point& comb_point : comb_path)
+                        if (evaluated_in_round[elem.val] != round)
                         {
-                            dist += vSize(comb_point - last_point);
-                            last_point = comb_point;
+                            candidates.emplace_back(vSize2f(elem.point - prev_point), elem.val);
                         }
-                        dist2 = dist * dist;
-                    }
-                }
+                        return true;
+                    };
+                start_point_grid.processNearby(prev_point, radius, add_candidate);
             }
-            if (dist2 < bestDist2)
+            std::sort(candidates.begin(), candidates.end());
+
+            for (const std::pair<float, unsigned int>& candidate : candidates)
             {
-                best_poly_idx = poly_idx;
-                bestDist2 = dist2;
+                const unsigned int poly_idx = candidate.second;
+                if (candidate.first > bestDist2 || (candidate.first == bestDist2 && static_cast<int>(poly_idx) > best_poly_idx))
+                {
+                    // this and all further candidates are further away than the best one in a straight line already
+                    break;
+                }
+                evaluated_in_round[poly_idx] = round;
+
+                bool combed;
+                const float dist2 = getTravelDistance2(poly_idx, prev_point, combed_count < max_combed_candidates, combed);
+                if (combed)
+                {
+                    combed_count++;
+                }
+                // on equal distance, prefer the lowest index to be independent of the order in which the candidates were found
+                if (dist2 < bestDist2 || (dist2 == bestDist2 && static_cast<int>(poly_idx) < best_poly_idx))
+                {
+                    best_poly_idx = poly_idx;
+                    bestDist2 = dist2;
+                }
             }
 
+            if (query_all || bestDist2 <= static_cast<float>(radius) * radius)
+            {
+                break;
+            }
         }
 
-
         if (best_poly_idx > -1) /// should always be true; we should have been able to identify the best next polygon
         {
             assert(polygons[best_poly_idx]->size() != 2);
 
             prev_point = (*polygons[best_poly_idx])[polyStart[best_poly_idx]];
 
+            start_point_grid.erase(prev_point, best_poly_idx);
             picked[best_poly_idx] = true;
             polyOrder.push_back(best_poly_idx);
         }
@@ -120,26 +253,309 @@ void PathOrderOptimizer::optimize()
         }
     }
 
-    if (loc_to_line != nullptr)
+    if (own_loc_to_line && loc_to_line != nullptr)
     {
         delete loc_to_line;
+        loc_to_line = nullptr;
+    }
+    if (use_cache)
+    {
+        travel_plan_cache->setOrder(input_hash, polyStart, polyOrder);
+    }
+}
+
+float PathOrderOptimizer::getTravelDistance2(unsigned int poly_idx, const Point& prev_point, bool may_comb, bool& combed)
+{
+    combed = false;
+    const Point& p = (*polygons[poly_idx])[polyStart[poly_idx]];
+    float dist2 = vSize2f(p - prev_point);
+    if (!combing_boundary || !PolygonUtils::polygonCollidesWithLineSegment(*combing_boundary, p, prev_point))
+    {
+        return dist2;
+    }
+    if (!may_comb)
+    {
+        return std::numeric_limits<float>::infinity();
+    }
+
+    // using direct routing, this poly would be reached by crossing the combing boundary
+    // as the combing boundary is available, get the combed distance and use that instead
+    if (!loc_to_line)
+    {
+        // the combing boundary has been provided so do the initialisation
+        // required to be able to calculate realistic travel distances to the start of new paths
+        loc_to_line = PolygonUtils::createLocToLineGrid(*combing_boundary, loc_to_line_grid_size);
+    }
+    combed = true;
+    CombPath comb_path;
+    if (LinePolygonsCrossings::comb(*combing_boundary, *loc_to_line, p, prev_point, comb_path, -40, 0, false))
+    {
+        float dist = 0;
+        Point last_point = p;
+        for (const Point& comb_point : comb_path)
+        {
+            dist += vSize(comb_point - last_point);
+            last_point = comb_point;
+        }
+        dist2 = dist * dist;
+    }
+    return dist2;
+}
+
+/*!
+ * A path in an order which is being refined by \ref refineOrder
+ */
+struct RefinedPath
+{
+    unsigned int poly_idx; //!< The index of the path in the polygons of the optimizer
+    Point start; //!< Where printing the path starts
+    Point end; //!< Where printing the path ends
+    bool reversed; //!< Whether start and end have been swapped by the refinement
+};
+
+/*!
+ * Shorten the travel moves in an order of paths with 2-opt and Or-opt moves,
+ * until no move improves the order any more or the time is up.
+ *
+ * Only the travel distances in a straight line are considered. If a combing
+ * boundary is given, moves that would introduce a travel move crossing it are
+ * not made.
+ *
+ * \param start_point From where the first path is reached
+ * \param order[in,out] The paths in the order in which they are printed
+ * \param combing_boundary The boundary which travel moves shouldn't cross, or
+ * nullptr if there is none
+ * \param time_left[in,out] The time in seconds which may be spent, from which
+ * the time spent is subtracted
+ */
+static void refineOrder(const Point start_point, std::vector<RefinedPath>& order, const Polygons* combing_boundary, double& time_left)
+{
+    const double start_time = getTime();
+    const double end_time = start_time + time_left;
+    const int path_count = order.size();
+
+    // the location from which the path at position pos is reached
+    const std::function<Point (int)> travel_start = [&](int pos)
+        {
+            return (pos < 0) ? start_point : order[pos].end;
+        };
+    const std::function<bool (const Point&, const Point&)> may_travel = [combing_boundary](const Point& from, const Point& to)
+        {
+            return !combing_boundary || !PolygonUtils::polygonCollidesWithLineSegment(*combing_boundary, from, to);
+        };
+    const std::function<void (int, int)> reverse = [&order](int first, int last)
+        {
+            std::reverse(order.begin() + first, order.begin() + last + 1);
+            for (int pos = first; pos <= last; pos++)
+            {
+                std::swap(order[pos].start, order[pos].end);
+                order[pos].reversed = !order[pos].reversed;
+            }
+        };
+
+    // distances are rounded to integers so that each move shortens the total travel by at least 1 micron and the refinement is bound to end
+    bool improved = true;
+    while (improved)
+    {
+        improved = false;
+
+        // 2-opt: reverse the paths from position first up to and including position last
+        for (int first = 0; first < path_count - 1; first++)
+        {
+            if (getTime() > end_time)
+            {
+                break;
+            }
+            const Point before = travel_start(first - 1);
+            for (int last = first + 1; last < path_count; last++)
+            {
+                coord_t old_length = vSize(order[first].start - before);
+                coord_t new_length = vSize(order[last].end - before);
+                if (last + 1 < path_count)
+                {
+                    old_length += vSize(order[last + 1].start - order[last].end);
+                    new_length += vSize(order[last + 1].start - order[first].start);
+                }
+                if (new_length < old_length
+                    && may_travel(before, order[last].end)
+                    && (last + 1 == path_count || may_travel(order[first].start, order[last + 1].start)))
+                {
+                    reverse(first, last);
+                    improved = true;
+                }
+            }
+        }
+
+        // Or-opt: move a sequence of up to three paths to another position in the order, possibly reversing it
+        constexpr int max_moved_count = 3;
+        for (int moved_count = 1; moved_count <= max_moved_count; moved_count++)
+        {
+            for (int first = 0; first + moved_count <= path_count; first++)
+            {
+                if (getTime() > end_time)
+                {
+                    break;
+                }
+                const int last = first + moved_count - 1;
+                const Point before = travel_start(first - 1);
+                // how much shorter the travel becomes when the sequence is taken out
+                coord_t removal_gain = vSize(order[first].start - before);
+                if (last + 1 < path_count)
+                {
+                    if (!may_travel(before, order[last + 1].start))
+                    {
+                        continue;
+                    }
+                    removal_gain += vSize(order[last + 1].start - order[last].end) - vSize(order[last + 1].start - before);
+                }
+
+                // insert the sequence before position insert_pos, or at the end if insert_pos == path_count
+                int best_insert_pos = -1;
+                bool best_reversed = false;
+                coord_t best_gain = 0;
+                for (int insert_pos = 0; insert_pos <= path_count; insert_pos++)
+                {
+                    if (insert_pos >= first && insert_pos <= last + 1)
+                    {
+                        continue;
+                    }
+                    const Point after_travel_start = travel_start(insert_pos - 1);
+                    for (const bool reversed : { false, true })
+                    {
+                        const Point& moved_start = reversed ? order[last].end : order[first].start;
+                        const Point& moved_end = reversed ? order[first].start : order[last].end;
+                        coord_t insertion_cost = vSize(moved_start - after_travel_start);
+                        if (insert_pos < path_count)
+                        {
+                            insertion_cost += vSize(order[insert_pos].start - moved_end) - vSize(order[insert_pos].start - after_travel_start);
+                        }
+                        if (removal_gain - insertion_cost > best_gain
+                            && may_travel(after_travel_start, moved_start)
+                            && (insert_pos == path_count || may_travel(moved_end, order[insert_pos].start)))
+                        {
+                            best_insert_pos = insert_pos;
+                            best_reversed = reversed;
+                            best_gain = removal_gain - insertion_cost;
+                        }
+                    }
+                }
+
+                if (best_insert_pos >= 0)
+                {
+                    if (best_reversed)
+                    {
+                        reverse(first, last);
+                    }
+                    if (best_insert_pos < first)
+                    {
+                        std::rotate(order.begin() + best_insert_pos, order.begin() + first, order.begin() + last + 1);
+                    }
+                    else
+                    {
+                        std::rotate(order.begin() + first, order.begin() + last + 1, order.begin() + best_insert_pos);
+                    }
+                    improved = true;
+                }
+            }
+        }
+
+        if (getTime() > end_time)
+        {
+            break;
+        }
+    }
+
+    time_left = std::max(0.0, time_left - (getTime() - start_time));
+}
+
+void PathOrderOptimizer::refine(double& time_left)
+{
+    if (time_left <= 0 || polyOrder.size() < 2)
+    {
+        return;
+    }
+    std::vector<RefinedPath> order;
+    order.reserve(polyOrder.size());
+    for (const int poly_idx : polyOrder)
+    {
+        const Point& start = (*polygons[poly_idx])[polyStart[poly_idx]];
+        order.push_back(RefinedPath{ static_cast<unsigned int>(poly_idx), start, start, false }); // a polygon is printed as a closed loop, so it ends where it starts
+    }
+    refineOrder(startPoint, order, combing_boundary, time_left);
+    for (size_t order_idx = 0; order_idx < order.size(); order_idx++)
+    {
+        polyOrder[order_idx] = order[order_idx].poly_idx;
     }
 }
 
 int PathOrderOptimizer::getClosestPointInPolygon(Point prev_point, int poly_idx)
 {
     ConstPolygonRef poly = *polygons[poly_idx];
+    const unsigned int size = poly.size();
+    if (size == 0)
+    {
+        return -1;
+    }
 
-    int best_point_idx = -1;
-    float best_point_score = std::numeric_limits<float>::infinity();
-    Point p0 = poly.back();
-    for (unsigned int point_idx = 0; point_idx < poly.size(); point_idx++)
-    {
-        const Point& p1 = poly[point_idx];
-        const Point& p2 = poly[(point_idx + 1) % poly.size()];
-        // when type is SHARPEST_CORNER, actual distance is ignored, we use a fixed distance and decision is based on curvature only
-        float dist_score = (config.type == EZSeamType::SHARPEST_CORNER && config.corner_pref != EZSeamCornerPrefType::Z_SEAM_CORNER_PREF_NONE)? 10000 : vSize2(p1 - prev_point);
-        const float corner_angle = LinearAlg2D::getAngleLeft(p0, p1, p2) / M_PI; // 0 -> 2
+    // the vertices are scored in separate passes over contiguous arrays, so that the cheap integer and float arithmetic can be vectorized
+    // and the corner angles (which need an atan2) are only computed for the vertices where they can change the score
+    seam_dets.resize(size);
+    seam_dots.resize(size);
+    seam_scores.resize(size);
+    const Point* points = &poly[0];
+    for (unsigned int point_idx = 0; point_idx < size; point_idx++)
+    {
+        const Point& p0 = points[(point_idx == 0) ? size - 1 : point_idx - 1];
+        const Point& p1 = points[point_idx];
+        const Point& p2 = points[(point_idx + 1 == size) ? 0 : point_idx + 1];
+        const Point ba = p0 - p1;
+        const Point bc = p2 - p1;
+        seam_dots[point_idx] = ba.X * bc.X + ba.Y * bc.Y;
+        seam_dets[point_idx] = ba.X * bc.Y - ba.Y * bc.X;
+    }
+
+    // when type is SHARPEST_CORNER, actual distance is ignored, we use a fixed distance and decision is based on curvature only
+    if (config.type == EZSeamType::SHARPEST_CORNER && config.corner_pref != EZSeamCornerPrefType::Z_SEAM_CORNER_PREF_NONE)
+    {
+        std::fill(seam_scores.begin(), seam_scores.end(), 10000);
+    }
+    else
+    {
+        for (unsigned int point_idx = 0; point_idx < size; point_idx++)
+        {
+            seam_scores[point_idx] = vSize2(points[point_idx] - prev_point);
+        }
+    }
+
+    for (unsigned int point_idx = 0; point_idx < size; point_idx++)
+    {
+        const coord_t det = seam_dets[point_idx];
+        const coord_t dott = seam_dots[point_idx];
+        switch (config.corner_pref)
+        {
+            case EZSeamCornerPrefType::Z_SEAM_CORNER_PREF_INNER:
+                // a corner which turns right (det < 0) or doesn't turn at all is at most pi, so it is never favoured
+                if (det < 0 || (det == 0 && dott >= 0))
+                {
+                    continue;
+                }
+                break;
+            case EZSeamCornerPrefType::Z_SEAM_CORNER_PREF_OUTER:
+                // a corner which turns left by at least 90 degrees is at least 1.5 pi, so it is never favoured
+                if (det > 0 && dott >= 0)
+                {
+                    continue;
+                }
+                break;
+            case EZSeamCornerPrefType::Z_SEAM_CORNER_PREF_ANY:
+                break;
+            case EZSeamCornerPrefType::Z_SEAM_CORNER_PREF_NONE:
+            default:
+                // the corner angle isn't used
+                continue;
+        }
+        float& dist_score = seam_scores[point_idx];
+        const float corner_angle = LinearAlg2D::getAngleLeft(det, dott) / M_PI; // 0 -> 2
         float corner_shift;
         if (config.type == EZSeamType::SHORTEST)
         {
@@ -174,20 +590,22 @@ int PathOrderOptimizer::getClosestPointInPolygon(Point prev_point, int poly_idx)
                 }
                 break;
             case EZSeamCornerPrefType::Z_SEAM_CORNER_PREF_ANY:
+            default:
                 // the more curved the region, the more we reduce the distance
                 dist_score -= fabs(corner_angle - 1) * corner_shift;
                 break;
-            case EZSeamCornerPrefType::Z_SEAM_CORNER_PREF_NONE:
-            default:
-                // do nothing
-                break;
         }
-        if (dist_score < best_point_score)
+    }
+
+    int best_point_idx = -1;
+    float best_point_score = std::numeric_limits<float>::infinity();
+    for (unsigned int point_idx = 0; point_idx < size; point_idx++)
+    {
+        if (seam_scores[point_idx] < best_point_score)
         {
             best_point_idx = point_idx;
-            best_point_score = dist_score;
+            best_point_score = seam_scores[point_idx];
         }
-        p0 = p1;
     }
     return best_point_idx;
 }
@@ -207,11 +625,30 @@ static inline bool pointsAreCoincident(const Point& a, const Point& b)
 */
 void LineOrderOptimizer::optimize(bool find_chains)
 {
+    // the order only depends on the input, so when the same input has been optimized before (e.g. on an earlier layer with the same infill) reuse that order
+    GeometryHash input_hash;
+    if (travel_plan_cache != nullptr)
+    {
+        input_hash = hashOrderInput(1, startPoint, polygons, combing_boundary, combing_boundary_hash);
+        input_hash.add(find_chains);
+        if (getCachedOrder(*travel_plan_cache, input_hash, polygons.size(), polyStart, polyOrder))
+        {
+            return;
+        }
+    }
+
     const int grid_size = 2000; // the size of the cells in the hash grid. TODO
     SparsePointGridInclusive<unsigned int> line_bucket_grid(grid_size);
     bool picked[polygons.size()];
 
-    loc_to_line = nullptr;
+    // when no grid or cache is shared with other optimizers, use ones which only live during this optimization
+    const bool own_loc_to_line = loc_to_line == nullptr;
+    CombingDistanceCache own_combing_distances;
+    const bool use_own_combing_distances = combing_distances == nullptr;
+    if (use_own_combing_distances)
+    {
+        combing_distances = &own_combing_distances;
+    }
 
     for (unsigned int poly_idx = 0; poly_idx < polygons.size(); poly_idx++) /// find closest point to initial starting point within each polygon +initialize picked
     {
@@ -426,18 +863,59 @@ void LineOrderOptimizer::optimize(bool find_chains)
             logError("Failed to find next closest line.\n");
         }
     }
-    if (loc_to_line != nullptr)
+    if (own_loc_to_line && loc_to_line != nullptr)
     {
         delete loc_to_line;
+        loc_to_line = nullptr;
+    }
+    if (use_own_combing_distances)
+    {
+        combing_distances = nullptr;
+    }
+    if (travel_plan_cache != nullptr)
+    {
+        travel_plan_cache->setOrder(input_hash, polyStart, polyOrder);
+    }
+}
+
+void LineOrderOptimizer::refine(double& time_left, const Polygons* travel_boundary)
+{
+    if (time_left <= 0 || polyOrder.size() < 2)
+    {
+        return;
+    }
+    std::vector<RefinedPath> order;
+    order.reserve(polyOrder.size());
+    for (const int poly_idx : polyOrder)
+    {
+        ConstPolygonRef line = *polygons[poly_idx];
+        order.push_back(RefinedPath{ static_cast<unsigned int>(poly_idx), line[polyStart[poly_idx]], line[1 - polyStart[poly_idx]], false });
+    }
+    const Polygons* boundary = (travel_boundary != nullptr && travel_boundary->size() > 0) ? travel_boundary : combing_boundary;
+    refineOrder(startPoint, order, boundary, time_left);
+    for (size_t order_idx = 0; order_idx < order.size(); order_idx++)
+    {
+        const RefinedPath& path = order[order_idx];
+        polyOrder[order_idx] = path.poly_idx;
+        if (path.reversed)
+        {
+            polyStart[path.poly_idx] = 1 - polyStart[path.poly_idx];
+        }
     }
 }
 
 float LineOrderOptimizer::combingDistance2(const Point &p0, const Point &p1)
 {
+    float dist2;
+    if (combing_distances != nullptr && combing_distances->get(p0, p1, dist2))
+    {
+        return dist2;
+    }
+
     if (loc_to_line == nullptr)
     {
         // do the initialisation required to be able to calculate realistic travel distances to the start of new paths
-        loc_to_line = PolygonUtils::createLocToLineGrid(*combing_boundary, 1000); // 1mm grid to reduce computation time
+        loc_to_line = PolygonUtils::createLocToLineGrid(*combing_boundary, loc_to_line_grid_size);
     }
 
     CombPath comb_path;
@@ -450,12 +928,19 @@ float LineOrderOptimizer::combingDistance2(const Point &p0, const Point &p1)
             dist += vSize(comb_point - last_point);
             last_point = comb_point;
         }
-        return dist * dist;
+        dist2 = dist * dist;
+    }
+    else
+    {
+        // couldn't comb, fall back to a large distance
+        dist2 = vSize2f(p1 - p0) * 10000;
     }
 
-    // couldn't comb, fall back to a large distance
-
-    return vSize2f(p1 - p0) * 10000;
+    if (combing_distances != nullptr)
+    {
+        combing_distances->set(p0, p1, dist2);
+    }
+    return dist2;
 }
 
 /*
@@ -5,12 +5,16 @@
 #define PATHOPTIMIZER_H
 
 #include <stdint.h>
+#include <unordered_map>
 #include "utils/polygon.h"
 #include "utils/polygonUtils.h"
 #include "settings/Settings.h"
+#include "utils/GeometryHash.h"
 
 namespace cura {
 
+class TravelPlanCache;
+
 /*!
  * Helper class that encapsulates the various criteria that define the location of the z-seam.
  * Instances of this are passed to the PathOrderOptimizer to specify where the z-seam is to be located.
@@ -50,13 +54,26 @@ public:
     std::vector<ConstPolygonPointer> polygons; //!< the parts of the layer (in arbitrary order)
     std::vector<int> polyStart; //!< polygons[i][polyStart[i]] = point of polygon i which is to be the starting point in printing the polygon
     std::vector<int> polyOrder; //!< the optimized order as indices in #polygons
-    LocToLineGrid* loc_to_line;
+    LocToLineGrid* loc_to_line; //!< Grid over #combing_boundary, used for computing combing paths
     const Polygons* combing_boundary;
 
-    PathOrderOptimizer(Point startPoint, const ZSeamConfig config = ZSeamConfig(), const Polygons* combing_boundary = nullptr)
+    static constexpr coord_t loc_to_line_grid_size = 2000; //!< The cell size of the grid over #combing_boundary; assume a travel avoid distance of 2mm - not really critical for our purposes
+
+    /*!
+     * \param startPoint A location near the prefered start location.
+     * \param config Where to place the seams of the polygons.
+     * \param combing_boundary Travel moves that cross this boundary are
+     * evaluated by their combed distance.
+     * \param loc_to_line A grid over \p combing_boundary to be used for
+     * combing, or nullptr to create one when it is needed.
+     */
+    PathOrderOptimizer(Point startPoint, const ZSeamConfig config = ZSeamConfig(), const Polygons* combing_boundary = nullptr, LocToLineGrid* loc_to_line = nullptr)
     : startPoint(startPoint)
     , config(config)
+    , loc_to_line(loc_to_line)
     , combing_boundary((combing_boundary != nullptr && combing_boundary->size() > 0) ? combing_boundary : nullptr)
+    , travel_plan_cache(nullptr)
+    , combing_boundary_hash(nullptr)
     {
     }
 
@@ -78,12 +95,118 @@ public:
         }
     }
 
+    /*!
+     * Reuse the order found before for the same input, e.g. for an earlier
+     * layer with the same geometry, and store the order found by \ref optimize
+     * for later reuse.
+     *
+     * \param cache Where the orders are stored.
+     * \param combing_boundary_hash The hash of #combing_boundary if it is
+     * already known, otherwise it is computed when needed.
+     */
+    void setTravelPlanCache(TravelPlanCache* cache, const GeometryHash* combing_boundary_hash = nullptr)
+    {
+        travel_plan_cache = cache;
+        this->combing_boundary_hash = combing_boundary_hash;
+    }
+
     void optimize(); //!< sets #polyStart and #polyOrder
 
+    /*!
+     * Shorten the travel moves between the polygons in #polyOrder with 2-opt
+     * and Or-opt moves. Should be called after \ref optimize.
+     *
+     * The starting points of the polygons are not changed.
+     *
+     * \param[in,out] time_left The time in seconds which may be spent on the
+     * refinement. The time actually spent is subtracted from it.
+     */
+    void refine(double& time_left);
+
 private:
+    /*!
+     * The maximum number of candidates for which the combed travel distance is
+     * computed when choosing the next polygon.
+     *
+     * Candidates are considered in order of their straight distance to the
+     * previous point. Once this many of them needed a combing computation,
+     * the remaining candidates are only considered if they can be reached
+     * without crossing the combing boundary.
+     */
+    static constexpr size_t max_combed_candidates = 8;
+
+    std::vector<coord_t> seam_dets; //!< Scratch space for getClosestPointInPolygon: the determinant of the corner at each vertex of a polygon
+    std::vector<coord_t> seam_dots; //!< Scratch space for getClosestPointInPolygon: the dot product of the corner at each vertex of a polygon
+    std::vector<float> seam_scores; //!< Scratch space for getClosestPointInPolygon: the score of each vertex of a polygon, lower is better
+    TravelPlanCache* travel_plan_cache; //!< Where orders found before are stored, if they may be reused
+    const GeometryHash* combing_boundary_hash; //!< The hash of #combing_boundary, if it is already known
+
     int getClosestPointInPolygon(Point prev, int i_polygon); //!< returns the index of the closest point
     int getRandomPointInPolygon(int poly_idx);
+
+    /*!
+     * Compute the squared travel distance from \p prev_point to the start of
+     * a polygon, taking the combing boundary into account if there is one.
+     *
+     * \param poly_idx The index of the polygon in #polygons.
+     * \param prev_point The position from which we travel.
+     * \param may_comb Whether a combing path may be computed if the straight
+     * travel move collides with the combing boundary.
+     * \param[out] combed Whether a combing path has been computed.
+     * \return The squared travel distance, or infinity if the travel move
+     * would need combing but \p may_comb is false.
+     */
+    float getTravelDistance2(unsigned int poly_idx, const Point& prev_point, bool may_comb, bool& combed);
+};
+/*!
+ * Cache of combed travel distances between points.
+ *
+ * Computing a combing path is expensive, while the order optimizers evaluate
+ * the same travel moves many times. One cache can be shared by all optimizers
+ * which comb within the same boundary, e.g. all line orders of a layer.
+ */
+class CombingDistanceCache
+{
+public:
+    /*!
+     * Look up the squared combed distance from \p from to \p to.
+     *
+     * \param from The start of the travel move.
+     * \param to The end of the travel move.
+     * \param[out] distance2 The squared combed distance, if it was found.
+     * \return Whether the distance has been stored before.
+     */
+    bool get(const Point& from, const Point& to, float& distance2) const
+    {
+        const std::unordered_map<std::pair<Point, Point>, float, PointPairHash>::const_iterator it = distances2.find(std::make_pair(from, to));
+        if (it == distances2.end())
+        {
+            return false;
+        }
+        distance2 = it->second;
+        return true;
+    }
+
+    /*!
+     * Store the squared combed distance from \p from to \p to.
+     */
+    void set(const Point& from, const Point& to, const float distance2)
+    {
+        distances2[std::make_pair(from, to)] = distance2;
+    }
+
+private:
+    struct PointPairHash
+    {
+        size_t operator()(const std::pair<Point, Point>& points) const
+        {
+            return std::hash<Point>()(points.first) * 31 + std::hash<Point>()(points.second);
+        }
+    };
+
+    std::unordered_map<std::pair<Point, Point>, float, PointPairHash> distances2; //!< The squared combed distance for each (start, end) pair of a travel move
 };
+
 //! Line path order optimization class.
 /*!
 * Utility class for optimizing the path order by minimizing the distance traveled between printing different lines within a part.
@@ -95,13 +218,31 @@ public:
     std::vector<ConstPolygonPointer> polygons; //!< the parts of the layer (in arbitrary order)
     std::vector<int> polyStart; //!< polygons[i][polyStart[i]] = point of polygon i which is to be the starting point in printing the polygon
     std::vector<int> polyOrder; //!< the optimized order as indices in #polygons
-    LocToLineGrid* loc_to_line;
+    LocToLineGrid* loc_to_line; //!< Grid over #combing_boundary, used for computing combing paths
     const Polygons* combing_boundary; //!< travel moves that cross this boundary are penalised so they are less likely to be chosen
+    CombingDistanceCache* combing_distances; //!< The combed distances computed so far
 
-    LineOrderOptimizer(Point startPoint, const Polygons* combing_boundary = nullptr)
+    static constexpr coord_t loc_to_line_grid_size = 1000; //!< The cell size of the grid over #combing_boundary; 1mm to reduce computation time
+
+    /*!
+     * \param startPoint The location of the nozzle before starting to print
+     * the lines.
+     * \param combing_boundary Travel moves that cross this boundary are
+     * penalised.
+     * \param loc_to_line A grid over \p combing_boundary to be used for
+     * combing, or nullptr to create one when it is needed.
+     * \param combing_distances A cache of combed distances within
+     * \p combing_boundary which may be shared with other optimizers, or nullptr
+     * to use a cache for this optimization only.
+     */
+    LineOrderOptimizer(Point startPoint, const Polygons* combing_boundary = nullptr, LocToLineGrid* loc_to_line = nullptr, CombingDistanceCache* combing_distances = nullptr)
     {
         this->startPoint = startPoint;
         this->combing_boundary = (combing_boundary != nullptr && combing_boundary->size() > 0) ? combing_boundary : nullptr;
+        this->loc_to_line = loc_to_line;
+        this->combing_distances = combing_distances;
+        travel_plan_cache = nullptr;
+        combing_boundary_hash = nullptr;
     }
 
     void addPolygon(PolygonRef polygon)
@@ -122,6 +263,21 @@ public:
         }
     }
 
+    /*!
+     * Reuse the order found before for the same input, e.g. for an earlier
+     * layer with the same geometry, and store the order found by \ref optimize
+     * for later reuse.
+     *
+     * \param cache Where the orders are stored.
+     * \param combing_boundary_hash The hash of #combing_boundary if it is
+     * already known, otherwise it is computed when needed.
+     */
+    void setTravelPlanCache(TravelPlanCache* cache, const GeometryHash* combing_boundary_hash = nullptr)
+    {
+        travel_plan_cache = cache;
+        this->combing_boundary_hash = combing_boundary_hash;
+    }
+
     /*!
      * Do the optimization
      *
@@ -131,7 +287,23 @@ public:
      */
     void optimize(bool find_chains = true); //!< sets #polyStart and #polyOrder
 
+    /*!
+     * Shorten the travel moves between the lines in #polyOrder with 2-opt and
+     * Or-opt moves. Should be called after \ref optimize.
+     *
+     * Lines may be reversed, in which case #polyStart is updated.
+     *
+     * \param[in,out] time_left The time in seconds which may be spent on the
+     * refinement. The time actually spent is subtracted from it.
+     * \param travel_boundary Travel moves which cross this boundary are not
+     * introduced by the refinement. If not given, #combing_boundary is used.
+     */
+    void refine(double& time_left, const Polygons* travel_boundary = nullptr);
+
 private:
+    TravelPlanCache* travel_plan_cache; //!< Where orders found before are stored, if they may be reused
+    const GeometryHash* combing_boundary_hash; //!< The hash of #combing_boundary, if it is already known
+
     /*!
      * Update LineOrderOptimizer::polyStart if the current line is better than the current best.
      * 
@@ -146,6 +318,8 @@ private:
     /*!
      * Compute the squared distance from \p p0 to \p p1 using combing
      *
+     * Distances computed before are taken from #combing_distances.
+     *
      * \param p0 A point
      * \param p1 Another point
      *
@@ -0,0 +1,126 @@
+//Copyright (c) 2018 Ultimaker B.V.
+//CuraEngine is released under the terms of the AGPLv3 or higher.
+
+#include <cmath>
+
+#include "ArcFitter.h"
+
+namespace cura
+{
+
+namespace
+{
+
+/*!
+ * The length of a vector, without rounding it to whole micrometers.
+ */
+double vSizeExact(const Point& p)
+{
+    return std::sqrt(static_cast<double>(p.X) * p.X + static_cast<double>(p.Y) * p.Y);
+}
+
+} //anonymous namespace
+
+ArcFitter::ArcFitter(const coord_t max_deviation, const coord_t max_radius, const size_t min_segments, const size_t max_segments)
+: max_deviation(max_deviation)
+, max_radius(max_radius)
+, min_segments(std::max(size_t(1), min_segments))
+, max_segments(max_segments)
+{
+}
+
+std::vector<PathArc> ArcFitter::fit(const std::vector<Point>& points) const
+{
+    std::vector<PathArc> arcs;
+    size_t start_idx = 0;
+    while (start_idx + min_segments < points.size())
+    {
+        PathArc arc;
+        bool found = false;
+        for (size_t end_idx = start_idx + min_segments; end_idx < points.size() && end_idx - start_idx <= max_segments; end_idx++)
+        {
+            PathArc longer_arc;
+            if (!fitArc(points, start_idx, end_idx, longer_arc))
+            {
+                break;
+            }
+            arc = longer_arc;
+            found = true;
+        }
+        if (found)
+        {
+            arcs.push_back(arc);
+            start_idx = arc.end_idx;
+        }
+        else
+        {
+            start_idx++;
+        }
+    }
+    return arcs;
+}
+
+bool ArcFitter::fitArc(const std::vector<Point>& points, const size_t start_idx, const size_t end_idx, PathArc& arc) const
+{
+    //The circle through the first, middle and last point.
+    const Point& a = points[start_idx];
+    const Point& b = points[(start_idx + end_idx) / 2];
+    const Point& c = points[end_idx];
+    const double ax = a.X, ay = a.Y, bx = b.X, by = b.Y, cx = c.X, cy = c.Y;
+    const double denominator = 2.0 * (ax * (by - cy) + bx * (cy - ay) + cx * (ay - by));
+    if (std::abs(denominator) < 1.0)
+    {
+        return false; //Collinear.
+    }
+    const double a_sq = ax * ax + ay * ay;
+    const double b_sq = bx * bx + by * by;
+    const double c_sq = cx * cx + cy * cy;
+    const double center_x = (a_sq * (by - cy) + b_sq * (cy - ay) + c_sq * (ay - by)) / denominator;
+    const double center_y = (a_sq * (cx - bx) + b_sq * (ax - cx) + c_sq * (bx - ax)) / denominator;
+    if (std::abs(center_x - ax) > max_radius || std::abs(center_y - ay) > max_radius)
+    {
+        return false;
+    }
+    const Point center(std::llround(center_x), std::llround(center_y));
+
+    //The firmware takes the radius from the start point, so check the rest against that.
+    const double radius = vSizeExact(a - center);
+    if (radius > max_radius || radius <= max_deviation)
+    {
+        return false;
+    }
+    const bool clockwise = denominator < 0; //The sign of the cross product of a->b and b->c.
+    double total_angle = 0.0;
+    for (size_t point_idx = start_idx; point_idx < end_idx; point_idx++)
+    {
+        const Point from = points[point_idx] - center;
+        const Point to = points[point_idx + 1] - center;
+        if (std::abs(vSizeExact(to) - radius) > max_deviation)
+        {
+            return false;
+        }
+        const Point middle = (points[point_idx] + points[point_idx + 1]) / 2 - center;
+        if (radius - vSizeExact(middle) > max_deviation) //The middle of a segment is always inside the circle.
+        {
+            return false;
+        }
+        const double cross = static_cast<double>(from.X) * to.Y - static_cast<double>(from.Y) * to.X;
+        if (cross == 0 || (cross < 0) != clockwise)
+        {
+            return false; //Doesn't go around the center in the same direction.
+        }
+        total_angle += std::atan2(std::abs(cross), static_cast<double>(from.X) * to.X + static_cast<double>(from.Y) * to.Y);
+    }
+    if (total_angle > 2 * M_PI - 0.05)
+    {
+        return false; //Would be ambiguous with a full circle.
+    }
+
+    arc.start_idx = start_idx;
+    arc.end_idx = end_idx;
+    arc.center = center;
+    arc.clockwise = clockwise;
+    return true;
+}
+
+} //namespace cura
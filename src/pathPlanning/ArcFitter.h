@@ -0,0 +1,83 @@
+//Copyright (c) 2018 Ultimaker B.V.
+//CuraEngine is released under the terms of the AGPLv3 or higher.
+
+#ifndef PATH_PLANNING_ARC_FITTER_H
+#define PATH_PLANNING_ARC_FITTER_H
+
+#include <vector>
+
+#include "../utils/IntPoint.h"
+
+namespace cura
+{
+
+/*!
+ * A run of consecutive points of a path which lie on a circular arc, so that
+ * they can be written as a single arc move.
+ */
+struct PathArc
+{
+    size_t start_idx; //!< The index of the point at which the arc starts
+    size_t end_idx; //!< The index of the point at which the arc ends, after all points in between
+    Point center; //!< The center of the circle the points lie on
+    bool clockwise; //!< Whether the arc goes clockwise around the center, when seen from above
+};
+
+/*!
+ * \brief Finds runs of points of a path which can be written as circular arcs.
+ *
+ * Curved walls are approximated by many short line segments. Firmwares which
+ * support G2 and G3 can print a run of such segments as a single arc, which
+ * makes the g-code much smaller and lets the firmware plan the curve as a
+ * whole instead of segment by segment.
+ *
+ * The arcs are found greedily: an arc is started at a point and extended over
+ * the following points for as long as all points, and the middle of each line
+ * segment between them, stay within the maximum deviation from a single
+ * circle.
+ */
+class ArcFitter
+{
+public:
+    /*!
+     * \param max_deviation How far the points and the line segments between
+     * them may be from the arc.
+     * \param max_radius The largest radius of an arc. Runs of points which are
+     * nearly straight are left as line segments.
+     * \param min_segments The minimum number of line segments replaced by a
+     * single arc.
+     * \param max_segments The maximum number of line segments replaced by a
+     * single arc. Limits the time needed to check an arc.
+     */
+    ArcFitter(const coord_t max_deviation, const coord_t max_radius = MM2INT(1000), const size_t min_segments = 3, const size_t max_segments = 256);
+
+    /*!
+     * Find the runs of points which lie on circular arcs.
+     *
+     * \param points The points of a path.
+     * \return The runs of points which lie on arcs, in order. They don't
+     * overlap, but one may end at the point where the next starts.
+     */
+    std::vector<PathArc> fit(const std::vector<Point>& points) const;
+
+private:
+    /*!
+     * Check whether a run of points lies on a circle.
+     *
+     * \param points The points of the path.
+     * \param start_idx The first point of the run.
+     * \param end_idx The last point of the run.
+     * \param[out] arc The arc through the points, if they lie on a circle.
+     * \return Whether the points lie on a circle within the maximum deviation.
+     */
+    bool fitArc(const std::vector<Point>& points, const size_t start_idx, const size_t end_idx, PathArc& arc) const;
+
+    const coord_t max_deviation; //!< How far the points and the line segments between them may be from the arc
+    const coord_t max_radius; //!< The largest radius of an arc
+    const size_t min_segments; //!< The minimum number of line segments replaced by a single arc
+    const size_t max_segments; //!< The maximum number of line segments replaced by a single arc
+};
+
+} //namespace cura
+
+#endif //PATH_PLANNING_ARC_FITTER_H
@@ -5,6 +5,7 @@
 
 #include <algorithm>
 #include <functional> // function
+#include <limits>
 #include <unordered_set>
 
 #include "../Application.h"
@@ -13,65 +14,48 @@
 #include "../utils/PolygonsPointIndex.h"
 #include "../sliceDataStorage.h"
 #include "../utils/SVG.h"
+#include "TravelPlanCache.h"
 
 namespace cura {
 
 LocToLineGrid& Comb::getOutsideLocToLine()
 {
-    return *outside_loc_to_line;
+    return *comb_boundaries.getLocToLine(CombBoundary::OUTSIDE);
 }
 
 Polygons& Comb::getBoundaryOutside()
 {
-    return *boundary_outside;
+    return comb_boundaries.getBoundary(CombBoundary::OUTSIDE);
 }
   
-Comb::Comb(const SliceDataStorage& storage, const LayerIndex layer_nr, const Polygons& comb_boundary_inside_minimum, const Polygons& comb_boundary_inside_optimal, coord_t comb_boundary_offset, coord_t travel_avoid_distance, coord_t move_inside_distance)
+Comb::Comb(const SliceDataStorage& storage, const LayerIndex layer_nr, CombBoundaryCache& comb_boundaries, coord_t comb_boundary_offset, coord_t travel_avoid_distance, coord_t move_inside_distance, TravelPlanCache* travel_plan_cache)
 : storage(storage)
 , layer_nr(layer_nr)
 , offset_from_outlines(comb_boundary_offset) // between second wall and infill / other walls
 , max_moveInside_distance2(offset_from_outlines * 2 * offset_from_outlines * 2)
 , offset_from_inside_to_outside(offset_from_outlines + travel_avoid_distance)
 , max_crossing_dist2(offset_from_inside_to_outside * offset_from_inside_to_outside * 2) // so max_crossing_dist = offset_from_inside_to_outside * sqrt(2) =approx 1.5 to allow for slightly diagonal crossings and slightly inaccurate crossing computation
-, boundary_inside_minimum( comb_boundary_inside_minimum ) // copy the boundary, because the partsView_inside will reorder the polygons
-, boundary_inside_optimal( comb_boundary_inside_optimal ) // copy the boundary, because the partsView_inside will reorder the polygons
+, comb_boundaries(comb_boundaries)
+, boundary_inside_minimum(comb_boundaries.getBoundary(CombBoundary::MINIMUM))
+, boundary_inside_optimal(comb_boundaries.getBoundary(CombBoundary::OPTIMAL))
 , partsView_inside_minimum( boundary_inside_minimum.splitIntoPartsView() ) // WARNING !! changes the order of boundary_inside !!
 , partsView_inside_optimal( boundary_inside_optimal.splitIntoPartsView() ) // WARNING !! changes the order of boundary_inside !!
-, inside_loc_to_line_minimum(PolygonUtils::createLocToLineGrid(boundary_inside_minimum, comb_boundary_offset))
-, inside_loc_to_line_optimal(PolygonUtils::createLocToLineGrid(boundary_inside_optimal, comb_boundary_offset))
-, boundary_outside(
-        [&storage, layer_nr, travel_avoid_distance]()
-        {
-            const std::vector<bool> extruder_is_used = storage.getExtrudersUsed();
-            bool travel_avoid_supports = false;
-            for (const ExtruderTrain& extruder : Application::getInstance().current_slice->scene.extruders)
-            {
-                travel_avoid_supports |= extruder_is_used[extruder.extruder_nr] && extruder.settings.get<bool>("travel_avoid_other_parts") && extruder.settings.get<bool>("travel_avoid_supports");
-            }
-            return storage.getLayerOutlines(layer_nr, travel_avoid_supports, travel_avoid_supports).offset(travel_avoid_distance);
-        }
-    )
-, outside_loc_to_line(
-        [](Comb* comber, const int64_t offset_from_inside_to_outside)
-        {
-            return PolygonUtils::createLocToLineGrid(comber->getBoundaryOutside(), offset_from_inside_to_outside * 3 / 2);
-        }
-        , this
-        , offset_from_inside_to_outside
-    )
+, inside_loc_to_line_minimum(comb_boundaries.getLocToLine(CombBoundary::MINIMUM))
+, inside_loc_to_line_optimal(comb_boundaries.getLocToLine(CombBoundary::OPTIMAL))
 , move_inside_distance(move_inside_distance)
+, use_visibility_graph(isVisibilityGraphEnabled())
+, travel_plan_cache(travel_plan_cache)
 {
-}
-
-Comb::~Comb()
-{
-    if (inside_loc_to_line_minimum)
+    if (use_visibility_graph)
     {
-        delete inside_loc_to_line_minimum;
+        visibility_graphs_minimum.resize(partsView_inside_minimum.size());
+        visibility_graphs_optimal.resize(partsView_inside_optimal.size());
     }
-    if (inside_loc_to_line_optimal)
+    if (travel_plan_cache)
     {
-        delete inside_loc_to_line_optimal;
+        // hashed after splitIntoPartsView has reordered the boundaries, so that the same boundaries always hash the same
+        boundaries_hash.add(comb_boundaries.getBoundaryHash(CombBoundary::MINIMUM)).add(comb_boundaries.getBoundaryHash(CombBoundary::OPTIMAL));
+        boundaries_hash.add(offset_from_outlines).add(offset_from_inside_to_outside).add(move_inside_distance).add(use_visibility_graph);
     }
 }
 
@@ -82,6 +66,25 @@ bool Comb::calc(const ExtruderTrain& train, Point startPoint, Point endPoint, Co
         return true;
     }
 
+    const bool perform_z_hops = train.settings.get<bool>("retraction_hop_enabled");
+    const bool perform_z_hops_only_when_collides = train.settings.get<bool>("retraction_hop_only_when_collides");
+    const bool fail_on_unavoidable_obstacles = perform_z_hops && perform_z_hops_only_when_collides;
+
+    // combing within a part only depends on the inside boundaries, so a travel move which has been combed for an earlier layer with the same boundaries can be reused
+    GeometryHash travel_hash;
+    if (travel_plan_cache)
+    {
+        travel_hash = boundaries_hash;
+        travel_hash.add(startPoint).add(endPoint).add(_startInside).add(_endInside).add(max_comb_distance_ignored).add(fail_on_unavoidable_obstacles);
+        CombPath comb_path;
+        bool comb_result;
+        if (travel_plan_cache->getCombPath(travel_hash, comb_path, comb_result))
+        {
+            combPaths.push_back(comb_path);
+            return comb_result;
+        }
+    }
+
     //Move start and end point inside the optimal comb boundary
     unsigned int start_inside_poly = NO_INDEX;
     const bool startInside = moveInside(boundary_inside_optimal, _startInside, inside_loc_to_line_optimal, startPoint, start_inside_poly);
@@ -94,16 +97,16 @@ bool Comb::calc(const ExtruderTrain& train, Point startPoint, Point endPoint, Co
     unsigned int start_part_idx =   (start_inside_poly == NO_INDEX)?    NO_INDEX : partsView_inside_optimal.getPartContaining(start_inside_poly, &start_part_boundary_poly_idx);
     unsigned int end_part_idx =     (end_inside_poly == NO_INDEX)?      NO_INDEX : partsView_inside_optimal.getPartContaining(end_inside_poly, &end_part_boundary_poly_idx);
 
-    const bool perform_z_hops = train.settings.get<bool>("retraction_hop_enabled");
-    const bool perform_z_hops_only_when_collides = train.settings.get<bool>("retraction_hop_only_when_collides");
-    const bool fail_on_unavoidable_obstacles = perform_z_hops && perform_z_hops_only_when_collides;
-
     // normal combing within part using optimal comb boundary
     if (startInside && endInside && start_part_idx == end_part_idx)
     {
-        PolygonsPart part = partsView_inside_optimal.assemblePart(start_part_idx);
         combPaths.emplace_back();
-        return LinePolygonsCrossings::comb(part, *inside_loc_to_line_optimal, startPoint, endPoint, combPaths.back(), -offset_dist_to_get_from_on_the_polygon_to_outside, max_comb_distance_ignored, fail_on_unavoidable_obstacles);
+        const bool comb_result = combWithinPart(boundary_inside_optimal, partsView_inside_optimal, start_part_idx, *inside_loc_to_line_optimal, visibility_graphs_optimal, startPoint, endPoint, combPaths.back(), max_comb_distance_ignored, fail_on_unavoidable_obstacles);
+        if (travel_plan_cache)
+        {
+            travel_plan_cache->setCombPath(travel_hash, combPaths.back(), comb_result);
+        }
+        return comb_result;
     }
 
     //Move start and end point inside the minimum comb boundary
@@ -124,11 +127,14 @@ bool Comb::calc(const ExtruderTrain& train, Point startPoint, Point endPoint, Co
     // normal combing within part using minimum comb boundary
     if (startInsideMin && endInsideMin && start_part_idx_min == end_part_idx_min)
     {
-        PolygonsPart part = partsView_inside_minimum.assemblePart(start_part_idx_min);
         combPaths.emplace_back();
 
-        comb_result = LinePolygonsCrossings::comb(part, *inside_loc_to_line_minimum, startPoint, endPoint, result_path, -offset_dist_to_get_from_on_the_polygon_to_outside, max_comb_distance_ignored, fail_on_unavoidable_obstacles);
+        comb_result = combWithinPart(boundary_inside_minimum, partsView_inside_minimum, start_part_idx_min, *inside_loc_to_line_minimum, visibility_graphs_minimum, startPoint, endPoint, result_path, max_comb_distance_ignored, fail_on_unavoidable_obstacles);
         Comb::moveCombPathInside(boundary_inside_minimum, boundary_inside_optimal, result_path, combPaths.back());  // add altered result_path to combPaths.back()
+        if (travel_plan_cache)
+        {
+            travel_plan_cache->setCombPath(travel_hash, combPaths.back(), comb_result);
+        }
         return comb_result;
     }
 
@@ -169,13 +175,13 @@ bool Comb::calc(const ExtruderTrain& train, Point startPoint, Point endPoint, Co
     { // compute the crossing points when moving through air
         // comb through all air, since generally the outside consists of a single part
 
-        bool success = start_crossing.findOutside(*boundary_outside, end_crossing.in_or_mid, fail_on_unavoidable_obstacles, *this);
+        bool success = start_crossing.findOutside(getBoundaryOutside(), end_crossing.in_or_mid, fail_on_unavoidable_obstacles, *this);
         if (!success)
         {
             return false;
         }
 
-        success = end_crossing.findOutside(*boundary_outside, start_crossing.out, fail_on_unavoidable_obstacles, *this);
+        success = end_crossing.findOutside(getBoundaryOutside(), start_crossing.out, fail_on_unavoidable_obstacles, *this);
         if (!success)
         {
             return false;
@@ -188,7 +194,7 @@ bool Comb::calc(const ExtruderTrain& train, Point startPoint, Point endPoint, Co
         // start to boundary
         assert(start_crossing.dest_part.size() > 0 && "The part we start inside when combing should have been computed already!");
         combPaths.emplace_back();
-        bool combing_succeeded = LinePolygonsCrossings::comb(start_crossing.dest_part, *inside_loc_to_line_optimal, startPoint, start_crossing.in_or_mid, combPaths.back(), -offset_dist_to_get_from_on_the_polygon_to_outside, max_comb_distance_ignored, fail_on_unavoidable_obstacles);
+        bool combing_succeeded = LinePolygonsCrossings::comb(start_crossing.dest_part, *inside_loc_to_line_optimal, startPoint, start_crossing.in_or_mid, combPaths.back(), -offset_dist_to_get_from_on_the_polygon_to_outside, max_comb_distance_ignored, fail_on_unavoidable_obstacles, &partsView_inside_optimal[start_part_idx]);
         if (!combing_succeeded)
         { // Couldn't comb between start point and computed crossing from the start part! Happens for very thin parts when the offset_to_get_off_boundary moves points to outside the polygon
             return false;
@@ -207,7 +213,7 @@ bool Comb::calc(const ExtruderTrain& train, Point startPoint, Point endPoint, Co
         }
         else
         {
-            bool combing_succeeded = LinePolygonsCrossings::comb(*boundary_outside, *outside_loc_to_line, start_crossing.out, end_crossing.out, combPaths.back(), offset_dist_to_get_from_on_the_polygon_to_outside, max_comb_distance_ignored, fail_on_unavoidable_obstacles);
+            bool combing_succeeded = LinePolygonsCrossings::comb(getBoundaryOutside(), getOutsideLocToLine(), start_crossing.out, end_crossing.out, combPaths.back(), offset_dist_to_get_from_on_the_polygon_to_outside, max_comb_distance_ignored, fail_on_unavoidable_obstacles);
             if (!combing_succeeded)
             {
                 return false;
@@ -232,7 +238,7 @@ bool Comb::calc(const ExtruderTrain& train, Point startPoint, Point endPoint, Co
             }
             else
             { // both start and end are outside
-                combPaths.back().cross_boundary = PolygonUtils::polygonCollidesWithLineSegment(startPoint, endPoint, *outside_loc_to_line);
+                combPaths.back().cross_boundary = PolygonUtils::polygonCollidesWithLineSegment(startPoint, endPoint, getOutsideLocToLine());
             }
         }
         else
@@ -247,7 +253,7 @@ bool Comb::calc(const ExtruderTrain& train, Point startPoint, Point endPoint, Co
         assert(end_crossing.dest_part.size() > 0 && "The part we end up inside when combing should have been computed already!");
         combPaths.emplace_back();
 
-        bool combing_succeeded = LinePolygonsCrossings::comb(end_crossing.dest_part, *inside_loc_to_line_optimal, end_crossing.in_or_mid, endPoint, combPaths.back(), -offset_dist_to_get_from_on_the_polygon_to_outside, max_comb_distance_ignored, fail_on_unavoidable_obstacles);
+        bool combing_succeeded = LinePolygonsCrossings::comb(end_crossing.dest_part, *inside_loc_to_line_optimal, end_crossing.in_or_mid, endPoint, combPaths.back(), -offset_dist_to_get_from_on_the_polygon_to_outside, max_comb_distance_ignored, fail_on_unavoidable_obstacles, &partsView_inside_optimal[end_part_idx]);
         if (!combing_succeeded)
         { // Couldn't comb between end point and computed crossing to the end part! Happens for very thin parts when the offset_to_get_off_boundary moves points to outside the polygon
             return false;
@@ -257,6 +263,46 @@ bool Comb::calc(const ExtruderTrain& train, Point startPoint, Point endPoint, Co
     return true;
 }
 
+bool Comb::isVisibilityGraphEnabled()
+{
+    return Application::getInstance().current_slice->scene.current_mesh_group->settings.get<bool>("retraction_combing_visibility_graph", false);
+}
+
+bool Comb::combWithinPart(const Polygons& boundary_inside, const PartsView& parts_view, const unsigned int part_idx, LocToLineGrid& inside_loc_to_line, std::vector<std::unique_ptr<VisibilityGraph>>& visibility_graphs, const Point start_point, const Point end_point, CombPath& comb_path, const coord_t max_comb_distance_ignored, const bool fail_on_unavoidable_obstacles)
+{
+    const size_t path_start_idx = comb_path.size();
+    PolygonsPart part = parts_view.assemblePart(part_idx);
+    const bool comb_result = LinePolygonsCrossings::comb(part, inside_loc_to_line, start_point, end_point, comb_path, -offset_dist_to_get_from_on_the_polygon_to_outside, max_comb_distance_ignored, fail_on_unavoidable_obstacles, &parts_view[part_idx]);
+    if (!use_visibility_graph || shorterThen(end_point - start_point, max_comb_distance_ignored) || (comb_result && comb_path.size() - path_start_idx <= 2))
+    { // no obstacles to go around
+        return comb_result;
+    }
+
+    std::unique_ptr<VisibilityGraph>& visibility_graph = visibility_graphs[part_idx];
+    if (!visibility_graph)
+    {
+        visibility_graph.reset(new VisibilityGraph(boundary_inside, parts_view[part_idx], inside_loc_to_line, -offset_dist_to_get_from_on_the_polygon_to_outside));
+    }
+    // LinePolygonsCrossings cuts the corners of the boundary a bit, so its path is often shorter when there is a single obstacle
+    coord_t comb_length = std::numeric_limits<coord_t>::max();
+    if (comb_result)
+    {
+        comb_length = 0;
+        for (size_t point_idx = path_start_idx + 1; point_idx < comb_path.size(); point_idx++)
+        {
+            comb_length += vSize(comb_path[point_idx] - comb_path[point_idx - 1]);
+        }
+    }
+    CombPath shortest_path;
+    if (!visibility_graph->findPath(start_point, end_point, shortest_path, comb_length))
+    { // no shorter path, or e.g. the start or end point is too close to the boundary to see any corner
+        return comb_result;
+    }
+    comb_path.erase(comb_path.begin() + path_start_idx, comb_path.end());
+    comb_path.insert(comb_path.end(), shortest_path.begin(), shortest_path.end());
+    return true;
+}
+
 //  Try to move comb_path_input points inside by the amount of `move_inside_distance` and see if the points are still in boundary_inside_optimal, add result in comp_path_output
 void Comb::moveCombPathInside(Polygons& boundary_inside, Polygons& boundary_inside_optimal, CombPath& comb_path_input, CombPath& comb_path_output)
 {
@@ -9,19 +9,21 @@
 
 #include "LinePolygonsCrossings.h"
 #include "CombPath.h"
+#include "CombBoundaryCache.h"
 #include "CombPaths.h"
+#include "VisibilityGraph.h"
 #include "../ExtruderTrain.h" //To get settings from an extruder.
 #include "../settings/types/LayerIndex.h" //To store the layer on which we comb.
 #include "../utils/optional.h"
 #include "../utils/polygon.h"
 #include "../utils/SparsePointGridInclusive.h"
 #include "../utils/polygonUtils.h"
-#include "../utils/LazyInitialization.h"
 
 namespace cura 
 {
 
 class SliceDataStorage;
+class TravelPlanCache;
 
 /*!
  * \brief Class for generating a full combing actions from a travel move from a start
@@ -35,7 +37,7 @@ class SliceDataStorage;
  * through air avoiding other parts in the layer + a combing path from the
  * boundary of the ending polygon to the end point. Each of these three is a
  * CombPath; the first and last are within Comb::boundary_inside while the
- * middle is outside of Comb::boundary_outside. Between these there is a little
+ * middle is outside of Comb::getBoundaryOutside. Between these there is a little
  * gap where the nozzle crosses the boundary of an object approximately
  * perpendicular to its boundary.
  *
@@ -128,16 +130,21 @@ private:
     static constexpr coord_t offset_dist_to_get_from_on_the_polygon_to_outside = 40; //!< in order to prevent on-boundary vs crossing boundary confusions (precision thing)
     static constexpr coord_t offset_extra_start_end = 100; //!< Distance to move start point and end point toward eachother to extra avoid collision with the boundaries.
 
-    Polygons boundary_inside_minimum; //!< The boundary within which to comb. (Will be reordered by the partsView_inside_minimum)
-    Polygons boundary_inside_optimal; //!< The boundary within which to comb. (Will be reordered by the partsView_inside_optimal)
+    CombBoundaryCache& comb_boundaries; //!< The boundaries of the layer, shared with the rest of the planning of the layer.
+    Polygons& boundary_inside_minimum; //!< The boundary within which to comb. (Will be reordered by the partsView_inside_minimum)
+    Polygons& boundary_inside_optimal; //!< The boundary within which to comb. (Will be reordered by the partsView_inside_optimal)
     const PartsView partsView_inside_minimum; //!< Structured indices onto boundary_inside_minimum which shows which polygons belong to which part.
     const PartsView partsView_inside_optimal; //!< Structured indices onto boundary_inside_optimal which shows which polygons belong to which part.
     LocToLineGrid* inside_loc_to_line_minimum; //!< The SparsePointGridInclusive mapping locations to line segments of the inner boundary.
     LocToLineGrid* inside_loc_to_line_optimal; //!< The SparsePointGridInclusive mapping locations to line segments of the inner boundary.
-    LazyInitialization<Polygons> boundary_outside; //!< The boundary outside of which to stay to avoid collision with other layer parts. This is a pointer cause we only compute it when we move outside the boundary (so not when there is only a single part in the layer)
-    LazyInitialization<LocToLineGrid, Comb*, const coord_t> outside_loc_to_line; //!< The SparsePointGridInclusive mapping locations to line segments of the outside boundary.
     coord_t move_inside_distance; //!< When using comb_boundary_inside_minimum for combing it tries to move points inside by this amount after calculating the path to move it from the border a bit.
 
+    const bool use_visibility_graph; //!< Whether to comb within a part along the shortest path through its visibility graph, rather than around the polygons crossed by the straight line.
+    std::vector<std::unique_ptr<VisibilityGraph>> visibility_graphs_minimum; //!< For each part of Comb::partsView_inside_minimum its visibility graph, once it has been needed.
+    std::vector<std::unique_ptr<VisibilityGraph>> visibility_graphs_optimal; //!< For each part of Comb::partsView_inside_optimal its visibility graph, once it has been needed.
+    TravelPlanCache* travel_plan_cache; //!< Where combing paths within parts found for earlier layers are stored, if they may be reused.
+    GeometryHash boundaries_hash; //!< The hash of the inside boundaries and the parameters of this Comb, with which combing paths within parts are stored in Comb::travel_plan_cache.
+
     /*!
      * Get the SparsePointGridInclusive mapping locations to line segments of the outside boundary. Calculate it when it hasn't been calculated yet.
      */
@@ -160,20 +167,53 @@ private:
 
     void moveCombPathInside(Polygons& boundary_inside, Polygons& boundary_inside_optimal, CombPath& comb_path_input, CombPath& comb_path_output);
 
+    /*!
+     * Whether the retraction_combing_visibility_graph setting is enabled. It
+     * is off when the setting is missing.
+     */
+    static bool isVisibilityGraphEnabled();
+
+    /*!
+     * Calculate a combing path between two points inside the same part of an
+     * inside boundary.
+     *
+     * Uses LinePolygonsCrossings. If Comb::use_visibility_graph is set and
+     * that path goes around obstacles or fails, the path through the
+     * visibility graph of the part is used instead if it is shorter.
+     *
+     * \param boundary_inside The inside boundary of which to comb in a part.
+     * \param parts_view The parts of \p boundary_inside.
+     * \param part_idx The index in \p parts_view of the part to comb in.
+     * \param inside_loc_to_line A grid mapping locations to line segments of
+     * \p boundary_inside.
+     * \param visibility_graphs The visibility graphs of the parts of
+     * \p parts_view, which are created when they are first needed.
+     * \param start_point Where to start moving from.
+     * \param end_point Where to move to.
+     * \param[out] comb_path The combing path from \p start_point to
+     * \p end_point.
+     * \param max_comb_distance_ignored Travel moves shorter than this are not
+     * combed.
+     * \param fail_on_unavoidable_obstacles When moving over other parts is
+     * unavoidable, stop calculation early and return false.
+     * \return Whether combing has succeeded.
+     */
+    bool combWithinPart(const Polygons& boundary_inside, const PartsView& parts_view, const unsigned int part_idx, LocToLineGrid& inside_loc_to_line, std::vector<std::unique_ptr<VisibilityGraph>>& visibility_graphs, const Point start_point, const Point end_point, CombPath& comb_path, const coord_t max_comb_distance_ignored, const bool fail_on_unavoidable_obstacles);
+
 public:
     /*!
      * Initialises the combing areas for every mesh in the layer (not support).
      * 
-     * \warning \ref Comb::calc changes the order of polygons in
-     * \p Comb::comb_boundary_inside
+     * \warning Changes the order of the polygons of the minimum and optimal
+     * boundaries in \p comb_boundaries
      * 
      * \param storage Where the layer polygon data is stored.
      * \param layer_nr The number of the layer for which to generate the combing
      * areas.
-     * \param comb_boundary_inside_optimal The better comb boundary within which
-     * to comb within layer parts.
-     * \param comb_boundary_inside_minimum The minimum comb boundary within
-     * which to comb within layer parts.
+     * \param comb_boundaries The boundaries of the layer within which to comb
+     * and outside of which to travel through air. Combing uses its
+     * CombBoundary::MINIMUM, CombBoundary::OPTIMAL and CombBoundary::OUTSIDE
+     * boundaries and their grids.
      * \param offset_from_outlines The offset from the outline polygon, to
      * create the combing boundary in case there is no second wall.
      * \param travel_avoid_distance The distance by which to avoid other layer
@@ -181,10 +221,11 @@ public:
      * \param move_inside_distance When using comb_boundary_inside_minimum for
      * combing it tries to move points inside by this amount after calculating
      * the path to move it from the border a bit.
+     * \param travel_plan_cache Where to store the combing paths within parts,
+     * to be reused by later layers with the same inside boundaries, or nullptr
+     * to always compute them.
      */
-    Comb(const SliceDataStorage& storage, const LayerIndex layer_nr, const Polygons& comb_boundary_inside_minimum, const Polygons& comb_boundary_inside_optimal, coord_t offset_from_outlines, coord_t travel_avoid_distance, coord_t move_inside_distance);
-
-    ~Comb();
+    Comb(const SliceDataStorage& storage, const LayerIndex layer_nr, CombBoundaryCache& comb_boundaries, coord_t offset_from_outlines, coord_t travel_avoid_distance, coord_t move_inside_distance, TravelPlanCache* travel_plan_cache = nullptr);
 
     /*!
      * \brief Calculate the comb paths (if any), one for each polygon combed
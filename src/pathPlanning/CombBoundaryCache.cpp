@@ -0,0 +1,275 @@
+//Copyright (c) 2018 Ultimaker B.V.
+//CuraEngine is released under the terms of the AGPLv3 or higher.
+
+#include "CombBoundaryCache.h"
+#include "../Application.h"
+#include "../ExtruderTrain.h"
+#include "../pathOrderOptimizer.h" //For the grid sizes of the order optimizers.
+#include "../sliceDataStorage.h"
+
+namespace cura
+{
+
+CombBoundaryCache::CombBoundaryCache(const SliceDataStorage& storage, const LayerIndex layer_nr, const coord_t comb_boundary_offset, const coord_t travel_avoid_distance)
+: storage(storage)
+, layer_nr(layer_nr)
+, comb_boundary_offset(comb_boundary_offset)
+, travel_avoid_distance(travel_avoid_distance)
+{
+    for (unsigned int boundary_idx = 0; boundary_idx < boundary_count; boundary_idx++)
+    {
+        loc_to_lines[boundary_idx] = nullptr;
+    }
+}
+
+CombBoundaryCache::~CombBoundaryCache()
+{
+    for (unsigned int boundary_idx = 0; boundary_idx < boundary_count; boundary_idx++)
+    {
+        if (loc_to_lines[boundary_idx])
+        {
+            delete loc_to_lines[boundary_idx];
+        }
+    }
+}
+
+Polygons& CombBoundaryCache::getBoundary(const CombBoundary boundary)
+{
+    std::optional<Polygons>& result = boundaries[static_cast<unsigned int>(boundary)];
+    if (!result)
+    {
+        switch (boundary)
+        {
+            case CombBoundary::MINIMUM:
+                result.emplace(computeCombBoundaryInside(1));
+                break;
+            case CombBoundary::OPTIMAL:
+                result.emplace(computeCombBoundaryInside(2));
+                break;
+            case CombBoundary::PATH_ORDER:
+                result.emplace(getBoundary(CombBoundary::OPTIMAL));
+                result->simplify(100, 100);
+                break;
+            case CombBoundary::LINE_ORDER:
+                result.emplace(computeLineOrderBoundary());
+                break;
+            case CombBoundary::OUTSIDE:
+                result.emplace(computeBoundaryOutside());
+                break;
+        }
+    }
+    return *result;
+}
+
+LocToLineGrid* CombBoundaryCache::getLocToLine(const CombBoundary boundary)
+{
+    LocToLineGrid*& result = loc_to_lines[static_cast<unsigned int>(boundary)];
+    if (!result)
+    {
+        result = PolygonUtils::createLocToLineGrid(getBoundary(boundary), getGridSize(boundary));
+    }
+    return result;
+}
+
+size_t CombBoundaryCache::getMemoryUsage() const
+{
+    //A grid stores each line segment in about two cells, in a hash map node with some overhead.
+    constexpr size_t grid_bytes_per_point = 2 * (sizeof(PolygonsPointIndex) + 32);
+    size_t result = 0;
+    for (unsigned int boundary_idx = 0; boundary_idx < boundary_count; boundary_idx++)
+    {
+        if (!boundaries[boundary_idx])
+        {
+            continue;
+        }
+        const size_t point_count = boundaries[boundary_idx]->pointCount();
+        result += point_count * sizeof(Point);
+        if (loc_to_lines[boundary_idx])
+        {
+            result += point_count * grid_bytes_per_point;
+        }
+    }
+    return result;
+}
+
+const GeometryHash& CombBoundaryCache::getBoundaryHash(const CombBoundary boundary)
+{
+    std::optional<GeometryHash>& result = boundary_hashes[static_cast<unsigned int>(boundary)];
+    if (!result)
+    {
+        result.emplace();
+        result->add(getBoundary(boundary));
+    }
+    return *result;
+}
+
+coord_t CombBoundaryCache::getGridSize(const CombBoundary boundary) const
+{
+    switch (boundary)
+    {
+        case CombBoundary::PATH_ORDER:
+            return PathOrderOptimizer::loc_to_line_grid_size;
+        case CombBoundary::LINE_ORDER:
+            return LineOrderOptimizer::loc_to_line_grid_size;
+        case CombBoundary::OUTSIDE:
+            return (comb_boundary_offset + travel_avoid_distance) * 3 / 2;
+        case CombBoundary::MINIMUM:
+        case CombBoundary::OPTIMAL:
+        default:
+            return comb_boundary_offset;
+    }
+}
+
+Polygons CombBoundaryCache::computeCombBoundaryInside(const size_t max_inset) const
+{
+    const CombingMode combing_mode = Application::getInstance().current_slice->scene.current_mesh_group->settings.get<CombingMode>("retraction_combing");
+    if (combing_mode == CombingMode::OFF)
+    {
+        return Polygons();
+    }
+    if (layer_nr < 0)
+    { // when a raft is present
+        if (combing_mode == CombingMode::NO_SKIN)
+        {
+            return Polygons();
+        }
+        else
+        {
+            return storage.raftOutline.offset(MM2INT(0.1));
+        }
+    }
+    else 
+    {
+        Polygons comb_boundary;
+        for (const SliceMeshStorage& mesh : storage.meshes)
+        {
+            const SliceLayer& layer = mesh.layers[layer_nr];
+            if (mesh.settings.get<bool>("infill_mesh")) {
+                continue;
+            }
+            const CombingMode combing_mode = mesh.settings.get<CombingMode>("retraction_combing");
+            if (combing_mode == CombingMode::NO_SKIN)
+            {
+                // we need to include the walls in the comb boundary otherwise it's not possible to tell if a travel move crosses a skin region
+
+                const coord_t line_width_0 = mesh.settings.get<coord_t>("wall_line_width_0");
+
+                for (const SliceLayerPart& part : layer.parts)
+                {
+                    const size_t num_insets = part.insets.size();
+                    Polygons outer = part.outline; // outer boundary of wall combing region
+                    coord_t outer_to_outline_dist = 0; // distance from outer to the part's outline
+
+                    if (num_insets > 1 && part.insets[1].size() == part.outline.size())
+                    {
+                        // part's wall has multiple lines and the 2nd wall line is complete
+                        // set the outer boundary to the inside edge of the outer wall
+
+                        outer = part.insets[0].offset(-line_width_0/2);
+                        outer_to_outline_dist = line_width_0;
+                    }
+                    else if (num_insets > 0)
+                    {
+                        // set the outer boundary to be 1/4 line width inside the centre line of the outer wall
+
+                        outer = part.insets[0].offset(-line_width_0/4);
+                        outer_to_outline_dist = line_width_0*3/4;
+                    }
+
+                    // finally, check that outer actually has the same number of polygons as the part's outline
+                    // if it doesn't it means that the outer wall is missing where the part narrows so in those
+                    // regions we need to use the part outline for the outer boundary of the combing region
+                    // (expect poor results due to the nozzle being allowed to go right to the part's edge)
+
+                    if (outer.size() != part.outline.size())
+                    {
+                        // first we calculate the part outline for those portions of the part where outer is missing
+                        // this is done by shrinking the part outline so that it is very slightly smaller than outer, then expanding it again so it is very
+                        // slightly larger than its original size and subtracting that from the original part outline
+                        // NOTE - the additional small shrink/expands are required to ensure that the polygons overlap a little so we do not rely on exact results
+
+                        Polygons outline_where_outer_is_missing(part.outline.difference(part.outline.offset(-(outer_to_outline_dist+5)).offset(outer_to_outline_dist+10)));
+
+                        // merge outer with the portions of the part outline we just calculated
+                        // the trick here is to expand the outlines sufficiently so that they overlap when unioned and then the result is shrunk back to the correct size
+
+                        outer = outer.offset(outer_to_outline_dist/2+10).unionPolygons(outline_where_outer_is_missing.offset(outer_to_outline_dist/2+10)).offset(-(outer_to_outline_dist/2+10));
+                    }
+
+                    Polygons inner; // inner boundary of wall combing region
+
+                    // the inside of the wall combing region is just inside the wall's inner edge so it can meet up with the infill (if any)
+
+                    if (num_insets == 0)
+                    {
+                        inner = part.outline.offset(-10);
+                    }
+                    else if (num_insets == 1)
+                    {
+                        inner = part.insets[0].offset(-10-line_width_0/2);
+                    }
+                    else if(num_insets > 1)
+                    {
+                        inner = part.insets[num_insets - 1].offset(-10 - mesh.settings.get<coord_t>("wall_line_width_x") / 2);
+                    }
+
+                    // combine the wall combing region (outer - inner) with the infill (if any)
+                    comb_boundary.add(part.infill_area.unionPolygons(outer.difference(inner)));
+                }
+            }
+            else if (combing_mode == CombingMode::INFILL)
+            {
+                for (const SliceLayerPart& part : layer.parts)
+                {
+                    comb_boundary.add(part.infill_area);
+                }
+            }
+            else
+            {
+                comb_boundary.add(layer.getInnermostWalls(max_inset, mesh));
+            }
+        }
+        return comb_boundary;
+    }
+}
+
+Polygons CombBoundaryCache::computeLineOrderBoundary()
+{
+    Polygons line_order_boundary;
+    const Polygons& comb_boundary_inside = getBoundary(CombBoundary::OPTIMAL);
+    if (comb_boundary_inside.size() > 0)
+    {
+        // use the combing boundary inflated so that all infill lines are inside the boundary
+        int dist = 0;
+        if (layer_nr >= 0)
+        {
+            // determine how much the skin/infill lines overlap the combing boundary
+            for (const SliceMeshStorage& mesh : storage.meshes)
+            {
+                const coord_t overlap = std::max(mesh.settings.get<coord_t>("skin_overlap_mm"), mesh.settings.get<coord_t>("infill_overlap_mm"));
+                if (overlap > dist)
+                {
+                    dist = overlap;
+                }
+            }
+            dist += 100; // ensure boundary is slightly outside all skin/infill lines
+        }
+        line_order_boundary.add(comb_boundary_inside.offset(dist));
+        // simplify boundary to cut down processing time
+        line_order_boundary.simplify(100, 100);
+    }
+    return line_order_boundary;
+}
+
+Polygons CombBoundaryCache::computeBoundaryOutside() const
+{
+    const std::vector<bool> extruder_is_used = storage.getExtrudersUsed();
+    bool travel_avoid_supports = false;
+    for (const ExtruderTrain& extruder : Application::getInstance().current_slice->scene.extruders)
+    {
+        travel_avoid_supports |= extruder_is_used[extruder.extruder_nr] && extruder.settings.get<bool>("travel_avoid_other_parts") && extruder.settings.get<bool>("travel_avoid_supports");
+    }
+    return storage.getLayerOutlines(layer_nr, travel_avoid_supports, travel_avoid_supports).offset(travel_avoid_distance);
+}
+
+} //namespace cura
@@ -0,0 +1,128 @@
+//Copyright (c) 2018 Ultimaker B.V.
+//CuraEngine is released under the terms of the AGPLv3 or higher.
+
+#ifndef PATH_PLANNING_COMB_BOUNDARY_CACHE_H
+#define PATH_PLANNING_COMB_BOUNDARY_CACHE_H
+
+#include "../settings/types/LayerIndex.h"
+#include "../utils/GeometryHash.h"
+#include "../utils/optional.h"
+#include "../utils/polygon.h"
+#include "../utils/polygonUtils.h"
+
+namespace cura
+{
+
+class SliceDataStorage;
+
+/*!
+ * The boundaries which are used to plan travel moves in a layer.
+ */
+enum class CombBoundary
+{
+    MINIMUM = 0, //!< The minimum boundary within which to comb, or to move into when performing a retraction.
+    OPTIMAL = 1, //!< The boundary preferably within which to comb, or to move into when performing a retraction.
+    PATH_ORDER = 2, //!< The optimal boundary, simplified, to estimate travel distances between polygons in a PathOrderOptimizer.
+    LINE_ORDER = 3, //!< The optimal boundary, inflated so that all skin and infill lines are inside it, to estimate travel distances in a LineOrderOptimizer.
+    OUTSIDE = 4, //!< The outlines of all parts in the layer, offset by the travel avoid distance, to travel around through air.
+};
+
+/*!
+ * \brief The comb boundaries of a single layer and the grids over them.
+ *
+ * Each boundary is computed only once per layer, when it is first needed, and
+ * is then shared by the Comb, the order optimizers and the LayerPlan of that
+ * layer.
+ */
+class CombBoundaryCache
+{
+public:
+    /*!
+     * \param storage Where the layer polygon data is stored.
+     * \param layer_nr The layer for which to compute the boundaries.
+     * \param comb_boundary_offset The offset from the outlines between the
+     * inside boundaries and the walls. Also the cell size of the grids over
+     * the inside boundaries.
+     * \param travel_avoid_distance The distance by which to avoid other parts
+     * when travelling through air.
+     */
+    CombBoundaryCache(const SliceDataStorage& storage, const LayerIndex layer_nr, const coord_t comb_boundary_offset, const coord_t travel_avoid_distance);
+
+    CombBoundaryCache(const CombBoundaryCache&) = delete;
+    CombBoundaryCache& operator=(const CombBoundaryCache&) = delete;
+
+    ~CombBoundaryCache();
+
+    /*!
+     * Get a boundary. Compute it when it hasn't been computed yet.
+     *
+     * \warning Comb changes the order of the polygons of the
+     * CombBoundary::MINIMUM and CombBoundary::OPTIMAL boundaries.
+     */
+    Polygons& getBoundary(const CombBoundary boundary);
+
+    /*!
+     * Get the grid mapping locations to the line segments of a boundary.
+     * Create it when it hasn't been created yet.
+     */
+    LocToLineGrid* getLocToLine(const CombBoundary boundary);
+
+    /*!
+     * Get the hash of a boundary, with which the orders and combing paths
+     * computed within it are stored in a TravelPlanCache. Compute it when it
+     * hasn't been computed yet.
+     *
+     * \warning The hash of the CombBoundary::MINIMUM and
+     * CombBoundary::OPTIMAL boundaries should only be computed after Comb has
+     * reordered them.
+     */
+    const GeometryHash& getBoundaryHash(const CombBoundary boundary);
+
+    /*!
+     * Estimate the memory used by the boundaries and grids computed so far.
+     *
+     * \return The estimated number of bytes.
+     */
+    size_t getMemoryUsage() const;
+
+private:
+    static constexpr unsigned int boundary_count = 5; //!< The number of values of CombBoundary
+
+    const SliceDataStorage& storage; //!< Where the layer polygon data is stored
+    const LayerIndex layer_nr; //!< The layer of the boundaries
+    const coord_t comb_boundary_offset; //!< The offset from the outlines between the inside boundaries and the walls
+    const coord_t travel_avoid_distance; //!< The distance by which to avoid other parts when travelling through air
+
+    std::optional<Polygons> boundaries[boundary_count]; //!< For each CombBoundary the boundary, once it has been computed
+    LocToLineGrid* loc_to_lines[boundary_count]; //!< For each CombBoundary the grid over its boundary, once it has been created
+    std::optional<GeometryHash> boundary_hashes[boundary_count]; //!< For each CombBoundary the hash of its boundary, once it has been computed
+
+    /*!
+     * \brief Compute the boundary within which to comb, or to move into when
+     * performing a retraction.
+     * \param max_inset The greatest inset index.
+     * \return the comb_boundary_inside
+     */
+    Polygons computeCombBoundaryInside(const size_t max_inset) const;
+
+    /*!
+     * \brief Compute the combing boundary, inflated so that all skin and infill
+     * lines are inside it.
+     */
+    Polygons computeLineOrderBoundary();
+
+    /*!
+     * \brief Compute the outlines of all parts in the layer, offset by the
+     * travel avoid distance.
+     */
+    Polygons computeBoundaryOutside() const;
+
+    /*!
+     * \brief Get the cell size of the grid over a boundary.
+     */
+    coord_t getGridSize(const CombBoundary boundary) const;
+};
+
+} //namespace cura
+
+#endif //PATH_PLANNING_COMB_BOUNDARY_CACHE_H
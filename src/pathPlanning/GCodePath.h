@@ -7,6 +7,7 @@
 #include "../SpaceFillType.h"
 #include "../GCodePathConfig.h"
 
+#include "ArcFitter.h"
 #include "TimeMaterialEstimates.h"
 
 namespace cura 
@@ -35,6 +36,7 @@ public:
     bool perform_prime; //!< Whether this path is preceded by a prime (blob)
     bool skip_agressive_merge_hint; //!< Wheter this path needs to skip merging if any travel paths are in between the extrusions.
     std::vector<Point> points; //!< The points constituting this path.
+    std::vector<PathArc> arcs; //!< Runs of points which are written as arcs instead of line segments, in order.
     bool done; //!< Path is finished, no more moves should be added, and a new path should be started instead of any appending done to this one.
 
     bool spiralize; //!< Whether to gradually increment the z position during the printing of this path. A sequence of spiralized paths should start at the given layer height and end in one layer higher.
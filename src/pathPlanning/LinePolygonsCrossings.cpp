@@ -4,6 +4,7 @@
 #include "LinePolygonsCrossings.h"
 
 #include <algorithm>
+#include <functional> //For function.
 
 #include "../utils/polygonUtils.h"
 #include "../sliceDataStorage.h"
@@ -29,44 +30,30 @@ bool LinePolygonsCrossings::calcScanlineCrossings(bool fail_on_unavoidable_obsta
     min_crossing_idx = NO_INDEX;
     max_crossing_idx = NO_INDEX;
 
+    unsigned int segment_idx = 0; // the first of LinePolygonsCrossings::scanline_segments which hasn't been processed yet
     for(unsigned int poly_idx = 0; poly_idx < boundary.size(); poly_idx++)
     {
         PolyCrossings minMax(poly_idx); 
         ConstPolygonRef poly = boundary[poly_idx];
-        Point p0 = transformation_matrix.apply(poly[poly.size() - 1]);
-        for(unsigned int point_idx = 0; point_idx < poly.size(); point_idx++)
+        if (use_scanline_segments)
         {
-            Point p1 = transformation_matrix.apply(poly[point_idx]);
-            if ((p0.Y >= transformed_startPoint.Y && p1.Y <= transformed_startPoint.Y) || (p1.Y >= transformed_startPoint.Y && p0.Y <= transformed_startPoint.Y))
-            { // if line segment crosses the line through the transformed start and end point (aka scanline)
-                if (p1.Y == p0.Y) //Line segment is parallel with the scanline. That means that both endpoints lie on the scanline, so they will have intersected with the adjacent line.
-                {
-                    p0 = p1;
-                    continue;
-                }
-                const coord_t x = p0.X + (p1.X - p0.X) * (transformed_startPoint.Y - p0.Y) / (p1.Y - p0.Y); // intersection point between line segment and the scanline
-                
-                if (x >= transformed_startPoint.X && x <= transformed_endPoint.X)
-                {
-                    if (!((p1.Y == transformed_startPoint.Y && p1.Y < p0.Y) || (p0.Y == transformed_startPoint.Y && p0.Y < p1.Y)))
-                    { // perform edge case only for line segments on and below the scanline, not for line segments on and above.
-                        // \/ will be no crossings and /\ two, but most importantly | will be one crossing.
-                        minMax.n_crossings++;
-                    }
-                    if(x < minMax.min.x) //For the leftmost intersection, move x left to stay outside of the border.
-                                         //Note: The actual distance from the intersection to the border is almost always less than dist_to_move_boundary_point_outside, since it only moves along the direction of the scanline.
-                    {
-                        minMax.min.x = x;
-                        minMax.min.point_idx = point_idx;
-                    }
-                    if(x > minMax.max.x) //For the rightmost intersection, move x right to stay outside of the border.
-                    {
-                        minMax.max.x = x;
-                        minMax.max.point_idx = point_idx;
-                    }
-                }
+            for (; segment_idx < scanline_segments.size() && scanline_segments[segment_idx].first == poly_idx; segment_idx++)
+            {
+                const unsigned int point_idx = scanline_segments[segment_idx].second;
+                const Point p0 = transformation_matrix.apply(poly[(point_idx + poly.size() - 1) % poly.size()]);
+                const Point p1 = transformation_matrix.apply(poly[point_idx]);
+                addScanlineCrossing(p0, p1, point_idx, minMax);
+            }
+        }
+        else
+        {
+            Point p0 = transformation_matrix.apply(poly[poly.size() - 1]);
+            for(unsigned int point_idx = 0; point_idx < poly.size(); point_idx++)
+            {
+                Point p1 = transformation_matrix.apply(poly[point_idx]);
+                addScanlineCrossing(p0, p1, point_idx, minMax);
+                p0 = p1;
             }
-            p0 = p1;
         }
 
         if (fail_on_unavoidable_obstacles && minMax.n_crossings % 2 == 1)
@@ -83,6 +70,104 @@ bool LinePolygonsCrossings::calcScanlineCrossings(bool fail_on_unavoidable_obsta
     return true;
 }
 
+void LinePolygonsCrossings::addScanlineCrossing(const Point p0, const Point p1, const size_t point_idx, PolyCrossings& minMax) const
+{
+    if ((p0.Y >= transformed_startPoint.Y && p1.Y <= transformed_startPoint.Y) || (p1.Y >= transformed_startPoint.Y && p0.Y <= transformed_startPoint.Y))
+    { // if line segment crosses the line through the transformed start and end point (aka scanline)
+        if (p1.Y == p0.Y) //Line segment is parallel with the scanline. That means that both endpoints lie on the scanline, so they will have intersected with the adjacent line.
+        {
+            return;
+        }
+        const coord_t x = p0.X + (p1.X - p0.X) * (transformed_startPoint.Y - p0.Y) / (p1.Y - p0.Y); // intersection point between line segment and the scanline
+
+        if (x >= transformed_startPoint.X && x <= transformed_endPoint.X)
+        {
+            if (!((p1.Y == transformed_startPoint.Y && p1.Y < p0.Y) || (p0.Y == transformed_startPoint.Y && p0.Y < p1.Y)))
+            { // perform edge case only for line segments on and below the scanline, not for line segments on and above.
+                // \/ will be no crossings and /\ two, but most importantly | will be one crossing.
+                minMax.n_crossings++;
+            }
+            if(x < minMax.min.x) //For the leftmost intersection, move x left to stay outside of the border.
+                                 //Note: The actual distance from the intersection to the border is almost always less than dist_to_move_boundary_point_outside, since it only moves along the direction of the scanline.
+            {
+                minMax.min.x = x;
+                minMax.min.point_idx = point_idx;
+            }
+            if(x > minMax.max.x) //For the rightmost intersection, move x right to stay outside of the border.
+            {
+                minMax.max.x = x;
+                minMax.max.point_idx = point_idx;
+            }
+        }
+    }
+}
+
+bool LinePolygonsCrossings::findScanlineSegments()
+{
+    std::vector<std::pair<unsigned int, unsigned int>> grid_to_boundary_poly_idx; // sorted pairs of the index of a polygon in the grid and in the boundary
+    if (grid_poly_indices)
+    {
+        grid_to_boundary_poly_idx.reserve(grid_poly_indices->size());
+        for (unsigned int poly_idx = 0; poly_idx < grid_poly_indices->size(); poly_idx++)
+        {
+            grid_to_boundary_poly_idx.emplace_back((*grid_poly_indices)[poly_idx], poly_idx);
+        }
+        std::sort(grid_to_boundary_poly_idx.begin(), grid_to_boundary_poly_idx.end());
+    }
+
+    bool grid_is_over_boundary = true;
+    const std::function<bool (const PolygonsPointIndex&)> process_elem_func =
+        [this, &grid_to_boundary_poly_idx, &grid_is_over_boundary](const PolygonsPointIndex& line_start)
+        {
+            unsigned int poly_idx = line_start.poly_idx;
+            if (grid_poly_indices)
+            {
+                const auto it = std::lower_bound(grid_to_boundary_poly_idx.begin(), grid_to_boundary_poly_idx.end(), std::make_pair(poly_idx, 0u));
+                if (it == grid_to_boundary_poly_idx.end() || it->first != poly_idx)
+                { // the polygon is not part of the boundary
+                    return true;
+                }
+                poly_idx = it->second;
+            }
+            else if (line_start.polygons != &boundary)
+            {
+                grid_is_over_boundary = false;
+                return false;
+            }
+            // the grid stores a line segment by its start point, while the crossings store its end point
+            scanline_segments.emplace_back(poly_idx, (line_start.point_idx + 1) % boundary[poly_idx].size());
+            return true;
+        };
+    loc_to_line_grid.processLine(std::make_pair(startPoint, endPoint), process_elem_func);
+    if (!grid_is_over_boundary)
+    {
+        scanline_segments.clear();
+        return false;
+    }
+    // line segments are found once for every cell they are in
+    std::sort(scanline_segments.begin(), scanline_segments.end());
+    scanline_segments.erase(std::unique(scanline_segments.begin(), scanline_segments.end()), scanline_segments.end());
+    return true;
+}
+
+bool LinePolygonsCrossings::segmentCollidesWithScanline(const Point p0, const Point p1) const
+{
+    // when the boundary just touches the line don't disambiguate between the boundary moving on to actually cross the line
+    // and the boundary bouncing back, resulting in not a real collision - to keep the algorithm simple.
+    //
+    // disregard overlapping line segments; probably the next or previous line segment is not overlapping, but will give a collision
+    // when the boundary line segment fully overlaps with the line segment this edge case is not viewed as a collision
+    if (p1.Y != p0.Y && ((p0.Y >= transformed_startPoint.Y && p1.Y <= transformed_startPoint.Y) || (p1.Y >= transformed_startPoint.Y && p0.Y <= transformed_startPoint.Y)))
+    {
+        int64_t x = p0.X + (p1.X - p0.X) * (transformed_startPoint.Y - p0.Y) / (p1.Y - p0.Y);
+
+        if (x > transformed_startPoint.X && x < transformed_endPoint.X)
+        {
+            return true;
+        }
+    }
+    return false;
+}
 
 bool LinePolygonsCrossings::lineSegmentCollidesWithBoundary()
 {
@@ -92,25 +177,31 @@ bool LinePolygonsCrossings::lineSegmentCollidesWithBoundary()
     transformed_startPoint = transformation_matrix.apply(startPoint);
     transformed_endPoint = transformation_matrix.apply(endPoint);
 
+    use_scanline_segments = findScanlineSegments();
+    if (use_scanline_segments)
+    {
+        for (const std::pair<unsigned int, unsigned int>& segment : scanline_segments)
+        {
+            ConstPolygonRef poly = boundary[segment.first];
+            const Point p0 = transformation_matrix.apply(poly[(segment.second + poly.size() - 1) % poly.size()]);
+            const Point p1 = transformation_matrix.apply(poly[segment.second]);
+            if (segmentCollidesWithScanline(p0, p1))
+            {
+                return true;
+            }
+        }
+        return false;
+    }
+
     for(ConstPolygonRef poly : boundary)
     {
         Point p0 = transformation_matrix.apply(poly.back());
         for(Point p1_ : poly)
         {
             Point p1 = transformation_matrix.apply(p1_);
-            // when the boundary just touches the line don't disambiguate between the boundary moving on to actually cross the line
-            // and the boundary bouncing back, resulting in not a real collision - to keep the algorithm simple.
-            //
-            // disregard overlapping line segments; probably the next or previous line segment is not overlapping, but will give a collision
-            // when the boundary line segment fully overlaps with the line segment this edge case is not viewed as a collision
-            if (p1.Y != p0.Y && ((p0.Y >= transformed_startPoint.Y && p1.Y <= transformed_startPoint.Y) || (p1.Y >= transformed_startPoint.Y && p0.Y <= transformed_startPoint.Y)))
+            if (segmentCollidesWithScanline(p0, p1))
             {
-                int64_t x = p0.X + (p1.X - p0.X) * (transformed_startPoint.Y - p0.Y) / (p1.Y - p0.Y);
-
-                if (x > transformed_startPoint.X && x < transformed_endPoint.X)
-                {
-                    return true;
-                }
+                return true;
             }
             p0 = p1;
         }
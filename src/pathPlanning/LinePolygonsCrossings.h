@@ -78,6 +78,9 @@ private:
     
     const Polygons& boundary; //!< The boundary not to cross during combing.
     LocToLineGrid& loc_to_line_grid; //!< Mapping from locations to line segments of \ref LinePolygonsCrossings::boundary
+    const std::vector<unsigned int>* grid_poly_indices; //!< For each polygon in \ref LinePolygonsCrossings::boundary its index in the polygons of the grid, or nullptr if the grid is over the boundary itself
+    std::vector<std::pair<unsigned int, unsigned int>> scanline_segments; //!< The line segments of the boundary near the scanline, as the index of the polygon and the index of the end point of the segment, see \ref LinePolygonsCrossings::findScanlineSegments
+    bool use_scanline_segments; //!< Whether only the \ref LinePolygonsCrossings::scanline_segments need to be checked for crossings, rather than the whole boundary
     Point startPoint; //!< The start point of the scanline.
     Point endPoint; //!< The end point of the scanline.
     
@@ -95,6 +98,40 @@ private:
      * \return Whether the line segment from LinePolygonsCrossings::startPoint to LinePolygonsCrossings::endPoint collides with the boundary
      */
     bool lineSegmentCollidesWithBoundary();
+
+    /*!
+     * Collect the line segments of the boundary in the cells of the grid
+     * through which the scanline passes into
+     * LinePolygonsCrossings::scanline_segments, sorted by polygon and point.
+     *
+     * Only those line segments can cross the scanline, so that the crossings
+     * don't have to be computed for all segments of the boundary.
+     *
+     * \return Whether the grid could be used, i.e. whether it is over the
+     * boundary itself or LinePolygonsCrossings::grid_poly_indices is given.
+     */
+    bool findScanlineSegments();
+
+    /*!
+     * Update the crossings of a polygon with the scanline with the crossing of
+     * a single line segment of that polygon, if it crosses.
+     *
+     * \param p0 The transformed start of the line segment.
+     * \param p1 The transformed end of the line segment.
+     * \param point_idx The index of the end of the line segment in its
+     * polygon.
+     * \param[in,out] poly_crossings The crossings of the polygon so far.
+     */
+    void addScanlineCrossing(const Point p0, const Point p1, const size_t point_idx, PolyCrossings& poly_crossings) const;
+
+    /*!
+     * Whether a line segment crosses the scanline strictly between the
+     * transformed start and end point.
+     *
+     * \param p0 The transformed start of the line segment.
+     * \param p1 The transformed end of the line segment.
+     */
+    bool segmentCollidesWithScanline(const Point p0, const Point p1) const;
     
     /*!
      * Calculate Comb::crossings, Comb::min_crossing_idx and Comb::max_crossing_idx.
@@ -160,10 +197,13 @@ private:
      * \param start the starting point
      * \param end the end point
      * \param dist_to_move_boundary_point_outside Distance used to move a point from a boundary so that it doesn't intersect with it anymore. (Precision issue)
+     * \param grid_poly_indices For each polygon in \p boundary its index in the polygons of \p loc_to_line_grid, or nullptr if the grid is over \p boundary itself
      */
-    LinePolygonsCrossings(const Polygons& boundary, LocToLineGrid& loc_to_line_grid, Point& start, Point& end, int64_t dist_to_move_boundary_point_outside)
+    LinePolygonsCrossings(const Polygons& boundary, LocToLineGrid& loc_to_line_grid, Point& start, Point& end, int64_t dist_to_move_boundary_point_outside, const std::vector<unsigned int>* grid_poly_indices)
     : boundary(boundary)
     , loc_to_line_grid(loc_to_line_grid)
+    , grid_poly_indices(grid_poly_indices)
+    , use_scanline_segments(false)
     , startPoint(start)
     , endPoint(end)
     , dist_to_move_boundary_point_outside(dist_to_move_boundary_point_outside)
@@ -180,11 +220,15 @@ public:
      * \param endPoint Where to end the combing move.
      * \param combPath Output parameter: the combing path generated.
      * \param fail_on_unavoidable_obstacles When moving over other parts is inavoidable, stop calculation early and return false.
+     * \param grid_poly_indices When \p boundary is a part of the polygons of
+     * \p loc_to_line_grid (see PartsView), the index in the polygons of the
+     * grid of each polygon in \p boundary. Otherwise nullptr, in which case
+     * the grid is only used to find crossings if it is over \p boundary itself.
      * \return Whether combing succeeded, i.e. we didn't cross any gaps/other parts
      */
-    static bool comb(const Polygons& boundary, LocToLineGrid& loc_to_line_grid, Point startPoint, Point endPoint, CombPath& combPath, int64_t dist_to_move_boundary_point_outside, int64_t max_comb_distance_ignored, bool fail_on_unavoidable_obstacles)
+    static bool comb(const Polygons& boundary, LocToLineGrid& loc_to_line_grid, Point startPoint, Point endPoint, CombPath& combPath, int64_t dist_to_move_boundary_point_outside, int64_t max_comb_distance_ignored, bool fail_on_unavoidable_obstacles, const std::vector<unsigned int>* grid_poly_indices = nullptr)
     {
-        LinePolygonsCrossings linePolygonsCrossings(boundary, loc_to_line_grid, startPoint, endPoint, dist_to_move_boundary_point_outside);
+        LinePolygonsCrossings linePolygonsCrossings(boundary, loc_to_line_grid, startPoint, endPoint, dist_to_move_boundary_point_outside, grid_poly_indices);
         return linePolygonsCrossings.generateCombingPath(combPath, max_comb_distance_ignored, fail_on_unavoidable_obstacles);
     };
 };
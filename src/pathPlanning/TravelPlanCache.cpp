@@ -0,0 +1,93 @@
+//Copyright (c) 2018 Ultimaker B.V.
+//CuraEngine is released under the terms of the AGPLv3 or higher.
+
+#include "TravelPlanCache.h"
+
+namespace cura
+{
+
+TravelPlanCache::TravelPlanCache(const size_t max_orders, const size_t max_comb_paths)
+: max_orders(max_orders)
+, max_comb_paths(max_comb_paths)
+{
+}
+
+template<typename T>
+const T* TravelPlanCache::Generations<T>::find(const GeometryHash& key, const size_t max_entries)
+{
+    typename std::unordered_map<GeometryHash, T, GeometryHash::Hasher>::iterator it = current.find(key);
+    if (it != current.end())
+    {
+        return &it->second;
+    }
+    it = previous.find(key);
+    if (it == previous.end())
+    {
+        return nullptr;
+    }
+    // still in use, so keep it when the previous generation is dropped
+    T value = std::move(it->second);
+    previous.erase(it);
+    insert(key, std::move(value), max_entries);
+    return &current.find(key)->second;
+}
+
+template<typename T>
+void TravelPlanCache::Generations<T>::insert(const GeometryHash& key, T&& value, const size_t max_entries)
+{
+    if (current.size() >= max_entries)
+    {
+        previous = std::move(current);
+        current.clear();
+    }
+    current[key] = std::move(value);
+}
+
+bool TravelPlanCache::getOrder(const GeometryHash& key, std::vector<int>& poly_start, std::vector<int>& poly_order)
+{
+    std::lock_guard<std::mutex> lock(mutex);
+    const Order* order = orders.find(key, max_orders);
+    if (order == nullptr)
+    {
+        return false;
+    }
+    poly_start = order->poly_start;
+    poly_order = order->poly_order;
+    return true;
+}
+
+void TravelPlanCache::setOrder(const GeometryHash& key, const std::vector<int>& poly_start, const std::vector<int>& poly_order)
+{
+    std::lock_guard<std::mutex> lock(mutex);
+    orders.insert(key, Order{ poly_start, poly_order }, max_orders);
+}
+
+bool TravelPlanCache::getCombPath(const GeometryHash& key, CombPath& path, bool& success)
+{
+    std::lock_guard<std::mutex> lock(mutex);
+    const StoredCombPath* stored = comb_paths.find(key, max_comb_paths);
+    if (stored == nullptr)
+    {
+        return false;
+    }
+    path = stored->path;
+    success = stored->success;
+    return true;
+}
+
+void TravelPlanCache::setCombPath(const GeometryHash& key, const CombPath& path, const bool success)
+{
+    std::lock_guard<std::mutex> lock(mutex);
+    comb_paths.insert(key, StoredCombPath{ path, success }, max_comb_paths);
+}
+
+void TravelPlanCache::clear()
+{
+    std::lock_guard<std::mutex> lock(mutex);
+    orders.current.clear();
+    orders.previous.clear();
+    comb_paths.current.clear();
+    comb_paths.previous.clear();
+}
+
+} //namespace cura
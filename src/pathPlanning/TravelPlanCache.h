@@ -0,0 +1,134 @@
+//Copyright (c) 2018 Ultimaker B.V.
+//CuraEngine is released under the terms of the AGPLv3 or higher.
+
+#ifndef PATH_PLANNING_TRAVEL_PLAN_CACHE_H
+#define PATH_PLANNING_TRAVEL_PLAN_CACHE_H
+
+#include <mutex>
+#include <unordered_map>
+#include <vector>
+
+#include "CombPath.h"
+#include "../utils/GeometryHash.h"
+
+namespace cura
+{
+
+/*!
+ * \brief Orders and combing paths found for earlier layers, to be reused by
+ * layers with the same geometry.
+ *
+ * Parts which are extruded straight up have the same walls, and often the same
+ * infill lines, on many consecutive layers. The order in which an order
+ * optimizer prints some polygons only depends on the polygons, the start
+ * point, the seam settings and the combing boundary, and a combing path within
+ * a part only depends on the comb boundaries and its end points. These are
+ * hashed with a GeometryHash and the result is stored under that hash, so that
+ * a later layer with the same input finds it instead of computing it again.
+ *
+ * The cache is shared by all layers and may be used from multiple threads at
+ * once. Its size is bounded by keeping two generations of entries: when the
+ * current generation is full, the previous generation is dropped. Entries which
+ * are found in the previous generation are moved to the current one, so those
+ * which are still being used survive.
+ */
+class TravelPlanCache
+{
+public:
+    /*!
+     * \param max_orders The number of orders in each generation.
+     * \param max_comb_paths The number of combing paths in each generation.
+     */
+    TravelPlanCache(const size_t max_orders = 4096, const size_t max_comb_paths = 65536);
+
+    TravelPlanCache(const TravelPlanCache&) = delete;
+    TravelPlanCache& operator=(const TravelPlanCache&) = delete;
+
+    /*!
+     * Look up the order found before for the same input.
+     *
+     * \param key The hash of the input of the order optimizer.
+     * \param[out] poly_start The start vertex of each polygon, if found.
+     * \param[out] poly_order The order of the polygons, if found.
+     * \return Whether an order has been stored for this input.
+     */
+    bool getOrder(const GeometryHash& key, std::vector<int>& poly_start, std::vector<int>& poly_order);
+
+    /*!
+     * Store the order found for some input.
+     *
+     * \param key The hash of the input of the order optimizer.
+     * \param poly_start The start vertex of each polygon.
+     * \param poly_order The order of the polygons.
+     */
+    void setOrder(const GeometryHash& key, const std::vector<int>& poly_start, const std::vector<int>& poly_order);
+
+    /*!
+     * Look up the combing path found before for the same travel move.
+     *
+     * \param key The hash of the travel move and the comb boundaries.
+     * \param[out] path The combing path, if found.
+     * \param[out] success Whether the combing succeeded, if found.
+     * \return Whether a combing path has been stored for this travel move.
+     */
+    bool getCombPath(const GeometryHash& key, CombPath& path, bool& success);
+
+    /*!
+     * Store the combing path found for a travel move.
+     *
+     * \param key The hash of the travel move and the comb boundaries.
+     * \param path The combing path.
+     * \param success Whether the combing succeeded.
+     */
+    void setCombPath(const GeometryHash& key, const CombPath& path, const bool success);
+
+    /*!
+     * Remove all stored orders and combing paths.
+     */
+    void clear();
+
+private:
+    struct Order
+    {
+        std::vector<int> poly_start;
+        std::vector<int> poly_order;
+    };
+
+    struct StoredCombPath
+    {
+        CombPath path;
+        bool success;
+    };
+
+    /*!
+     * Two generations of entries, see TravelPlanCache.
+     */
+    template<typename T>
+    struct Generations
+    {
+        std::unordered_map<GeometryHash, T, GeometryHash::Hasher> current;
+        std::unordered_map<GeometryHash, T, GeometryHash::Hasher> previous;
+
+        /*!
+         * Find an entry, moving it to the current generation if it was found
+         * in the previous one.
+         * \return The entry, or nullptr if there is none.
+         */
+        const T* find(const GeometryHash& key, const size_t max_entries);
+
+        /*!
+         * Store an entry in the current generation.
+         */
+        void insert(const GeometryHash& key, T&& value, const size_t max_entries);
+    };
+
+    const size_t max_orders; //!< The number of orders in each generation
+    const size_t max_comb_paths; //!< The number of combing paths in each generation
+    std::mutex mutex; //!< Guards the stored entries, since layers are planned in parallel
+    Generations<Order> orders; //!< The stored orders
+    Generations<StoredCombPath> comb_paths; //!< The stored combing paths
+};
+
+} //namespace cura
+
+#endif //PATH_PLANNING_TRAVEL_PLAN_CACHE_H
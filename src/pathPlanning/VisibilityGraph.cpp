@@ -0,0 +1,267 @@
+//Copyright (c) 2018 Ultimaker B.V.
+//CuraEngine is released under the terms of the AGPLv3 or higher.
+
+#include <algorithm> //For sort and binary_search.
+#include <functional> //For greater.
+#include <limits>
+#include <queue>
+#include <tuple>
+
+#include "VisibilityGraph.h"
+#include "../utils/linearAlg2D.h"
+
+namespace cura
+{
+
+VisibilityGraph::VisibilityGraph(const Polygons& boundary, const std::vector<unsigned int>& part_poly_indices, const LocToLineGrid& loc_to_line, const coord_t dist_to_move_boundary_point_outside)
+: boundary(boundary)
+, part_poly_indices(part_poly_indices)
+, loc_to_line(loc_to_line)
+, dist_to_move_boundary_point_outside(dist_to_move_boundary_point_outside)
+{
+    std::sort(this->part_poly_indices.begin(), this->part_poly_indices.end());
+}
+
+size_t VisibilityGraph::nodeCount() const
+{
+    return nodes.size();
+}
+
+bool VisibilityGraph::isPartPolygon(const unsigned int poly_idx) const
+{
+    return std::binary_search(part_poly_indices.begin(), part_poly_indices.end(), poly_idx);
+}
+
+std::pair<unsigned int, unsigned int> VisibilityGraph::getPolygonNodes(const unsigned int poly_idx)
+{
+    const std::unordered_map<unsigned int, std::pair<unsigned int, unsigned int>>::const_iterator found = polygon_nodes.find(poly_idx);
+    if (found != polygon_nodes.end())
+    {
+        return found->second;
+    }
+
+    const unsigned int first_node_idx = nodes.size();
+    ConstPolygonRef poly = boundary[poly_idx];
+    if (poly.size() >= 3)
+    {
+        for (unsigned int point_idx = 0; point_idx < poly.size(); point_idx++)
+        {
+            const Point& prev = poly[(point_idx + poly.size() - 1) % poly.size()];
+            const Point& here = poly[point_idx];
+            const Point& next = poly[(point_idx + 1) % poly.size()];
+            // the inside of a part is to the left of its polygons, so a right turn is a concave corner
+            const Point in = here - prev;
+            const Point out = next - here;
+            if (in.X * out.Y - in.Y * out.X < 0)
+            {
+                nodes.push_back(Node{PolygonUtils::getBoundaryPointWithOffset(poly, point_idx, dist_to_move_boundary_point_outside), here, prev - here, next - here});
+            }
+        }
+    }
+    const std::pair<unsigned int, unsigned int> result(first_node_idx, nodes.size());
+    polygon_nodes.emplace(poly_idx, result);
+    return result;
+}
+
+void VisibilityGraph::findCrossedPolygons(const Point from, const Point to, std::vector<unsigned int>& result) const
+{
+    const Point diff = to - from;
+    if (vSize2(diff) < 2)
+    { // transformation matrix would fail
+        return;
+    }
+    const PointMatrix transformation_matrix(diff);
+    const Point transformed_from = transformation_matrix.apply(from);
+    const Point transformed_to = transformation_matrix.apply(to);
+    const std::function<bool (const PolygonsPointIndex&)> process_elem_func =
+        [this, &transformation_matrix, transformed_from, transformed_to, &result](const PolygonsPointIndex& line_start)
+        {
+            const unsigned int poly_idx = line_start.poly_idx;
+            if (line_start.polygons != &boundary || !isPartPolygon(poly_idx) || std::find(result.begin(), result.end(), poly_idx) != result.end())
+            {
+                return true;
+            }
+            const Point p0 = transformation_matrix.apply(line_start.p());
+            const Point p1 = transformation_matrix.apply(line_start.next().p());
+            if (LinearAlg2D::lineSegmentsCollide(transformed_from, transformed_to, p0, p1))
+            {
+                result.push_back(poly_idx);
+            }
+            return true;
+        };
+    loc_to_line.processLine(std::make_pair(from, to), process_elem_func);
+}
+
+int VisibilityGraph::findObstacle(const Point from, const Point to) const
+{
+    PolygonsPointIndex collision;
+    if (!PolygonUtils::polygonCollidesWithLineSegment(from, to, loc_to_line, &collision))
+    {
+        return -1;
+    }
+    return collision.poly_idx;
+}
+
+int VisibilityGraph::findObstacle(const unsigned int node_a, const unsigned int node_b)
+{
+    const uint64_t key = (static_cast<uint64_t>(std::min(node_a, node_b)) << 32) | std::max(node_a, node_b);
+    const std::unordered_map<uint64_t, int>::const_iterator found = node_obstacles.find(key);
+    if (found != node_obstacles.end())
+    {
+        return found->second;
+    }
+    const int result = findObstacle(nodes[node_a].location, nodes[node_b].location);
+    node_obstacles.emplace(key, result);
+    return result;
+}
+
+bool VisibilityGraph::isTangent(const Node& node, const Point direction) const
+{
+    // the line only enters the boundary at the corner if the neighbouring vertices are on either side of it
+    const coord_t prev_side = direction.X * node.to_prev.Y - direction.Y * node.to_prev.X;
+    const coord_t next_side = direction.X * node.to_next.Y - direction.Y * node.to_next.X;
+    return (prev_side >= 0 && next_side >= 0) || (prev_side <= 0 && next_side <= 0);
+}
+
+bool VisibilityGraph::findPath(const Point start, const Point end, CombPath& path, const coord_t max_length)
+{
+    if (vSize(end - start) >= max_length)
+    {
+        return false;
+    }
+    if (findObstacle(start, end) < 0)
+    {
+        path.push_back(start);
+        path.push_back(end);
+        return true;
+    }
+
+    std::vector<unsigned int> obstacles;
+    findCrossedPolygons(start, end, obstacles);
+    CombPath best_path;
+    coord_t best_length = max_length;
+    while (!obstacles.empty())
+    {
+        std::vector<unsigned int> blocking_polygons;
+        CombPath obstacles_path;
+        if (searchPath(start, end, obstacles, best_length, blocking_polygons, obstacles_path))
+        {
+            // with more obstacles the search has more corners to bend at, so a later path is only found if it is shorter
+            best_path = obstacles_path;
+            best_length = 0;
+            for (unsigned int point_idx = 1; point_idx < best_path.size(); point_idx++)
+            {
+                best_length += vSize(best_path[point_idx] - best_path[point_idx - 1]);
+            }
+        }
+        // some lines were blocked by polygons whose corners weren't used yet, which might give a shorter path
+        const size_t obstacle_count = obstacles.size();
+        for (const unsigned int poly_idx : blocking_polygons)
+        {
+            if (isPartPolygon(poly_idx) && std::find(obstacles.begin(), obstacles.end(), poly_idx) == obstacles.end())
+            {
+                obstacles.push_back(poly_idx);
+            }
+        }
+        if (obstacles.size() == obstacle_count || obstacles.size() > max_obstacle_count)
+        {
+            break;
+        }
+    }
+    if (best_path.empty())
+    {
+        return false;
+    }
+    path.insert(path.end(), best_path.begin(), best_path.end());
+    return true;
+}
+
+bool VisibilityGraph::searchPath(const Point start, const Point end, const std::vector<unsigned int>& obstacles, const coord_t max_length, std::vector<unsigned int>& blocking_polygons, CombPath& path)
+{
+    // the search works on the nodes of the obstacles, followed by the start and the end point
+    std::vector<unsigned int> search_nodes;
+    for (const unsigned int poly_idx : obstacles)
+    {
+        const std::pair<unsigned int, unsigned int> poly_nodes = getPolygonNodes(poly_idx);
+        for (unsigned int node_idx = poly_nodes.first; node_idx < poly_nodes.second; node_idx++)
+        {
+            search_nodes.push_back(node_idx);
+        }
+    }
+    const unsigned int start_idx = search_nodes.size();
+    const unsigned int end_idx = search_nodes.size() + 1;
+    const std::function<Point (unsigned int)> location =
+        [&](unsigned int search_idx)
+        {
+            return (search_idx == start_idx) ? start : ((search_idx == end_idx) ? end : nodes[search_nodes[search_idx]].location);
+        };
+
+    // Whether the lines are clear is only checked once they are taken from the queue, since most lines never are.
+    // The first line to reach a node that turns out to be clear is still on the shortest path to that node.
+    std::vector<unsigned int> previous(search_nodes.size() + 2, start_idx); // the node before each node on the shortest path
+    std::vector<bool> done(search_nodes.size() + 2, false);
+    typedef std::tuple<coord_t, coord_t, unsigned int, unsigned int> QueueItem; // the estimated length of a path via a line, the length of the path up to the end of the line, and the end and start of the line
+    std::priority_queue<QueueItem, std::vector<QueueItem>, std::greater<QueueItem>> queue;
+    const std::function<void (unsigned int, coord_t)> add_lines_from =
+        [&](unsigned int from_idx, coord_t distance)
+        {
+            const Point from = location(from_idx);
+            for (unsigned int to_idx = 0; to_idx < start_idx; to_idx++)
+            {
+                if (done[to_idx])
+                {
+                    continue;
+                }
+                // a shortest path only follows lines that touch the boundary at both of their ends
+                const Node& to_node = nodes[search_nodes[to_idx]];
+                const Point direction = (from_idx == start_idx) ? to_node.corner - start : to_node.corner - nodes[search_nodes[from_idx]].corner;
+                if (isTangent(to_node, direction) && (from_idx == start_idx || isTangent(nodes[search_nodes[from_idx]], direction)))
+                {
+                    const coord_t to_distance = distance + vSize(to_node.location - from);
+                    queue.emplace(to_distance + vSize(end - to_node.location), to_distance, to_idx, from_idx); // the straight distance to the end never overestimates
+                }
+            }
+            if (from_idx != start_idx && isTangent(nodes[search_nodes[from_idx]], end - nodes[search_nodes[from_idx]].corner))
+            {
+                const coord_t to_distance = distance + vSize(end - from);
+                queue.emplace(to_distance, to_distance, end_idx, from_idx);
+            }
+        };
+
+    done[start_idx] = true;
+    add_lines_from(start_idx, 0);
+    while (!queue.empty() && std::get<0>(queue.top()) < max_length)
+    {
+        const coord_t distance = std::get<1>(queue.top());
+        const unsigned int to_idx = std::get<2>(queue.top());
+        const unsigned int from_idx = std::get<3>(queue.top());
+        queue.pop();
+        if (done[to_idx])
+        {
+            continue;
+        }
+        const int obstacle = (from_idx == start_idx || to_idx == end_idx) ? findObstacle(location(from_idx), location(to_idx)) : findObstacle(search_nodes[from_idx], search_nodes[to_idx]);
+        if (obstacle >= 0)
+        {
+            blocking_polygons.push_back(obstacle);
+            continue;
+        }
+        done[to_idx] = true;
+        previous[to_idx] = from_idx;
+        if (to_idx == end_idx)
+        {
+            std::vector<Point> reversed_path;
+            for (unsigned int path_idx = end_idx; path_idx != start_idx; path_idx = previous[path_idx])
+            {
+                reversed_path.push_back(location(path_idx));
+            }
+            path.push_back(start);
+            path.insert(path.end(), reversed_path.rbegin(), reversed_path.rend());
+            return true;
+        }
+        add_lines_from(to_idx, distance);
+    }
+    return false;
+}
+
+} //namespace cura
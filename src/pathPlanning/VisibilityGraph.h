@@ -0,0 +1,157 @@
+//Copyright (c) 2018 Ultimaker B.V.
+//CuraEngine is released under the terms of the AGPLv3 or higher.
+
+#ifndef PATH_PLANNING_VISIBILITY_GRAPH_H
+#define PATH_PLANNING_VISIBILITY_GRAPH_H
+
+#include <limits>
+#include <unordered_map>
+#include <utility> //For pair.
+#include <vector>
+
+#include "CombPath.h"
+#include "../utils/polygon.h"
+#include "../utils/polygonUtils.h"
+
+namespace cura
+{
+
+/*!
+ * \brief Visibility graph of a single part of a comb boundary, to find the
+ * shortest travel path between two points within that part.
+ *
+ * The shortest path between two points inside a polygonal area only bends at
+ * concave corners of that area. The nodes of the graph are these corners,
+ * moved slightly off the boundary. Two nodes are connected when the straight
+ * line between them doesn't collide with the boundary.
+ *
+ * A part can have thousands of corners, so a path search doesn't use all of
+ * them. It starts with the corners of the polygons crossed by the straight
+ * line from the start to the end, and only adds the corners of polygons that
+ * turn out to block the way. Only lines that are tangent to the boundary at
+ * both of their corners are considered, since a shortest path never bends
+ * anywhere else.
+ *
+ * The corners of a polygon are computed when they are first needed, and
+ * whether two corners see each other is kept once it has been checked. One
+ * graph is meant to be reused for all travel moves within the part in a layer.
+ */
+class VisibilityGraph
+{
+public:
+    /*!
+     * \brief Create the visibility graph of a part.
+     *
+     * \param boundary The polygons of the comb boundary.
+     * \param part_poly_indices The indices in \p boundary of the polygons of
+     * the part within which to find paths.
+     * \param loc_to_line A grid mapping locations to the line segments of
+     * \p boundary.
+     * \param dist_to_move_boundary_point_outside Distance by which to move the
+     * corners of the part off the boundary, negative to move them inside.
+     * (Precision issue)
+     */
+    VisibilityGraph(const Polygons& boundary, const std::vector<unsigned int>& part_poly_indices, const LocToLineGrid& loc_to_line, const coord_t dist_to_move_boundary_point_outside);
+
+    /*!
+     * \brief Find the shortest path from \p start to \p end within the part
+     * with an A* search.
+     *
+     * \param start Where to start the path. Should be inside the part.
+     * \param end Where to end the path. Should be inside the part.
+     * \param[out] path The path, including \p start and \p end.
+     * \param max_length Only find a path shorter than this, e.g. because a
+     * path of this length is known already.
+     * \return Whether a path has been found. If not, \p path is not changed.
+     */
+    bool findPath(const Point start, const Point end, CombPath& path, const coord_t max_length = std::numeric_limits<coord_t>::max());
+
+    /*!
+     * \brief Get the number of nodes of the graph that have been created so
+     * far, excluding the start and end points of path searches.
+     */
+    size_t nodeCount() const;
+
+private:
+    /*!
+     * \brief A concave corner of the part.
+     */
+    struct Node
+    {
+        Point location; //!< The corner, moved off the boundary.
+        Point corner; //!< The corner itself.
+        Point to_prev; //!< The direction from the corner to the previous vertex of its polygon.
+        Point to_next; //!< The direction from the corner to the next vertex of its polygon.
+    };
+
+    /*!
+     * \brief The maximum number of polygons whose corners are used in a
+     * single path search. If more polygons are in the way, no path is found.
+     */
+    static constexpr unsigned int max_obstacle_count = 16;
+
+    const Polygons& boundary; //!< The polygons of the comb boundary.
+    std::vector<unsigned int> part_poly_indices; //!< The sorted indices in VisibilityGraph::boundary of the polygons of the part.
+    const LocToLineGrid& loc_to_line; //!< Grid over the comb boundary, to check whether nodes see each other.
+    const coord_t dist_to_move_boundary_point_outside; //!< Distance by which to move the corners off the boundary.
+    std::vector<Node> nodes; //!< The concave corners of the polygons that have been used so far.
+    std::unordered_map<unsigned int, std::pair<unsigned int, unsigned int>> polygon_nodes; //!< For each polygon that has been used so far, the range of its nodes in VisibilityGraph::nodes.
+    std::unordered_map<uint64_t, int> node_obstacles; //!< For each pair of nodes that has been checked, the polygon between them, or -1 if they see each other.
+
+    /*!
+     * \brief Whether a polygon of the boundary belongs to the part.
+     */
+    bool isPartPolygon(const unsigned int poly_idx) const;
+
+    /*!
+     * \brief Get the range of the nodes of a polygon in VisibilityGraph::nodes,
+     * creating them when they haven't been created yet.
+     */
+    std::pair<unsigned int, unsigned int> getPolygonNodes(const unsigned int poly_idx);
+
+    /*!
+     * \brief Find the polygons of the part that a line crosses.
+     *
+     * \param from The start of the line.
+     * \param to The end of the line.
+     * \param[out] result Where to add the polygons, each only once.
+     */
+    void findCrossedPolygons(const Point from, const Point to, std::vector<unsigned int>& result) const;
+
+    /*!
+     * \brief Find a polygon of the boundary between two points.
+     *
+     * \return The index of a polygon that collides with the straight line
+     * between the points, or -1 if they see each other.
+     */
+    int findObstacle(const Point from, const Point to) const;
+
+    /*!
+     * \brief Find a polygon of the boundary between two nodes, remembering the
+     * result for later searches.
+     */
+    int findObstacle(const unsigned int node_a, const unsigned int node_b);
+
+    /*!
+     * \brief Whether a line in the given direction through the corner of a
+     * node only touches the boundary at that corner, rather than entering it.
+     */
+    bool isTangent(const Node& node, const Point direction) const;
+
+    /*!
+     * \brief Search the shortest path from \p start to \p end, bending only at
+     * the nodes of the given polygons.
+     *
+     * \param obstacles The polygons whose nodes the path may bend at.
+     * \param max_length Only find a path shorter than this.
+     * \param[out] blocking_polygons Where to add the polygons that blocked the
+     * lines that were checked.
+     * \param[out] path The path, if it has been found.
+     * \return Whether a path has been found.
+     */
+    bool searchPath(const Point start, const Point end, const std::vector<unsigned int>& obstacles, const coord_t max_length, std::vector<unsigned int>& blocking_polygons, CombPath& path);
+};
+
+} //namespace cura
+
+#endif //PATH_PLANNING_VISIBILITY_GRAPH_H
@@ -580,6 +580,11 @@ bool Settings::has(const std::string& key) const
     return settings.find(key) != settings.end();
 }
 
+bool Settings::hasInherited(const std::string& key) const
+{
+    return has(key) || (parent && parent->hasInherited(key));
+}
+
 void Settings::setParent(Settings* new_parent)
 {
     parent = new_parent;
@@ -71,6 +71,21 @@ public:
      */
     template<typename A> A get(const std::string& key) const;
 
+    /*!
+     * \brief Get the value of a setting, or a default value if neither this
+     * container nor any of its parents has a value for it.
+     *
+     * This is for settings that the front-ends don't know about, so they may
+     * not send a value for them.
+     * \param key The key of the setting to get.
+     * \param default_value The value to return if the setting is missing.
+     * \return The setting's value, cast to the desired type.
+     */
+    template<typename A> A get(const std::string& key, const A& default_value) const
+    {
+        return hasInherited(key) ? get<A>(key) : default_value;
+    }
+
     /*!
      * \brief Get a string containing all settings in this container.
      *
@@ -122,6 +137,14 @@ private:
      * \return The setting's value.
      */
     std::string getWithoutLimiting(const std::string& key) const;
+
+    /*!
+     * \brief Indicate whether this settings instance or any of its parents
+     * has an entry for the specified setting.
+     * \param key The setting to check.
+     * \return Whether the setting has a value somewhere in the inheritance.
+     */
+    bool hasInherited(const std::string& key) const;
 };
 
 } //namespace cura
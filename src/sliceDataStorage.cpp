@@ -49,6 +49,15 @@ SliceLayer::~SliceLayer()
 {
 }
 
+void SliceLayer::releaseData()
+{
+    // assign empty containers rather than clearing, so that the memory is actually freed
+    parts = std::vector<SliceLayerPart>();
+    openPolyLines = Polygons();
+    innermost_walls_cache = std::map<size_t, Polygons>();
+    top_surface.areas = Polygons();
+}
+
 Polygons SliceLayer::getOutlines(bool external_polys_only) const
 {
     Polygons ret;
@@ -487,6 +496,30 @@ std::vector<bool> SliceDataStorage::getExtrudersUsed() const
     return ret;
 }
 
+void SliceDataStorage::releaseLayer(const LayerIndex layer_nr)
+{
+    if (layer_nr < 0)
+    {
+        return;
+    }
+    const size_t layer_idx = layer_nr;
+    for (SliceMeshStorage& mesh : meshes)
+    {
+        if (layer_idx < mesh.layers.size())
+        {
+            mesh.layers[layer_idx].releaseData();
+        }
+    }
+    if (layer_idx < support.supportLayers.size())
+    {
+        support.supportLayers[layer_idx].releaseData();
+    }
+    if (layer_idx < oozeShield.size())
+    {
+        oozeShield[layer_idx] = Polygons();
+    }
+}
+
 std::vector<bool> SliceDataStorage::getExtrudersUsed(LayerIndex layer_nr) const
 {
     std::vector<bool> ret;
@@ -710,4 +743,14 @@ void SupportLayer::excludeAreasFromSupportInfillAreas(const Polygons& exclude_po
     }
 }
 
+void SupportLayer::releaseData()
+{
+    support_infill_parts = std::vector<SupportInfillPart>();
+    support_bottom = Polygons();
+    support_roof = Polygons();
+    support_mesh_drop_down = Polygons();
+    support_mesh = Polygons();
+    anti_overhang = Polygons();
+}
+
 } // namespace cura
@@ -182,6 +182,14 @@ public:
      */
     Polygons& getInnermostWalls(const size_t max_inset, const SliceMeshStorage& mesh) const;
 
+    /*!
+     * Free the parts of this layer and everything computed from them, once no
+     * g-code is planned with them any more.
+     *
+     * The height and the thickness of the layer are kept.
+     */
+    void releaseData();
+
     ~SliceLayer();
 };
 
@@ -207,6 +215,12 @@ public:
      * \param exclude_polygons_boundary_box The boundary box for the polygons to exclude
      */
     void excludeAreasFromSupportInfillAreas(const Polygons& exclude_polygons, const AABB& exclude_polygons_boundary_box);
+
+    /*!
+     * Free all support areas of this layer, once no g-code is planned with
+     * them any more.
+     */
+    void releaseData();
 };
 
 class SupportStorage
@@ -350,6 +364,14 @@ public:
      */
     std::vector<bool> getExtrudersUsed(LayerIndex layer_nr) const;
 
+    /*!
+     * Free the data of a layer of all meshes and of the support and the ooze
+     * shield, once no g-code is planned with it any more.
+     *
+     * \param layer_nr The layer of which to free the data.
+     */
+    void releaseLayer(const LayerIndex layer_nr);
+
     /*!
      * Gets whether prime blob is enabled for the given extruder number.
      *
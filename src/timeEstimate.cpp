@@ -15,6 +15,7 @@ namespace cura
 {
 
 #define MINIMUM_PLANNER_SPEED 0.05 // mm/sec
+#define MM_PER_ARC_SEGMENT 1.0 // mm, the length of the segments arcs are divided into, as in Marlin
 
 void TimeEstimateCalculator::setFirmwareDefaults(const Settings& settings)
 {
@@ -39,6 +40,38 @@ void TimeEstimateCalculator::setPosition(Position newPos)
     currentPosition = newPos;
 }
 
+void TimeEstimateCalculator::planArc(Position newPos, const double center_offset_x, const double center_offset_y, const bool clockwise, Velocity feedrate, PrintFeatureType feature)
+{
+    const Position start = currentPosition;
+    const double center_x = start.axis[X_AXIS] + center_offset_x;
+    const double center_y = start.axis[Y_AXIS] + center_offset_y;
+    const double radius = sqrt(square(center_offset_x) + square(center_offset_y));
+    const double start_angle = atan2(-center_offset_y, -center_offset_x);
+    double angle = atan2(newPos[Y_AXIS] - center_y, newPos[X_AXIS] - center_x) - start_angle; //Counter-clockwise.
+    if (clockwise && angle >= 0)
+    {
+        angle -= 2 * M_PI;
+    }
+    else if (!clockwise && angle <= 0)
+    {
+        angle += 2 * M_PI;
+    }
+
+    const size_t segment_count = std::max(size_t(1), static_cast<size_t>(fabs(angle) * radius / MM_PER_ARC_SEGMENT));
+    for (size_t segment = 1; segment < segment_count; segment++)
+    {
+        const double ratio = static_cast<double>(segment) / segment_count;
+        const double segment_angle = start_angle + angle * ratio;
+        const Position segment_end(
+            center_x + radius * cos(segment_angle),
+            center_y + radius * sin(segment_angle),
+            start.axis[Z_AXIS] + (newPos[Z_AXIS] - start.axis[Z_AXIS]) * ratio,
+            start.axis[E_AXIS] + (newPos[E_AXIS] - start.axis[E_AXIS]) * ratio);
+        plan(segment_end, feedrate, feature);
+    }
+    plan(newPos, feedrate, feature);
+}
+
 void TimeEstimateCalculator::addTime(const Duration& time)
 {
     extra_time += time;
@@ -90,6 +90,25 @@ public:
     void setFirmwareDefaults(const Settings& settings);
     void setPosition(Position newPos);
     void plan(Position newPos, Velocity feedRate, PrintFeatureType feature);
+
+    /*!
+     * Plan a circular arc from the current position to \p newPos, as written
+     * with G2 or G3.
+     *
+     * Like the firmware, the arc is divided into segments of about a
+     * millimetre, which are planned as straight moves. The Z and E axes move
+     * linearly along the arc.
+     * \param newPos The end of the arc.
+     * \param center_offset_x The X coordinate of the center of the arc,
+     * relative to the current position.
+     * \param center_offset_y The Y coordinate of the center of the arc,
+     * relative to the current position.
+     * \param clockwise Whether the arc goes clockwise (G2) or
+     * counter-clockwise (G3) around the center.
+     * \param feedRate The speed along the arc.
+     * \param feature The feature the arc prints.
+     */
+    void planArc(Position newPos, const double center_offset_x, const double center_offset_y, const bool clockwise, Velocity feedRate, PrintFeatureType feature);
     void addTime(const Duration& time);
     void setAcceleration(const Acceleration& acc); //!< Set the default acceleration to \p acc
     void setMaxXyJerk(const Velocity& jerk); //!< Set the max xy jerk to \p jerk
@@ -0,0 +1,274 @@
+//Copyright (c) 2018 Ultimaker B.V.
+//CuraEngine is released under the terms of the AGPLv3 or higher.
+
+#include <algorithm> //For std::max.
+#if defined(__linux__)
+    #include <fcntl.h> //To advise the kernel that the file is written sequentially.
+#endif
+#ifdef GZIP
+    #include <zlib.h> //To compress the file.
+#endif
+
+#include "BackgroundWriteBuffer.h"
+#include "logoutput.h"
+
+namespace cura
+{
+
+constexpr size_t BackgroundWriteBuffer::default_buffer_size;
+
+/*!
+ * The state of the compression of a file.
+ */
+struct BackgroundWriteBuffer::Compressor
+{
+#ifdef GZIP
+    z_stream stream; //!< The state of zlib
+    std::vector<char> output; //!< The compressed data which is to be written to the file
+    bool initialized; //!< Whether zlib could set up the stream
+
+    Compressor()
+    : output(256 * 1024)
+    {
+        stream.zalloc = Z_NULL;
+        stream.zfree = Z_NULL;
+        stream.opaque = Z_NULL;
+        constexpr int gzip_window_bits = 15 + 16; //The largest window, with a gzip header and trailer instead of a zlib one.
+        constexpr int memory_level = 8; //The default.
+        initialized = deflateInit2(&stream, Z_DEFAULT_COMPRESSION, Z_DEFLATED, gzip_window_bits, memory_level, Z_DEFAULT_STRATEGY) == Z_OK;
+    }
+
+    ~Compressor()
+    {
+        if (initialized)
+        {
+            deflateEnd(&stream);
+        }
+    }
+#endif
+};
+
+BackgroundWriteBuffer::BackgroundWriteBuffer(const size_t buffer_size)
+: file(nullptr)
+, owns_file(false)
+, buffer_size(buffer_size)
+, writing_size(0)
+, stopping(false)
+, failed(false)
+, compressed(false)
+{
+}
+
+BackgroundWriteBuffer::~BackgroundWriteBuffer()
+{
+    close();
+}
+
+bool BackgroundWriteBuffer::open(const char* filename)
+{
+    close();
+    std::FILE* opened_file = std::fopen(filename, "wb");
+    if (!opened_file)
+    {
+        return false;
+    }
+    std::setvbuf(opened_file, nullptr, _IONBF, 0); //The buffers of this class are large enough already.
+#if defined(__linux__) && defined(POSIX_FADV_SEQUENTIAL)
+    posix_fadvise(fileno(opened_file), 0, 0, POSIX_FADV_SEQUENTIAL);
+#endif
+    open(opened_file);
+    owns_file = true;
+    return true;
+}
+
+void BackgroundWriteBuffer::open(std::FILE* file)
+{
+    close();
+    this->file = file;
+    owns_file = false;
+    failed = false;
+    collecting_buffer.resize(buffer_size);
+    setp(collecting_buffer.data(), collecting_buffer.data() + collecting_buffer.size());
+}
+
+bool BackgroundWriteBuffer::close()
+{
+    if (!file)
+    {
+        return true;
+    }
+    const bool success = sync() == 0;
+    {
+        std::lock_guard<std::mutex> lock(mutex);
+        stopping = true;
+    }
+    state_changed.notify_all();
+    if (writer.joinable())
+    {
+        writer.join();
+    }
+    stopping = false;
+    if (compressed && compressor && success) //Nothing is written if the file wasn't used, e.g. stdout before an output file is given.
+    {
+        failed = !writeToFile(nullptr, 0, CompressionFlush::FINISH);
+    }
+    compressor.reset();
+    if (owns_file)
+    {
+        std::fclose(file);
+    }
+    file = nullptr;
+    setp(nullptr, nullptr);
+    return success && !failed;
+}
+
+void BackgroundWriteBuffer::setBufferSize(const size_t buffer_size)
+{
+    this->buffer_size = std::max(size_t(1), buffer_size);
+}
+
+bool BackgroundWriteBuffer::canCompress()
+{
+#ifdef GZIP
+    return true;
+#else
+    return false;
+#endif
+}
+
+bool BackgroundWriteBuffer::setCompressed(const bool compress)
+{
+    compressed = compress && canCompress();
+    return compressed == compress;
+}
+
+BackgroundWriteBuffer::int_type BackgroundWriteBuffer::overflow(int_type ch)
+{
+    if (!file || !handOff())
+    {
+        return traits_type::eof();
+    }
+    if (!traits_type::eq_int_type(ch, traits_type::eof()))
+    {
+        *pptr() = traits_type::to_char_type(ch);
+        pbump(1);
+    }
+    return traits_type::not_eof(ch);
+}
+
+int BackgroundWriteBuffer::sync()
+{
+    if (!file)
+    {
+        return 0;
+    }
+    handOff();
+    std::unique_lock<std::mutex> lock(mutex);
+    waitUntilWritten(lock);
+    if (compressed && compressor && !failed && !writeToFile(nullptr, 0, CompressionFlush::SYNC)) //The writer thread is idle, so it's safe to write here. Nothing to flush if nothing was written yet.
+    {
+        failed = true;
+    }
+    if (std::fflush(file) != 0)
+    {
+        failed = true;
+    }
+    return failed ? -1 : 0;
+}
+
+bool BackgroundWriteBuffer::handOff()
+{
+    const size_t count = pptr() - pbase();
+    {
+        std::unique_lock<std::mutex> lock(mutex);
+        waitUntilWritten(lock);
+        if (failed)
+        {
+            return false;
+        }
+        if (count > 0)
+        {
+            std::swap(collecting_buffer, writing_buffer);
+            writing_size = count;
+            if (!writer.joinable())
+            {
+                writer = std::thread(&BackgroundWriteBuffer::writeBuffers, this);
+            }
+        }
+    }
+    state_changed.notify_all();
+    collecting_buffer.resize(buffer_size);
+    setp(collecting_buffer.data(), collecting_buffer.data() + collecting_buffer.size());
+    return true;
+}
+
+void BackgroundWriteBuffer::waitUntilWritten(std::unique_lock<std::mutex>& lock)
+{
+    state_changed.wait(lock, [this]() { return writing_size == 0; });
+}
+
+void BackgroundWriteBuffer::writeBuffers()
+{
+    std::unique_lock<std::mutex> lock(mutex);
+    while (true)
+    {
+        state_changed.wait(lock, [this]() { return writing_size > 0 || stopping; });
+        if (writing_size == 0)
+        {
+            return; //Stopped while idle.
+        }
+        const size_t count = writing_size;
+        lock.unlock(); //The writing buffer isn't touched by the stream until the writing size is reset.
+        const bool written = writeToFile(writing_buffer.data(), count, CompressionFlush::NONE);
+        lock.lock();
+        if (!written && !failed)
+        {
+            logError("Failed to write g-code to the output file.\n");
+            failed = true;
+        }
+        writing_size = 0;
+        state_changed.notify_all();
+    }
+}
+
+bool BackgroundWriteBuffer::writeToFile(const char* text, const size_t count, const CompressionFlush flush)
+{
+    if (!compressed)
+    {
+        return std::fwrite(text, 1, count, file) == count;
+    }
+#ifdef GZIP
+    if (!compressor)
+    {
+        compressor.reset(new Compressor());
+    }
+    if (!compressor->initialized) //E.g. out of memory. Fails the stream, just like a failed write.
+    {
+        return false;
+    }
+    z_stream& stream = compressor->stream;
+    stream.next_in = reinterpret_cast<Bytef*>(const_cast<char*>(text));
+    stream.avail_in = count;
+    const int deflate_flush = (flush == CompressionFlush::FINISH) ? Z_FINISH : (flush == CompressionFlush::SYNC) ? Z_SYNC_FLUSH : Z_NO_FLUSH;
+    do
+    {
+        stream.next_out = reinterpret_cast<Bytef*>(compressor->output.data());
+        stream.avail_out = compressor->output.size();
+        if (deflate(&stream, deflate_flush) == Z_STREAM_ERROR)
+        {
+            return false;
+        }
+        const size_t compressed_count = compressor->output.size() - stream.avail_out;
+        if (std::fwrite(compressor->output.data(), 1, compressed_count, file) != compressed_count)
+        {
+            return false;
+        }
+    }
+    while (stream.avail_out == 0); //Output buffer was full, so there may be more.
+    return true;
+#else
+    return false;
+#endif
+}
+
+} //namespace cura
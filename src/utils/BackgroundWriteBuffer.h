@@ -0,0 +1,164 @@
+//Copyright (c) 2018 Ultimaker B.V.
+//CuraEngine is released under the terms of the AGPLv3 or higher.
+
+#ifndef UTILS_BACKGROUND_WRITE_BUFFER_H
+#define UTILS_BACKGROUND_WRITE_BUFFER_H
+
+#include <condition_variable>
+#include <cstdio>
+#include <memory>
+#include <mutex>
+#include <streambuf>
+#include <thread>
+#include <vector>
+
+namespace cura
+{
+
+/*!
+ * \brief A stream buffer which writes to a file on a background thread.
+ *
+ * The text is collected in a large buffer. When it is full it is handed to a
+ * writer thread, and the text which follows is collected in a second buffer
+ * in the meantime. Writing to the stream therefore only waits for the disk if
+ * the disk is slower than the slicing, rather than on every write.
+ *
+ * Flushing the stream waits until everything written so far has been passed
+ * on to the file.
+ *
+ * The text can be compressed with gzip, which is then also done by the writer
+ * thread.
+ */
+class BackgroundWriteBuffer : public std::streambuf
+{
+public:
+    static constexpr size_t default_buffer_size = 8 * 1024 * 1024; //!< The size of each of the two buffers, unless specified otherwise
+
+    /*!
+     * \param buffer_size The size of each of the two buffers, in bytes.
+     */
+    BackgroundWriteBuffer(const size_t buffer_size = default_buffer_size);
+
+    BackgroundWriteBuffer(const BackgroundWriteBuffer&) = delete;
+    BackgroundWriteBuffer& operator=(const BackgroundWriteBuffer&) = delete;
+
+    /*!
+     * Writes everything which is still in the buffers and closes the file.
+     */
+    ~BackgroundWriteBuffer() override;
+
+    /*!
+     * Open a file to write to, closing the file which was written to before.
+     * \param filename The file to create or overwrite.
+     * \return Whether the file could be opened.
+     */
+    bool open(const char* filename);
+
+    /*!
+     * Write to a file which is already open, such as stdout, closing the file
+     * which was written to before.
+     *
+     * The file is not closed by this buffer.
+     * \param file The file to write to.
+     */
+    void open(std::FILE* file);
+
+    /*!
+     * Write everything which is still in the buffers and close the file.
+     * \return Whether everything has been written successfully.
+     */
+    bool close();
+
+    /*!
+     * Change the size of the buffers.
+     *
+     * Takes effect when the current buffer is handed to the writer thread.
+     * \param buffer_size The size of each of the two buffers, in bytes.
+     */
+    void setBufferSize(const size_t buffer_size);
+
+    /*!
+     * Whether this build can compress the file with gzip.
+     */
+    static bool canCompress();
+
+    /*!
+     * Set whether to compress the file with gzip.
+     *
+     * Should be set before anything is written to the file. Flushing the
+     * stream then also flushes the compressed data, and the file is completed
+     * when it is closed.
+     * \param compress Whether to compress the file.
+     * \return Whether the file will be written as requested, which is not the
+     * case if compression is requested but this build can't compress.
+     */
+    bool setCompressed(const bool compress);
+
+protected:
+    int_type overflow(int_type ch) override;
+    int sync() override;
+
+private:
+    /*!
+     * Hand the text in the current buffer to the writer thread, and continue
+     * with the other buffer.
+     *
+     * Waits until the writer thread is done with the other buffer.
+     * \return Whether all text before could be written.
+     */
+    bool handOff();
+
+    /*!
+     * Wait until the writer thread is done with the text handed to it.
+     * \param lock A lock on \ref BackgroundWriteBuffer::mutex.
+     */
+    void waitUntilWritten(std::unique_lock<std::mutex>& lock);
+
+    /*!
+     * The work of the writer thread: write each buffer handed to it until it
+     * is stopped.
+     */
+    void writeBuffers();
+
+    /*!
+     * How far to flush the compressed data after compressing some text.
+     */
+    enum class CompressionFlush
+    {
+        NONE, //!< Keep as much in the compressor as is best for compression
+        SYNC, //!< Write everything so far, so that it can be decompressed
+        FINISH //!< Write everything and end the compressed file
+    };
+
+    /*!
+     * Write text to the file, compressing it if the file is compressed.
+     *
+     * Should only be called by one thread at a time.
+     * \param text The text to write.
+     * \param count The number of characters to write.
+     * \param flush How far to flush the compressed data. Ignored if the file
+     * isn't compressed.
+     * \return Whether the text has been written successfully.
+     */
+    bool writeToFile(const char* text, const size_t count, const CompressionFlush flush);
+
+    struct Compressor;
+
+    std::FILE* file; //!< The file to write to, or nullptr if no file is open
+    bool owns_file; //!< Whether the file was opened by this buffer, and should be closed by it
+    size_t buffer_size; //!< The size of each of the two buffers
+    std::vector<char> collecting_buffer; //!< The buffer which text is written to by the stream
+    std::vector<char> writing_buffer; //!< The buffer which is written to the file by the writer thread
+    size_t writing_size; //!< The amount of text in the writing buffer which is yet to be written, or zero if the writer thread is idle
+    bool stopping; //!< Whether the writer thread should stop once it's idle
+    bool failed; //!< Whether writing to the file failed
+    bool compressed; //!< Whether to compress the file with gzip
+    std::unique_ptr<Compressor> compressor; //!< The state of the compression of the current file, created when it's first written to
+    std::mutex mutex; //!< Guards the writing buffer and its state, which are shared with the writer thread
+    std::condition_variable state_changed; //!< Notified when text is handed to the writer thread, when it's written or when the writer should stop
+    std::thread writer; //!< The writer thread, started when the first text is handed off
+};
+
+} //namespace cura
+
+#endif //UTILS_BACKGROUND_WRITE_BUFFER_H
@@ -0,0 +1,392 @@
+//Copyright (c) 2018 Ultimaker B.V.
+//CuraEngine is released under the terms of the AGPLv3 or higher.
+
+#include <algorithm> //For std::fill and std::find.
+#include <cstring> //For memcmp.
+
+#include "BinaryGcodeBuffer.h"
+#include "string.h" //For writeInt2mm.
+
+namespace cura
+{
+
+constexpr uint8_t BinaryGcodeBuffer::version;
+constexpr char BinaryGcodeBuffer::move_words[];
+constexpr size_t BinaryGcodeBuffer::move_word_count;
+
+namespace
+{
+
+constexpr char file_magic[] = "CBGC"; //!< The characters the file starts with
+constexpr char index_magic[] = "CBGI"; //!< The characters the file ends with
+constexpr size_t initial_buffer_size = 64 * 1024; //!< Grows if a single line is longer
+constexpr size_t max_move_length = 200; //!< Longer lines are never moves
+
+/*!
+ * The number of decimals with which each of the move words is written.
+ */
+constexpr unsigned int move_word_decimals[] = { 1, 3, 3, 3, 3, 3, 5 };
+
+/*!
+ * Whether each of the move words is stored as the difference with its
+ * previous value.
+ */
+constexpr bool move_word_is_delta[] = { false, true, true, true, false, false, true };
+
+constexpr int64_t powers_of_ten[] = { 1, 10, 100, 1000, 10000, 100000 };
+
+/*!
+ * Write a number with a fixed number of decimals, without trailing zeros, the
+ * way writeDoubleToBuffer writes it.
+ */
+char* writeFixed(const int64_t value, const unsigned int decimal_count, char* buffer)
+{
+    const uint64_t magnitude = (value < 0) ? -static_cast<uint64_t>(value) : value;
+    const uint64_t unit = powers_of_ten[decimal_count];
+    if (value < 0)
+    {
+        *buffer++ = '-';
+    }
+    buffer = writeDigits(magnitude / unit, buffer);
+    if (magnitude % unit != 0)
+    {
+        *buffer++ = '.';
+        buffer = writeDecimals(magnitude % unit, decimal_count, buffer);
+    }
+    return buffer;
+}
+
+/*!
+ * Parse a number with at most \p decimal_count decimals.
+ * \param[in,out] text The start of the number, which is moved to its end.
+ * \param end The end of the line.
+ * \param[out] value The number multiplied by 10 to the power
+ * \p decimal_count.
+ * \return Whether a number could be parsed.
+ */
+bool parseFixed(const char*& text, const char* end, const unsigned int decimal_count, int64_t& value)
+{
+    const bool negative = text < end && *text == '-';
+    if (negative)
+    {
+        text++;
+    }
+    uint64_t magnitude = 0;
+    unsigned int digit_count = 0;
+    for (; text < end && *text >= '0' && *text <= '9'; text++, digit_count++)
+    {
+        magnitude = magnitude * 10 + (*text - '0');
+    }
+    unsigned int decimals_read = 0;
+    if (text < end && *text == '.')
+    {
+        text++;
+        for (; text < end && *text >= '0' && *text <= '9'; text++, decimals_read++, digit_count++)
+        {
+            if (decimals_read >= decimal_count)
+            {
+                return false;
+            }
+            magnitude = magnitude * 10 + (*text - '0');
+        }
+    }
+    if (digit_count == 0 || digit_count + decimal_count - decimals_read > 18)
+    {
+        return false; //No number, or it might not fit.
+    }
+    magnitude *= powers_of_ten[decimal_count - decimals_read];
+    value = negative ? -static_cast<int64_t>(magnitude) : static_cast<int64_t>(magnitude);
+    return true;
+}
+
+} //anonymous namespace
+
+BinaryGcodeBuffer::BinaryGcodeBuffer(std::streambuf* target)
+: target(target)
+, buffer(initial_buffer_size)
+, written_size(0)
+, started(false)
+, failed(false)
+{
+    std::fill(previous, previous + move_word_count, 0);
+    setp(buffer.data(), buffer.data() + buffer.size());
+}
+
+void BinaryGcodeBuffer::setTarget(std::streambuf* target)
+{
+    this->target = target;
+}
+
+bool BinaryGcodeBuffer::finish()
+{
+    encodeLines();
+    if (pptr() > pbase())
+    { //The g-code doesn't end with a line end.
+        encodeText(Opcode::PARTIAL_TEXT, pbase(), pptr() - pbase());
+        setp(buffer.data(), buffer.data() + buffer.size());
+    }
+    writeHeader();
+
+    const uint64_t end_position = written_size + encoded.size();
+    encoded.push_back(static_cast<char>(Opcode::END));
+    writeUnsigned(layer_index.size());
+    for (const std::pair<int64_t, uint64_t>& layer : layer_index)
+    {
+        writeSigned(layer.first);
+        writeUnsigned(layer.second);
+    }
+    for (size_t byte = 0; byte < 8; byte++)
+    {
+        encoded.push_back(static_cast<char>((end_position >> (byte * 8)) & 0xFF));
+    }
+    encoded.append(index_magic, sizeof(index_magic) - 1);
+    bool success = writeEncoded();
+    if (target && target->pubsync() != 0)
+    {
+        success = false;
+    }
+
+    //Start over for the next file.
+    written_size = 0;
+    started = false;
+    failed = false;
+    std::fill(previous, previous + move_word_count, 0);
+    layer_index.clear();
+    return success;
+}
+
+BinaryGcodeBuffer::int_type BinaryGcodeBuffer::overflow(int_type ch)
+{
+    encodeLines();
+    if (failed)
+    {
+        return traits_type::eof();
+    }
+    if (pptr() == epptr())
+    { //A single line fills the whole buffer.
+        const size_t size = pptr() - pbase();
+        buffer.resize(buffer.size() * 2);
+        setp(buffer.data(), buffer.data() + buffer.size());
+        pbump(size);
+    }
+    if (!traits_type::eq_int_type(ch, traits_type::eof()))
+    {
+        *pptr() = traits_type::to_char_type(ch);
+        pbump(1);
+    }
+    return traits_type::not_eof(ch);
+}
+
+int BinaryGcodeBuffer::sync()
+{
+    encodeLines();
+    if (failed)
+    {
+        return -1;
+    }
+    if (target)
+    {
+        return target->pubsync();
+    }
+    return 0;
+}
+
+void BinaryGcodeBuffer::encodeLines()
+{
+    const char* line = pbase();
+    const char* const end = pptr();
+    if (line == end)
+    {
+        return;
+    }
+    writeHeader();
+    for (const char* line_end = std::find(line, end, '\n'); line_end != end; line_end = std::find(line, end, '\n'))
+    {
+        encodeLine(line, line_end - line);
+        line = line_end + 1;
+    }
+    writeEncoded();
+
+    const size_t remaining = end - line;
+    std::memmove(buffer.data(), line, remaining);
+    setp(buffer.data(), buffer.data() + buffer.size());
+    pbump(remaining);
+}
+
+void BinaryGcodeBuffer::encodeLine(const char* line, const size_t length)
+{
+    if (length >= 2 && line[0] == 'G' && encodeMove(line, length))
+    {
+        return;
+    }
+    if (length >= 1 && line[0] == ';' && encodeLayer(line, length))
+    {
+        return;
+    }
+    encodeText(Opcode::TEXT, line, length);
+}
+
+bool BinaryGcodeBuffer::encodeMove(const char* line, const size_t length)
+{
+    if (length > max_move_length || line[1] < '0' || line[1] > '3' || (length > 2 && line[2] != ' '))
+    {
+        return false;
+    }
+    const unsigned int g = line[1] - '0';
+    const char* const end = line + length;
+    const char* text = line + 2;
+    uint8_t mask = 0;
+    int64_t values[move_word_count];
+    size_t word_idx = 0;
+    while (text < end)
+    {
+        if (*text != ' ' || text + 1 >= end)
+        {
+            return false;
+        }
+        const char letter = text[1];
+        while (word_idx < move_word_count && move_words[word_idx] != letter)
+        {
+            word_idx++;
+        }
+        if (word_idx == move_word_count)
+        {
+            return false; //Not a move word, or not in the usual order.
+        }
+        text += 2;
+        if (!parseFixed(text, end, move_word_decimals[word_idx], values[word_idx]))
+        {
+            return false;
+        }
+        mask |= 1 << word_idx;
+        word_idx++;
+    }
+
+    //Only encode the move if it's decoded to exactly the same text.
+    char written[max_move_length];
+    const char* written_end = writeMove(g, mask, values, written);
+    if (static_cast<size_t>(written_end - written) != length || std::memcmp(written, line, length) != 0)
+    {
+        return false;
+    }
+
+    encoded.push_back(static_cast<char>(static_cast<uint8_t>(Opcode::MOVE_G0) + g));
+    encoded.push_back(static_cast<char>(mask));
+    for (size_t word = 0; word < move_word_count; word++)
+    {
+        if (!(mask & (1 << word)))
+        {
+            continue;
+        }
+        if (move_word_is_delta[word])
+        {
+            writeSigned(values[word] - previous[word]);
+            previous[word] = values[word];
+        }
+        else
+        {
+            writeSigned(values[word]);
+        }
+    }
+    return true;
+}
+
+bool BinaryGcodeBuffer::encodeLayer(const char* line, const size_t length)
+{
+    constexpr char layer_comment[] = ";LAYER:";
+    constexpr size_t prefix_length = sizeof(layer_comment) - 1;
+    if (length <= prefix_length || length > prefix_length + 12 || std::memcmp(line, layer_comment, prefix_length) != 0)
+    {
+        return false;
+    }
+    const char* text = line + prefix_length;
+    const char* const end = line + length;
+    int64_t layer_nr;
+    if (!parseFixed(text, end, 0, layer_nr) || text != end)
+    {
+        return false;
+    }
+    char written[24];
+    char* written_end = writeFixed(layer_nr, 0, written);
+    if (static_cast<size_t>(written_end - written) != length - prefix_length || std::memcmp(written, line + prefix_length, length - prefix_length) != 0)
+    {
+        return false; //E.g. "-0" or leading zeros.
+    }
+
+    layer_index.emplace_back(layer_nr, written_size + encoded.size());
+    encoded.push_back(static_cast<char>(Opcode::LAYER));
+    writeSigned(layer_nr);
+    std::fill(previous, previous + move_word_count, 0);
+    return true;
+}
+
+void BinaryGcodeBuffer::encodeText(const Opcode opcode, const char* line, const size_t length)
+{
+    encoded.push_back(static_cast<char>(opcode));
+    writeUnsigned(length);
+    encoded.append(line, length);
+}
+
+char* BinaryGcodeBuffer::writeMove(const unsigned int g, const uint8_t mask, const int64_t* values, char* buffer)
+{
+    *buffer++ = 'G';
+    *buffer++ = '0' + g;
+    for (size_t word = 0; word < move_word_count; word++)
+    {
+        if (!(mask & (1 << word)))
+        {
+            continue;
+        }
+        *buffer++ = ' ';
+        *buffer++ = move_words[word];
+        if (move_word_decimals[word] == 3)
+        {
+            buffer = writeInt2mm(values[word], buffer);
+        }
+        else
+        {
+            buffer = writeFixed(values[word], move_word_decimals[word], buffer);
+        }
+    }
+    return buffer;
+}
+
+void BinaryGcodeBuffer::writeHeader()
+{
+    if (started)
+    {
+        return;
+    }
+    encoded.append(file_magic, sizeof(file_magic) - 1);
+    encoded.push_back(static_cast<char>(version));
+    started = true;
+}
+
+bool BinaryGcodeBuffer::writeEncoded()
+{
+    //After a short write the positions in the index would be wrong, so the rest of the file is dropped.
+    if (target && !failed && target->sputn(encoded.data(), encoded.size()) != static_cast<std::streamsize>(encoded.size()))
+    {
+        failed = true;
+    }
+    written_size += encoded.size();
+    encoded.clear();
+    return !failed;
+}
+
+void BinaryGcodeBuffer::writeUnsigned(uint64_t value)
+{
+    while (value >= 0x80)
+    {
+        encoded.push_back(static_cast<char>((value & 0x7F) | 0x80));
+        value >>= 7;
+    }
+    encoded.push_back(static_cast<char>(value));
+}
+
+void BinaryGcodeBuffer::writeSigned(const int64_t value)
+{
+    writeUnsigned((static_cast<uint64_t>(value) << 1) ^ static_cast<uint64_t>(value >> 63));
+}
+
+} //namespace cura
@@ -0,0 +1,184 @@
+//Copyright (c) 2018 Ultimaker B.V.
+//CuraEngine is released under the terms of the AGPLv3 or higher.
+
+#ifndef UTILS_BINARY_GCODE_BUFFER_H
+#define UTILS_BINARY_GCODE_BUFFER_H
+
+#include <cstdint>
+#include <streambuf>
+#include <string>
+#include <utility>
+#include <vector>
+
+namespace cura
+{
+
+/*!
+ * \brief A stream buffer which encodes the g-code written to it in a compact
+ * binary format, and passes that on to another stream buffer.
+ *
+ * A printer host can read the binary format much faster than the text, and
+ * can go to any layer right away with the index at the end of the file.
+ *
+ * The format starts with the four characters "CBGC" and a version byte.
+ * Then follows one record for each line of the g-code, starting with an
+ * opcode byte:
+ * - \ref BinaryGcodeBuffer::Opcode::MOVE_G0 up to MOVE_G3: a G0, G1, G2 or
+ * G3 move. A byte follows with a bit for each of the words F, X, Y, Z, I, J
+ * and E which the move has, from the lowest bit up, in the order in which
+ * they are written. Then follows the value of each of these words as a
+ * signed varint: F in tenths of mm/min, X, Y, Z, I and J in micron and E in
+ * hundred thousandths of mm. X, Y, Z and E are stored as the difference with
+ * the previous value of the same word in the same layer.
+ * - \ref BinaryGcodeBuffer::Opcode::LAYER: the line ";LAYER:<n>", followed by
+ * n as a signed varint. Starts a new layer, so the first X, Y, Z and E of the
+ * layer are stored as the difference with 0.
+ * - \ref BinaryGcodeBuffer::Opcode::TEXT: any other line, followed by its
+ * length as an unsigned varint and the text without the line end.
+ * - \ref BinaryGcodeBuffer::Opcode::PARTIAL_TEXT: the same, for the end of
+ * the g-code if it doesn't end with a line end.
+ * - \ref BinaryGcodeBuffer::Opcode::END: the end of the g-code, followed by
+ * the index: the number of layers as an unsigned varint and for each layer
+ * its number as a signed varint and the position of its LAYER record in the
+ * file as an unsigned varint. The file ends with the position of the END
+ * record as 8 bytes, least significant first, and the four characters
+ * "CBGI".
+ *
+ * The positions are offsets in the binary format itself. If the file is
+ * compressed with gzip ("-z" on the command line), they are positions in the
+ * decompressed stream, not in the compressed file.
+ *
+ * Unsigned varints are written 7 bits per byte, least significant first, with
+ * the highest bit set in all but the last byte. Signed varints are zigzag
+ * encoded to an unsigned varint first: 0, -1, 1, -2, ... become 0, 1, 2,
+ * 3, ...
+ *
+ * A move is only encoded as such if writing it back as text gives exactly the
+ * same line, so decoding always gives the original g-code.
+ *
+ * If the target doesn't take all of the encoded records, e.g. because the
+ * disk is full, nothing more is written to it and the stream fails.
+ */
+class BinaryGcodeBuffer : public std::streambuf
+{
+public:
+    static constexpr uint8_t version = 1; //!< The version of the format
+
+    /*!
+     * The opcodes of the records.
+     */
+    enum class Opcode : uint8_t
+    {
+        TEXT = 0x00,
+        PARTIAL_TEXT = 0x01,
+        LAYER = 0x02,
+        END = 0x03,
+        MOVE_G0 = 0x10,
+        MOVE_G1 = 0x11,
+        MOVE_G2 = 0x12,
+        MOVE_G3 = 0x13
+    };
+
+    /*!
+     * The words a move can have, in the order in which they are written. The
+     * bit of each word in the mask of a move is 1 shifted by its index here.
+     */
+    static constexpr char move_words[] = "FXYZIJE";
+    static constexpr size_t move_word_count = sizeof(move_words) - 1; //!< The number of words a move can have
+
+    /*!
+     * \param target The stream buffer to write the encoded g-code to.
+     */
+    BinaryGcodeBuffer(std::streambuf* target = nullptr);
+
+    BinaryGcodeBuffer(const BinaryGcodeBuffer&) = delete;
+    BinaryGcodeBuffer& operator=(const BinaryGcodeBuffer&) = delete;
+
+    /*!
+     * Set the stream buffer to write the encoded g-code to.
+     */
+    void setTarget(std::streambuf* target);
+
+    /*!
+     * Encode what's left of the g-code and write the index, which completes
+     * the file.
+     *
+     * Anything written after this starts a new file.
+     * \return Whether the whole file has been written to the target.
+     */
+    bool finish();
+
+    /*!
+     * Write a move back as text, the way \ref GCodeExport writes it.
+     * \param g The number of the G command, from 0 up to 3.
+     * \param mask Which of the \ref BinaryGcodeBuffer::move_words the move
+     * has.
+     * \param values The value of each word the move has, or anything for the
+     * words it doesn't have.
+     * \param buffer The buffer to write to, which should have room for 200
+     * characters.
+     * \return The end of the written characters.
+     */
+    static char* writeMove(const unsigned int g, const uint8_t mask, const int64_t* values, char* buffer);
+
+protected:
+    int_type overflow(int_type ch) override;
+    int sync() override;
+
+private:
+    /*!
+     * Encode all complete lines in the buffer and move the rest of the text
+     * to the start of the buffer.
+     */
+    void encodeLines();
+
+    /*!
+     * Encode a single line, without its line end.
+     */
+    void encodeLine(const char* line, const size_t length);
+
+    /*!
+     * Try to encode a line as a move.
+     * \return Whether the line is a move which can be written back exactly.
+     */
+    bool encodeMove(const char* line, const size_t length);
+
+    /*!
+     * Try to encode a line as the start of a layer.
+     * \return Whether the line is a layer comment.
+     */
+    bool encodeLayer(const char* line, const size_t length);
+
+    /*!
+     * Encode a line as text.
+     */
+    void encodeText(const Opcode opcode, const char* line, const size_t length);
+
+    /*!
+     * Write the magic characters and the version, if this is the start of
+     * the file.
+     */
+    void writeHeader();
+
+    /*!
+     * Pass the encoded records on to the target.
+     * \return Whether the target took all of the records.
+     */
+    bool writeEncoded();
+
+    void writeUnsigned(uint64_t value); //!< Append an unsigned varint to the encoded records
+    void writeSigned(const int64_t value); //!< Append a signed varint to the encoded records
+
+    std::streambuf* target; //!< The stream buffer to write the encoded g-code to
+    std::vector<char> buffer; //!< The text written to this buffer which is yet to be encoded
+    std::string encoded; //!< The records which are yet to be written to the target
+    uint64_t written_size; //!< The number of bytes of the file written to the target so far
+    bool started; //!< Whether the header of the current file has been written
+    bool failed; //!< Whether the target didn't take some of the records of the current file
+    int64_t previous[move_word_count]; //!< The previous value of each word of a move in the current layer
+    std::vector<std::pair<int64_t, uint64_t>> layer_index; //!< The number and the position of the LAYER record of each layer
+};
+
+} //namespace cura
+
+#endif //UTILS_BINARY_GCODE_BUFFER_H
@@ -0,0 +1,168 @@
+//Copyright (c) 2018 Ultimaker B.V.
+//CuraEngine is released under the terms of the AGPLv3 or higher.
+
+#include <cmath> //For llround.
+#include <cstdint>
+
+#include "CompactPathEncoding.h"
+
+namespace cura
+{
+
+constexpr double CompactPathEncoding::coordinate_scale;
+constexpr double CompactPathEncoding::feedrate_scale;
+
+namespace
+{
+
+void writeUnsigned(uint64_t value, std::string& data)
+{
+    while (value >= 0x80)
+    {
+        data.push_back(static_cast<char>((value & 0x7F) | 0x80));
+        value >>= 7;
+    }
+    data.push_back(static_cast<char>(value));
+}
+
+void writeSigned(const int64_t value, std::string& data)
+{
+    writeUnsigned((static_cast<uint64_t>(value) << 1) ^ static_cast<uint64_t>(value >> 63), data);
+}
+
+/*!
+ * Read an unsigned varint.
+ * \param data The encoded data.
+ * \param[in,out] position Where the varint starts, which is moved to its end.
+ * \param[out] value The value of the varint.
+ * \return Whether a complete varint could be read.
+ */
+bool readUnsigned(const std::string& data, size_t& position, uint64_t& value)
+{
+    value = 0;
+    for (unsigned int shift = 0; position < data.size() && shift < 64; shift += 7)
+    {
+        const uint8_t byte = data[position++];
+        value |= static_cast<uint64_t>(byte & 0x7F) << shift;
+        if (!(byte & 0x80))
+        {
+            return true;
+        }
+    }
+    return false;
+}
+
+bool readSigned(const std::string& data, size_t& position, int64_t& value)
+{
+    uint64_t zigzag;
+    if (!readUnsigned(data, position, zigzag))
+    {
+        return false;
+    }
+    value = static_cast<int64_t>(zigzag >> 1) ^ -static_cast<int64_t>(zigzag & 1);
+    return true;
+}
+
+int64_t quantize(const float value, const double scale)
+{
+    return std::llround(static_cast<double>(value) * scale);
+}
+
+float dequantize(const int64_t value, const double scale)
+{
+    return value / scale; //Divide rather than multiply by the resolution, like INT2MM, so that values from micron come back exactly.
+}
+
+} //Anonymous namespace.
+
+std::string CompactPathEncoding::encodePoints(const std::vector<float>& points, const size_t dimensions)
+{
+    std::string data;
+    data.reserve(points.size() * 2);
+    std::vector<int64_t> previous(dimensions, 0);
+    for (size_t coordinate_idx = 0; coordinate_idx < points.size(); coordinate_idx++)
+    {
+        const int64_t coordinate = quantize(points[coordinate_idx], coordinate_scale);
+        int64_t& previous_coordinate = previous[coordinate_idx % dimensions];
+        writeSigned(coordinate - previous_coordinate, data);
+        previous_coordinate = coordinate;
+    }
+    return data;
+}
+
+std::vector<float> CompactPathEncoding::decodePoints(const std::string& data, const size_t dimensions)
+{
+    std::vector<float> points;
+    std::vector<int64_t> previous(dimensions, 0);
+    size_t position = 0;
+    int64_t delta;
+    while (readSigned(data, position, delta))
+    {
+        int64_t& coordinate = previous[points.size() % dimensions];
+        coordinate += delta;
+        points.push_back(dequantize(coordinate, coordinate_scale));
+    }
+    return points;
+}
+
+std::string CompactPathEncoding::encodeRuns(const std::vector<float>& values, const double scale)
+{
+    std::string data;
+    for (size_t run_start = 0; run_start < values.size();)
+    {
+        const int64_t value = quantize(values[run_start], scale);
+        size_t run_end = run_start + 1;
+        while (run_end < values.size() && quantize(values[run_end], scale) == value)
+        {
+            run_end++;
+        }
+        writeUnsigned(run_end - run_start, data);
+        writeSigned(value, data);
+        run_start = run_end;
+    }
+    return data;
+}
+
+std::vector<float> CompactPathEncoding::decodeRuns(const std::string& data, const double scale)
+{
+    std::vector<float> values;
+    size_t position = 0;
+    uint64_t run_length;
+    int64_t value;
+    while (readUnsigned(data, position, run_length) && readSigned(data, position, value))
+    {
+        values.insert(values.end(), run_length, dequantize(value, scale));
+    }
+    return values;
+}
+
+std::string CompactPathEncoding::encodeTypes(const std::vector<PrintFeatureType>& types)
+{
+    std::string data;
+    for (size_t run_start = 0; run_start < types.size();)
+    {
+        size_t run_end = run_start + 1;
+        while (run_end < types.size() && types[run_end] == types[run_start])
+        {
+            run_end++;
+        }
+        writeUnsigned(run_end - run_start, data);
+        data.push_back(static_cast<char>(types[run_start]));
+        run_start = run_end;
+    }
+    return data;
+}
+
+std::vector<PrintFeatureType> CompactPathEncoding::decodeTypes(const std::string& data)
+{
+    std::vector<PrintFeatureType> types;
+    size_t position = 0;
+    uint64_t run_length;
+    while (readUnsigned(data, position, run_length) && position < data.size())
+    {
+        types.insert(types.end(), run_length, static_cast<PrintFeatureType>(data[position++]));
+    }
+    return types;
+}
+
+} //namespace cura
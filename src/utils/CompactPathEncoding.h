@@ -0,0 +1,101 @@
+//Copyright (c) 2018 Ultimaker B.V.
+//CuraEngine is released under the terms of the AGPLv3 or higher.
+
+#ifndef UTILS_COMPACT_PATH_ENCODING_H
+#define UTILS_COMPACT_PATH_ENCODING_H
+
+#include <string>
+#include <vector>
+
+#include "../PrintFeature.h"
+
+namespace cura
+{
+
+/*!
+ * \brief Encodes the layer view data of a path segment compactly, as an
+ * alternative to sending it as arrays of floats.
+ *
+ * Most of the layer view data is very repetitive: consecutive points are
+ * close together and long runs of line segments have the same type, width,
+ * thickness and feedrate. Sent as floats the layer view data is about as
+ * large as the g-code itself.
+ *
+ * The encoded arrays are:
+ * - The points: for each point, for each of its dimensions, the difference
+ * with the same coordinate of the previous point as a signed varint, in
+ * micron. The first point is stored as the difference with 0.
+ * - The line types: runs of line segments with the same type, each as the
+ * length of the run as an unsigned varint followed by the type as one byte.
+ * - The line widths, thicknesses and feedrates: runs of line segments with
+ * the same value, each as the length of the run as an unsigned varint
+ * followed by the value as a signed varint, in micron for widths and
+ * thicknesses and in hundredths of mm/s for feedrates.
+ *
+ * Unsigned varints are written 7 bits per byte, least significant first, with
+ * the highest bit set in all but the last byte. Signed varints are zigzag
+ * encoded to an unsigned varint first: 0, -1, 1, -2, ... become 0, 1, 2,
+ * 3, ...
+ *
+ * The engine's coordinates and line widths are in micron already, so these
+ * are sent without loss. Only feedrates are rounded.
+ */
+class CompactPathEncoding
+{
+public:
+    static constexpr double coordinate_scale = 1000.0; //!< The number of stored units per mm of coordinates, widths and thicknesses
+    static constexpr double feedrate_scale = 100.0; //!< The number of stored units per mm/s of feedrates
+
+    /*!
+     * Encode the points of a path segment.
+     * \param points The coordinates of the points in mm, each point as
+     * \p dimensions consecutive values.
+     * \param dimensions The number of coordinates of each point.
+     * \return The encoded points.
+     */
+    static std::string encodePoints(const std::vector<float>& points, const size_t dimensions);
+
+    /*!
+     * Decode the points of a path segment.
+     * \param data The encoded points.
+     * \param dimensions The number of coordinates of each point.
+     * \return The coordinates of the points in mm.
+     */
+    static std::vector<float> decodePoints(const std::string& data, const size_t dimensions);
+
+    /*!
+     * Encode the widths, thicknesses or feedrates of the line segments of a
+     * path segment.
+     * \param values The value of each line segment.
+     * \param scale The number of stored units per unit of the values.
+     * \return The encoded values.
+     */
+    static std::string encodeRuns(const std::vector<float>& values, const double scale);
+
+    /*!
+     * Decode the widths, thicknesses or feedrates of the line segments of a
+     * path segment.
+     * \param data The encoded values.
+     * \param scale The number of stored units per unit of the values.
+     * \return The value of each line segment.
+     */
+    static std::vector<float> decodeRuns(const std::string& data, const double scale);
+
+    /*!
+     * Encode the types of the line segments of a path segment.
+     * \param types The type of each line segment.
+     * \return The encoded types.
+     */
+    static std::string encodeTypes(const std::vector<PrintFeatureType>& types);
+
+    /*!
+     * Decode the types of the line segments of a path segment.
+     * \param data The encoded types.
+     * \return The type of each line segment.
+     */
+    static std::vector<PrintFeatureType> decodeTypes(const std::string& data);
+};
+
+} //namespace cura
+
+#endif //UTILS_COMPACT_PATH_ENCODING_H
@@ -0,0 +1,70 @@
+//Copyright (c) 2018 Ultimaker B.V.
+//CuraEngine is released under the terms of the AGPLv3 or higher.
+
+#include <sstream> //To format the pending numbers like a stream would.
+
+#include "DeferredFormatBuffer.h"
+#include "string.h" //To format the numbers.
+
+namespace cura
+{
+
+constexpr int DeferredFormatBuffer::mm_precision;
+
+std::string DeferredFormatBuffer::format() const
+{
+    std::string result;
+    result.reserve(text.size() + numbers.size() * 8); // most numbers in g-code are no longer than 8 characters
+    char number_buffer[400];
+    size_t text_pos = 0;
+    std::vector<PendingNumber>::const_iterator pending = pending_numbers.begin();
+    const auto appendPendingBefore = [this, &result, &text_pos, &pending](const size_t position)
+    {
+        for (; pending != pending_numbers.end() && pending->position <= position; ++pending)
+        {
+            result.append(text, text_pos, pending->position - text_pos);
+            text_pos = pending->position;
+            std::ostringstream number;
+            number.flags(pending->flags);
+            number.precision(pending->precision);
+            number << pending->value.get();
+            result.append(number.str());
+        }
+    };
+    for (const DeferredNumber& number : numbers)
+    {
+        appendPendingBefore(number.position);
+        result.append(text, text_pos, number.position - text_pos);
+        text_pos = number.position;
+        const char* number_end;
+        if (number.precision == mm_precision)
+        {
+            number_end = writeInt2mm(number.coord, number_buffer);
+        }
+        else
+        {
+            number_end = writeDoubleToBuffer(number.precision, number.value, number_buffer);
+        }
+        result.append(number_buffer, number_end - number_buffer);
+    }
+    appendPendingBefore(text.size());
+    result.append(text, text_pos, std::string::npos);
+    return result;
+}
+
+DeferredFormatBuffer::int_type DeferredFormatBuffer::overflow(int_type ch)
+{
+    if (!traits_type::eq_int_type(ch, traits_type::eof()))
+    {
+        text.push_back(traits_type::to_char_type(ch));
+    }
+    return traits_type::not_eof(ch);
+}
+
+std::streamsize DeferredFormatBuffer::xsputn(const char* str, std::streamsize count)
+{
+    text.append(str, count);
+    return count;
+}
+
+} //namespace cura
@@ -0,0 +1,139 @@
+//Copyright (c) 2018 Ultimaker B.V.
+//CuraEngine is released under the terms of the AGPLv3 or higher.
+
+#ifndef UTILS_DEFERRED_FORMAT_BUFFER_H
+#define UTILS_DEFERRED_FORMAT_BUFFER_H
+
+#include <cstdint>
+#include <future>
+#include <ostream>
+#include <streambuf>
+#include <string>
+#include <vector>
+
+namespace cura
+{
+
+/*!
+ * \brief A stream buffer which collects text of which the numbers are
+ * formatted later.
+ *
+ * Formatting the coordinates, feedrates and extrusion amounts of g-code takes
+ * about as long as computing them. When a \ref MMtoStream or a
+ * \ref PrecisionedDouble is written to a stream with this buffer, only its
+ * value and where it belongs in the text are stored. The numbers can then be
+ * formatted with \ref DeferredFormatBuffer::format on another thread, while
+ * the writer goes on with the next piece of text.
+ *
+ * Everything else written to the stream is stored as text right away, so it
+ * is formatted with the flags of the stream at the time of writing.
+ *
+ * A number which is still being computed when it's written, such as the
+ * estimated print time, can be stored as a future with
+ * \ref DeferredFormatBuffer::deferPending. Formatting then waits for it.
+ */
+class DeferredFormatBuffer : public std::streambuf
+{
+public:
+    /*!
+     * Get the deferred format buffer of a stream.
+     * \return The buffer, or nullptr if the stream doesn't write to a deferred
+     * format buffer.
+     */
+    static DeferredFormatBuffer* of(std::ostream& stream)
+    {
+        return dynamic_cast<DeferredFormatBuffer*>(stream.rdbuf());
+    }
+
+    /*!
+     * Store a coordinate in micron, to be written in millimetres at the
+     * current end of the text.
+     */
+    void deferMM(const int64_t coord)
+    {
+        numbers.emplace_back(text.size(), mm_precision, coord, 0.0);
+    }
+
+    /*!
+     * Store a number, to be written with at most \p precision decimals at the
+     * current end of the text.
+     */
+    void deferDouble(const unsigned int precision, const double value)
+    {
+        numbers.emplace_back(text.size(), precision, 0, value);
+    }
+
+    /*!
+     * Store a number which is yet to be computed, to be written at the
+     * current end of the text the way \p stream writes a double now.
+     * \param value The number, which \ref DeferredFormatBuffer::format waits
+     * for.
+     * \param stream The stream of which to use the formatting flags and the
+     * precision.
+     */
+    void deferPending(const std::shared_future<double>& value, const std::ios_base& stream)
+    {
+        pending_numbers.emplace_back(text.size(), value, stream.flags(), stream.precision());
+    }
+
+    /*!
+     * Produce the text with all stored numbers formatted.
+     *
+     * The result is the same as if the numbers had been written to the stream
+     * directly. Only reads the buffer, so it can be called on any thread once
+     * nothing is written to the buffer any more.
+     */
+    std::string format() const;
+
+protected:
+    int_type overflow(int_type ch) override;
+    std::streamsize xsputn(const char* str, std::streamsize count) override;
+
+private:
+    static constexpr int mm_precision = -1; //!< The precision of coordinates in micron, which are written with \ref writeInt2mm
+
+    /*!
+     * A number which is yet to be formatted.
+     */
+    struct DeferredNumber
+    {
+        DeferredNumber(const size_t position, const int precision, const int64_t coord, const double value)
+        : position(position)
+        , precision(precision)
+        , coord(coord)
+        , value(value)
+        {
+        }
+
+        size_t position; //!< Where in the text to insert the number
+        int precision; //!< The number of decimals, or mm_precision if the number is a coordinate
+        int64_t coord; //!< The coordinate, if this is a coordinate
+        double value; //!< The number, if this isn't a coordinate
+    };
+
+    /*!
+     * A number which is yet to be computed.
+     */
+    struct PendingNumber
+    {
+        PendingNumber(const size_t position, const std::shared_future<double>& value, const std::ios_base::fmtflags flags, const std::streamsize precision)
+        : position(position)
+        , value(value)
+        , flags(flags)
+        , precision(precision)
+        {
+        }
+        size_t position; //!< Where in the text to insert the number
+        std::shared_future<double> value; //!< The number, once it's computed
+        std::ios_base::fmtflags flags; //!< The formatting flags of the stream it was written to
+        std::streamsize precision; //!< The precision of the stream it was written to
+    };
+
+    std::string text; //!< The text written to the stream, without the deferred numbers
+    std::vector<DeferredNumber> numbers; //!< The deferred numbers, in order of their position in the text
+    std::vector<PendingNumber> pending_numbers; //!< The numbers yet to be computed, in order of their position in the text
+};
+
+} //namespace cura
+
+#endif //UTILS_DEFERRED_FORMAT_BUFFER_H
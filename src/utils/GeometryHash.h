@@ -0,0 +1,112 @@
+//Copyright (c) 2018 Ultimaker B.V.
+//CuraEngine is released under the terms of the AGPLv3 or higher.
+
+#ifndef UTILS_GEOMETRY_HASH_H
+#define UTILS_GEOMETRY_HASH_H
+
+#include <cstdint>
+
+#include "IntPoint.h"
+#include "polygon.h"
+
+namespace cura
+{
+
+/*!
+ * \brief A hash of the coordinates of some geometry and of the parameters it
+ * is processed with.
+ *
+ * Used to recognise input which is exactly the same as input which has been
+ * processed before, e.g. the walls of a layer which are the same as the walls
+ * of the layer below, so that the result computed before can be reused.
+ *
+ * Two independent 64-bit hashes are kept, so that two different inputs with
+ * the same hash are so unlikely that results can be reused without comparing
+ * the input itself.
+ */
+class GeometryHash
+{
+public:
+    GeometryHash()
+    : a(14695981039346656037ull)
+    , b(0x9E3779B97F4A7C15ull)
+    {
+    }
+
+    GeometryHash& add(const uint64_t value)
+    {
+        a = (a ^ value) * 1099511628211ull;
+        b += value * 0xBF58476D1CE4E5B9ull;
+        b = ((b << 31) | (b >> 33)) * 0x94D049BB133111EBull;
+        return *this;
+    }
+
+    GeometryHash& add(const coord_t value)
+    {
+        return add(static_cast<uint64_t>(value));
+    }
+
+    GeometryHash& add(const int value)
+    {
+        return add(static_cast<uint64_t>(static_cast<int64_t>(value)));
+    }
+
+    GeometryHash& add(const bool value)
+    {
+        return add(static_cast<uint64_t>(value));
+    }
+
+    GeometryHash& add(const Point& point)
+    {
+        return add(point.X).add(point.Y);
+    }
+
+    GeometryHash& add(const ConstPolygonRef& polygon)
+    {
+        add(static_cast<uint64_t>(polygon.size())); // so that the same points divided differently over polygons hash differently
+        for (const Point& point : polygon)
+        {
+            add(point);
+        }
+        return *this;
+    }
+
+    GeometryHash& add(const Polygons& polygons)
+    {
+        add(static_cast<uint64_t>(polygons.size()));
+        for (ConstPolygonRef polygon : polygons)
+        {
+            add(polygon);
+        }
+        return *this;
+    }
+
+    GeometryHash& add(const GeometryHash& other)
+    {
+        return add(other.a).add(other.b);
+    }
+
+    bool operator==(const GeometryHash& other) const
+    {
+        return a == other.a && b == other.b;
+    }
+
+    /*!
+     * Hash function to use GeometryHash as the key of an unordered_map.
+     */
+    struct Hasher
+    {
+        size_t operator()(const GeometryHash& hash) const
+        {
+            return static_cast<size_t>(hash.a ^ hash.b);
+        }
+    };
+
+private:
+    uint64_t a; //!< The first hash, FNV-1a over 64-bit words
+    uint64_t b; //!< The second hash, with a different multiply-rotate mix
+};
+
+} //namespace cura
+
+#endif //UTILS_GEOMETRY_HASH_H
@@ -18,6 +18,11 @@ float LinearAlg2D::getAngleLeft(const Point& a, const Point& b, const Point& c)
     const Point bc = c - b;
     const coord_t dott = dot(ba, bc); // dot product
     const coord_t det = ba.X * bc.Y - ba.Y * bc.X; // determinant
+    return getAngleLeft(det, dott);
+}
+
+float LinearAlg2D::getAngleLeft(const coord_t det, const coord_t dott)
+{
     const float angle = -atan2(det, dott); // from -pi to pi
     if (angle >= 0)
     {
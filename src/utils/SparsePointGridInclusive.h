@@ -75,6 +75,17 @@ public:
      */
     void insert(const Point &point, const Val &val);
 
+    /*! \brief Removes an element with specified point and value from the sparse grid.
+     *
+     * Only the cell containing \p point is searched, so \p point must be the
+     * same location that was used to insert the value.
+     *
+     * \param[in] point The location of the element.
+     * \param[in] val The value of the element.
+     * \return Whether an element has been found and removed.
+     */
+    bool erase(const Point &point, const Val &val);
+
     /*! \brief Returns all values within radius of query_pt.
      *
      * Finds all values with location within radius of \p query_pt.  May
@@ -106,6 +117,21 @@ void SG_THIS::insert(const Point &point, const Val &val)
     Base::insert(elem);
 }
 
+SG_TEMPLATE
+bool SG_THIS::erase(const Point &point, const Val &val)
+{
+    auto grid_range = this->m_grid.equal_range(this->toGridPoint(point));
+    for (auto iter = grid_range.first; iter != grid_range.second; ++iter)
+    {
+        if (iter->second.point == point && iter->second.val == val)
+        {
+            this->m_grid.erase(iter);
+            return true;
+        }
+    }
+    return false;
+}
+
 SG_TEMPLATE
 std::vector<Val>
 SG_THIS::getNearbyVals(const Point &query_pt, coord_t radius) const
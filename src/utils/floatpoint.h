@@ -125,6 +125,31 @@ public:
             MM2INT(p.x * m[0][1] + p.y * m[1][1] + p.z * m[2][1]),
             MM2INT(p.x * m[0][2] + p.y * m[1][2] + p.z * m[2][2]));
     }
+
+    /*!
+     * Apply the matrix to many points at once, straight from an array of
+     * floats.
+     *
+     * This gives exactly the same points as applying the matrix to each
+     * point, but without copying the points into FPoint3s first, so that the
+     * loop can be vectorized.
+     * \param coords The coordinates of the points in millimetres: the x, y
+     * and z of each point after each other.
+     * \param point_count The number of points.
+     * \param[out] result Where to store the points, with room for
+     * \p point_count points.
+     */
+    void apply(const float* coords, const size_t point_count, Point3* result) const
+    {
+        for (size_t point_idx = 0; point_idx < point_count; point_idx++)
+        {
+            const float* p = coords + point_idx * 3;
+            result[point_idx] = Point3(
+                MM2INT(p[0] * m[0][0] + p[1] * m[1][0] + p[2] * m[2][0]),
+                MM2INT(p[0] * m[0][1] + p[1] * m[1][1] + p[2] * m[2][1]),
+                MM2INT(p[0] * m[0][2] + p[1] * m[1][2] + p[2] * m[2][2]));
+        }
+    }
 };
 
 }//namespace cura
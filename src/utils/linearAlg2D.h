@@ -281,6 +281,19 @@ public:
      */
     static float getAngleLeft(const Point& a, const Point& b, const Point& c);
 
+    /*!
+     * Compute the angle between two consecutive line segments from the
+     * determinant and the dot product of the vectors ba and bc.
+     *
+     * This gives the same result as getAngleLeft(a, b, c), for when the
+     * products have already been computed, e.g. for many corners at once.
+     *
+     * \param det The determinant of ba and bc: ba.X * bc.Y - ba.Y * bc.X
+     * \param dott The dot product of ba and bc
+     * \return the angle in radians between 0 and 2 * pi of the corner in b
+     */
+    static float getAngleLeft(const coord_t det, const coord_t dott);
+
     /*!
      * Returns the determinant of the 2D matrix defined by the the vectors ab and ap as rows.
      * 
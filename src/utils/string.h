@@ -5,9 +5,12 @@
 #define UTILS_STRING_H
 
 #include <ctype.h>
-#include <cstdio> // sprintf
+#include <cmath> // floor, signbit
+#include <cstdint>
+#include <cstdio> // snprintf
 #include <sstream> // ostringstream
 
+#include "DeferredFormatBuffer.h"
 #include "logoutput.h"
 
 namespace cura
@@ -27,73 +30,93 @@ static inline int stringcasecompare(const char* a, const char* b)
 }
 
 /*!
- * Efficient conversion of micron integer type to millimeter string.
- * 
- * The integer type is half the size of the normal integer type because of implementation details.
- * However, half the integer type should suffice, because we made the basic coord_t twice as big as necessary
- * so as to support multiplication within the same integer type.
+ * Write the decimal digits of a non-negative integer to a buffer.
  * 
- * \param coord The micron unit to convert
- * \param ss The output stream to write the string to
+ * \param value The integer to write
+ * \param buffer The buffer to write to, which should have room for 20 characters
+ * \return The end of the written characters
  */
-static inline void writeInt2mm(const int32_t coord, std::ostream& ss)
+static inline char* writeDigits(uint64_t value, char* buffer)
 {
-    constexpr size_t buffer_size = 24;
-    char buffer[buffer_size];
-    int char_count = sprintf(buffer, "%d", coord); // we haven't found any way for the windows compiler to accept formatting of a coord_t, so it has to be int32_t instead
-#ifdef DEBUG
-    if (char_count + 1 >= int(buffer_size)) // + 1 for the null character
+    char digits[20];
+    int digit_count = 0;
+    do
     {
-        logError("Cannot write %ld to buffer of size %i", coord, buffer_size);
+        digits[digit_count++] = '0' + value % 10;
+        value /= 10;
     }
-    if (char_count < 0)
+    while (value > 0);
+    while (digit_count > 0)
     {
-        logError("Encoding error while writing %ld", coord);
+        *buffer++ = digits[--digit_count];
     }
-#endif // DEBUG
-    int end_pos = char_count; // the first character not to write any more
-    int trailing_zeros = 1;
-    while (trailing_zeros < 4 && buffer[char_count - trailing_zeros] == '0')
+    return buffer;
+}
+
+/*!
+ * Write the decimals of a fraction to a buffer, without the trailing zeros.
+ * 
+ * \param decimals The fraction multiplied by 10 to the power \p decimal_count, which shouldn't be zero
+ * \param decimal_count The number of decimals of the fraction
+ * \param buffer The buffer to write to, which should have room for \p decimal_count characters
+ * \return The end of the written characters
+ */
+static inline char* writeDecimals(uint64_t decimals, unsigned int decimal_count, char* buffer)
+{
+    while (decimals % 10 == 0)
     {
-        trailing_zeros++;
+        decimals /= 10;
+        decimal_count--;
     }
-    trailing_zeros--;
-    end_pos = char_count - trailing_zeros;
-    if (trailing_zeros == 3)
-    { // no need to write the decimal dot
-        buffer[char_count - trailing_zeros] = '\0';
-        ss << buffer;
-        return;
+    for (unsigned int digit = decimal_count; digit > 0; digit--)
+    {
+        buffer[digit - 1] = '0' + decimals % 10;
+        decimals /= 10;
     }
-    if (char_count <= 3)
+    return buffer + decimal_count;
+}
+
+/*!
+ * Efficient conversion of micron integer type to millimeter string.
+ * 
+ * Writes the coordinate with at most three decimals and without trailing
+ * zeros. Doesn't use the locale or any allocation, so that it can be used to
+ * write large amounts of g-code quickly.
+ * 
+ * \param coord The micron unit to convert
+ * \param buffer The buffer to write to, which should have room for 24 characters
+ * \return The end of the written characters
+ */
+static inline char* writeInt2mm(const int64_t coord, char* buffer)
+{
+    const uint64_t micron = (coord < 0) ? -static_cast<uint64_t>(coord) : coord;
+    const uint64_t whole = micron / 1000;
+    if (coord < 0)
     {
-        int start = 0; // where to start writing from the buffer
-        if (coord < 0)
-        {
-            ss << '-';
-            start = 1;
-        }
-        ss << "0.";
-        for (int nulls = char_count - start; nulls < 3; nulls++)
-        { // fill up to 3 decimals with zeros
-            ss << '0';
-        }
-        buffer[char_count - trailing_zeros] = '\0';
-        ss << (static_cast<char*>(buffer) + start);
+        *buffer++ = '-';
     }
-    else
+    if (coord >= 0 || micron < 100 || micron >= 1000)
+    { // coordinates from -0.999 up to -0.1 have always been written without the leading zero, e.g. as -.5
+        buffer = writeDigits(whole, buffer);
+    }
+    if (micron % 1000 != 0)
     {
-        char prev = '.';
-        int pos;
-        for (pos = char_count - 3; pos <= end_pos; pos++)
-        { // shift all characters and insert the decimal dot
-            char next_prev = buffer[pos];
-            buffer[pos] = prev;
-            prev = next_prev;
-        }
-        buffer[pos] = '\0';
-        ss << buffer;
+        *buffer++ = '.';
+        buffer = writeDecimals(micron % 1000, 3, buffer);
     }
+    return buffer;
+}
+
+/*!
+ * Efficient conversion of micron integer type to millimeter string.
+ * 
+ * \param coord The micron unit to convert
+ * \param ss The output stream to write the string to
+ */
+static inline void writeInt2mm(const int64_t coord, std::ostream& ss)
+{
+    char buffer[24];
+    ss.write(buffer, writeInt2mm(coord, buffer) - buffer);
 }
 
 /*!
@@ -105,29 +128,63 @@ struct MMtoStream
 
     friend inline std::ostream& operator<< (std::ostream& out, const MMtoStream precision_and_input)
     {
+        DeferredFormatBuffer* deferred = DeferredFormatBuffer::of(out);
+        if (deferred)
+        {
+            deferred->deferMM(precision_and_input.value);
+            return out;
+        }
         writeInt2mm(precision_and_input.value, out);
         return out;
     }
 };
 
 /*!
- * Efficient writing of a double to a stringstream
+ * Efficient writing of a double to a buffer
  * 
  * writes with \p precision digits after the decimal dot, but removes trailing zeros
  * 
+ * Writes the same as printf with "%.<precision>F" would, without the trailing
+ * zeros. Numbers up to 10^12 / 10^precision which aren't (nearly) halfway
+ * between two numbers with \p precision decimals are written without printf,
+ * which is several times faster and doesn't use the locale.
+ * 
  * \warning only works with precision up to 9 and input up to 10^14
  * 
  * \param precision The number of (non-zero) digits after the decimal dot
  * \param coord double to output
- * \param ss The output stream to write the string to
+ * \param buffer The buffer to write to, which should have room for 400 characters
+ * \return The end of the written characters
  */
-static inline void writeDoubleToStream(const unsigned int precision, const double coord, std::ostream& ss)
+static inline char* writeDoubleToBuffer(const unsigned int precision, const double coord, char* buffer)
 {
+    static constexpr double powers_of_ten[] = { 1e0, 1e1, 1e2, 1e3, 1e4, 1e5, 1e6, 1e7, 1e8, 1e9 };
+    if (precision < sizeof(powers_of_ten) / sizeof(double))
+    {
+        const double scaled = std::abs(coord) * powers_of_ten[precision]; // off by less than 10^-4 from the exact scaled value if below 10^12
+        const double fraction = scaled - std::floor(scaled);
+        if (scaled < 1e12 && std::abs(fraction - 0.5) > 1e-3) // so it rounds the same way as the exact value, which printf rounds
+        {
+            const uint64_t rounded = static_cast<uint64_t>(scaled + 0.5);
+            const uint64_t unit = static_cast<uint64_t>(powers_of_ten[precision]);
+            if (std::signbit(coord))
+            { // printf writes numbers which round to zero as -0 too
+                *buffer++ = '-';
+            }
+            buffer = writeDigits(rounded / unit, buffer);
+            if (rounded % unit != 0)
+            {
+                *buffer++ = '.';
+                buffer = writeDecimals(rounded % unit, precision, buffer);
+            }
+            return buffer;
+        }
+    }
+
     char format[5] = "%.xF"; // write a float with [x] digits after the dot
     format[2] = '0' + precision; // set [x]
     constexpr size_t buffer_size = 400;
-    char buffer[buffer_size];
-    int char_count = sprintf(buffer, format, coord);
+    int char_count = snprintf(buffer, buffer_size, format, coord);
 #ifdef DEBUG
     if (char_count + 1 >= int(buffer_size)) // + 1 for the null character
     {
@@ -140,9 +197,9 @@ static inline void writeDoubleToStream(const unsigned int precision, const doubl
 #endif // DEBUG
     if (char_count <= 0)
     {
-        return;
+        return buffer;
     }
-    if (buffer[char_count - precision - 1] == '.')
+    if (char_count > static_cast<int>(precision) && buffer[char_count - precision - 1] == '.')
     {
         int non_nul_pos = char_count - 1;
         while (buffer[non_nul_pos] == '0')
@@ -151,14 +208,28 @@ static inline void writeDoubleToStream(const unsigned int precision, const doubl
         }
         if (buffer[non_nul_pos] == '.')
         {
-            buffer[non_nul_pos] = '\0';
-        }
-        else
-        {
-            buffer[non_nul_pos + 1] = '\0';
+            return buffer + non_nul_pos;
         }
+        return buffer + non_nul_pos + 1;
     }
-    ss << buffer;
+    return buffer + char_count;
+}
+
+/*!
+ * Efficient writing of a double to a stringstream
+ * 
+ * writes with \p precision digits after the decimal dot, but removes trailing zeros
+ * 
+ * \warning only works with precision up to 9 and input up to 10^14
+ * 
+ * \param precision The number of (non-zero) digits after the decimal dot
+ * \param coord double to output
+ * \param ss The output stream to write the string to
+ */
+static inline void writeDoubleToStream(const unsigned int precision, const double coord, std::ostream& ss)
+{
+    char buffer[400];
+    ss.write(buffer, writeDoubleToBuffer(precision, coord, buffer) - buffer);
 }
 
 /*!
@@ -171,6 +242,12 @@ struct PrecisionedDouble
 
     friend inline std::ostream& operator<< (std::ostream& out, const PrecisionedDouble precision_and_input)
     {
+        DeferredFormatBuffer* deferred = DeferredFormatBuffer::of(out);
+        if (deferred)
+        {
+            deferred->deferDouble(precision_and_input.precision, precision_and_input.value);
+            return out;
+        }
         writeDoubleToStream(precision_and_input.precision, precision_and_input.value, out);
         return out;
     }
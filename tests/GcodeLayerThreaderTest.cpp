@@ -0,0 +1,151 @@
+//Copyright (c) 2018 Ultimaker B.V.
+//CuraEngine is released under the terms of the AGPLv3 or higher.
+
+#include <atomic>
+
+#include "GcodeLayerThreaderTest.h"
+
+namespace cura
+{
+
+CPPUNIT_TEST_SUITE_REGISTRATION(GcodeLayerThreaderTest);
+
+void GcodeLayerThreaderTest::consumeInOrder()
+{
+    std::vector<int> consumed;
+    const std::function<int* (int)> produce_item = [](int argument)
+        {
+            return new int(argument);
+        };
+    const std::function<void (int*)> consume_item = [&consumed](int* item)
+        {
+            consumed.push_back(*item); //Only one thread consumes at a time.
+            delete item;
+        };
+    GcodeLayerThreader<int> threader(-3, 100, produce_item, consume_item, 8);
+    threader.run();
+
+    CPPUNIT_ASSERT_EQUAL(size_t(103), consumed.size());
+    for (size_t item_idx = 0; item_idx < consumed.size(); item_idx++)
+    {
+        CPPUNIT_ASSERT_EQUAL(static_cast<int>(item_idx) - 3, consumed[item_idx]);
+    }
+}
+
+void GcodeLayerThreaderTest::limitActiveTasks()
+{
+    constexpr unsigned int max_task_count = 3;
+    std::atomic<int> active(0);
+    std::atomic<int> max_active(0);
+    const std::function<int* (int)> produce_item = [&active, &max_active](int argument)
+        {
+            const int now_active = ++active;
+            int previous_max = max_active;
+            while (now_active > previous_max && !max_active.compare_exchange_weak(previous_max, now_active)) {}
+            return new int(argument);
+        };
+    const std::function<void (int*)> consume_item = [&active](int* item)
+        {
+            --active;
+            delete item;
+        };
+    GcodeLayerThreader<int> threader(0, 50, produce_item, consume_item, max_task_count);
+    threader.run();
+
+    CPPUNIT_ASSERT_EQUAL(0, active.load());
+    CPPUNIT_ASSERT(max_active.load() >= 1);
+    CPPUNIT_ASSERT(max_active.load() <= static_cast<int>(max_task_count));
+}
+
+void GcodeLayerThreaderTest::noItems()
+{
+    int consumed_count = 0;
+    const std::function<int* (int)> produce_item = [](int argument)
+        {
+            return new int(argument);
+        };
+    const std::function<void (int*)> consume_item = [&consumed_count](int* item)
+        {
+            consumed_count++;
+            delete item;
+        };
+    GcodeLayerThreader<int> threader(5, 5, produce_item, consume_item, 4);
+    threader.run();
+
+    CPPUNIT_ASSERT_EQUAL(0, consumed_count);
+}
+
+void GcodeLayerThreaderTest::consumeInOrderWithMemoryBudget()
+{
+    std::vector<int> consumed;
+    const std::function<int* (int)> produce_item = [](int argument)
+        {
+            return new int(argument);
+        };
+    const std::function<void (int*)> consume_item = [&consumed](int* item)
+        {
+            consumed.push_back(*item);
+            delete item;
+        };
+    const std::function<size_t (const int*)> item_memory = [](const int* item)
+        {
+            return static_cast<size_t>(*item) * 100; //Items get larger than the budget.
+        };
+    GcodeLayerThreader<int> threader(0, 60, produce_item, consume_item, 60, item_memory, 1000);
+    threader.run();
+
+    CPPUNIT_ASSERT_EQUAL(size_t(60), consumed.size());
+    for (size_t item_idx = 0; item_idx < consumed.size(); item_idx++)
+    {
+        CPPUNIT_ASSERT_EQUAL(static_cast<int>(item_idx), consumed[item_idx]);
+    }
+}
+
+void GcodeLayerThreaderTest::memoryBudgetWindowLimitsMemory()
+{
+    MemoryBudgetWindow window(1000, 30);
+    window.start();
+    CPPUNIT_ASSERT_MESSAGE("Without an estimate yet, another item may start.", window.mayStart());
+    window.produced(300);
+    CPPUNIT_ASSERT_EQUAL(size_t(300), window.getEstimatedItemMemory());
+    window.start();
+    CPPUNIT_ASSERT_MESSAGE("300 produced and 2 items of about 300 expected fit in 1000.", window.mayStart());
+    window.start();
+    CPPUNIT_ASSERT_MESSAGE("300 produced and 3 items of about 300 expected don't fit in 1000.", !window.mayStart());
+
+    window.consumed(300);
+    CPPUNIT_ASSERT_MESSAGE("3 items of about 300 expected fit in 1000.", window.mayStart());
+
+    window.produced(700);
+    CPPUNIT_ASSERT_EQUAL(size_t((3 * 300 + 700) / 4), window.getEstimatedItemMemory());
+    CPPUNIT_ASSERT_MESSAGE("700 produced and 2 items of about 400 expected don't fit in 1000.", !window.mayStart());
+}
+
+void GcodeLayerThreaderTest::memoryBudgetWindowAlwaysAllowsOne()
+{
+    MemoryBudgetWindow window(1000, 30);
+    window.start();
+    window.produced(5000);
+    CPPUNIT_ASSERT(!window.mayStart());
+    window.consumed(5000);
+    CPPUNIT_ASSERT_MESSAGE("Nothing is active, so an item may start even if it's expected to exceed the budget.", window.mayStart());
+}
+
+void GcodeLayerThreaderTest::memoryBudgetWindowLimitsCount()
+{
+    MemoryBudgetWindow limited_window(1000000, 2);
+    limited_window.start();
+    limited_window.produced(10);
+    limited_window.start();
+    CPPUNIT_ASSERT(!limited_window.mayStart());
+
+    MemoryBudgetWindow unlimited_window(0, 3);
+    unlimited_window.start();
+    unlimited_window.produced(1000000);
+    unlimited_window.start();
+    CPPUNIT_ASSERT(unlimited_window.mayStart());
+    unlimited_window.start();
+    CPPUNIT_ASSERT(!unlimited_window.mayStart());
+}
+
+}
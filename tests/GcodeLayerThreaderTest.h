@@ -0,0 +1,76 @@
+//Copyright (c) 2018 Ultimaker B.V.
+//CuraEngine is released under the terms of the AGPLv3 or higher.
+
+#ifndef GCODELAYERTHREADERTEST_H
+#define GCODELAYERTHREADERTEST_H
+
+#include <cppunit/TestFixture.h>
+#include <cppunit/extensions/HelperMacros.h>
+
+#include "../src/GcodeLayerThreader.h" //The class we're testing.
+
+namespace cura
+{
+
+/*
+ * \brief Tests producing and consuming items with the GcodeLayerThreader.
+ */
+class GcodeLayerThreaderTest : public CppUnit::TestFixture
+{
+    CPPUNIT_TEST_SUITE(GcodeLayerThreaderTest);
+    CPPUNIT_TEST(consumeInOrder);
+    CPPUNIT_TEST(limitActiveTasks);
+    CPPUNIT_TEST(noItems);
+    CPPUNIT_TEST(consumeInOrderWithMemoryBudget);
+    CPPUNIT_TEST(memoryBudgetWindowLimitsMemory);
+    CPPUNIT_TEST(memoryBudgetWindowAlwaysAllowsOne);
+    CPPUNIT_TEST(memoryBudgetWindowLimitsCount);
+    CPPUNIT_TEST_SUITE_END();
+
+public:
+    /*
+     * \brief Tests whether all items are consumed exactly once, in the order
+     * of their arguments, also when the arguments don't start at zero.
+     */
+    void consumeInOrder();
+
+    /*
+     * \brief Tests whether no more items than the maximum task count are
+     * produced without having been consumed.
+     */
+    void limitActiveTasks();
+
+    /*
+     * \brief Tests whether running without any items to produce finishes.
+     */
+    void noItems();
+
+    /*
+     * \brief Tests whether all items are consumed in order when the memory
+     * the items use is limited.
+     */
+    void consumeInOrderWithMemoryBudget();
+
+    /*
+     * \brief Tests whether no item may be started if the expected memory of
+     * the active items would exceed the budget.
+     */
+    void memoryBudgetWindowLimitsMemory();
+
+    /*
+     * \brief Tests whether an item may always be started if nothing is
+     * active, even if it's larger than the budget.
+     */
+    void memoryBudgetWindowAlwaysAllowsOne();
+
+    /*
+     * \brief Tests whether the maximum number of active items still applies
+     * when the budget isn't reached, and whether a budget of 0 only limits the
+     * number of items.
+     */
+    void memoryBudgetWindowLimitsCount();
+};
+
+}
+
+#endif //GCODELAYERTHREADERTEST_H
@@ -0,0 +1,104 @@
+//Copyright (c) 2018 Ultimaker B.V.
+//CuraEngine is released under the terms of the AGPLv3 or higher.
+
+#include "MeshTest.h"
+
+namespace cura
+{
+
+CPPUNIT_TEST_SUITE_REGISTRATION(MeshTest);
+
+void MeshTest::setUp()
+{
+    matrix = FMatrix3x3();
+    matrix.m[0][0] = 0.0;
+    matrix.m[1][0] = -1.1;
+    matrix.m[0][1] = 1.1;
+    matrix.m[1][1] = 0.0;
+    matrix.m[2][2] = -0.9;
+}
+
+void MeshTest::applyMatrixBulk()
+{
+    const std::vector<float> coords = {0.0f, 0.0f, 0.0f, 12.3456f, -7.0005f, 3.14159f, -0.0004f, 0.0006f, 200.0f};
+    std::vector<Point3> result(coords.size() / 3);
+    matrix.apply(coords.data(), result.size(), result.data());
+
+    for (size_t point_idx = 0; point_idx < result.size(); point_idx++)
+    {
+        const FPoint3 point(coords[point_idx * 3], coords[point_idx * 3 + 1], coords[point_idx * 3 + 2]);
+        CPPUNIT_ASSERT(matrix.apply(point) == result[point_idx]);
+    }
+}
+
+void MeshTest::addFacesSameAsAddFace()
+{
+    const std::vector<float> vertex_data = {
+        0.0f, 0.0f, 0.0f,    10.0f, 0.0f, 0.0f,    0.0f, 10.0f, 0.0f,
+        10.0f, 0.0f, 0.0f,   10.0f, 10.0f, 0.0f,   0.0f, 10.0f, 0.0f,
+        0.0f, 0.0f, 0.0f,    0.01f, 0.0f, 0.0f,    0.0f, 10.0f, 0.0f, //Degenerate, since the first two vertices are melded.
+        0.0f, 0.0f, 0.0f,    10.0f, 0.0f, 0.0f,    5.0f, 5.0f, 10.0f,
+    };
+
+    Mesh expected;
+    addFacesSeparately(expected, vertex_data);
+    Mesh actual;
+    actual.addFaces(vertex_data.data(), vertex_data.size() / 9, matrix);
+
+    CPPUNIT_ASSERT_EQUAL(size_t(3), actual.faces.size());
+    CPPUNIT_ASSERT_EQUAL(size_t(5), actual.vertices.size());
+    assertSameMesh(expected, actual);
+}
+
+void MeshTest::addFacesManyBatches()
+{
+    //A strip of triangles that is long enough to need several batches.
+    constexpr size_t face_count = 10000;
+    std::vector<float> vertex_data;
+    vertex_data.reserve(face_count * 9);
+    for (size_t face_idx = 0; face_idx < face_count; face_idx++)
+    {
+        const float x = face_idx * 0.5f;
+        const float corners[9] = {x, 0.0f, 0.0f, x + 0.5f, 0.0f, 0.0f, x, 1.0f, 0.0f};
+        vertex_data.insert(vertex_data.end(), corners, corners + 9);
+    }
+
+    Mesh expected;
+    addFacesSeparately(expected, vertex_data);
+    Mesh actual;
+    actual.addFaces(vertex_data.data(), face_count, matrix);
+
+    CPPUNIT_ASSERT_EQUAL(face_count, actual.faces.size());
+    assertSameMesh(expected, actual);
+}
+
+void MeshTest::addFacesSeparately(Mesh& mesh, const std::vector<float>& vertex_data) const
+{
+    for (size_t face_idx = 0; face_idx < vertex_data.size() / 9; face_idx++)
+    {
+        const float* face = vertex_data.data() + face_idx * 9;
+        Point3 v0 = matrix.apply(FPoint3(face[0], face[1], face[2]));
+        Point3 v1 = matrix.apply(FPoint3(face[3], face[4], face[5]));
+        Point3 v2 = matrix.apply(FPoint3(face[6], face[7], face[8]));
+        mesh.addFace(v0, v1, v2);
+    }
+}
+
+void MeshTest::assertSameMesh(const Mesh& expected, const Mesh& actual) const
+{
+    CPPUNIT_ASSERT_EQUAL(expected.vertices.size(), actual.vertices.size());
+    for (size_t vertex_idx = 0; vertex_idx < expected.vertices.size(); vertex_idx++)
+    {
+        CPPUNIT_ASSERT(expected.vertices[vertex_idx].p == actual.vertices[vertex_idx].p);
+    }
+    CPPUNIT_ASSERT_EQUAL(expected.faces.size(), actual.faces.size());
+    for (size_t face_idx = 0; face_idx < expected.faces.size(); face_idx++)
+    {
+        for (size_t corner = 0; corner < 3; corner++)
+        {
+            CPPUNIT_ASSERT_EQUAL(expected.faces[face_idx].vertex_index[corner], actual.faces[face_idx].vertex_index[corner]);
+        }
+    }
+}
+
+}
@@ -0,0 +1,71 @@
+//Copyright (c) 2018 Ultimaker B.V.
+//CuraEngine is released under the terms of the AGPLv3 or higher.
+
+#ifndef MESHTEST_H
+#define MESHTEST_H
+
+#include <cppunit/TestFixture.h>
+#include <cppunit/extensions/HelperMacros.h>
+
+#include "../src/mesh.h" //The class we're testing.
+
+namespace cura
+{
+
+/*
+ * \brief Tests the routines of the Mesh class that add faces to it.
+ */
+class MeshTest : public CppUnit::TestFixture
+{
+    CPPUNIT_TEST_SUITE(MeshTest);
+    CPPUNIT_TEST(applyMatrixBulk);
+    CPPUNIT_TEST(addFacesSameAsAddFace);
+    CPPUNIT_TEST(addFacesManyBatches);
+    CPPUNIT_TEST_SUITE_END();
+
+public:
+    /*
+     * \brief Resets the fixtures for a new test.
+     */
+    void setUp();
+
+    /*
+     * \brief Tests whether applying a matrix to an array of floats gives the
+     * same points as applying it to each point separately.
+     */
+    void applyMatrixBulk();
+
+    /*
+     * \brief Tests whether adding faces in bulk gives the same mesh as adding
+     * each face separately, including melded vertices and skipped degenerate
+     * faces.
+     */
+    void addFacesSameAsAddFace();
+
+    /*
+     * \brief Tests adding more faces at once than are transformed in one
+     * batch.
+     */
+    void addFacesManyBatches();
+
+private:
+    /*
+     * \brief A rotation, scaling and mirroring like the front-end sends.
+     */
+    FMatrix3x3 matrix;
+
+    /*
+     * \brief Adds the faces to a mesh one by one, the way it was done before
+     * \ref Mesh::addFaces existed.
+     */
+    void addFacesSeparately(Mesh& mesh, const std::vector<float>& vertex_data) const;
+
+    /*
+     * \brief Asserts that two meshes have the same vertices and faces.
+     */
+    void assertSameMesh(const Mesh& expected, const Mesh& actual) const;
+};
+
+}
+
+#endif //MESHTEST_H
@@ -0,0 +1,200 @@
+//Copyright (c) 2018 Ultimaker B.V.
+//CuraEngine is released under the terms of the AGPLv3 or higher.
+
+#include <algorithm>
+#include <sstream>
+
+#include "PathOrderOptimizerTest.h"
+
+namespace cura
+{
+
+CPPUNIT_TEST_SUITE_REGISTRATION(PathOrderOptimizerTest);
+
+void PathOrderOptimizerTest::setUp()
+{
+    squares.clear();
+    lines.clear();
+    for (const coord_t x : { 10000, -11000, 32000, -40000 })
+    {
+        PolygonRef square = squares.newPoly();
+        square.add(Point(x, 0));
+        square.add(Point(x + 200, 0));
+        square.add(Point(x + 200, 200));
+        square.add(Point(x, 200));
+
+        PolygonRef line = lines.newPoly();
+        line.add(Point(x, 0));
+        line.add(Point(x, 1000));
+    }
+}
+
+coord_t PathOrderOptimizerTest::travelDistance(const PathOrderOptimizer& optimizer) const
+{
+    coord_t distance = 0;
+    Point position = optimizer.startPoint;
+    for (const int poly_idx : optimizer.polyOrder)
+    {
+        const Point start = (*optimizer.polygons[poly_idx])[optimizer.polyStart[poly_idx]];
+        distance += vSize(start - position);
+        position = start;
+    }
+    return distance;
+}
+
+coord_t PathOrderOptimizerTest::travelDistance(const LineOrderOptimizer& optimizer) const
+{
+    coord_t distance = 0;
+    Point position = optimizer.startPoint;
+    for (const int poly_idx : optimizer.polyOrder)
+    {
+        ConstPolygonRef line = *optimizer.polygons[poly_idx];
+        distance += vSize(line[optimizer.polyStart[poly_idx]] - position);
+        position = line[1 - optimizer.polyStart[poly_idx]];
+    }
+    return distance;
+}
+
+void PathOrderOptimizerTest::refinePolygonsShortensTravel()
+{
+    PathOrderOptimizer optimizer(Point(0, 0));
+    optimizer.addPolygons(squares);
+    optimizer.optimize();
+    const coord_t greedy_distance = travelDistance(optimizer);
+    const std::vector<int> greedy_start = optimizer.polyStart;
+
+    double time_left = 1.0;
+    optimizer.refine(time_left);
+
+    CPPUNIT_ASSERT_MESSAGE("The refinement must not take more than the given time.", time_left >= 0.0 && time_left <= 1.0);
+    CPPUNIT_ASSERT_MESSAGE("The starting points of the polygons must not change.", optimizer.polyStart == greedy_start);
+    std::vector<int> sorted_order = optimizer.polyOrder;
+    std::sort(sorted_order.begin(), sorted_order.end());
+    CPPUNIT_ASSERT_MESSAGE("Each polygon must be in the order exactly once.", sorted_order == std::vector<int>({ 0, 1, 2, 3 }));
+    const coord_t refined_distance = travelDistance(optimizer);
+    std::stringstream ss;
+    ss << "The refined travel distance " << refined_distance << " must be shorter than the greedy travel distance " << greedy_distance << ".";
+    CPPUNIT_ASSERT_MESSAGE(ss.str(), refined_distance < greedy_distance);
+}
+
+void PathOrderOptimizerTest::refinePolygonsWithoutTime()
+{
+    PathOrderOptimizer optimizer(Point(0, 0));
+    optimizer.addPolygons(squares);
+    optimizer.optimize();
+    const std::vector<int> greedy_order = optimizer.polyOrder;
+
+    double time_left = 0.0;
+    optimizer.refine(time_left);
+
+    CPPUNIT_ASSERT_MESSAGE("Without time, the order must not be changed.", optimizer.polyOrder == greedy_order);
+    CPPUNIT_ASSERT_EQUAL(0.0, time_left);
+}
+
+void PathOrderOptimizerTest::refineLinesShortensTravel()
+{
+    LineOrderOptimizer optimizer(Point(0, 0));
+    optimizer.addPolygons(lines);
+    optimizer.optimize();
+    const coord_t greedy_distance = travelDistance(optimizer);
+
+    double time_left = 1.0;
+    optimizer.refine(time_left);
+
+    std::vector<int> sorted_order = optimizer.polyOrder;
+    std::sort(sorted_order.begin(), sorted_order.end());
+    CPPUNIT_ASSERT_MESSAGE("Each line must be in the order exactly once.", sorted_order == std::vector<int>({ 0, 1, 2, 3 }));
+    for (const int start : optimizer.polyStart)
+    {
+        CPPUNIT_ASSERT_MESSAGE("Lines must start at one of their two vertices.", start == 0 || start == 1);
+    }
+    const coord_t refined_distance = travelDistance(optimizer);
+    std::stringstream ss;
+    ss << "The refined travel distance " << refined_distance << " must be shorter than the greedy travel distance " << greedy_distance << ".";
+    CPPUNIT_ASSERT_MESSAGE(ss.str(), refined_distance < greedy_distance);
+}
+
+void PathOrderOptimizerTest::combingDistanceCacheLookup()
+{
+    CombingDistanceCache cache;
+    float distance2 = 0;
+    CPPUNIT_ASSERT_MESSAGE("An empty cache must not contain any distances.", !cache.get(Point(0, 0), Point(1000, 0), distance2));
+
+    cache.set(Point(0, 0), Point(1000, 0), 4000000.0f);
+    CPPUNIT_ASSERT_MESSAGE("A stored distance must be found.", cache.get(Point(0, 0), Point(1000, 0), distance2));
+    CPPUNIT_ASSERT_EQUAL(4000000.0f, distance2);
+    CPPUNIT_ASSERT_MESSAGE("The distance of the reverse travel move was not stored.", !cache.get(Point(1000, 0), Point(0, 0), distance2));
+}
+
+void PathOrderOptimizerTest::sharedCombingDistanceCache()
+{
+    // a boundary with a wall in the middle, so that travel moves between the two halves need to comb around it
+    Polygons boundary;
+    PolygonRef outline = boundary.newPoly();
+    outline.add(Point(-50000, -10000));
+    outline.add(Point(50000, -10000));
+    outline.add(Point(50000, 10000));
+    outline.add(Point(-50000, 10000));
+    PolygonRef wall = boundary.newPoly();
+    wall.add(Point(-100, -5000));
+    wall.add(Point(-100, 10000));
+    wall.add(Point(100, 10000));
+    wall.add(Point(100, -5000));
+
+    LineOrderOptimizer reference(Point(0, 0), &boundary);
+    reference.addPolygons(lines);
+    reference.optimize();
+
+    LocToLineGrid* loc_to_line = PolygonUtils::createLocToLineGrid(boundary, LineOrderOptimizer::loc_to_line_grid_size);
+    CombingDistanceCache cache;
+    for (int repetition = 0; repetition < 2; repetition++) // the second time, the distances come from the cache
+    {
+        LineOrderOptimizer shared(Point(0, 0), &boundary, loc_to_line, &cache);
+        shared.addPolygons(lines);
+        shared.optimize();
+        CPPUNIT_ASSERT_MESSAGE("Sharing the grid and the cache must not change the order.", shared.polyOrder == reference.polyOrder);
+        CPPUNIT_ASSERT_MESSAGE("Sharing the grid and the cache must not change the starting points.", shared.polyStart == reference.polyStart);
+        CPPUNIT_ASSERT_MESSAGE("A shared grid must not be deleted by the optimizer.", shared.loc_to_line == loc_to_line);
+    }
+    delete loc_to_line;
+}
+
+void PathOrderOptimizerTest::seamCornerPreference()
+{
+    // a quadrangle with a notch, with one concave corner and one corner which is sharper than the others
+    const std::vector<Point> corners = { Point(0, 0), Point(10000, 0), Point(10000, 10000), Point(5000, 4000), Point(0, 8000) };
+    for (const coord_t subdivisions : { 1, 100 })
+    {
+        Polygons polygons;
+        PolygonRef poly = polygons.newPoly();
+        for (size_t corner_idx = 0; corner_idx < corners.size(); corner_idx++)
+        {
+            const Point& from = corners[corner_idx];
+            const Point& to = corners[(corner_idx + 1) % corners.size()];
+            for (coord_t step = 0; step < subdivisions; step++)
+            {
+                poly.add(from + (to - from) * step / subdivisions);
+            }
+        }
+
+        const std::vector<std::pair<ZSeamConfig, Point>> expected_seams = {
+            { ZSeamConfig(EZSeamType::SHARPEST_CORNER, Point(0, 0), EZSeamCornerPrefType::Z_SEAM_CORNER_PREF_INNER), Point(5000, 4000) },
+            { ZSeamConfig(EZSeamType::SHARPEST_CORNER, Point(0, 0), EZSeamCornerPrefType::Z_SEAM_CORNER_PREF_OUTER), Point(10000, 10000) },
+            { ZSeamConfig(EZSeamType::SHARPEST_CORNER, Point(0, 0), EZSeamCornerPrefType::Z_SEAM_CORNER_PREF_ANY), Point(10000, 10000) },
+            { ZSeamConfig(EZSeamType::SHORTEST, Point(0, 0), EZSeamCornerPrefType::Z_SEAM_CORNER_PREF_NONE), Point(0, 8000) },
+            { ZSeamConfig(EZSeamType::USER_SPECIFIED, Point(11000, -1000), EZSeamCornerPrefType::Z_SEAM_CORNER_PREF_NONE), Point(10000, 0) }
+        };
+        for (const std::pair<ZSeamConfig, Point>& expected_seam : expected_seams)
+        {
+            PathOrderOptimizer optimizer(Point(-1000, 9000), expected_seam.first);
+            optimizer.addPolygons(polygons);
+            optimizer.optimize();
+            const Point seam = poly[optimizer.polyStart[0]];
+            std::stringstream ss;
+            ss << "With " << subdivisions << " subdivisions, the seam must be at " << expected_seam.second << " rather than " << seam << ".";
+            CPPUNIT_ASSERT_MESSAGE(ss.str(), seam == expected_seam.second);
+        }
+    }
+}
+
+}
@@ -0,0 +1,102 @@
+//Copyright (c) 2018 Ultimaker B.V.
+//CuraEngine is released under the terms of the AGPLv3 or higher.
+
+#ifndef PATHORDEROPTIMIZERTEST_H
+#define PATHORDEROPTIMIZERTEST_H
+
+#include <cppunit/TestFixture.h>
+#include <cppunit/extensions/HelperMacros.h>
+
+#include "../src/pathOrderOptimizer.h" //The classes we're testing.
+
+namespace cura
+{
+
+/*
+ * \brief Tests the refinement of the orders found by the PathOrderOptimizer
+ * and the LineOrderOptimizer.
+ */
+class PathOrderOptimizerTest : public CppUnit::TestFixture
+{
+    CPPUNIT_TEST_SUITE(PathOrderOptimizerTest);
+    CPPUNIT_TEST(refinePolygonsShortensTravel);
+    CPPUNIT_TEST(refinePolygonsWithoutTime);
+    CPPUNIT_TEST(refineLinesShortensTravel);
+    CPPUNIT_TEST(combingDistanceCacheLookup);
+    CPPUNIT_TEST(sharedCombingDistanceCache);
+    CPPUNIT_TEST(seamCornerPreference);
+    CPPUNIT_TEST_SUITE_END();
+
+public:
+    /*
+     * \brief Resets the fixtures for a new test.
+     */
+    void setUp();
+
+    /*
+     * \brief Tests whether refining the greedy order of small squares on both
+     * sides of the start point shortens the total travel distance.
+     */
+    void refinePolygonsShortensTravel();
+
+    /*
+     * \brief Tests whether the order is left alone if there is no time left
+     * for the refinement.
+     */
+    void refinePolygonsWithoutTime();
+
+    /*
+     * \brief Tests whether refining the greedy order of short lines on both
+     * sides of the start point shortens the total travel distance and keeps
+     * every line in the order once.
+     */
+    void refineLinesShortensTravel();
+
+    /*
+     * \brief Tests whether stored combing distances are found again, for the
+     * direction in which they were stored only.
+     */
+    void combingDistanceCacheLookup();
+
+    /*
+     * \brief Tests whether line orders which share a grid and a cache of
+     * combing distances find the same order as a line order which doesn't.
+     */
+    void sharedCombingDistanceCache();
+
+    /*
+     * \brief Tests whether the seam is placed on the corner that the corner
+     * preference asks for, also when the edges of the polygon are densely
+     * subdivided.
+     */
+    void seamCornerPreference();
+
+private:
+    /*
+     * \brief Small squares, placed such that the greedy order zigzags around
+     * the origin.
+     */
+    Polygons squares;
+
+    /*
+     * \brief Short lines, placed such that the greedy order zigzags around
+     * the origin.
+     */
+    Polygons lines;
+
+    /*
+     * \brief Compute the total travel distance of the order found by a
+     * PathOrderOptimizer, starting at its start point.
+     */
+    coord_t travelDistance(const PathOrderOptimizer& optimizer) const;
+
+    /*
+     * \brief Compute the total travel distance of the order found by a
+     * LineOrderOptimizer, starting at its start point.
+     */
+    coord_t travelDistance(const LineOrderOptimizer& optimizer) const;
+};
+
+}
+
+#endif //PATHORDEROPTIMIZERTEST_H
@@ -251,4 +251,46 @@ void TimeEstimateCalculatorTest::diagonalLineNoJerk()
     );
 }
 
-} //namespace cura
\ No newline at end of file
+double TimeEstimateCalculatorTest::segmentedLineDuration(const double length, const size_t segment_count) const
+{
+    TimeEstimateCalculator line_calculator;
+    line_calculator.setFirmwareDefaults(always_50);
+    for (size_t segment = 1; segment <= segment_count; segment++)
+    {
+        line_calculator.plan(TimeEstimateCalculator::Position(length * segment / segment_count, 0, 0, 0), 50.0, PrintFeatureType::Infill);
+    }
+    return line_calculator.calculate()[static_cast<size_t>(PrintFeatureType::Infill)];
+}
+
+void TimeEstimateCalculatorTest::counterClockwiseArcOnlyJerk()
+{
+    calculator.setFirmwareDefaults(always_50);
+
+    //From the start at 0,0 around the center at 0,1000 to 1000,1000.
+    const TimeEstimateCalculator::Position destination(1000, 1000, 0, 0);
+    calculator.planArc(destination, 0, 1000, false, 50.0, PrintFeatureType::Infill);
+
+    const std::vector<Duration> result = calculator.calculate();
+    CPPUNIT_ASSERT_DOUBLES_EQUAL(
+        Duration(segmentedLineDuration(M_PI / 2 * 1000.0, 1570)), //A quarter of the circumference, in segments of about 1mm.
+        result[static_cast<size_t>(PrintFeatureType::Infill)],
+        0.01 //The deceleration at the end isn't exactly along a straight line.
+    );
+}
+
+void TimeEstimateCalculatorTest::clockwiseArcOnlyJerk()
+{
+    calculator.setFirmwareDefaults(always_50);
+
+    const TimeEstimateCalculator::Position destination(1000, 1000, 0, 0);
+    calculator.planArc(destination, 0, 1000, true, 50.0, PrintFeatureType::Infill);
+
+    const std::vector<Duration> result = calculator.calculate();
+    CPPUNIT_ASSERT_DOUBLES_EQUAL(
+        Duration(segmentedLineDuration(3 * M_PI / 2 * 1000.0, 4712)), //Three quarters of the circumference.
+        result[static_cast<size_t>(PrintFeatureType::Infill)],
+        0.01
+    );
+}
+
+} //namespace cura
@@ -26,6 +26,8 @@ class TimeEstimateCalculatorTest : public CppUnit::TestFixture
     CPPUNIT_TEST(singleLineNoJerk);
     CPPUNIT_TEST(doubleLineNoJerk);
     CPPUNIT_TEST(diagonalLineNoJerk);
+    CPPUNIT_TEST(counterClockwiseArcOnlyJerk);
+    CPPUNIT_TEST(clockwiseArcOnlyJerk);
     CPPUNIT_TEST_SUITE_END();
 
 public:
@@ -90,7 +92,29 @@ public:
      */
     void diagonalLineNoJerk();
 
+    /*
+     * \brief Tests printing a quarter circle counter-clockwise (G3) without
+     * acceleration.
+     *
+     * The arc is divided into segments of about a millimetre, which only turn
+     * a little from each other, so it should take as long as a straight line of
+     * the same length divided into as many segments.
+     */
+    void counterClockwiseArcOnlyJerk();
+
+    /*
+     * \brief Tests printing between the same points clockwise (G2), which goes
+     * three quarters around the circle instead.
+     */
+    void clockwiseArcOnlyJerk();
+
 private:
+    /*
+     * \brief Gives the time to print a straight line of the given length,
+     * divided into equal segments, with the always_50 settings.
+     */
+    double segmentedLineDuration(const double length, const size_t segment_count) const;
+
     /*
      * Fixture calculator that starts without any time or moves planned.
      */
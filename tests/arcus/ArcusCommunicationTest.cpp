@@ -132,6 +132,34 @@ namespace cura
         CPPUNIT_ASSERT_EQUAL(static_cast<float>(layer_thickness), message->thickness());
     }
 
+    void ArcusCommunicationTest::streamOptimizedLayersTest()
+    {
+        ac->private_data->object_count = 1;
+        ac->sendLayerComplete(0, 200, 200);
+        ac->sendLayerComplete(1, 400, 200);
+
+        ac->setLayerForSend(0);
+        ac->sendCurrentPosition(Point(0, 0));
+        ac->sendPolygon(PrintFeatureType::OuterWall, test_square, 400, 200, 30);
+        CPPUNIT_ASSERT_MESSAGE("A layer may not be sent while it is still being written.", socket->sent_messages.empty());
+
+        ac->setLayerForSend(1);
+        CPPUNIT_ASSERT_EQUAL_MESSAGE("Moving on to the next layer must send the completed layer.", size_t(1), socket->sent_messages.size());
+        const proto::LayerOptimized* message = dynamic_cast<proto::LayerOptimized*>(socket->sent_messages.back().get());
+        CPPUNIT_ASSERT(message);
+        CPPUNIT_ASSERT_EQUAL(google::protobuf::int32(0), message->id());
+        CPPUNIT_ASSERT_EQUAL(1, message->path_segment_size());
+        CPPUNIT_ASSERT_EQUAL_MESSAGE("The sent layer must not be kept in memory.", size_t(1), ac->private_data->optimized_layers.slice_data.size());
+
+        ac->sendPolygon(PrintFeatureType::InnerWall, test_triangle, 400, 200, 30);
+        ac->sendOptimizedLayerData();
+        CPPUNIT_ASSERT_EQUAL_MESSAGE("The last layer must be sent when slicing is done.", size_t(2), socket->sent_messages.size());
+        message = dynamic_cast<proto::LayerOptimized*>(socket->sent_messages.back().get());
+        CPPUNIT_ASSERT(message);
+        CPPUNIT_ASSERT_EQUAL(google::protobuf::int32(1), message->id());
+        CPPUNIT_ASSERT(ac->private_data->optimized_layers.slice_data.empty());
+    }
+
     void ArcusCommunicationTest::sendProgressTest()
     {
         ac->private_data->object_count = 2; //If there are two objects, all progress should get halved.
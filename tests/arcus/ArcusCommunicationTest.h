@@ -26,6 +26,7 @@ class ArcusCommunicationTest : public CppUnit::TestFixture
     CPPUNIT_TEST(sendGCodePrefixTest);
     CPPUNIT_TEST(sendFinishedSlicingTest);
     CPPUNIT_TEST(sendLayerCompleteTest);
+    CPPUNIT_TEST(streamOptimizedLayersTest);
     CPPUNIT_TEST(sendProgressTest);
     CPPUNIT_TEST_SUITE_END();
 
@@ -56,6 +57,7 @@ public:
     void sendGCodePrefixTest();
     void sendFinishedSlicingTest();
     void sendLayerCompleteTest();
+    void streamOptimizedLayersTest();
     void sendProgressTest();
 
 private:
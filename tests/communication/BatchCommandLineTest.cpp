@@ -0,0 +1,46 @@
+//Copyright (c) 2018 Ultimaker B.V.
+//CuraEngine is released under the terms of the AGPLv3 or higher.
+
+#include <sstream>
+
+#include "BatchCommandLineTest.h"
+#include "../src/communication/BatchCommandLine.h"
+
+namespace cura
+{
+
+CPPUNIT_TEST_SUITE_REGISTRATION(BatchCommandLineTest);
+
+void BatchCommandLineTest::readManifestJobs()
+{
+    std::istringstream manifest("-j printer.def.json -l part1.stl -o part1.gcode\n-j printer.def.json  -s layer_height=0.2\t-l part2.stl -o part2.gcode");
+    const std::vector<std::vector<std::string>> jobs = BatchCommandLine::readManifest(manifest);
+
+    CPPUNIT_ASSERT_EQUAL(size_t(2), jobs.size());
+    const std::vector<std::string> first_job = {"-j", "printer.def.json", "-l", "part1.stl", "-o", "part1.gcode"};
+    CPPUNIT_ASSERT(jobs[0] == first_job);
+    const std::vector<std::string> second_job = {"-j", "printer.def.json", "-s", "layer_height=0.2", "-l", "part2.stl", "-o", "part2.gcode"};
+    CPPUNIT_ASSERT(jobs[1] == second_job);
+}
+
+void BatchCommandLineTest::readManifestQuotes()
+{
+    std::istringstream manifest("-l \"my part.stl\" -s \"machine_start_gcode=G28 ;home\" -o \"\" -o out\" put\".gcode");
+    const std::vector<std::vector<std::string>> jobs = BatchCommandLine::readManifest(manifest);
+
+    CPPUNIT_ASSERT_EQUAL(size_t(1), jobs.size());
+    const std::vector<std::string> job = {"-l", "my part.stl", "-s", "machine_start_gcode=G28 ;home", "-o", "", "-o", "out put.gcode"};
+    CPPUNIT_ASSERT(jobs[0] == job);
+}
+
+void BatchCommandLineTest::readManifestSkipsCommentsAndEmptyLines()
+{
+    std::istringstream manifest("# The catalog parts.\r\n\r\n   \r\n-l part.stl -o part.gcode\r\n");
+    const std::vector<std::vector<std::string>> jobs = BatchCommandLine::readManifest(manifest);
+
+    CPPUNIT_ASSERT_EQUAL(size_t(1), jobs.size());
+    const std::vector<std::string> job = {"-l", "part.stl", "-o", "part.gcode"};
+    CPPUNIT_ASSERT(jobs[0] == job);
+}
+
+}
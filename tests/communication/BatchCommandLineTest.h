@@ -0,0 +1,42 @@
+//Copyright (c) 2018 Ultimaker B.V.
+//CuraEngine is released under the terms of the AGPLv3 or higher.
+
+#ifndef BATCHCOMMANDLINETEST_H
+#define BATCHCOMMANDLINETEST_H
+
+#include <cppunit/TestFixture.h>
+#include <cppunit/extensions/HelperMacros.h>
+
+namespace cura
+{
+
+class BatchCommandLineTest : public CppUnit::TestFixture
+{
+    CPPUNIT_TEST_SUITE(BatchCommandLineTest);
+    CPPUNIT_TEST(readManifestJobs);
+    CPPUNIT_TEST(readManifestQuotes);
+    CPPUNIT_TEST(readManifestSkipsCommentsAndEmptyLines);
+    CPPUNIT_TEST_SUITE_END();
+
+public:
+    /*!
+     * \brief Test that each line of a manifest becomes a job with its
+     * arguments.
+     */
+    void readManifestJobs();
+
+    /*!
+     * \brief Test that arguments between double quotes may contain spaces.
+     */
+    void readManifestQuotes();
+
+    /*!
+     * \brief Test that empty lines and comments don't become jobs, also with
+     * Windows line ends.
+     */
+    void readManifestSkipsCommentsAndEmptyLines();
+};
+
+}
+
+#endif //BATCHCOMMANDLINETEST_H
@@ -0,0 +1,76 @@
+//Copyright (c) 2018 Ultimaker B.V.
+//CuraEngine is released under the terms of the AGPLv3 or higher.
+
+#include <cstdio> //To remove the test file.
+#include <fstream> //To write the test file.
+
+#include "DaemonCommandLineTest.h"
+#include "../src/communication/DaemonCommandLine.h"
+
+namespace cura
+{
+
+CPPUNIT_TEST_SUITE_REGISTRATION(DaemonCommandLineTest);
+
+void DaemonCommandLineTest::downstreamSettingChanged()
+{
+    const std::vector<std::string> last_arguments = {"CuraEngine", "slice", "-j", "printer.def.json", "-s", "speed_print=60", "-l", "part.stl", "-s", "material_print_temperature=200", "-o", "part.gcode"};
+    const std::vector<std::string> arguments = {"CuraEngine", "slice", "-j", "printer.def.json", "-s", "speed_print=80", "-l", "part.stl", "-s", "material_print_temperature=200", "-o", "part.gcode"};
+    std::unordered_map<size_t, std::string> changed_settings;
+
+    CPPUNIT_ASSERT(DaemonCommandLine::findDownstreamChanges(last_arguments, arguments, changed_settings));
+    CPPUNIT_ASSERT_EQUAL(size_t(1), changed_settings.size());
+    CPPUNIT_ASSERT_EQUAL(std::string("speed_print=80"), changed_settings[5]);
+}
+
+void DaemonCommandLineTest::outputChanged()
+{
+    const std::vector<std::string> last_arguments = {"CuraEngine", "slice", "-j", "printer.def.json", "-l", "part.stl", "-o", "part.gcode"};
+    const std::vector<std::string> arguments = {"CuraEngine", "slice", "-z", "-j", "printer.def.json", "-l", "part.stl", "-o", "other.gcode", "-b4"};
+    std::unordered_map<size_t, std::string> changed_settings;
+
+    CPPUNIT_ASSERT(DaemonCommandLine::findDownstreamChanges(last_arguments, arguments, changed_settings));
+    CPPUNIT_ASSERT(changed_settings.empty());
+}
+
+void DaemonCommandLineTest::upstreamSettingChanged()
+{
+    const std::vector<std::string> last_arguments = {"CuraEngine", "slice", "-j", "printer.def.json", "-s", "layer_height=0.1", "-l", "part.stl", "-o", "part.gcode"};
+    const std::vector<std::string> changed_layer_height = {"CuraEngine", "slice", "-j", "printer.def.json", "-s", "layer_height=0.2", "-l", "part.stl", "-o", "part.gcode"};
+    const std::vector<std::string> added_speed = {"CuraEngine", "slice", "-j", "printer.def.json", "-s", "layer_height=0.1", "-s", "speed_print=80", "-l", "part.stl", "-o", "part.gcode"};
+    const std::vector<std::string> replaced_setting = {"CuraEngine", "slice", "-j", "printer.def.json", "-s", "speed_print=0.1", "-l", "part.stl", "-o", "part.gcode"};
+    std::unordered_map<size_t, std::string> changed_settings;
+
+    CPPUNIT_ASSERT(!DaemonCommandLine::findDownstreamChanges(last_arguments, changed_layer_height, changed_settings));
+    CPPUNIT_ASSERT(!DaemonCommandLine::findDownstreamChanges(last_arguments, added_speed, changed_settings));
+    CPPUNIT_ASSERT(!DaemonCommandLine::findDownstreamChanges(last_arguments, replaced_setting, changed_settings));
+}
+
+void DaemonCommandLineTest::modelChanged()
+{
+    const std::vector<std::string> last_arguments = {"CuraEngine", "slice", "-j", "printer.def.json", "-l", "part.stl", "-o", "part.gcode"};
+    const std::vector<std::string> arguments = {"CuraEngine", "slice", "-j", "printer.def.json", "-l", "other.stl", "-o", "part.gcode"};
+    std::unordered_map<size_t, std::string> changed_settings;
+
+    CPPUNIT_ASSERT(!DaemonCommandLine::findDownstreamChanges(last_arguments, arguments, changed_settings));
+}
+
+void DaemonCommandLineTest::inputFileChanged()
+{
+    const std::string model_file = "daemon_test_part.stl";
+    std::ofstream(model_file) << "solid part\n";
+    const std::vector<std::string> arguments = {"CuraEngine", "slice", "-j", "missing.def.json", "-s", "speed_print=60", "-l", model_file, "-o", "part.gcode"};
+    const std::unordered_map<std::string, CommandLine::FileStatus> statuses = DaemonCommandLine::getInputFileStatuses(arguments);
+
+    CPPUNIT_ASSERT_EQUAL(size_t(2), statuses.size());
+    CPPUNIT_ASSERT_EQUAL_MESSAGE("A missing file has no size.", int64_t(-1), statuses.at("missing.def.json").size);
+    CPPUNIT_ASSERT_EQUAL(int64_t(11), statuses.at(model_file).size);
+    const std::vector<std::string> other_settings = {"CuraEngine", "slice", "-j", "missing.def.json", "-s", "speed_print=80", "-l", model_file, "-o", "other.gcode"};
+    CPPUNIT_ASSERT_MESSAGE("Only the files are looked at.", DaemonCommandLine::getInputFileStatuses(other_settings) == statuses);
+
+    std::ofstream(model_file, std::ios::app) << "endsolid part\n";
+    CPPUNIT_ASSERT_MESSAGE("The edited model is noticed.", !(DaemonCommandLine::getInputFileStatuses(arguments) == statuses));
+    std::remove(model_file.c_str());
+}
+
+}
@@ -0,0 +1,58 @@
+//Copyright (c) 2018 Ultimaker B.V.
+//CuraEngine is released under the terms of the AGPLv3 or higher.
+
+#ifndef DAEMONCOMMANDLINETEST_H
+#define DAEMONCOMMANDLINETEST_H
+
+#include <cppunit/TestFixture.h>
+#include <cppunit/extensions/HelperMacros.h>
+
+namespace cura
+{
+
+class DaemonCommandLineTest : public CppUnit::TestFixture
+{
+    CPPUNIT_TEST_SUITE(DaemonCommandLineTest);
+    CPPUNIT_TEST(downstreamSettingChanged);
+    CPPUNIT_TEST(outputChanged);
+    CPPUNIT_TEST(upstreamSettingChanged);
+    CPPUNIT_TEST(modelChanged);
+    CPPUNIT_TEST(inputFileChanged);
+    CPPUNIT_TEST_SUITE_END();
+
+public:
+    /*!
+     * \brief Test that changing a setting that is only used when writing the
+     * g-code allows reusing the layer data, and reports the new value.
+     */
+    void downstreamSettingChanged();
+
+    /*!
+     * \brief Test that changing the arguments about the output allows reusing
+     * the layer data.
+     */
+    void outputChanged();
+
+    /*!
+     * \brief Test that changing a setting that affects the layer data, or
+     * adding a setting, doesn't allow reusing the layer data.
+     */
+    void upstreamSettingChanged();
+
+    /*!
+     * \brief Test that loading a different model doesn't allow reusing the
+     * layer data.
+     */
+    void modelChanged();
+
+    /*!
+     * \brief Test that the status of the model and JSON files of a job
+     * changes when a file is edited, but not when only the other arguments
+     * change.
+     */
+    void inputFileChanged();
+};
+
+}
+
+#endif //DAEMONCOMMANDLINETEST_H
@@ -0,0 +1,98 @@
+//Copyright (c) 2018 Ultimaker B.V.
+//CuraEngine is released under the terms of the AGPLv3 or higher.
+
+#include <algorithm>
+#include <cmath>
+
+#include "ArcFitterTest.h"
+
+namespace cura
+{
+
+CPPUNIT_TEST_SUITE_REGISTRATION(ArcFitterTest);
+
+std::vector<Point> ArcFitterTest::circlePoints(const coord_t radius, const size_t count, const double angle_step) const
+{
+    std::vector<Point> points;
+    for (size_t i = 0; i < count; i++)
+    {
+        points.emplace_back(std::llround(radius * std::cos(i * angle_step)), std::llround(radius * std::sin(i * angle_step)));
+    }
+    return points;
+}
+
+void ArcFitterTest::counterClockwiseCircle()
+{
+    const ArcFitter fitter(25);
+    const std::vector<Point> points = circlePoints(10000, 100, 1.5 * M_PI / 99); //Three quarters in 99 segments.
+
+    const std::vector<PathArc> arcs = fitter.fit(points);
+    CPPUNIT_ASSERT_EQUAL_MESSAGE("All points lie on a single arc.", size_t(1), arcs.size());
+    CPPUNIT_ASSERT_EQUAL(size_t(0), arcs[0].start_idx);
+    CPPUNIT_ASSERT_EQUAL(size_t(99), arcs[0].end_idx);
+    CPPUNIT_ASSERT_MESSAGE("The center must be close to the center of the circle.", vSize(arcs[0].center) <= 25);
+    CPPUNIT_ASSERT_MESSAGE("The points go counter-clockwise.", !arcs[0].clockwise);
+}
+
+void ArcFitterTest::clockwiseCircle()
+{
+    const ArcFitter fitter(25);
+    std::vector<Point> points = circlePoints(10000, 100, 1.5 * M_PI / 99);
+    std::reverse(points.begin(), points.end());
+
+    const std::vector<PathArc> arcs = fitter.fit(points);
+    CPPUNIT_ASSERT_EQUAL_MESSAGE("All points lie on a single arc.", size_t(1), arcs.size());
+    CPPUNIT_ASSERT_EQUAL(size_t(0), arcs[0].start_idx);
+    CPPUNIT_ASSERT_EQUAL(size_t(99), arcs[0].end_idx);
+    CPPUNIT_ASSERT_MESSAGE("The center must be close to the center of the circle.", vSize(arcs[0].center) <= 25);
+    CPPUNIT_ASSERT_MESSAGE("The points go clockwise.", arcs[0].clockwise);
+}
+
+void ArcFitterTest::straightLine()
+{
+    const ArcFitter fitter(25);
+    std::vector<Point> points;
+    for (coord_t x = 0; x < 20000; x += 1000)
+    {
+        points.emplace_back(x, 500);
+    }
+
+    CPPUNIT_ASSERT_MESSAGE("A straight line isn't an arc.", fitter.fit(points).empty());
+}
+
+void ArcFitterTest::zigzag()
+{
+    const ArcFitter fitter(25);
+    std::vector<Point> points;
+    for (coord_t x = 0; x < 20000; x += 1000)
+    {
+        points.emplace_back(x, (x / 1000) % 2 == 0 ? 0 : 1000);
+    }
+
+    CPPUNIT_ASSERT_MESSAGE("A zigzag isn't an arc.", fitter.fit(points).empty());
+}
+
+void ArcFitterTest::tooFewSegments()
+{
+    const ArcFitter fitter(25, MM2INT(1000), 3);
+    const std::vector<Point> points = circlePoints(10000, 3, 0.1); //Only two segments.
+
+    CPPUNIT_ASSERT_MESSAGE("Two segments are too few to replace by an arc.", fitter.fit(points).empty());
+}
+
+void ArcFitterTest::deviatingPoint()
+{
+    const ArcFitter fitter(25);
+    std::vector<Point> points = circlePoints(10000, 100, 1.5 * M_PI / 99);
+    constexpr size_t deviating_idx = 50;
+    points[deviating_idx] = points[deviating_idx] * 1.01; //100 micron outward.
+
+    const std::vector<PathArc> arcs = fitter.fit(points);
+    CPPUNIT_ASSERT_MESSAGE("The other points still lie on arcs.", !arcs.empty());
+    for (const PathArc& arc : arcs)
+    {
+        CPPUNIT_ASSERT_MESSAGE("The deviating point can't be part of an arc.", deviating_idx < arc.start_idx || deviating_idx > arc.end_idx);
+    }
+}
+
+}
@@ -0,0 +1,79 @@
+//Copyright (c) 2018 Ultimaker B.V.
+//CuraEngine is released under the terms of the AGPLv3 or higher.
+
+#ifndef ARCFITTERTEST_H
+#define ARCFITTERTEST_H
+
+#include <cppunit/TestFixture.h>
+#include <cppunit/extensions/HelperMacros.h>
+
+#include "../src/pathPlanning/ArcFitter.h" //The class we're testing.
+
+namespace cura
+{
+
+/*
+ * \brief Tests finding the runs of points of a path which lie on arcs.
+ */
+class ArcFitterTest : public CppUnit::TestFixture
+{
+    CPPUNIT_TEST_SUITE(ArcFitterTest);
+    CPPUNIT_TEST(counterClockwiseCircle);
+    CPPUNIT_TEST(clockwiseCircle);
+    CPPUNIT_TEST(straightLine);
+    CPPUNIT_TEST(zigzag);
+    CPPUNIT_TEST(tooFewSegments);
+    CPPUNIT_TEST(deviatingPoint);
+    CPPUNIT_TEST_SUITE_END();
+
+public:
+    /*
+     * \brief Tests whether the points along three quarters of a circle are
+     * written as a single counter-clockwise arc with the right center.
+     */
+    void counterClockwiseCircle();
+
+    /*
+     * \brief Tests whether the same points in reverse are written as a single
+     * clockwise arc.
+     */
+    void clockwiseCircle();
+
+    /*
+     * \brief Tests whether points on a straight line are left as line
+     * segments.
+     */
+    void straightLine();
+
+    /*
+     * \brief Tests whether points which go back and forth are left as line
+     * segments.
+     */
+    void zigzag();
+
+    /*
+     * \brief Tests whether too short runs of points on a circle are left as
+     * line segments.
+     */
+    void tooFewSegments();
+
+    /*
+     * \brief Tests whether a point which is further from the circle than the
+     * maximum deviation is not part of any arc.
+     */
+    void deviatingPoint();
+
+private:
+    /*
+     * \brief Makes points on a circle around 0,0.
+     * \param radius The radius of the circle.
+     * \param count How many points to make.
+     * \param angle_step The angle between consecutive points, in radians.
+     * Positive goes counter-clockwise.
+     */
+    std::vector<Point> circlePoints(const coord_t radius, const size_t count, const double angle_step) const;
+};
+
+}
+
+#endif //ARCFITTERTEST_H
@@ -0,0 +1,98 @@
+//Copyright (c) 2018 Ultimaker B.V.
+//CuraEngine is released under the terms of the AGPLv3 or higher.
+
+#include <cmath>
+#include <sstream>
+
+#include "LinePolygonsCrossingsTest.h"
+
+namespace cura
+{
+
+CPPUNIT_TEST_SUITE_REGISTRATION(LinePolygonsCrossingsTest);
+
+void LinePolygonsCrossingsTest::setUp()
+{
+    boundary.clear();
+    PolygonRef outline = boundary.newPoly();
+    outline.add(Point(0, 0));
+    outline.add(Point(40000, 0));
+    outline.add(Point(40000, 40000));
+    outline.add(Point(0, 40000));
+    constexpr unsigned int hole_point_count = 32;
+    for (coord_t x = 5000; x < 40000; x += 10000)
+    {
+        for (coord_t y = 5000; y < 40000; y += 10000)
+        {
+            PolygonRef hole = boundary.newPoly(); //Holes are clockwise.
+            for (unsigned int point_idx = hole_point_count; point_idx > 0; point_idx--)
+            {
+                const double angle = 2 * M_PI * point_idx / hole_point_count;
+                hole.add(Point(x + 3000 * std::cos(angle), y + 3000 * std::sin(angle)));
+            }
+        }
+    }
+    PolygonRef island = boundary.newPoly(); //An island in the first hole, which is not part of the outline's part.
+    island.add(Point(4000, 4000));
+    island.add(Point(6000, 4000));
+    island.add(Point(6000, 6000));
+    island.add(Point(4000, 6000));
+
+    loc_to_line = PolygonUtils::createLocToLineGrid(boundary, 500);
+    boundary_copy = boundary;
+    copy_loc_to_line = PolygonUtils::createLocToLineGrid(boundary_copy, 500);
+}
+
+void LinePolygonsCrossingsTest::tearDown()
+{
+    delete loc_to_line;
+    delete copy_loc_to_line;
+}
+
+void LinePolygonsCrossingsTest::gridOverBoundary()
+{
+    checkSamePaths(boundary, nullptr);
+}
+
+void LinePolygonsCrossingsTest::gridOverPart()
+{
+    //The part of the outline is all polygons except the island.
+    std::vector<unsigned int> part_poly_indices;
+    Polygons part;
+    for (unsigned int poly_idx = boundary.size() - 1; poly_idx > 0; poly_idx--) //Reversed, so that the indices in the part differ from those in the grid.
+    {
+        part_poly_indices.push_back(poly_idx - 1);
+        part.add(boundary[poly_idx - 1]);
+    }
+    checkSamePaths(part, &part_poly_indices);
+}
+
+void LinePolygonsCrossingsTest::checkSamePaths(const Polygons& comb_boundary, const std::vector<unsigned int>* grid_poly_indices)
+{
+    const std::vector<Point> points = { Point(1000, 1000), Point(39000, 39000), Point(1000, 25000), Point(20000, 9000), Point(39000, 1000), Point(9000, 15000), Point(25000, 31000) };
+    for (const Point& start : points)
+    {
+        for (const Point& end : points)
+        {
+            if (start == end)
+            {
+                continue;
+            }
+            CombPath path;
+            const bool success = LinePolygonsCrossings::comb(comb_boundary, *loc_to_line, start, end, path, -40, 0, false, grid_poly_indices);
+            CombPath expected_path;
+            const bool expected_success = LinePolygonsCrossings::comb(comb_boundary, *copy_loc_to_line, start, end, expected_path, -40, 0, false);
+
+            std::stringstream ss;
+            ss << "Combing from " << start << " to " << end << " must give the same path with and without using the grid to find crossings.";
+            CPPUNIT_ASSERT_EQUAL_MESSAGE(ss.str(), expected_success, success);
+            CPPUNIT_ASSERT_EQUAL_MESSAGE(ss.str(), expected_path.size(), path.size());
+            for (unsigned int point_idx = 0; point_idx < path.size(); point_idx++)
+            {
+                CPPUNIT_ASSERT_MESSAGE(ss.str(), expected_path[point_idx] == path[point_idx]);
+            }
+        }
+    }
+}
+
+}
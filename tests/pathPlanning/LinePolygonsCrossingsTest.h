@@ -0,0 +1,83 @@
+//Copyright (c) 2018 Ultimaker B.V.
+//CuraEngine is released under the terms of the AGPLv3 or higher.
+
+#ifndef LINEPOLYGONSCROSSINGSTEST_H
+#define LINEPOLYGONSCROSSINGSTEST_H
+
+#include <cppunit/TestFixture.h>
+#include <cppunit/extensions/HelperMacros.h>
+
+#include "../src/pathPlanning/LinePolygonsCrossings.h" //The class we're testing.
+
+namespace cura
+{
+
+/*
+ * \brief Tests whether combing with the line segments found in the grid over
+ * the boundary gives the same paths as combing with all line segments of the
+ * boundary.
+ */
+class LinePolygonsCrossingsTest : public CppUnit::TestFixture
+{
+    CPPUNIT_TEST_SUITE(LinePolygonsCrossingsTest);
+    CPPUNIT_TEST(gridOverBoundary);
+    CPPUNIT_TEST(gridOverPart);
+    CPPUNIT_TEST_SUITE_END();
+
+public:
+    /*
+     * \brief Resets the fixtures for a new test.
+     */
+    void setUp();
+
+    /*
+     * \brief Releases the grids of the fixtures.
+     */
+    void tearDown();
+
+    /*
+     * \brief Tests combing with a grid over the boundary itself.
+     */
+    void gridOverBoundary();
+
+    /*
+     * \brief Tests combing within a part of the polygons of a grid, given the
+     * indices of the polygons of the part in the polygons of the grid.
+     */
+    void gridOverPart();
+
+private:
+    /*
+     * \brief A square with a grid of round holes, with an island in one of
+     * the holes.
+     */
+    Polygons boundary;
+
+    /*
+     * \brief A grid over LinePolygonsCrossingsTest::boundary.
+     */
+    LocToLineGrid* loc_to_line;
+
+    /*
+     * \brief A copy of LinePolygonsCrossingsTest::boundary.
+     *
+     * Since a grid over this copy is not over the boundary, combing in the
+     * boundary with this grid has to check all line segments.
+     */
+    Polygons boundary_copy;
+
+    /*
+     * \brief A grid over LinePolygonsCrossingsTest::boundary_copy.
+     */
+    LocToLineGrid* copy_loc_to_line;
+
+    /*
+     * \brief Comb between a number of pairs of points with both grids and
+     * check whether the paths are the same.
+     */
+    void checkSamePaths(const Polygons& boundary, const std::vector<unsigned int>* grid_poly_indices);
+};
+
+}
+
+#endif //LINEPOLYGONSCROSSINGSTEST_H
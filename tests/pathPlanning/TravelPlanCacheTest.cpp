@@ -0,0 +1,118 @@
+//Copyright (c) 2018 Ultimaker B.V.
+//CuraEngine is released under the terms of the AGPLv3 or higher.
+
+#include "TravelPlanCacheTest.h"
+#include "../src/pathOrderOptimizer.h"
+
+namespace cura
+{
+
+CPPUNIT_TEST_SUITE_REGISTRATION(TravelPlanCacheTest);
+
+void TravelPlanCacheTest::setUp()
+{
+    squares.clear();
+    for (coord_t x : {0, 20000, 10000})
+    {
+        PolygonRef square = squares.newPoly();
+        square.add(Point(x, 0));
+        square.add(Point(x + 5000, 0));
+        square.add(Point(x + 5000, 5000));
+        square.add(Point(x, 5000));
+    }
+}
+
+GeometryHash TravelPlanCacheTest::key(const int i) const
+{
+    return GeometryHash().add(i);
+}
+
+void TravelPlanCacheTest::optimizeSquares(const Point start, TravelPlanCache* cache, std::vector<int>& poly_start, std::vector<int>& poly_order) const
+{
+    PathOrderOptimizer optimizer(start);
+    optimizer.setTravelPlanCache(cache);
+    optimizer.addPolygons(squares);
+    optimizer.optimize();
+    poly_start = optimizer.polyStart;
+    poly_order = optimizer.polyOrder;
+}
+
+void TravelPlanCacheTest::storedOrderIsFound()
+{
+    TravelPlanCache cache;
+    cache.setOrder(key(1), {2, 0}, {1, 0});
+
+    std::vector<int> poly_start;
+    std::vector<int> poly_order;
+    CPPUNIT_ASSERT_MESSAGE("Nothing was stored under this key.", !cache.getOrder(key(2), poly_start, poly_order));
+    CPPUNIT_ASSERT_MESSAGE("An order was stored under this key.", cache.getOrder(key(1), poly_start, poly_order));
+    CPPUNIT_ASSERT(poly_start == std::vector<int>({2, 0}));
+    CPPUNIT_ASSERT(poly_order == std::vector<int>({1, 0}));
+}
+
+void TravelPlanCacheTest::oldGenerationIsDropped()
+{
+    TravelPlanCache cache(2, 2);
+    for (int i = 0; i < 5; i++) //Fills two generations and starts a third.
+    {
+        cache.setOrder(key(i), {i}, {0});
+    }
+
+    std::vector<int> poly_start;
+    std::vector<int> poly_order;
+    CPPUNIT_ASSERT_MESSAGE("The first generation must have been dropped.", !cache.getOrder(key(0), poly_start, poly_order));
+    CPPUNIT_ASSERT_MESSAGE("The first generation must have been dropped.", !cache.getOrder(key(1), poly_start, poly_order));
+    for (int i = 2; i < 5; i++)
+    {
+        CPPUNIT_ASSERT_MESSAGE("The last two generations must be kept.", cache.getOrder(key(i), poly_start, poly_order));
+        CPPUNIT_ASSERT_EQUAL(i, poly_start[0]);
+    }
+}
+
+void TravelPlanCacheTest::usedEntrySurvives()
+{
+    TravelPlanCache cache(2, 2);
+    cache.setOrder(key(0), {0}, {0});
+    cache.setOrder(key(1), {1}, {0});
+    cache.setOrder(key(2), {2}, {0}); //Key 0 and 1 are now in the previous generation.
+
+    std::vector<int> poly_start;
+    std::vector<int> poly_order;
+    CPPUNIT_ASSERT(cache.getOrder(key(0), poly_start, poly_order)); //Moves key 0 to the current generation.
+    cache.setOrder(key(3), {3}, {0}); //Drops the generation which held key 1.
+
+    CPPUNIT_ASSERT_MESSAGE("The entry which was looked up must have been kept.", cache.getOrder(key(0), poly_start, poly_order));
+    CPPUNIT_ASSERT_EQUAL(0, poly_start[0]);
+    CPPUNIT_ASSERT_MESSAGE("The entry which wasn't looked up must have been dropped.", !cache.getOrder(key(1), poly_start, poly_order));
+}
+
+void TravelPlanCacheTest::cachedOrderMatchesOptimized()
+{
+    std::vector<int> expected_start;
+    std::vector<int> expected_order;
+    optimizeSquares(Point(-1000, 0), nullptr, expected_start, expected_order);
+
+    TravelPlanCache cache;
+    for (int repetition = 0; repetition < 2; repetition++) //The second time the order comes from the cache.
+    {
+        std::vector<int> poly_start;
+        std::vector<int> poly_order;
+        optimizeSquares(Point(-1000, 0), &cache, poly_start, poly_order);
+        CPPUNIT_ASSERT(poly_start == expected_start);
+        CPPUNIT_ASSERT(poly_order == expected_order);
+    }
+}
+
+void TravelPlanCacheTest::differentInputIsNotReused()
+{
+    TravelPlanCache cache;
+    std::vector<int> poly_start;
+    std::vector<int> poly_order;
+    optimizeSquares(Point(-1000, 0), &cache, poly_start, poly_order);
+    CPPUNIT_ASSERT(poly_order == std::vector<int>({0, 2, 1}));
+
+    optimizeSquares(Point(30000, 0), &cache, poly_start, poly_order);
+    CPPUNIT_ASSERT_MESSAGE("From the other side the squares must be printed in the reverse order.", poly_order == std::vector<int>({1, 2, 0}));
+}
+
+}
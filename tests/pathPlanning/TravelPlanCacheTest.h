@@ -0,0 +1,83 @@
+//Copyright (c) 2018 Ultimaker B.V.
+//CuraEngine is released under the terms of the AGPLv3 or higher.
+
+#ifndef TRAVELPLANCACHETEST_H
+#define TRAVELPLANCACHETEST_H
+
+#include <cppunit/TestFixture.h>
+#include <cppunit/extensions/HelperMacros.h>
+
+#include "../src/pathPlanning/TravelPlanCache.h" //The class we're testing.
+
+namespace cura
+{
+
+/*
+ * \brief Tests storing and reusing orders in the travel plan cache.
+ */
+class TravelPlanCacheTest : public CppUnit::TestFixture
+{
+    CPPUNIT_TEST_SUITE(TravelPlanCacheTest);
+    CPPUNIT_TEST(storedOrderIsFound);
+    CPPUNIT_TEST(oldGenerationIsDropped);
+    CPPUNIT_TEST(usedEntrySurvives);
+    CPPUNIT_TEST(cachedOrderMatchesOptimized);
+    CPPUNIT_TEST(differentInputIsNotReused);
+    CPPUNIT_TEST_SUITE_END();
+
+public:
+    /*
+     * \brief Resets the fixtures for a new test.
+     */
+    void setUp();
+
+    /*
+     * \brief Tests whether an order is found under the key it was stored with,
+     * and not under another key.
+     */
+    void storedOrderIsFound();
+
+    /*
+     * \brief Tests whether the oldest entries are dropped once two generations
+     * are full.
+     */
+    void oldGenerationIsDropped();
+
+    /*
+     * \brief Tests whether an entry which is looked up is kept when its
+     * generation is dropped.
+     */
+    void usedEntrySurvives();
+
+    /*
+     * \brief Tests whether optimizing the same polygons twice with a cache
+     * gives the same order as optimizing them without a cache.
+     */
+    void cachedOrderMatchesOptimized();
+
+    /*
+     * \brief Tests whether the order of the same polygons from another start
+     * point is computed instead of taken from the cache.
+     */
+    void differentInputIsNotReused();
+
+private:
+    /*
+     * \brief Three squares in a row.
+     */
+    Polygons squares;
+
+    /*
+     * \brief Makes a key which differs for each \p i.
+     */
+    GeometryHash key(const int i) const;
+
+    /*
+     * \brief Orders the squares from the given start point.
+     */
+    void optimizeSquares(const Point start, TravelPlanCache* cache, std::vector<int>& poly_start, std::vector<int>& poly_order) const;
+};
+
+}
+
+#endif //TRAVELPLANCACHETEST_H
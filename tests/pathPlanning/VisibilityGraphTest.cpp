@@ -0,0 +1,156 @@
+//Copyright (c) 2018 Ultimaker B.V.
+//CuraEngine is released under the terms of the AGPLv3 or higher.
+
+#include <sstream>
+
+#include "VisibilityGraphTest.h"
+
+namespace cura
+{
+
+CPPUNIT_TEST_SUITE_REGISTRATION(VisibilityGraphTest);
+
+void VisibilityGraphTest::setUp()
+{
+    square_with_hole.clear();
+    PolygonRef outline = square_with_hole.newPoly();
+    outline.add(Point(0, 0));
+    outline.add(Point(10000, 0));
+    outline.add(Point(10000, 10000));
+    outline.add(Point(0, 10000));
+    PolygonRef hole = square_with_hole.newPoly(); //Holes are clockwise.
+    hole.add(Point(4000, 4000));
+    hole.add(Point(4000, 6000));
+    hole.add(Point(6000, 6000));
+    hole.add(Point(6000, 4000));
+    PolygonRef corner_hole = square_with_hole.newPoly();
+    corner_hole.add(Point(8000, 8000));
+    corner_hole.add(Point(8000, 9000));
+    corner_hole.add(Point(9000, 9000));
+    corner_hole.add(Point(9000, 8000));
+    square_with_hole_loc_to_line = PolygonUtils::createLocToLineGrid(square_with_hole, 1000);
+
+    u_shape.clear();
+    PolygonRef u = u_shape.newPoly();
+    u.add(Point(0, 0));
+    u.add(Point(10000, 0));
+    u.add(Point(10000, 10000));
+    u.add(Point(6000, 10000));
+    u.add(Point(6000, 2000)); //Concave corner.
+    u.add(Point(4000, 2000)); //Concave corner.
+    u.add(Point(4000, 10000));
+    u.add(Point(0, 10000));
+    u_shape_loc_to_line = PolygonUtils::createLocToLineGrid(u_shape, 1000);
+}
+
+void VisibilityGraphTest::tearDown()
+{
+    delete square_with_hole_loc_to_line;
+    delete u_shape_loc_to_line;
+}
+
+void VisibilityGraphTest::onlyCornersOfObstaclesAreNodes()
+{
+    VisibilityGraph square_graph(square_with_hole, {0, 1, 2}, *square_with_hole_loc_to_line, -40);
+    CPPUNIT_ASSERT_EQUAL_MESSAGE("Nodes are only created when a path needs them.", size_t(0), square_graph.nodeCount());
+    CombPath square_path;
+    square_graph.findPath(Point(1000, 5500), Point(9000, 5500), square_path);
+    CPPUNIT_ASSERT_EQUAL_MESSAGE("Only the corners of the hole in the middle are in the way, and the outline has no concave corners.", size_t(4), square_graph.nodeCount());
+
+    VisibilityGraph u_graph(u_shape, {0}, *u_shape_loc_to_line, -40);
+    CombPath u_path;
+    u_graph.findPath(Point(2000, 9000), Point(8000, 9000), u_path);
+    CPPUNIT_ASSERT_EQUAL_MESSAGE("Only the bottom corners of the notch are concave.", size_t(2), u_graph.nodeCount());
+}
+
+void VisibilityGraphTest::directPath()
+{
+    VisibilityGraph graph(square_with_hole, {0, 1, 2}, *square_with_hole_loc_to_line, -40);
+    const Point start(1000, 1000);
+    const Point end(9000, 2000);
+    CombPath path;
+    CPPUNIT_ASSERT_MESSAGE("The points see each other, so there must be a path.", graph.findPath(start, end, path));
+    CPPUNIT_ASSERT_EQUAL_MESSAGE("A direct path has no bends.", size_t(2), path.size());
+    checkPath(path, start, end, *square_with_hole_loc_to_line);
+}
+
+void VisibilityGraphTest::pathAroundHole()
+{
+    VisibilityGraph graph(square_with_hole, {0, 1, 2}, *square_with_hole_loc_to_line, -40);
+    const Point start(1000, 5500);
+    const Point end(9000, 5500);
+    CombPath path;
+    CPPUNIT_ASSERT_MESSAGE("The points are in the same part, so there must be a path.", graph.findPath(start, end, path));
+    checkPath(path, start, end, *square_with_hole_loc_to_line);
+    CPPUNIT_ASSERT_EQUAL_MESSAGE("The shortest path bends around the two corners of the hole closest to the points.", size_t(4), path.size());
+    CPPUNIT_ASSERT_MESSAGE("The path must go around the top of the hole, which is closer.", path[1].Y > 6000 && path[2].Y > 6000);
+
+    //The shortest path is start -> (4000, 6000) -> (6000, 6000) -> end, apart from the offset of the corners.
+    const coord_t shortest_length = 2 * vSize(Point(3000, 500)) + 2000;
+    std::stringstream ss;
+    ss << "The path length " << pathLength(path) << " must be about the shortest length " << shortest_length << ".";
+    CPPUNIT_ASSERT_MESSAGE(ss.str(), std::abs(pathLength(path) - shortest_length) < 200);
+}
+
+void VisibilityGraphTest::pathAroundNotch()
+{
+    VisibilityGraph graph(u_shape, {0}, *u_shape_loc_to_line, -40);
+    const Point start(2000, 9000);
+    const Point end(8000, 9000);
+    CombPath path;
+    CPPUNIT_ASSERT_MESSAGE("The points are in the same part, so there must be a path.", graph.findPath(start, end, path));
+    checkPath(path, start, end, *u_shape_loc_to_line);
+    CPPUNIT_ASSERT_EQUAL_MESSAGE("The path must bend around both bottom corners of the notch.", size_t(4), path.size());
+    for (unsigned int point_idx = 1; point_idx < path.size() - 1; point_idx++)
+    {
+        CPPUNIT_ASSERT_MESSAGE("The bends must be below the notch.", path[point_idx].Y < 2000);
+    }
+}
+
+void VisibilityGraphTest::pathAroundBlockingHole()
+{
+    Polygons boundary = square_with_hole;
+    PolygonRef blocking_hole = boundary.newPoly(); //Blocks the way from the start to the top left corner of the hole in the middle.
+    blocking_hole.add(Point(2000, 5800));
+    blocking_hole.add(Point(2000, 7000));
+    blocking_hole.add(Point(3000, 7000));
+    blocking_hole.add(Point(3000, 5800));
+    LocToLineGrid* loc_to_line = PolygonUtils::createLocToLineGrid(boundary, 1000);
+    VisibilityGraph graph(boundary, {0, 1, 2, 3}, *loc_to_line, -40);
+    const Point start(1000, 5500);
+    const Point end(9000, 5500);
+    CombPath path;
+    CPPUNIT_ASSERT_MESSAGE("The points are in the same part, so there must be a path.", graph.findPath(start, end, path));
+    checkPath(path, start, end, *loc_to_line);
+
+    //Around the top of the hole in the middle via the bottom right corner of the blocking hole, rather than around the bottom of the hole in the middle.
+    const coord_t shortest_length = vSize(Point(2000, 300)) + vSize(Point(1000, 200)) + 2000 + vSize(Point(3000, 500));
+    std::stringstream ss;
+    ss << "The path length " << pathLength(path) << " must be about the shortest length " << shortest_length << ".";
+    CPPUNIT_ASSERT_MESSAGE(ss.str(), std::abs(pathLength(path) - shortest_length) < 200);
+    delete loc_to_line;
+}
+
+void VisibilityGraphTest::checkPath(const CombPath& path, const Point start, const Point end, const LocToLineGrid& loc_to_line) const
+{
+    CPPUNIT_ASSERT_MESSAGE("The path must start at the start point.", path.front() == start);
+    CPPUNIT_ASSERT_MESSAGE("The path must end at the end point.", path.back() == end);
+    for (unsigned int point_idx = 1; point_idx < path.size(); point_idx++)
+    {
+        std::stringstream ss;
+        ss << "Segment " << path[point_idx - 1] << " - " << path[point_idx] << " must not collide with the boundary.";
+        CPPUNIT_ASSERT_MESSAGE(ss.str(), !PolygonUtils::polygonCollidesWithLineSegment(path[point_idx - 1], path[point_idx], loc_to_line));
+    }
+}
+
+coord_t VisibilityGraphTest::pathLength(const CombPath& path) const
+{
+    coord_t length = 0;
+    for (unsigned int point_idx = 1; point_idx < path.size(); point_idx++)
+    {
+        length += vSize(path[point_idx] - path[point_idx - 1]);
+    }
+    return length;
+}
+
+}
@@ -0,0 +1,108 @@
+//Copyright (c) 2018 Ultimaker B.V.
+//CuraEngine is released under the terms of the AGPLv3 or higher.
+
+#ifndef VISIBILITYGRAPHTEST_H
+#define VISIBILITYGRAPHTEST_H
+
+#include <cppunit/TestFixture.h>
+#include <cppunit/extensions/HelperMacros.h>
+
+#include "../src/pathPlanning/VisibilityGraph.h" //The class we're testing.
+
+namespace cura
+{
+
+/*
+ * \brief Tests the shortest paths found through the visibility graph of a
+ * part.
+ */
+class VisibilityGraphTest : public CppUnit::TestFixture
+{
+    CPPUNIT_TEST_SUITE(VisibilityGraphTest);
+    CPPUNIT_TEST(onlyCornersOfObstaclesAreNodes);
+    CPPUNIT_TEST(directPath);
+    CPPUNIT_TEST(pathAroundHole);
+    CPPUNIT_TEST(pathAroundNotch);
+    CPPUNIT_TEST(pathAroundBlockingHole);
+    CPPUNIT_TEST_SUITE_END();
+
+public:
+    /*
+     * \brief Resets the fixtures for a new test.
+     */
+    void setUp();
+
+    /*
+     * \brief Releases the grids of the fixtures.
+     */
+    void tearDown();
+
+    /*
+     * \brief Tests whether only the concave corners of the polygons in the way
+     * of a path become nodes.
+     */
+    void onlyCornersOfObstaclesAreNodes();
+
+    /*
+     * \brief Tests whether two points which see each other are connected
+     * directly.
+     */
+    void directPath();
+
+    /*
+     * \brief Tests whether a path between two points on either side of a hole
+     * goes around the hole without colliding with it.
+     */
+    void pathAroundHole();
+
+    /*
+     * \brief Tests whether a path between the two legs of a U-shaped part goes
+     * around the notch without colliding with it.
+     */
+    void pathAroundNotch();
+
+    /*
+     * \brief Tests whether the shortest path also bends around a hole that
+     * isn't crossed by the straight line, but blocks the shortest way around
+     * the hole that is.
+     */
+    void pathAroundBlockingHole();
+
+private:
+    /*
+     * \brief A 10x10mm square with a 2x2mm square hole in the middle and a
+     * small hole in a corner.
+     */
+    PolygonsPart square_with_hole;
+
+    /*
+     * \brief A grid over the line segments of the square with the hole.
+     */
+    LocToLineGrid* square_with_hole_loc_to_line;
+
+    /*
+     * \brief A 10x10mm square with a 2mm wide notch from the top down to 2mm
+     * above the bottom, making it U-shaped.
+     */
+    PolygonsPart u_shape;
+
+    /*
+     * \brief A grid over the line segments of the U-shape.
+     */
+    LocToLineGrid* u_shape_loc_to_line;
+
+    /*
+     * \brief Checks whether a path starts and ends at the given points and
+     * whether none of its segments collide with the boundary of the grid.
+     */
+    void checkPath(const CombPath& path, const Point start, const Point end, const LocToLineGrid& loc_to_line) const;
+
+    /*
+     * \brief Computes the length of a path.
+     */
+    coord_t pathLength(const CombPath& path) const;
+};
+
+}
+
+#endif //VISIBILITYGRAPHTEST_H
@@ -254,4 +254,23 @@ void SettingsTest::limitToExtruderTest()
     CPPUNIT_ASSERT_EQUAL(limit_extruder_value, settings.get<std::string>("test_setting"));
 }
 
+void SettingsTest::defaultValueTest()
+{
+    std::shared_ptr<Slice> current_slice = std::make_shared<Slice>(0);
+    Application::getInstance().current_slice = current_slice.get();
+
+    CPPUNIT_ASSERT_EQUAL_MESSAGE("A missing setting gets the default value.",
+                                 size_t(42), settings.get<size_t>("test_setting", 42));
+
+    Settings parent;
+    parent.add("test_setting", "7");
+    settings.setParent(&parent);
+    CPPUNIT_ASSERT_EQUAL_MESSAGE("A setting of the parent is used instead of the default value.",
+                                 size_t(7), settings.get<size_t>("test_setting", 42));
+
+    settings.add("test_setting", "3");
+    CPPUNIT_ASSERT_EQUAL_MESSAGE("The own value overrides both the parent and the default value.",
+                                 size_t(3), settings.get<size_t>("test_setting", 42));
+}
+
 }
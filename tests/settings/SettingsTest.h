@@ -39,6 +39,7 @@ class SettingsTest : public CppUnit::TestFixture
     CPPUNIT_TEST(overwriteSettingTest);
     CPPUNIT_TEST(inheritanceTest);
     CPPUNIT_TEST(limitToExtruderTest);
+    CPPUNIT_TEST(defaultValueTest);
     CPPUNIT_TEST_SUITE_END();
 
 public:
@@ -158,6 +159,12 @@ public:
      */
     void limitToExtruderTest();
 
+    /*
+     * \brief Test getting a setting with a default value for when it's
+     * missing.
+     */
+    void defaultValueTest();
+
 private:
     Settings settings; //Settings fixture to test on.
 };
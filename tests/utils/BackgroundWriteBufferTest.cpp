@@ -0,0 +1,133 @@
+//Copyright (c) 2018 Ultimaker B.V.
+//CuraEngine is released under the terms of the AGPLv3 or higher.
+
+#include "BackgroundWriteBufferTest.h"
+
+#include <cstdio>
+#include <fstream>
+#include <ostream>
+#include <sstream>
+#ifdef GZIP
+    #include <zlib.h> //To decompress the written files.
+#endif
+#include <../src/utils/BackgroundWriteBuffer.h>
+
+namespace cura
+{
+    CPPUNIT_TEST_SUITE_REGISTRATION(BackgroundWriteBufferTest);
+
+void BackgroundWriteBufferTest::setUp()
+{
+    filename_a = "background_write_buffer_test_a.gcode";
+    filename_b = "background_write_buffer_test_b.gcode";
+}
+
+void BackgroundWriteBufferTest::tearDown()
+{
+    std::remove(filename_a.c_str());
+    std::remove(filename_b.c_str());
+}
+
+std::string BackgroundWriteBufferTest::readFile(const std::string& filename)
+{
+    std::ifstream file(filename, std::ios::binary);
+    std::ostringstream contents;
+    contents << file.rdbuf();
+    return contents.str();
+}
+
+void BackgroundWriteBufferTest::writeManyBuffers()
+{
+    std::string expected;
+    {
+        BackgroundWriteBuffer buffer(100);
+        CPPUNIT_ASSERT(buffer.open(filename_a.c_str()));
+        std::ostream out(&buffer);
+        for (int line = 0; line < 10000; line++)
+        {
+            std::ostringstream text;
+            text << "G1 X" << line << " Y" << (line * 7) % 1000 << std::string(line % 300, ';') << '\n';
+            out << text.str();
+            expected += text.str();
+            if (line == 5000)
+            {
+                buffer.setBufferSize(4096);
+            }
+        }
+        CPPUNIT_ASSERT(out.good());
+        CPPUNIT_ASSERT(buffer.close());
+    }
+    CPPUNIT_ASSERT(expected == readFile(filename_a));
+}
+
+void BackgroundWriteBufferTest::flushWritesEverything()
+{
+    BackgroundWriteBuffer buffer;
+    CPPUNIT_ASSERT(buffer.open(filename_a.c_str()));
+    std::ostream out(&buffer);
+    out << ";FLAVOR:Marlin\n" << 'G' << 28 << '\n';
+    CPPUNIT_ASSERT_EQUAL(std::string(""), readFile(filename_a)); //Still in the buffer.
+    out.flush();
+    CPPUNIT_ASSERT(out.good());
+    CPPUNIT_ASSERT_EQUAL(std::string(";FLAVOR:Marlin\nG28\n"), readFile(filename_a));
+}
+
+void BackgroundWriteBufferTest::reopenOtherFile()
+{
+    BackgroundWriteBuffer buffer(8);
+    std::ostream out(&buffer);
+    CPPUNIT_ASSERT(buffer.open(filename_a.c_str()));
+    out << "first file, longer than the buffer\n";
+    CPPUNIT_ASSERT(buffer.open(filename_b.c_str()));
+    out << "second file\n";
+    CPPUNIT_ASSERT(buffer.close());
+    CPPUNIT_ASSERT_EQUAL(std::string("first file, longer than the buffer\n"), readFile(filename_a));
+    CPPUNIT_ASSERT_EQUAL(std::string("second file\n"), readFile(filename_b));
+
+    out << "closed";
+    CPPUNIT_ASSERT(!out.good()); //Nothing to write to any more.
+}
+
+void BackgroundWriteBufferTest::writeCompressed()
+{
+#ifdef GZIP
+    std::string expected;
+    for (int line = 0; line < 100000; line++)
+    {
+        expected += "G1 X" + std::to_string(line % 200) + " Y" + std::to_string(line % 150) + " E" + std::to_string(line) + "\n";
+    }
+
+    BackgroundWriteBuffer buffer(4096);
+    CPPUNIT_ASSERT(buffer.setCompressed(true));
+    CPPUNIT_ASSERT(buffer.open(filename_a.c_str()));
+    std::ostream out(&buffer);
+    out << expected.substr(0, expected.size() / 2);
+    out.flush(); //All text so far must be readable already.
+    CPPUNIT_ASSERT(out.good());
+    CPPUNIT_ASSERT(readFile(filename_a).size() < expected.size() / 4);
+
+    const auto decompress = [](const std::string& filename)
+    {
+        gzFile file = gzopen(filename.c_str(), "rb");
+        std::string decompressed;
+        char chunk[4096];
+        int read_count;
+        while ((read_count = gzread(file, chunk, sizeof(chunk))) > 0)
+        {
+            decompressed.append(chunk, read_count);
+        }
+        gzclose(file);
+        return decompressed;
+    };
+    CPPUNIT_ASSERT(expected.substr(0, expected.size() / 2) == decompress(filename_a));
+
+    out << expected.substr(expected.size() / 2);
+    CPPUNIT_ASSERT(buffer.close());
+    CPPUNIT_ASSERT(expected == decompress(filename_a));
+#else
+    BackgroundWriteBuffer buffer;
+    CPPUNIT_ASSERT(!buffer.setCompressed(true));
+#endif
+}
+
+}
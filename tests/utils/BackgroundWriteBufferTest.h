@@ -0,0 +1,65 @@
+//Copyright (c) 2018 Ultimaker B.V.
+//CuraEngine is released under the terms of the AGPLv3 or higher.
+
+#ifndef BACKGROUND_WRITE_BUFFER_TEST_H
+#define BACKGROUND_WRITE_BUFFER_TEST_H
+
+#include <cppunit/TestFixture.h>
+#include <cppunit/extensions/HelperMacros.h>
+#include <string>
+
+namespace cura
+{
+
+class BackgroundWriteBufferTest : public CppUnit::TestFixture
+{
+    CPPUNIT_TEST_SUITE(BackgroundWriteBufferTest);
+    CPPUNIT_TEST(writeManyBuffers);
+    CPPUNIT_TEST(flushWritesEverything);
+    CPPUNIT_TEST(reopenOtherFile);
+    CPPUNIT_TEST(writeCompressed);
+    CPPUNIT_TEST_SUITE_END();
+
+public:
+    void setUp();
+    void tearDown();
+
+    /*!
+     * \brief Test writing much more text than fits in the buffers, in pieces
+     * of all sizes.
+     */
+    void writeManyBuffers();
+
+    /*!
+     * \brief Test that flushing the stream writes all text to the file, while
+     * the file is still open.
+     */
+    void flushWritesEverything();
+
+    /*!
+     * \brief Test that opening another file finishes the first one.
+     */
+    void reopenOtherFile();
+
+    /*!
+     * \brief Test that compressed text decompresses to the original text, both
+     * after flushing and after closing the file.
+     */
+    void writeCompressed();
+
+private:
+    /*!
+     * \brief Files to write to during the tests, removed afterwards.
+     */
+    std::string filename_a;
+    std::string filename_b;
+
+    /*!
+     * \brief Read the whole contents of a file.
+     */
+    static std::string readFile(const std::string& filename);
+};
+
+}
+
+#endif //BACKGROUND_WRITE_BUFFER_TEST_H
@@ -0,0 +1,362 @@
+//Copyright (c) 2018 Ultimaker B.V.
+//CuraEngine is released under the terms of the AGPLv3 or higher.
+
+#include <algorithm> //For std::min.
+#include <random>
+#include <sstream>
+
+#include "BinaryGcodeBufferTest.h"
+#include "../src/utils/BinaryGcodeBuffer.h"
+#include "../src/utils/string.h"
+
+namespace cura
+{
+
+CPPUNIT_TEST_SUITE_REGISTRATION(BinaryGcodeBufferTest);
+
+namespace
+{
+
+/*!
+ * Reads the varints of the binary format.
+ */
+struct Reader
+{
+    const std::string& binary;
+    size_t position;
+
+    uint8_t readByte()
+    {
+        CPPUNIT_ASSERT_MESSAGE("Read past the end of the file.", position < binary.size());
+        return binary[position++];
+    }
+
+    uint64_t readUnsigned()
+    {
+        uint64_t value = 0;
+        for (unsigned int shift = 0; ; shift += 7)
+        {
+            const uint8_t byte = readByte();
+            value |= static_cast<uint64_t>(byte & 0x7F) << shift;
+            if (!(byte & 0x80))
+            {
+                return value;
+            }
+        }
+    }
+
+    int64_t readSigned()
+    {
+        const uint64_t zigzag = readUnsigned();
+        return static_cast<int64_t>(zigzag >> 1) ^ -static_cast<int64_t>(zigzag & 1);
+    }
+};
+
+/*!
+ * A stream buffer which only takes a limited number of characters, like a
+ * file on a disk which is almost full.
+ */
+class LimitedBuffer : public std::stringbuf
+{
+public:
+    LimitedBuffer(const std::streamsize capacity)
+    : capacity(capacity)
+    {}
+
+protected:
+    std::streamsize xsputn(const char* text, std::streamsize count) override
+    {
+        const std::streamsize written = std::stringbuf::xsputn(text, std::min(count, capacity));
+        capacity -= written;
+        return written;
+    }
+
+private:
+    std::streamsize capacity;
+};
+
+} //anonymous namespace
+
+std::string BinaryGcodeBufferTest::encode(const std::string& text)
+{
+    std::stringbuf result;
+    BinaryGcodeBuffer encoder(&result);
+    std::ostream stream(&encoder);
+    size_t piece_size = 1;
+    for (size_t start = 0; start < text.size(); start += piece_size, piece_size = piece_size * 7 % 1000 + 1)
+    {
+        stream << text.substr(start, piece_size);
+        if (piece_size % 3 == 0)
+        {
+            stream.flush(); //Flushing shouldn't make a difference.
+        }
+    }
+    encoder.finish();
+    return result.str();
+}
+
+std::string BinaryGcodeBufferTest::decode(const std::string& binary)
+{
+    CPPUNIT_ASSERT_MESSAGE("The file should start with the magic characters.", binary.compare(0, 4, "CBGC") == 0);
+    CPPUNIT_ASSERT_EQUAL(BinaryGcodeBuffer::version, static_cast<uint8_t>(binary[4]));
+    return decodeFrom(binary, 5, false);
+}
+
+std::string BinaryGcodeBufferTest::decodeLayer(const std::string& binary, const int layer_nr)
+{
+    CPPUNIT_ASSERT_MESSAGE("The file should end with the magic characters of the index.", binary.compare(binary.size() - 4, 4, "CBGI") == 0);
+    uint64_t end_position = 0;
+    for (size_t byte = 0; byte < 8; byte++)
+    {
+        end_position |= static_cast<uint64_t>(static_cast<uint8_t>(binary[binary.size() - 12 + byte])) << (byte * 8);
+    }
+    Reader reader{binary, end_position};
+    CPPUNIT_ASSERT_EQUAL(static_cast<uint8_t>(BinaryGcodeBuffer::Opcode::END), reader.readByte());
+    const uint64_t layer_count = reader.readUnsigned();
+    for (uint64_t layer = 0; layer < layer_count; layer++)
+    {
+        const int64_t indexed_layer_nr = reader.readSigned();
+        const uint64_t layer_position = reader.readUnsigned();
+        if (indexed_layer_nr == layer_nr)
+        {
+            return decodeFrom(binary, layer_position, true);
+        }
+    }
+    return "";
+}
+
+std::string BinaryGcodeBufferTest::decodeFrom(const std::string& binary, size_t position, const bool single_layer)
+{
+    std::string text;
+    Reader reader{binary, position};
+    int64_t previous[BinaryGcodeBuffer::move_word_count] = {};
+    bool in_layer = false;
+    while (true)
+    {
+        const BinaryGcodeBuffer::Opcode opcode = static_cast<BinaryGcodeBuffer::Opcode>(reader.readByte());
+        switch (opcode)
+        {
+            case BinaryGcodeBuffer::Opcode::TEXT:
+            case BinaryGcodeBuffer::Opcode::PARTIAL_TEXT:
+            {
+                const uint64_t length = reader.readUnsigned();
+                CPPUNIT_ASSERT(reader.position + length <= binary.size());
+                text.append(binary, reader.position, length);
+                reader.position += length;
+                if (opcode == BinaryGcodeBuffer::Opcode::TEXT)
+                {
+                    text += '\n';
+                }
+                break;
+            }
+            case BinaryGcodeBuffer::Opcode::LAYER:
+            {
+                if (single_layer && in_layer)
+                {
+                    return text;
+                }
+                in_layer = true;
+                text += ";LAYER:" + std::to_string(reader.readSigned()) + "\n";
+                std::fill(previous, previous + BinaryGcodeBuffer::move_word_count, 0);
+                break;
+            }
+            case BinaryGcodeBuffer::Opcode::END:
+            {
+                return text;
+            }
+            case BinaryGcodeBuffer::Opcode::MOVE_G0:
+            case BinaryGcodeBuffer::Opcode::MOVE_G1:
+            case BinaryGcodeBuffer::Opcode::MOVE_G2:
+            case BinaryGcodeBuffer::Opcode::MOVE_G3:
+            {
+                const unsigned int g = static_cast<uint8_t>(opcode) - static_cast<uint8_t>(BinaryGcodeBuffer::Opcode::MOVE_G0);
+                const uint8_t mask = reader.readByte();
+                int64_t values[BinaryGcodeBuffer::move_word_count] = {};
+                for (size_t word = 0; word < BinaryGcodeBuffer::move_word_count; word++)
+                {
+                    if (!(mask & (1 << word)))
+                    {
+                        continue;
+                    }
+                    const char letter = BinaryGcodeBuffer::move_words[word];
+                    if (letter == 'X' || letter == 'Y' || letter == 'Z' || letter == 'E')
+                    {
+                        previous[word] += reader.readSigned();
+                        values[word] = previous[word];
+                    }
+                    else
+                    {
+                        values[word] = reader.readSigned();
+                    }
+                }
+                char line[200];
+                text.append(line, BinaryGcodeBuffer::writeMove(g, mask, values, line) - line);
+                text += '\n';
+                break;
+            }
+            default:
+            {
+                CPPUNIT_ASSERT_MESSAGE("Unknown opcode.", false);
+                return text;
+            }
+        }
+    }
+}
+
+void BinaryGcodeBufferTest::roundTripLines()
+{
+    const std::string text =
+        ";FLAVOR:Marlin\n"
+        "M104 S200\n"
+        "G28 ;Home\n"
+        "\n"
+        ";LAYER:-2\n"
+        "G0 F9000 X10.5 Y-.5 Z.3\n"
+        "G1 F1500 E0\n"
+        "G1 X11 Y-0.5 E1.23456\n" //-0.5 isn't how the coordinate is written, so it's kept as text.
+        "G1 X11.0 Y1 E1.5\n" //Neither is a trailing zero.
+        "G1 X1.2345 Y1\n" //Too many decimals.
+        "G1 Y1 X2\n" //Unusual order.
+        "G1 X1 A2.5\n" //Another extruder character.
+        "G1 E-0\n"
+        "G1 X\n"
+        "G10\n"
+        "G0\n"
+        "G4 P100\n"
+        ";LAYER:0\n"
+        ";LAYER:007\n"
+        ";LAYER:1.5\n"
+        "G2 X-1.001 Y2 I-.999 J-1000 E123456.78901\r\n"
+        "G3 F1234.5 X0 Y0 I.001 J0 E-9.87654\n"
+        "G1 X9223372036854775807\n"
+        ";LAYER:1\n"
+        "G1 X1 Y2 Z3 E4\n"
+        "G92 E0\n"
+        ";End of the g-code without a line end";
+
+    const std::string binary = encode(text);
+    CPPUNIT_ASSERT_EQUAL(text, decode(binary));
+}
+
+void BinaryGcodeBufferTest::roundTripFormattedMoves()
+{
+    std::ostringstream text;
+    std::stringbuf binary;
+    BinaryGcodeBuffer encoder(&binary);
+    std::ostream binary_stream(&encoder);
+    std::mt19937 random(42);
+    std::uniform_int_distribution<int64_t> coordinate(-200000, 200000);
+    std::uniform_real_distribution<double> extrusion(0.0, 10000.0);
+    std::uniform_real_distribution<double> speed(1.0, 300.0);
+    for (int layer_nr = 0; layer_nr < 10; layer_nr++)
+    {
+        for (std::ostream* stream : std::initializer_list<std::ostream*>{&text, &binary_stream})
+        {
+            *stream << ";LAYER:" << layer_nr << "\n";
+        }
+        for (int move = 0; move < 1000; move++)
+        {
+            const int g = move % 4;
+            const double f = speed(random) * 60;
+            const int64_t x = coordinate(random);
+            const int64_t y = coordinate(random);
+            const int64_t z = layer_nr * 200 + 100;
+            const double e = extrusion(random);
+            for (std::ostream* stream : std::initializer_list<std::ostream*>{&text, &binary_stream})
+            {
+                *stream << "G" << g;
+                if (move % 5 == 0)
+                {
+                    *stream << " F" << PrecisionedDouble{1, f};
+                }
+                *stream << " X" << MMtoStream{x} << " Y" << MMtoStream{y};
+                if (move % 50 == 0)
+                {
+                    *stream << " Z" << MMtoStream{z};
+                }
+                if (g >= 2)
+                {
+                    *stream << " I" << MMtoStream{-x / 2} << " J" << MMtoStream{y / 3};
+                }
+                if (g != 0)
+                {
+                    *stream << " E" << PrecisionedDouble{5, e};
+                }
+                *stream << "\n";
+            }
+        }
+    }
+    encoder.finish();
+
+    CPPUNIT_ASSERT_EQUAL(text.str(), decode(binary.str()));
+    CPPUNIT_ASSERT_MESSAGE("The moves should be encoded as moves, not as text.", binary.str().size() * 2 < text.str().size());
+}
+
+void BinaryGcodeBufferTest::seekToLayer()
+{
+    std::string text = "M104 S200\n";
+    std::vector<std::string> layers;
+    for (int layer_nr = -3; layer_nr < 3; layer_nr++)
+    {
+        std::string layer = ";LAYER:" + std::to_string(layer_nr) + "\n";
+        for (int move = 0; move < 5; move++)
+        {
+            layer += "G1 X" + std::to_string(layer_nr * 10 + move) + " Y" + std::to_string(move) + " E" + std::to_string(layer_nr + 100 + move) + ".5\n";
+        }
+        layer += ";TIME_ELAPSED:" + std::to_string(layer_nr) + "\n";
+        layers.push_back(layer);
+        text += layer;
+    }
+
+    const std::string binary = encode(text);
+    for (int layer_nr = -3; layer_nr < 3; layer_nr++)
+    {
+        CPPUNIT_ASSERT_EQUAL(layers[layer_nr + 3], decodeLayer(binary, layer_nr));
+    }
+    CPPUNIT_ASSERT_EQUAL_MESSAGE("There's no layer 3.", std::string(""), decodeLayer(binary, 3));
+}
+
+void BinaryGcodeBufferTest::roundTripLongLine()
+{
+    const std::string text = "G1 X1 Y1\n;" + std::string(300 * 1024, 'a') + "\nG1 X2 Y2\n";
+    CPPUNIT_ASSERT_EQUAL(text, decode(encode(text)));
+}
+
+void BinaryGcodeBufferTest::finishStartsNewFile()
+{
+    std::stringbuf first;
+    BinaryGcodeBuffer encoder(&first);
+    std::ostream stream(&encoder);
+    stream << ";LAYER:0\nG1 X5 Y5\n";
+    encoder.finish();
+
+    std::stringbuf second;
+    encoder.setTarget(&second);
+    stream << ";LAYER:1\nG1 X6 Y6\n";
+    encoder.finish();
+
+    CPPUNIT_ASSERT_EQUAL(std::string(";LAYER:0\nG1 X5 Y5\n"), decode(first.str()));
+    CPPUNIT_ASSERT_EQUAL(std::string(";LAYER:1\nG1 X6 Y6\n"), decode(second.str()));
+    CPPUNIT_ASSERT_EQUAL(std::string(";LAYER:1\nG1 X6 Y6\n"), decodeLayer(second.str(), 1));
+    CPPUNIT_ASSERT_EQUAL_MESSAGE("The first layer is in the first file only.", std::string(""), decodeLayer(second.str(), 0));
+}
+
+void BinaryGcodeBufferTest::shortWriteFailsStream()
+{
+    LimitedBuffer target(16);
+    BinaryGcodeBuffer encoder(&target);
+    std::ostream stream(&encoder);
+    stream << ";LAYER:0\n;This comment doesn't fit on the disk any more.\n";
+    stream.flush();
+    CPPUNIT_ASSERT_MESSAGE("The stream fails when the target can't take the g-code.", stream.fail());
+    CPPUNIT_ASSERT_MESSAGE("The file is reported to be incomplete.", !encoder.finish());
+
+    std::stringbuf next;
+    encoder.setTarget(&next);
+    stream.clear();
+    stream << ";LAYER:1\nG1 X6 Y6\n";
+    CPPUNIT_ASSERT_MESSAGE("The next file is written completely.", encoder.finish());
+    CPPUNIT_ASSERT_EQUAL(std::string(";LAYER:1\nG1 X6 Y6\n"), decode(next.str()));
+}
+
+}
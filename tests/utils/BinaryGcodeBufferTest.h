@@ -0,0 +1,94 @@
+//Copyright (c) 2018 Ultimaker B.V.
+//CuraEngine is released under the terms of the AGPLv3 or higher.
+
+#ifndef BINARY_GCODE_BUFFER_TEST_H
+#define BINARY_GCODE_BUFFER_TEST_H
+
+#include <cppunit/TestFixture.h>
+#include <cppunit/extensions/HelperMacros.h>
+#include <string>
+
+namespace cura
+{
+
+class BinaryGcodeBufferTest : public CppUnit::TestFixture
+{
+    CPPUNIT_TEST_SUITE(BinaryGcodeBufferTest);
+    CPPUNIT_TEST(roundTripLines);
+    CPPUNIT_TEST(roundTripFormattedMoves);
+    CPPUNIT_TEST(seekToLayer);
+    CPPUNIT_TEST(roundTripLongLine);
+    CPPUNIT_TEST(finishStartsNewFile);
+    CPPUNIT_TEST(shortWriteFailsStream);
+    CPPUNIT_TEST_SUITE_END();
+
+public:
+    /*!
+     * \brief Test that all sorts of lines, including ones which look like
+     * moves but can't be written back exactly, decode to the original text.
+     */
+    void roundTripLines();
+
+    /*!
+     * \brief Test that moves written the way GCodeExport writes them decode
+     * to the original text, and are much smaller than the text.
+     */
+    void roundTripFormattedMoves();
+
+    /*!
+     * \brief Test that each layer can be decoded on its own, after looking it
+     * up in the index.
+     */
+    void seekToLayer();
+
+    /*!
+     * \brief Test a line which is longer than the buffer of the encoder.
+     */
+    void roundTripLongLine();
+
+    /*!
+     * \brief Test that after finishing a file, the next file is complete on its
+     * own.
+     */
+    void finishStartsNewFile();
+
+    /*!
+     * \brief Test that the stream fails if the target doesn't take all of
+     * the encoded g-code, e.g. because the disk is full.
+     */
+    void shortWriteFailsStream();
+
+private:
+    /*!
+     * \brief Encode text in pieces of various sizes.
+     */
+    static std::string encode(const std::string& text);
+
+    /*!
+     * \brief The reference decoder: decode a whole binary g-code file to text.
+     */
+    static std::string decode(const std::string& binary);
+
+    /*!
+     * \brief Decode a single layer, which is looked up in the index at the end
+     * of the file.
+     *
+     * \return The text from the layer comment of the layer up to the next
+     * layer or the end of the file, or an empty string if the index doesn't
+     * contain the layer.
+     */
+    static std::string decodeLayer(const std::string& binary, const int layer_nr);
+
+    /*!
+     * \brief Decode the records from a position in the file.
+     *
+     * \param binary The binary g-code file.
+     * \param position The position of the first record to decode.
+     * \param single_layer Whether to stop at the start of the next layer.
+     */
+    static std::string decodeFrom(const std::string& binary, size_t position, const bool single_layer);
+};
+
+}
+
+#endif //BINARY_GCODE_BUFFER_TEST_H
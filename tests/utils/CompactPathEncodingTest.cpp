@@ -0,0 +1,134 @@
+//Copyright (c) 2018 Ultimaker B.V.
+//CuraEngine is released under the terms of the AGPLv3 or higher.
+
+#include <cmath>
+#include <random>
+
+#include "CompactPathEncodingTest.h"
+#include "../src/utils/CompactPathEncoding.h"
+#include "../src/utils/IntPoint.h" //For INT2MM.
+
+namespace cura
+{
+
+CPPUNIT_TEST_SUITE_REGISTRATION(CompactPathEncodingTest);
+
+namespace
+{
+
+/*!
+ * Random coordinates in micron, converted to floats in mm the way
+ * ArcusCommunication converts them.
+ */
+std::vector<float> randomCoordinates(const size_t count, const coord_t max_step)
+{
+    std::mt19937 generator(42);
+    std::uniform_int_distribution<coord_t> step(-max_step, max_step);
+    std::vector<float> coordinates;
+    coord_t coordinate = 0;
+    for (size_t i = 0; i < count; i++)
+    {
+        coordinate += step(generator);
+        coordinates.push_back(INT2MM(coordinate));
+    }
+    return coordinates;
+}
+
+}
+
+void CompactPathEncodingTest::roundTripPoints2D()
+{
+    std::vector<float> points = randomCoordinates(2000, 500000);
+    points.push_back(INT2MM(-999999)); //Large jumps, in both directions.
+    points.push_back(INT2MM(999999));
+    const std::vector<float> decoded = CompactPathEncoding::decodePoints(CompactPathEncoding::encodePoints(points, 2), 2);
+    CPPUNIT_ASSERT(decoded == points);
+}
+
+void CompactPathEncodingTest::roundTripPoints3D()
+{
+    const std::vector<float> points = randomCoordinates(3000, 2000);
+    const std::vector<float> decoded = CompactPathEncoding::decodePoints(CompactPathEncoding::encodePoints(points, 3), 3);
+    CPPUNIT_ASSERT(decoded == points);
+}
+
+void CompactPathEncodingTest::roundTripWidths()
+{
+    std::vector<float> widths(100, INT2MM(400));
+    widths.insert(widths.end(), 5, INT2MM(350));
+    widths.push_back(INT2MM(1));
+    const std::vector<float> varying = randomCoordinates(100, 100);
+    widths.insert(widths.end(), varying.begin(), varying.end());
+
+    const std::string encoded = CompactPathEncoding::encodeRuns(widths, CompactPathEncoding::coordinate_scale);
+    const std::vector<float> decoded = CompactPathEncoding::decodeRuns(encoded, CompactPathEncoding::coordinate_scale);
+    CPPUNIT_ASSERT(decoded == widths);
+}
+
+void CompactPathEncodingTest::roundTripFeedrates()
+{
+    const std::vector<float> feedrates = {30.0f, 30.0f, 30.0f, 25.123456f, 150.0f, 150.0f, 0.001f, 1000.5f};
+    const std::string encoded = CompactPathEncoding::encodeRuns(feedrates, CompactPathEncoding::feedrate_scale);
+    const std::vector<float> decoded = CompactPathEncoding::decodeRuns(encoded, CompactPathEncoding::feedrate_scale);
+
+    CPPUNIT_ASSERT_EQUAL(feedrates.size(), decoded.size());
+    for (size_t i = 0; i < feedrates.size(); i++)
+    {
+        CPPUNIT_ASSERT_DOUBLES_EQUAL(feedrates[i], decoded[i], 0.5 / CompactPathEncoding::feedrate_scale + 1e-5);
+    }
+}
+
+void CompactPathEncodingTest::roundTripTypes()
+{
+    std::vector<PrintFeatureType> types(300, PrintFeatureType::Infill); //Longer than fits in a single byte varint.
+    types.push_back(PrintFeatureType::NoneType);
+    types.push_back(PrintFeatureType::OuterWall);
+    types.insert(types.end(), 3, PrintFeatureType::MoveCombing);
+    types.push_back(PrintFeatureType::NumPrintFeatureTypes);
+
+    const std::vector<PrintFeatureType> decoded = CompactPathEncoding::decodeTypes(CompactPathEncoding::encodeTypes(types));
+    CPPUNIT_ASSERT(decoded == types);
+}
+
+void CompactPathEncodingTest::roundTripEmpty()
+{
+    CPPUNIT_ASSERT(CompactPathEncoding::encodePoints({}, 2).empty());
+    CPPUNIT_ASSERT(CompactPathEncoding::encodeRuns({}, CompactPathEncoding::coordinate_scale).empty());
+    CPPUNIT_ASSERT(CompactPathEncoding::encodeTypes({}).empty());
+    CPPUNIT_ASSERT(CompactPathEncoding::decodePoints("", 2).empty());
+    CPPUNIT_ASSERT(CompactPathEncoding::decodeRuns("", CompactPathEncoding::coordinate_scale).empty());
+    CPPUNIT_ASSERT(CompactPathEncoding::decodeTypes("").empty());
+}
+
+void CompactPathEncodingTest::smallerThanFloats()
+{
+    //A wall around a circle of 50mm, with a travel move to it, like a path segment of the layer view.
+    std::vector<float> points;
+    std::vector<PrintFeatureType> types;
+    constexpr size_t segment_count = 1000;
+    for (size_t i = 0; i <= segment_count; i++)
+    {
+        const double angle = 2 * M_PI * i / segment_count;
+        points.push_back(INT2MM(static_cast<coord_t>(100000 + 25000 * std::cos(angle))));
+        points.push_back(INT2MM(static_cast<coord_t>(100000 + 25000 * std::sin(angle))));
+        if (i > 0)
+        {
+            types.push_back((i == 1) ? PrintFeatureType::MoveCombing : PrintFeatureType::OuterWall);
+        }
+    }
+    std::vector<float> widths(segment_count, INT2MM(400));
+    widths[0] = INT2MM(100);
+    std::vector<float> thicknesses(segment_count, INT2MM(200));
+    std::vector<float> feedrates(segment_count, 30.0f);
+    feedrates[0] = 150.0f;
+
+    const size_t float_size = points.size() * sizeof(float) + types.size() * sizeof(PrintFeatureType) + 3 * segment_count * sizeof(float);
+    const size_t compact_size = CompactPathEncoding::encodePoints(points, 2).size()
+        + CompactPathEncoding::encodeTypes(types).size()
+        + CompactPathEncoding::encodeRuns(widths, CompactPathEncoding::coordinate_scale).size()
+        + CompactPathEncoding::encodeRuns(thicknesses, CompactPathEncoding::coordinate_scale).size()
+        + CompactPathEncoding::encodeRuns(feedrates, CompactPathEncoding::feedrate_scale).size();
+    CPPUNIT_ASSERT_MESSAGE("The compact encoding must be at least 3 times as small as the floats.", compact_size * 3 <= float_size);
+}
+
+}
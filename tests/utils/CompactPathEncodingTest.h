@@ -0,0 +1,68 @@
+//Copyright (c) 2018 Ultimaker B.V.
+//CuraEngine is released under the terms of the AGPLv3 or higher.
+
+#ifndef COMPACT_PATH_ENCODING_TEST_H
+#define COMPACT_PATH_ENCODING_TEST_H
+
+#include <cppunit/TestFixture.h>
+#include <cppunit/extensions/HelperMacros.h>
+
+namespace cura
+{
+
+class CompactPathEncodingTest : public CppUnit::TestFixture
+{
+    CPPUNIT_TEST_SUITE(CompactPathEncodingTest);
+    CPPUNIT_TEST(roundTripPoints2D);
+    CPPUNIT_TEST(roundTripPoints3D);
+    CPPUNIT_TEST(roundTripWidths);
+    CPPUNIT_TEST(roundTripFeedrates);
+    CPPUNIT_TEST(roundTripTypes);
+    CPPUNIT_TEST(roundTripEmpty);
+    CPPUNIT_TEST(smallerThanFloats);
+    CPPUNIT_TEST_SUITE_END();
+
+public:
+    /*!
+     * \brief Test that 2D points in micron, sent as floats in mm the way the
+     * layer view data is, decode to exactly the same floats.
+     */
+    void roundTripPoints2D();
+
+    /*!
+     * \brief Test the same for 3D points.
+     */
+    void roundTripPoints3D();
+
+    /*!
+     * \brief Test that line widths in micron decode to exactly the same
+     * floats, both in runs and when they change every line segment.
+     */
+    void roundTripWidths();
+
+    /*!
+     * \brief Test that feedrates decode to within the resolution of the
+     * encoding.
+     */
+    void roundTripFeedrates();
+
+    /*!
+     * \brief Test that line types decode to the same types.
+     */
+    void roundTripTypes();
+
+    /*!
+     * \brief Test that a path segment without line segments encodes to
+     * nothing and back.
+     */
+    void roundTripEmpty();
+
+    /*!
+     * \brief Test that a typical path is encoded much smaller than as floats.
+     */
+    void smallerThanFloats();
+};
+
+}
+
+#endif //COMPACT_PATH_ENCODING_TEST_H
@@ -0,0 +1,94 @@
+//Copyright (c) 2018 Ultimaker B.V.
+//CuraEngine is released under the terms of the AGPLv3 or higher.
+
+#include "DeferredFormatBufferTest.h"
+
+#include <future> // promise
+#include <iomanip>
+#include <sstream> // ostringstream
+#include <../src/utils/DeferredFormatBuffer.h>
+#include <../src/utils/string.h>
+
+namespace cura
+{
+    CPPUNIT_TEST_SUITE_REGISTRATION(DeferredFormatBufferTest);
+
+void DeferredFormatBufferTest::setUp()
+{
+    //Do nothing.
+}
+
+void DeferredFormatBufferTest::tearDown()
+{
+    //Do nothing.
+}
+
+/*!
+ * Write some g-code to a stream, the way GCodeExport does.
+ */
+static void writeGCode(std::ostream& out)
+{
+    out << std::fixed;
+    out << ";LAYER:" << 12 << "\n";
+    out << "G1 F" << PrecisionedDouble{1, 1800.0} << " X" << MMtoStream{-12345} << " Y" << MMtoStream{100000} << " E" << PrecisionedDouble{5, 0.123456789} << "\n";
+    out << "G0 X" << MMtoStream{0} << " Y" << MMtoStream{1} << " Z" << MMtoStream{200} << "\n";
+    out << "M104 S" << std::setprecision(1) << 210.0 << "\n";
+    out << "G1 E" << PrecisionedDouble{5, -6.5} << "\n";
+}
+
+void DeferredFormatBufferTest::formatSameAsDirect()
+{
+    std::ostringstream direct;
+    writeGCode(direct);
+
+    DeferredFormatBuffer buffer;
+    std::ostream deferred(&buffer);
+    writeGCode(deferred);
+
+    CPPUNIT_ASSERT(DeferredFormatBuffer::of(deferred) == &buffer);
+    CPPUNIT_ASSERT(DeferredFormatBuffer::of(direct) == nullptr);
+    CPPUNIT_ASSERT_EQUAL(direct.str(), buffer.format());
+}
+
+void DeferredFormatBufferTest::formatOnlyText()
+{
+    DeferredFormatBuffer buffer;
+    std::ostream deferred(&buffer);
+    deferred << "M107\n" << 'G' << 28 << "\n";
+
+    CPPUNIT_ASSERT_EQUAL(std::string("M107\nG28\n"), buffer.format());
+}
+
+void DeferredFormatBufferTest::formatOnlyNumbers()
+{
+    std::ostringstream direct;
+    direct << MMtoStream{1500} << MMtoStream{-2} << PrecisionedDouble{2, 0.5};
+
+    DeferredFormatBuffer buffer;
+    std::ostream deferred(&buffer);
+    deferred << MMtoStream{1500} << MMtoStream{-2} << PrecisionedDouble{2, 0.5};
+
+    CPPUNIT_ASSERT_EQUAL(direct.str(), buffer.format());
+}
+
+void DeferredFormatBufferTest::formatPendingNumbers()
+{
+    std::ostringstream direct;
+    direct << std::fixed << ";TIME_ELAPSED:" << 82.25 << "\nG0 X" << MMtoStream{100} << " S" << std::setprecision(1) << 12.345 << MMtoStream{7};
+
+    DeferredFormatBuffer buffer;
+    std::ostream deferred(&buffer);
+    std::promise<double> time_elapsed;
+    std::promise<double> temperature;
+    deferred << std::fixed << ";TIME_ELAPSED:";
+    buffer.deferPending(time_elapsed.get_future().share(), deferred);
+    deferred << "\nG0 X" << MMtoStream{100} << " S" << std::setprecision(1);
+    buffer.deferPending(temperature.get_future().share(), deferred);
+    deferred << MMtoStream{7};
+
+    time_elapsed.set_value(82.25); //Only known after writing.
+    temperature.set_value(12.345);
+    CPPUNIT_ASSERT_EQUAL(direct.str(), buffer.format());
+}
+
+}
@@ -0,0 +1,53 @@
+//Copyright (c) 2018 Ultimaker B.V.
+//CuraEngine is released under the terms of the AGPLv3 or higher.
+
+#ifndef DEFERRED_FORMAT_BUFFER_TEST_H
+#define DEFERRED_FORMAT_BUFFER_TEST_H
+
+#include <cppunit/TestFixture.h>
+#include <cppunit/extensions/HelperMacros.h>
+
+namespace cura
+{
+
+class DeferredFormatBufferTest : public CppUnit::TestFixture
+{
+    CPPUNIT_TEST_SUITE(DeferredFormatBufferTest);
+    CPPUNIT_TEST(formatSameAsDirect);
+    CPPUNIT_TEST(formatOnlyText);
+    CPPUNIT_TEST(formatOnlyNumbers);
+    CPPUNIT_TEST(formatPendingNumbers);
+    CPPUNIT_TEST_SUITE_END();
+
+public:
+    void setUp();
+    void tearDown();
+
+    /*!
+     * \brief Test writing g-code-like text with coordinates and numbers, which
+     * should give the same text as writing to a stream directly.
+     */
+    void formatSameAsDirect();
+
+    /*!
+     * \brief Test that text without any deferred numbers is kept as is.
+     */
+    void formatOnlyText();
+
+    /*!
+     * \brief Test deferred numbers which are written next to each other and at
+     * the very start and end of the text.
+     */
+    void formatOnlyNumbers();
+
+    /*!
+     * \brief Test numbers which are computed only after they have been
+     * written, between other deferred numbers and with the formatting of the
+     * stream at the time of writing.
+     */
+    void formatPendingNumbers();
+};
+
+}
+
+#endif //DEFERRED_FORMAT_BUFFER_TEST_H
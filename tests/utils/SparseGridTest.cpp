@@ -180,6 +180,31 @@ void SparseGridTest::getNearestSameTest()
     getNearestAssert(input, Point(100, 100), 10, new Point(100, 100));
 }
 
+void SparseGridTest::eraseTest()
+{
+    SparsePointGridInclusive<size_t> grid(10);
+    grid.insert(Point(95, 100), 0);
+    grid.insert(Point(98, 100), 1);
+    grid.insert(Point(98, 100), 2); //Same location, different value.
+
+    CPPUNIT_ASSERT_MESSAGE("Erasing an inserted element must succeed.", grid.erase(Point(98, 100), 1));
+
+    const std::vector<size_t> result = grid.getNearbyVals(Point(100, 100), 10);
+    CPPUNIT_ASSERT_EQUAL_MESSAGE("Only the erased element must be gone.", size_t(2), result.size());
+    CPPUNIT_ASSERT_MESSAGE("The erased value must no longer be found.", std::find(result.begin(), result.end(), 1) == result.end());
+    CPPUNIT_ASSERT_MESSAGE("The value at the same location must remain.", std::find(result.begin(), result.end(), 2) != result.end());
+}
+
+void SparseGridTest::eraseMissingTest()
+{
+    SparsePointGridInclusive<size_t> grid(10);
+    grid.insert(Point(95, 100), 0);
+
+    CPPUNIT_ASSERT_MESSAGE("There is no element with this value.", !grid.erase(Point(95, 100), 1));
+    CPPUNIT_ASSERT_MESSAGE("There is no element at this location.", !grid.erase(Point(200, 100), 0));
+    CPPUNIT_ASSERT_EQUAL_MESSAGE("Failed erasures must not remove anything.", size_t(1), grid.getNearbyVals(Point(95, 100), 10).size());
+}
+
 void SparseGridTest::getNearbyAssert(
     const std::vector<Point>& registered_points,
     Point target, const coord_t grid_size,
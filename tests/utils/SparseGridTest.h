@@ -27,6 +27,8 @@ class SparseGridTest : public CppUnit::TestFixture
     CPPUNIT_TEST(getNearestFilterTest);
     CPPUNIT_TEST(getNearestNoneTest);
     CPPUNIT_TEST(getNearestSameTest);
+    CPPUNIT_TEST(eraseTest);
+    CPPUNIT_TEST(eraseMissingTest);
     CPPUNIT_TEST_SUITE_END();
 
 public:
@@ -53,6 +55,8 @@ public:
     void getNearestFilterTest();
     void getNearestNoneTest();
     void getNearestSameTest();
+    void eraseTest();
+    void eraseMissingTest();
 
 private:
     /*!
@@ -5,6 +5,7 @@
 
 #include <iomanip>
 #include <sstream> // ostringstream
+#include <vector>
 #include <../src/utils/IntPoint.h>
 #include <../src/utils/string.h>
 
@@ -169,6 +170,92 @@ void StringTest::writeDoubleToStreamTestLow()
 }
 
 
+void StringTest::writeInt2mmBufferTest()
+{
+    const std::vector<std::pair<int64_t, std::string>> cases = {
+        {0, "0"},
+        {1, "0.001"},
+        {50, "0.05"},
+        {999, "0.999"},
+        {1000, "1"},
+        {1230, "1.23"},
+        {12345, "12.345"},
+        {-1, "-0.001"},
+        {-50, "-0.05"},
+        {-500, "-.5"}, // always written without leading zero
+        {-999, "-.999"},
+        {-1000, "-1"},
+        {-1500, "-1.5"},
+        {std::numeric_limits<int32_t>::max(), "2147483.647"},
+        {std::numeric_limits<int32_t>::lowest(), "-2147483.648"}
+    };
+    for (const std::pair<int64_t, std::string>& test_case : cases)
+    {
+        char buffer[24];
+        const std::string out(buffer, writeInt2mm(test_case.first, buffer));
+        CPPUNIT_ASSERT_EQUAL(test_case.second, out);
+
+        std::ostringstream ss;
+        ss << MMtoStream{test_case.first};
+        CPPUNIT_ASSERT_EQUAL(test_case.second, ss.str());
+    }
+}
+
+void StringTest::writeDoubleToBufferSameAsPrintfTest()
+{
+    for (unsigned int precision = 0; precision <= 9; precision++)
+    {
+        for (int i = -20000; i <= 20000; i++)
+        {
+            writeDoubleToBufferAssert(i / 1000.0, precision);
+            writeDoubleToBufferAssert(i * 0.1, precision);
+            writeDoubleToBufferAssert(i * 123.456789, precision);
+            writeDoubleToBufferAssert(i / 3.0e7, precision);
+        }
+        writeDoubleToBufferAssert(0.0, precision);
+        writeDoubleToBufferAssert(-0.0, precision);
+        writeDoubleToBufferAssert(1e13, precision);
+        writeDoubleToBufferAssert(-99999999999.999, precision);
+    }
+}
+
+void StringTest::writeDoubleToBufferHalfwayTest()
+{
+    for (unsigned int precision = 0; precision <= 9; precision++)
+    {
+        for (int i = -20000; i <= 20000; i++)
+        {
+            writeDoubleToBufferAssert(i / 64.0, precision); // exactly halfway for some precisions
+            writeDoubleToBufferAssert((i + 0.5) / 1000.0, precision); // slightly above or below halfway in binary
+            writeDoubleToBufferAssert((i + 0.5) / 100000.0, precision);
+        }
+    }
+}
+
+void StringTest::writeDoubleToBufferAssert(double in, unsigned int precision)
+{
+    char expected[400];
+    int expected_count = snprintf(expected, sizeof(expected), "%.*F", precision, in);
+    if (precision > 0)
+    {
+        while (expected[expected_count - 1] == '0')
+        {
+            expected_count--;
+        }
+        if (expected[expected_count - 1] == '.')
+        {
+            expected_count--;
+        }
+    }
+
+    char buffer[400];
+    const std::string out(buffer, writeDoubleToBuffer(precision, in, buffer));
+
+    char message[1000];
+    snprintf(message, sizeof(message), "The double %.17g was written as '%s' with precision %u", in, out.c_str(), precision);
+    CPPUNIT_ASSERT_EQUAL_MESSAGE(std::string(message), std::string(expected, expected_count), out);
+}
+
 void StringTest::writeDoubleToStreamAssert(double in, unsigned int precision)
 {
     std::ostringstream ss;
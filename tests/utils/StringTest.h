@@ -44,6 +44,10 @@ class StringTest : public CppUnit::TestFixture
     CPPUNIT_TEST(writeDoubleToStreamTestLowest);
     CPPUNIT_TEST(writeDoubleToStreamTestLowestNeg);
     CPPUNIT_TEST(writeDoubleToStreamTestLow);
+
+    CPPUNIT_TEST(writeInt2mmBufferTest);
+    CPPUNIT_TEST(writeDoubleToBufferSameAsPrintfTest);
+    CPPUNIT_TEST(writeDoubleToBufferHalfwayTest);
     CPPUNIT_TEST_SUITE_END();
 
 public:
@@ -96,6 +100,25 @@ public:
     void writeDoubleToStreamTestLowestNeg();
     void writeDoubleToStreamTestLow();
 
+    /*!
+     * \brief Test the exact text which writeInt2mm writes to a buffer,
+     * including the corner cases of the format g-code has always been written
+     * with.
+     */
+    void writeInt2mmBufferTest();
+
+    /*!
+     * \brief Test that writeDoubleToBuffer writes the same text as printf,
+     * without the trailing zeros, for many numbers and all precisions.
+     */
+    void writeDoubleToBufferSameAsPrintfTest();
+
+    /*!
+     * \brief Test numbers which are (nearly) halfway between two numbers with
+     * the requested precision, which printf rounds by their exact binary value.
+     */
+    void writeDoubleToBufferHalfwayTest();
+
 private:
 
     /*!
@@ -118,6 +141,15 @@ private:
      * \param precision the (maximum) number of digits after the decimal mark to print
      */
     void writeDoubleToStreamAssert(double in, unsigned int precision = 4);
+
+    /*!
+     * \brief Asserts that writeDoubleToBuffer writes exactly what printf writes
+     * with the same precision, without the trailing zeros.
+     *
+     * \param in the double to check
+     * \param precision the (maximum) number of digits after the decimal mark to print
+     */
+    void writeDoubleToBufferAssert(double in, unsigned int precision);
 };
 
 }